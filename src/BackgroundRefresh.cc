@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 88    Client-side Reply Routines */
+
+#include "squid.h"
+#include "BackgroundRefresh.h"
+#include "client_side_reply.h"
+#include "client_side_request.h"
+#include "ClientRequestContext.h"
+#include "clientStream.h"
+#include "fatal.h"
+#include "HttpRequest.h"
+#include "sbuf/Algorithms.h"
+#include "Store.h"
+#include "store_key_md5.h"
+
+#include <unordered_set>
+
+CBDATA_CLASS_INIT(BackgroundRefresh);
+
+/// Used to hold and pass the required info and buffers to the
+/// clientStream callbacks
+class BackgroundRefreshContext: public RefCountable
+{
+    MEMPROXY_CLASS(BackgroundRefreshContext);
+
+public:
+    typedef RefCount<BackgroundRefreshContext> Pointer;
+
+    BackgroundRefreshContext(BackgroundRefresh *job, ClientHttpRequest *h): refresher(job), http(h) {}
+    ~BackgroundRefreshContext() override { finished(); }
+
+    void finished() {
+        delete http;
+        http = nullptr;
+    }
+
+    CbcPointer<BackgroundRefresh> refresher;
+    ClientHttpRequest *http;
+    char requestBuffer[HTTP_REQBUF_SZ];
+};
+
+/// public keys of the entries being refreshed in the background
+static std::unordered_set<SBuf> &
+RefreshesInProgress()
+{
+    static const auto keys = new std::unordered_set<SBuf>();
+    return *keys;
+}
+
+void
+BackgroundRefresh::Start(const StoreEntry &e, const HttpRequest &cause)
+{
+    if (cause.method != Http::METHOD_GET)
+        return;
+
+    const auto publicKey = e.publicKey();
+    if (!publicKey)
+        return; // nobody else can find the refreshed entry anyway
+
+    const SBuf storeKey(storeKeyText(publicKey));
+    if (!RefreshesInProgress().insert(storeKey).second) {
+        debugs(88, 5, "already refreshing " << e);
+        return;
+    }
+
+    const auto mx = MasterXaction::MakePortless<XactionInitiator::initBackgroundRefresh>();
+    const auto request = HttpRequest::FromUrl(cause.effectiveRequestUri(), mx, cause.method);
+    if (!request) {
+        RefreshesInProgress().erase(storeKey);
+        return;
+    }
+
+    request->http_ver = cause.http_ver;
+
+    // keep Vary-relevant fields but let refreshCheck() decide how to validate
+    request->header.append(&cause.header);
+    request->header.delById(Http::HdrType::IF_MODIFIED_SINCE);
+    request->header.delById(Http::HdrType::IF_NONE_MATCH);
+    request->header.delById(Http::HdrType::IF_MATCH);
+    request->header.delById(Http::HdrType::IF_UNMODIFIED_SINCE);
+    request->header.delById(Http::HdrType::IF_RANGE);
+    request->header.delById(Http::HdrType::RANGE);
+    request->header.delById(Http::HdrType::REQUEST_RANGE);
+    request->header.delById(Http::HdrType::CACHE_CONTROL);
+    request->header.delById(Http::HdrType::PRAGMA);
+
+    // http_access and other client-address rules see the triggering client
+    request->client_addr = cause.client_addr;
+#if FOLLOW_X_FORWARDED_FOR
+    request->indirect_client_addr = cause.indirect_client_addr;
+#endif /* FOLLOW_X_FORWARDED_FOR */
+    request->my_addr = cause.my_addr;
+    request->flags.backgroundRefresh = true;
+
+    debugs(88, 3, "refreshing " << e << " for " << cause.effectiveRequestUri());
+    AsyncJob::Start(new BackgroundRefresh(storeKey, request));
+}
+
+BackgroundRefresh::BackgroundRefresh(const SBuf &storeKey, HttpRequest *request):
+    AsyncJob("BackgroundRefresh"),
+    storeKey_(storeKey),
+    request_(request)
+{
+}
+
+BackgroundRefresh::~BackgroundRefresh()
+{
+    debugs(88, 6, this);
+    RefreshesInProgress().erase(storeKey_);
+}
+
+void
+BackgroundRefresh::swanSong()
+{
+    debugs(88, 6, this);
+
+    if (context_) {
+        context_->finished();
+        context_ = nullptr;
+    }
+}
+
+bool
+BackgroundRefresh::doneAll() const
+{
+    return finished_ && AsyncJob::doneAll();
+}
+
+static void
+backgroundRefreshRecipient(clientStreamNode * node, ClientHttpRequest * http,
+                           HttpReply * rep, StoreIOBuffer receivedData)
+{
+    assert(node);
+    assert(cbdataReferenceValid(node));
+    assert(!node->node.next);
+    BackgroundRefreshContext::Pointer context = dynamic_cast<BackgroundRefreshContext *>(node->data.getRaw());
+    assert(context);
+
+    if (context->refresher.valid())
+        context->refresher->handleReply(node, http, rep, receivedData);
+}
+
+static void
+backgroundRefreshDetach(clientStreamNode * node, ClientHttpRequest * http)
+{
+    clientStreamDetach(node, http);
+}
+
+void
+BackgroundRefresh::buildClientStream()
+{
+    ClientHttpRequest *const http = new ClientHttpRequest(nullptr);
+    http->initRequest(request_.getRaw());
+    http->req_sz = 0;
+    http->uri = SBufToCstring(request_->effectiveRequestUri());
+
+    context_ = new BackgroundRefreshContext(this, http);
+    StoreIOBuffer tempBuffer;
+    tempBuffer.data = context_->requestBuffer;
+    tempBuffer.length = HTTP_REQBUF_SZ;
+
+    ClientStreamData newServer = new clientReplyContext(http);
+    ClientStreamData newClient = context_.getRaw();
+    clientStreamInit(&http->client_stream, clientGetMoreData, clientReplyDetach,
+                     clientReplyStatus, newServer, backgroundRefreshRecipient,
+                     backgroundRefreshDetach, newClient, tempBuffer);
+
+    // Build a ClientRequestContext to start doCallouts
+    http->calloutContext = new ClientRequestContext(http);
+    http->doCallouts();
+}
+
+void
+BackgroundRefresh::start()
+{
+    buildClientStream();
+}
+
+void
+BackgroundRefresh::handleReply(clientStreamNode * node, ClientHttpRequest *http, HttpReply *, StoreIOBuffer receivedData)
+{
+    if (finished_)
+        return;
+
+    if (receivedData.flags.error) {
+        finish("error");
+        return;
+    }
+
+    // the refreshed response body is of no interest to us
+    http->out.size += receivedData.length;
+    http->out.offset += receivedData.length;
+
+    switch (clientStreamStatus(node, http)) {
+    case STREAM_NONE: {
+        StoreIOBuffer tempBuffer;
+        tempBuffer.offset = http->out.offset;
+        tempBuffer.data = context_->requestBuffer;
+        tempBuffer.length = HTTP_REQBUF_SZ;
+        clientStreamRead(node, http, tempBuffer);
+    }
+    break;
+    case STREAM_COMPLETE:
+        finish("success");
+        break;
+    case STREAM_UNPLANNED_COMPLETE:
+        finish("STREAM_UNPLANNED_COMPLETE");
+        break;
+    case STREAM_FAILED:
+        finish("STREAM_FAILED");
+        break;
+    default:
+        fatal("unreachable code");
+    }
+}
+
+void
+BackgroundRefresh::refreshFinished()
+{
+    debugs(88, 7, this);
+    Must(done());
+}
+
+/// stops receiving the refreshed response
+void
+BackgroundRefresh::finish(const char *outcome)
+{
+    debugs(88, 3, outcome << " refreshing " << request_->effectiveRequestUri());
+    finished_ = true;
+
+    // We cannot deleteThis() because we may be called synchronously from
+    // doCallouts() via handleReply(), and doCallouts() may crash if we
+    // disappear. Instead, schedule an async call now so that later, when the
+    // call firing code discovers a done() job, it deletes us.
+    CallJobHere(88, 7, CbcPointer<BackgroundRefresh>(this), BackgroundRefresh, refreshFinished);
+}
+
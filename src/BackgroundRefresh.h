@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_BACKGROUNDREFRESH_H
+#define SQUID_SRC_BACKGROUNDREFRESH_H
+
+#include "base/AsyncJob.h"
+#include "http/forward.h"
+#include "sbuf/SBuf.h"
+#include "store/forward.h"
+
+class ClientHttpRequest;
+class StoreIOBuffer;
+class clientStreamNode;
+class BackgroundRefreshContext;
+typedef RefCount<BackgroundRefreshContext> BackgroundRefreshContextPointer;
+
+/// Refreshes a cached response using an internal request, without delaying
+/// the client that is being served that cached response. Used for hits that
+/// are stale within their stale-while-revalidate period and for popular hits
+/// that are about to become stale (refresh_pattern prefetch option). The
+/// internal request goes through the regular client-side code, so the
+/// refreshed response is cached (or revalidated) as usual.
+class BackgroundRefresh: virtual public AsyncJob
+{
+    CBDATA_CHILD(BackgroundRefresh);
+
+public:
+    /// starts refreshing the given cached entry, unless that entry is
+    /// already being refreshed in the background
+    static void Start(const StoreEntry &, const HttpRequest &);
+
+    ~BackgroundRefresh() override;
+    void swanSong() override;
+
+    /// delays destruction to protect doCallouts()
+    void refreshFinished();
+
+    void handleReply(clientStreamNode *, ClientHttpRequest *, HttpReply *, StoreIOBuffer);
+
+protected:
+    /* AsyncJob API */
+    bool doneAll() const override;
+    void start() override;
+
+private:
+    BackgroundRefresh(const SBuf &storeKey, HttpRequest *);
+
+    void buildClientStream();
+    void finish(const char *outcome);
+
+    /// the public key of the entry being refreshed (for duplicate detection)
+    const SBuf storeKey_;
+
+    /// the internal request that refreshes the entry
+    HttpRequestPointer request_;
+
+    /// whether we are done receiving the refreshed response
+    bool finished_ = false;
+
+    /// Pointer to an object that stores the clientStream required info
+    BackgroundRefreshContextPointer context_;
+};
+
+#endif /* SQUID_SRC_BACKGROUNDREFRESH_H */
+
@@ -22,8 +22,7 @@ public:
     ~BodySink() override { assert(!body_pipe); }
 
     void noteMoreBodyDataAvailable(BodyPipe::Pointer bp) override {
-        size_t contentSize = bp->buf().contentSize();
-        bp->consume(contentSize);
+        bp->consume(bp->buf().length());
     }
     void noteBodyProductionEnded(BodyPipe::Pointer) override {
         stopConsumingFrom(body_pipe);
@@ -130,9 +129,6 @@ BodyPipe::BodyPipe(Producer *aProducer): theBodySize(-1),
     thePutSize(0), theGetSize(0),
     mustAutoConsume(false), abortedConsumption(false), isCheckedOut(false)
 {
-    // TODO: teach MemBuf to start with zero minSize
-    // TODO: limit maxSize by theBodySize, when known?
-    theBuf.init(2*1024, MaxCapacity);
     debugs(91,7, "created BodyPipe" << status());
 }
 
@@ -141,7 +137,6 @@ BodyPipe::~BodyPipe()
     debugs(91,7, "destroying BodyPipe" << status());
     assert(!theProducer);
     assert(!theConsumer);
-    theBuf.clean();
 }
 
 void BodyPipe::setBodySize(uint64_t aBodySize)
@@ -215,8 +210,7 @@ BodyPipe::putMoreData(const char *aBuffer, size_t size)
     if (bodySizeKnown())
         size = min((uint64_t)size, unproducedSize());
 
-    const size_t spaceSize = static_cast<size_t>(theBuf.potentialSpaceSize());
-    if ((size = min(size, spaceSize))) {
+    if ((size = min(size, spaceSize()))) {
         theBuf.append(aBuffer, size);
         postAppend(size);
         return size;
@@ -224,6 +218,24 @@ BodyPipe::putMoreData(const char *aBuffer, size_t size)
     return 0;
 }
 
+size_t
+BodyPipe::putMoreData(const SBuf &content)
+{
+    size_t size = content.length();
+    if (bodySizeKnown())
+        size = min((uint64_t)size, unproducedSize());
+
+    if ((size = min(size, spaceSize()))) {
+        if (theBuf.isEmpty())
+            theBuf = content.substr(0, size); // share content storage
+        else
+            theBuf.append(content.substr(0, size));
+        postAppend(size);
+        return size;
+    }
+    return 0;
+}
+
 bool
 BodyPipe::setConsumerIfNotLate(const Consumer::Pointer &aConsumer)
 {
@@ -242,7 +254,7 @@ BodyPipe::setConsumerIfNotLate(const Consumer::Pointer &aConsumer)
 
     theConsumer = aConsumer;
     debugs(91,7, "set consumer" << status());
-    if (theBuf.hasContent())
+    if (!theBuf.isEmpty())
         scheduleBodyDataNotification();
     if (!theProducer)
         scheduleBodyEndNotification();
@@ -293,13 +305,13 @@ BodyPipe::expectNoConsumption()
 size_t
 BodyPipe::getMoreData(MemBuf &aMemBuffer)
 {
-    if (!theBuf.hasContent())
+    if (theBuf.isEmpty())
         return 0; // did not touch the possibly uninitialized buf
 
     if (aMemBuffer.isNull())
         aMemBuffer.init();
-    const size_t size = min(theBuf.contentSize(), aMemBuffer.potentialSpaceSize());
-    aMemBuffer.append(theBuf.content(), size);
+    const size_t size = min(static_cast<size_t>(theBuf.length()), static_cast<size_t>(aMemBuffer.potentialSpaceSize()));
+    aMemBuffer.append(theBuf.rawContent(), size);
     theBuf.consume(size);
     postConsume(size);
     return size; // cannot be zero if we called buf.init above
@@ -308,6 +320,7 @@ BodyPipe::getMoreData(MemBuf &aMemBuffer)
 void
 BodyPipe::consume(size_t size)
 {
+    assert(size <= theBuf.length());
     theBuf.consume(size);
     postConsume(size);
 }
@@ -330,7 +343,7 @@ BodyPipe::startAutoConsumptionIfNeeded()
         mustAutoConsume && // was enabled
         !theConsumer && // has not started yet
         theProducer.valid() && // still useful (and will eventually stop)
-        theBuf.hasContent(); // has something to consume right now
+        !theBuf.isEmpty(); // has something to consume right now
     if (!startNow)
         return;
 
@@ -340,7 +353,7 @@ BodyPipe::startAutoConsumptionIfNeeded()
     scheduleBodyDataNotification();
 }
 
-MemBuf &
+SBuf &
 BodyPipe::checkOut()
 {
     assert(!isCheckedOut);
@@ -353,7 +366,7 @@ BodyPipe::checkIn(Checkout &checkout)
 {
     assert(isCheckedOut);
     isCheckedOut = false;
-    const size_t currentSize = theBuf.contentSize();
+    const size_t currentSize = theBuf.length();
     if (checkout.checkedOutSize > currentSize)
         postConsume(checkout.checkedOutSize - currentSize);
     else if (checkout.checkedOutSize < currentSize)
@@ -364,7 +377,7 @@ void
 BodyPipe::undoCheckOut(Checkout &checkout)
 {
     assert(isCheckedOut);
-    const size_t currentSize = theBuf.contentSize();
+    const size_t currentSize = theBuf.length();
     // We can only undo if size did not change, and even that carries
     // some risk. If this becomes a problem, the code checking out
     // raw buffers should always check them in (possibly unchanged)
@@ -456,7 +469,7 @@ const char *BodyPipe::status() const
     else
         outputBuffer.append("<=?", 3);
 
-    outputBuffer.appendf(" %" PRId64 "+%" PRId64, static_cast<int64_t>(theBuf.contentSize()), static_cast<int64_t>(theBuf.spaceSize()));
+    outputBuffer.appendf(" %" PRId64 "+%" PRId64, static_cast<int64_t>(theBuf.length()), static_cast<int64_t>(spaceSize()));
 
     outputBuffer.appendf(" pipe%p", this);
     if (theProducer.set())
@@ -482,7 +495,7 @@ const char *BodyPipe::status() const
 
 BodyPipeCheckout::BodyPipeCheckout(BodyPipe &aPipe): thePipe(aPipe),
     buf(aPipe.checkOut()), offset(aPipe.consumedSize()),
-    checkedOutSize(buf.contentSize()), checkedIn(false)
+    checkedOutSize(buf.length()), checkedIn(false)
 {
 }
 
@@ -12,6 +12,7 @@
 #include "base/AsyncJob.h"
 #include "base/CbcPointer.h"
 #include "MemBuf.h"
+#include "sbuf/SBuf.h"
 
 class BodyPipe;
 
@@ -71,7 +72,7 @@ public:
 
 public:
     BodyPipe &thePipe;
-    MemBuf &buf;
+    SBuf &buf;
     const uint64_t offset; // of current content, relative to the body start
 
 protected:
@@ -86,6 +87,10 @@ private:
 /** Connects those who produces message body content with those who
  * consume it. For example, connects ConnStateData with FtpStateData OR
  * ICAPModXact with HttpStateData.
+ *
+ * Buffered content is kept in a reference-counted SBuf. Producers that
+ * supply an SBuf and consumers that use buf() share that storage instead
+ * of copying body bytes from one buffer to another.
  */
 class BodyPipe: public RefCountable
 {
@@ -115,6 +120,9 @@ public:
     // called by producers
     void clearProducer(bool atEof); // aborts or sends eof
     size_t putMoreData(const char *buf, size_t size);
+    /// Appends a prefix of the given content, sharing its storage if possible.
+    /// \returns the number of appended bytes
+    size_t putMoreData(const SBuf &content);
     bool mayNeedMoreData() const { return !bodySizeKnown() || needsMoreData(); }
     bool needsMoreData() const { return bodySizeKnown() && unproducedSize() > 0; }
     uint64_t unproducedSize() const; // size of still unproduced data
@@ -134,13 +142,16 @@ public:
     /// start or continue consuming when producing without consumer
     void enableAutoConsumption();
 
-    const MemBuf &buf() const { return theBuf; }
+    const SBuf &buf() const { return theBuf; }
+
+    /// the number of bytes putMoreData() may add to the buffer now
+    size_t spaceSize() const { return theBuf.length() < MaxCapacity ? MaxCapacity - theBuf.length() : 0; }
 
     const char *status() const; // for debugging only
 
 protected:
     // lower-level interface used by Checkout
-    MemBuf &checkOut(); // obtain raw buffer
+    SBuf &checkOut(); // obtain raw buffer
     void checkIn(Checkout &checkout); // return updated raw buffer
     void undoCheckOut(Checkout &checkout); // undo checkout effect
 
@@ -161,7 +172,7 @@ private:
     uint64_t thePutSize; // ever-increasing total
     uint64_t theGetSize; // ever-increasing total
 
-    MemBuf theBuf; // produced but not yet consumed content, if any
+    SBuf theBuf; // produced but not yet consumed content, if any
 
     bool mustAutoConsume; ///< keep theBuf empty when producing without consumer
     bool abortedConsumption; ///< called BodyProducer::noteBodyConsumerAborted
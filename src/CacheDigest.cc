@@ -34,6 +34,9 @@ static void cacheDigestHashKey(const CacheDigest * cd, const cache_key * key);
 /* static array used by cacheDigestHashKey for optimization purposes */
 static uint32_t hashed_keys[4];
 
+/// saturated reference counters are never decremented
+static const uint8_t CounterMax = 255;
+
 void
 CacheDigest::init(uint64_t newCapacity)
 {
@@ -43,6 +46,10 @@ CacheDigest::init(uint64_t newCapacity)
     capacity = newCapacity;
     mask_size = newMaskSz;
     mask = static_cast<char *>(xcalloc(mask_size,1));
+    if (counters) {
+        xfree(counters);
+        counters = static_cast<uint8_t *>(xcalloc(mask_size * 8, 1));
+    }
     debugs(70, 2, "capacity: " << capacity << " entries, bpe: " << bits_per_entry << "; size: "
            << mask_size << " bytes");
 }
@@ -52,6 +59,7 @@ CacheDigest::CacheDigest(uint64_t aCapacity, uint8_t bpe) :
     del_count(0),
     capacity(0),
     mask(nullptr),
+    counters(nullptr),
     mask_size(0),
     bits_per_entry(bpe)
 {
@@ -62,12 +70,17 @@ CacheDigest::CacheDigest(uint64_t aCapacity, uint8_t bpe) :
 CacheDigest::~CacheDigest()
 {
     xfree(mask);
+    xfree(counters);
 }
 
 CacheDigest *
 CacheDigest::clone() const
 {
     CacheDigest *cl = new CacheDigest(capacity, bits_per_entry);
+    if (counters) {
+        cl->enableRemovals();
+        memcpy(cl->counters, counters, mask_size * 8);
+    }
     cl->count = count;
     cl->del_count = del_count;
     assert(mask_size == cl->mask_size);
@@ -80,6 +93,16 @@ CacheDigest::clear()
 {
     count = del_count = 0;
     memset(mask, 0, mask_size);
+    if (counters)
+        memset(counters, 0, mask_size * 8);
+}
+
+void
+CacheDigest::enableRemovals()
+{
+    if (!counters)
+        counters = static_cast<uint8_t *>(xcalloc(mask_size * 8, 1));
+    clear();
 }
 
 void
@@ -132,6 +155,13 @@ CacheDigest::add(const cache_key * key)
         ++on_xition_cnt;
     }
 
+    if (counters) {
+        for (const auto bit: hashed_keys) {
+            if (counters[bit] < CounterMax)
+                ++counters[bit];
+        }
+    }
+
     statCounter.cd.on_xition_count.count(on_xition_cnt);
     ++count;
 }
@@ -141,7 +171,19 @@ CacheDigest::remove(const cache_key * key)
 {
     assert(key);
     ++del_count;
-    /* we do not support deletions from the digest */
+
+    if (!counters)
+        return; // we do not support deletions from a plain digest
+
+    cacheDigestHashKey(this, key);
+    for (const auto bit: hashed_keys) {
+        // a saturated counter may correspond to more keys than it can count
+        if (counters[bit] && counters[bit] < CounterMax && !--counters[bit])
+            CBIT_CLR(mask, bit);
+    }
+
+    if (count)
+        --count;
 }
 
 /* returns mask utilization parameters */
@@ -253,8 +295,9 @@ cacheDigestReport(CacheDigest * cd, const SBuf &label, StoreEntry * e)
                       cd->capacity,
                       xpercentInt(cd->count, cd->capacity)
                      );
-    storeAppendPrintf(e, "\t deletion attempts: %" PRIu64 "\n",
-                      cd->del_count
+    storeAppendPrintf(e, "\t deletion attempts: %" PRIu64 " removals: %s\n",
+                      cd->del_count,
+                      cd->removable() ? "yes" : "no"
                      );
     storeAppendPrintf(e, "\t bits: per entry: %d on: %d capacity: %d util: %d%%\n",
                       cd->bits_per_entry,
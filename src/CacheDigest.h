@@ -34,7 +34,18 @@ public:
     /// changes mask size to fit newCapacity, resets bits to 0
     void updateCapacity(uint64_t newCapacity);
 
+    /// Starts maintaining a reference counter for each mask bit, turning
+    /// this digest into a counting Bloom filter that supports remove().
+    /// Resets the digest. The transmitted digest format is not affected.
+    void enableRemovals();
+
+    /// whether remove() can actually remove keys (see enableRemovals())
+    bool removable() const { return counters != nullptr; }
+
     void add(const cache_key * key);
+
+    /// Removes a previously added key if removals are enabled. Otherwise,
+    /// just counts deletion attempts.
     void remove(const cache_key * key);
 
     /// \returns true if the key belongs to the digest
@@ -56,6 +67,7 @@ public:
     uint64_t del_count;      /* number of deletions performed so far */
     uint64_t capacity;       /* expected maximum for .count, not a hard limit */
     char *mask;              /* bit mask */
+    uint8_t *counters;       ///< saturating per-bit reference counters or nil
     uint32_t mask_size;      /* mask size in bytes */
     int8_t bits_per_entry;   /* number of bits allocated for each entry from capacity */
 };
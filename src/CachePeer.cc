@@ -15,6 +15,7 @@
 #include "NeighborTypeDomainList.h"
 #include "pconn.h"
 #include "PeerDigest.h"
+#include "PeerHashRing.h"
 #include "PeerPoolMgr.h"
 #include "sbuf/Stream.h"
 #include "SquidConfig.h"
@@ -106,6 +107,20 @@ CachePeer::noteFailure()
     }
 }
 
+void
+CachePeer::noteConnectionOpened()
+{
+    ++stats.conn_open;
+    PeerHashRing::NoteConnectionOpened(*this);
+}
+
+void
+CachePeer::noteConnectionClosed()
+{
+    --stats.conn_open;
+    PeerHashRing::NoteConnectionClosed(*this);
+}
+
 void
 CachePeer::rename(const char * const newName)
 {
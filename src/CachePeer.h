@@ -17,6 +17,7 @@
 #include "icp_opcode.h"
 #include "ip/Address.h"
 #include "security/PeerOptions.h"
+#include "security/SessionResumption.h"
 
 #include <iosfwd>
 
@@ -39,6 +40,12 @@ public:
     /// reacts to a failed attempt to establish a connection to this cache_peer
     void noteFailure();
 
+    /// accounts for a new open connection to this cache_peer (see stats.conn_open)
+    void noteConnectionOpened();
+
+    /// accounts for a closed connection to this cache_peer (see stats.conn_open)
+    void noteConnectionClosed();
+
     /// (re)configure cache_peer name=value
     void rename(const char *);
 
@@ -142,6 +149,7 @@ public:
 #endif
         bool sourcehash = false;
         bool originserver = false;
+        bool http2 = false;
         bool no_tproxy = false;
         bool mcast_siblings = false;
         bool auth_no_keytab = false;
@@ -222,6 +230,9 @@ public:
 
     Security::SessionStatePointer sslSession;
 
+    /// TLS handshake outcomes for connections to this peer
+    Security::HandshakeCounters tlsHandshakes;
+
     int front_end_https = 0; ///< 0 - off, 1 - on, 2 - auto
     int connection_auth = 2; ///< 0 - off, 1 - on, 2 - auto
 
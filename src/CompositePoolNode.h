@@ -22,22 +22,23 @@
 class StoreEntry;
 
 /// \ingroup DelayPoolsAPI
-class CompositePoolNode : public RefCountable, public Updateable
+class CompositePoolNode : public RefCountable
 {
     MEMPROXY_CLASS(CompositePoolNode);
 
 public:
     typedef RefCount<CompositePoolNode> Pointer;
-    ~CompositePoolNode() override {}
+    ~CompositePoolNode() override;
 
     virtual void stats(StoreEntry * sentry) =0;
     virtual void dump(StoreEntry *entry) const =0;
-    void update(int incr) override =0;
     virtual void parse() = 0;
 
     class CompositeSelectionDetails;
     virtual DelayIdComposite::Pointer id(CompositeSelectionDetails &) = 0;
     void delayRead(const AsyncCallPointer &);
+    /// resumes deferred readers; called by DelayPools::scheduleWakeup()
+    void wakeup();
 
     /// \ingroup DelayPoolsAPI
     class CompositeSelectionDetails
@@ -58,6 +59,10 @@ public:
 protected:
     void kickReads();
     DelayedAsyncCalls deferredReads;
+
+private:
+    /// whether DelayPools will call our wakeup()
+    bool awaitingWakeup = false;
 };
 
 #endif /* USE_DELAY_POOLS */
@@ -15,6 +15,9 @@
 #include "DelaySpec.h"
 #include "SquidConfig.h"
 #include "Store.h"
+#include "time/gadgets.h"
+
+#include <limits>
 
 void
 DelayBucket::stats(StoreEntry *entry)const
@@ -23,11 +26,26 @@ DelayBucket::stats(StoreEntry *entry)const
 }
 
 void
-DelayBucket::update(DelaySpec const &rate, int incr)
+DelayBucket::update(DelaySpec const &rate, time_t incr)
 {
-    if (rate.restore_bps != -1 &&
-            (level() += rate.restore_bps * incr) > rate.max_bytes)
-        level() = rate.max_bytes;
+    if (rate.restore_bps == -1)
+        return;
+
+    // a long-idle bucket may have restored more than int can hold
+    const auto restored = static_cast<int64_t>(rate.restore_bps) * incr;
+    const auto limit = min(rate.max_bytes, static_cast<int64_t>(std::numeric_limits<int>::max()));
+    level() = static_cast<int>(min(level() + restored, limit));
+}
+
+void
+DelayBucket::refill(DelaySpec const &rate)
+{
+    const auto incr = squid_curtime - lastRefill_;
+    if (incr < 1)
+        return;
+
+    lastRefill_ = squid_curtime;
+    update(rate, incr);
 }
 
 int
@@ -48,6 +66,7 @@ DelayBucket::init(DelaySpec const &rate)
 {
     level() = (int) (((double)rate.max_bytes *
                       Config.Delay.initial) / 100);
+    lastRefill_ = squid_curtime;
 }
 
 #endif /* USE_DELAY_POOLS */
@@ -9,6 +9,8 @@
 #ifndef SQUID_SRC_DELAYBUCKET_H
 #define SQUID_SRC_DELAYBUCKET_H
 
+#include <ctime>
+
 class DelaySpec;
 class StoreEntry;
 
@@ -19,20 +21,24 @@ class DelayBucket
 {
 
 public:
-    DelayBucket() : level_(0) {}
+    DelayBucket() : level_(0), lastRefill_(0) {}
 
     int const& level() const {return level_;}
 
     int & level() {return level_;}
 
     void stats(StoreEntry *)const;
-    void update (DelaySpec const &, int incr);
+    /// adds bytes restored during incr seconds, up to the bucket maximum
+    void update(DelaySpec const &, time_t incr);
+    /// adds bytes restored since the last refill (or init) call
+    void refill(DelaySpec const &);
     int bytesWanted (int min, int max) const;
     void bytesIn(int qty);
     void init (DelaySpec const &);
 
 private:
     int level_;
+    time_t lastRefill_; ///< when refill() or init() was last called
 };
 
 #endif /* SQUID_SRC_DELAYBUCKET_H */
@@ -76,10 +76,28 @@ DelayPool::freeData()
 }
 
 // TODO: create DelayIdComposite.cc
+CompositePoolNode::~CompositePoolNode()
+{
+    if (awaitingWakeup)
+        DelayPools::cancelWakeup(this);
+}
+
 void
 CompositePoolNode::delayRead(const AsyncCall::Pointer &aRead)
 {
     deferredReads.delay(aRead);
+
+    if (!awaitingWakeup) {
+        awaitingWakeup = true;
+        DelayPools::scheduleWakeup(this);
+    }
+}
+
+void
+CompositePoolNode::wakeup()
+{
+    awaitingWakeup = false;
+    kickReads();
 }
 
 #include "comm.h"
@@ -11,8 +11,8 @@
 
 #include <vector>
 
+class CompositePoolNode;
 class DelayPool;
-class Updateable;
 class StoreEntry;
 
 /**
@@ -20,38 +20,32 @@ class StoreEntry;
  \ingroup Components
  */
 
-/// \ingroup DelayPoolsAPI
-class Updateable
-{
-
-public:
-    virtual ~Updateable() {}
-
-    virtual void update(int) = 0;
-};
-
 /// \ingroup DelayPoolsAPI
 class DelayPools
 {
 
 public:
     static void Init();
-    static void Update(void *);
     static unsigned short pools();
     static void pools(unsigned short pools);
     static void FreePools();
     static unsigned char *DelayClasses();
-    static void registerForUpdates(Updateable *);
-    static void deregisterForUpdates (Updateable *);
+    /// Resumes readers deferred by the given node when its buckets
+    /// are refilled. Buckets are refilled lazily, when used, so only nodes
+    /// with deferred readers need periodic attention.
+    static void scheduleWakeup(CompositePoolNode *);
+    /// forgets a scheduleWakeup() node (e.g., because it is being destroyed)
+    static void cancelWakeup(CompositePoolNode *);
     static DelayPool *delay_data;
 
 private:
     static void Stats(StoreEntry *);
     static void InitDelayData();
-    static time_t LastUpdate;
+    static void Wakeup(void *);
     static unsigned short pools_;
     static void FreeDelayData ();
-    static std::vector<Updateable *> toUpdate;
+    static std::vector<CompositePoolNode *> toWake; ///< scheduleWakeup() FIFO
+    static bool WakeupScheduled; ///< whether a Wakeup() event is pending
     static void RegisterWithCacheManager(void);
 };
 
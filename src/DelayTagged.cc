@@ -16,16 +16,10 @@
 #include "NullDelayId.h"
 #include "Store.h"
 
-DelayTagged::DelayTagged()
-{
-    DelayPools::registerForUpdates (this);
-}
-
 static Splay<DelayTaggedBucket::Pointer>::SPLAYFREE DelayTaggedFree;
 
 DelayTagged::~DelayTagged()
 {
-    DelayPools::deregisterForUpdates (this);
     buckets.destroy(DelayTaggedFree);
 }
 
@@ -43,9 +37,11 @@ DelayTaggedFree(DelayTaggedBucket::Pointer &)
 {}
 
 struct DelayTaggedStatsVisitor {
+    DelaySpec &spec;
     StoreEntry *sentry;
-    explicit DelayTaggedStatsVisitor(StoreEntry *se): sentry(se) {}
+    DelayTaggedStatsVisitor(DelaySpec &aSpec, StoreEntry *se): spec(aSpec), sentry(se) {}
     void operator() (DelayTaggedBucket::Pointer const &current) {
+        const_cast<DelayTaggedBucket *>(current.getRaw())->theBucket.refill(spec);
         current->stats(sentry);
     }
 };
@@ -65,7 +61,7 @@ DelayTagged::stats(StoreEntry * sentry)
         return;
     }
 
-    DelayTaggedStatsVisitor visitor(sentry);
+    DelayTaggedStatsVisitor visitor(spec, sentry);
     buckets.visit(visitor);
     storeAppendPrintf(sentry, "\n\n");
 }
@@ -76,30 +72,6 @@ DelayTagged::dump(StoreEntry *entry) const
     spec.dump(entry);
 }
 
-struct DelayTaggedUpdater {
-    DelayTaggedUpdater (DelaySpec &_spec, int _incr):spec(_spec),incr(_incr) {};
-
-    DelaySpec spec;
-    int incr;
-};
-
-struct DelayTaggedUpdateVisitor {
-    DelayTaggedUpdater *updater;
-    explicit DelayTaggedUpdateVisitor(DelayTaggedUpdater *u) : updater(u) {}
-    void operator() (DelayTaggedBucket::Pointer const &current) {
-        const_cast<DelayTaggedBucket *>(current.getRaw())->theBucket.update(updater->spec, updater->incr);
-    }
-};
-
-void
-DelayTagged::update(int incr)
-{
-    DelayTaggedUpdater updater(spec, incr);
-    DelayTaggedUpdateVisitor visitor(&updater);
-    buckets.visit(visitor);
-    kickReads();
-}
-
 void
 DelayTagged::parse()
 {
@@ -155,12 +127,14 @@ DelayTagged::Id::~Id()
 int
 DelayTagged::Id::bytesWanted (int min, int max) const
 {
+    theBucket->theBucket.refill(theTagged->spec);
     return theBucket->theBucket.bytesWanted(min,max);
 }
 
 void
 DelayTagged::Id::bytesIn(int qty)
 {
+    theBucket->theBucket.refill(theTagged->spec);
     theBucket->theBucket.bytesIn(qty);
 }
 
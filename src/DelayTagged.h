@@ -45,11 +45,9 @@ class DelayTagged : public CompositePoolNode
 public:
     typedef RefCount<DelayTagged> Pointer;
 
-    DelayTagged();
     ~DelayTagged() override;
     void stats(StoreEntry * sentry) override;
     void dump(StoreEntry *entry) const override;
-    void update(int incr) override;
     void parse() override;
 
     DelayIdComposite::Pointer id(CompositeSelectionDetails &) override;
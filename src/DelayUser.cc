@@ -18,16 +18,10 @@
 #include "NullDelayId.h"
 #include "Store.h"
 
-DelayUser::DelayUser()
-{
-    DelayPools::registerForUpdates (this);
-}
-
 static Splay<DelayUserBucket::Pointer>::SPLAYFREE DelayUserFree;
 
 DelayUser::~DelayUser()
 {
-    DelayPools::deregisterForUpdates (this);
     buckets.destroy(DelayUserFree);
 }
 
@@ -49,9 +43,11 @@ DelayUserFree(DelayUserBucket::Pointer &)
 {}
 
 struct DelayUserStatsVisitor {
+    DelaySpec &spec;
     StoreEntry *se;
-    explicit DelayUserStatsVisitor(StoreEntry *s) : se(s) {}
+    DelayUserStatsVisitor(DelaySpec &aSpec, StoreEntry *s) : spec(aSpec), se(s) {}
     void operator() (DelayUserBucket::Pointer const &current) {
+        const_cast<DelayUserBucket *>(current.getRaw())->theBucket.refill(spec);
         current->stats(se);
     }
 };
@@ -71,7 +67,7 @@ DelayUser::stats(StoreEntry * sentry)
         return;
     }
 
-    DelayUserStatsVisitor visitor(sentry);
+    DelayUserStatsVisitor visitor(spec, sentry);
     buckets.visit(visitor);
     storeAppendPrintf(sentry, "\n\n");
 }
@@ -82,29 +78,6 @@ DelayUser::dump(StoreEntry *entry) const
     spec.dump(entry);
 }
 
-struct DelayUserUpdater {
-    DelayUserUpdater (DelaySpec &_spec, int _incr):spec(_spec),incr(_incr) {};
-
-    DelaySpec spec;
-    int incr;
-};
-
-struct DelayUserUpdateVisitor {
-    DelayUserUpdater *t;
-    DelayUserUpdateVisitor(DelayUserUpdater *updater) : t(updater) {}
-    void operator() (DelayUserBucket::Pointer const &current) {
-        const_cast<DelayUserBucket *>(current.getRaw())->theBucket.update(t->spec, t->incr);
-    }
-};
-
-void
-DelayUser::update(int incr)
-{
-    DelayUserUpdater updater(spec, incr);
-    DelayUserUpdateVisitor visitor(&updater);
-    buckets.visit(visitor);
-}
-
 void
 DelayUser::parse()
 {
@@ -161,12 +134,14 @@ DelayUser::Id::~Id()
 int
 DelayUser::Id::bytesWanted (int min, int max) const
 {
+    theBucket->theBucket.refill(theUser->spec);
     return theBucket->theBucket.bytesWanted(min,max);
 }
 
 void
 DelayUser::Id::bytesIn(int qty)
 {
+    theBucket->theBucket.refill(theUser->spec);
     theBucket->theBucket.bytesIn(qty);
 }
 
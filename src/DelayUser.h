@@ -43,11 +43,9 @@ class DelayUser : public CompositePoolNode
 
 public:
     typedef RefCount<DelayUser> Pointer;
-    DelayUser();
     ~DelayUser() override;
     void stats(StoreEntry * sentry) override;
     void dump(StoreEntry *entry) const override;
-    void update(int incr) override;
     void parse() override;
 
     DelayIdComposite::Pointer id(CompositeSelectionDetails &) override;
@@ -16,16 +16,6 @@
 #include "comm/Connection.h"
 #include "DelayVector.h"
 
-DelayVector::DelayVector()
-{
-    DelayPools::registerForUpdates (this);
-}
-
-DelayVector::~DelayVector()
-{
-    DelayPools::deregisterForUpdates (this);
-}
-
 void
 DelayVector::stats(StoreEntry * sentry)
 {
@@ -48,17 +38,6 @@ DelayVector::dump(StoreEntry *entry) const
     }
 }
 
-void
-DelayVector::update(int)
-{
-    /*
-     * Each pool updates itself,
-     * but we may have deferred reads waiting on the pool as a whole.
-     */
-
-    kickReads();
-}
-
 void
 DelayVector::parse()
 {
@@ -21,11 +21,8 @@ class DelayVector : public CompositePoolNode
 
 public:
     typedef RefCount<DelayVector> Pointer;
-    DelayVector();
-    ~DelayVector() override;
     void stats(StoreEntry * sentry) override;
     void dump(StoreEntry *entry) const override;
-    void update(int incr) override;
     void parse() override;
 
     DelayIdComposite::Pointer id(CompositeSelectionDetails &) override;
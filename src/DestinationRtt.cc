@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 17    Request Forwarding */
+
+#include "squid.h"
+#include "base/ClpMap.h"
+#include "debug/Stream.h"
+#include "DestinationRtt.h"
+#include "ip/Address.h"
+#include "sbuf/Algorithms.h"
+#include "SquidConfig.h"
+
+/// srtt weight of a new connection opening time sample (as in RFC 6298)
+static const double RttGain = 1.0/8;
+
+/// failures weight of a new connection attempt outcome
+static const double FailureGain = 1.0/4;
+
+/// a binary IPv6 (or IPv4-mapped) address
+using DestinationKey = SBuf;
+
+using DestinationRtts = ClpMap<DestinationKey, DestinationRtt>;
+
+/// learned destination histories or nil (when learning is disabled)
+static DestinationRtts *TheRtts = nullptr;
+
+/// TheRtts, (re)configured in accordance with happy_eyeballs_rtt_cache_size
+static DestinationRtts *
+Rtts()
+{
+    const auto limit = Config.happyEyeballs.rtt_cache_size;
+    if (!limit) {
+        delete TheRtts;
+        TheRtts = nullptr;
+        return nullptr;
+    }
+
+    if (!TheRtts)
+        TheRtts = new DestinationRtts(limit);
+    else if (TheRtts->memLimit() != limit)
+        TheRtts->setMemLimit(limit);
+    return TheRtts;
+}
+
+static DestinationKey
+MakeKey(const Ip::Address &address)
+{
+    struct in6_addr raw;
+    address.getInAddr(raw);
+    return DestinationKey(reinterpret_cast<const char *>(&raw), sizeof(raw));
+}
+
+/// applies the given update to the (possibly new) history of the address
+template <class Updater>
+static void
+UpdateRtt(const Ip::Address &address, const Updater &update)
+{
+    const auto rtts = Rtts();
+    if (!rtts)
+        return;
+
+    const auto key = MakeKey(address);
+    DestinationRtt history;
+    if (const auto known = rtts->get(key))
+        history = *known;
+    update(history);
+    debugs(17, 7, address << " srtt=" << history.srtt << " failures=" << history.failures);
+    (void)rtts->add(key, history);
+}
+
+void
+DestinationRtt::NoteSuccess(const Ip::Address &address, const double connectSeconds)
+{
+    UpdateRtt(address, [connectSeconds](DestinationRtt &history) {
+        if (history.hasRtt)
+            history.srtt += RttGain * (connectSeconds - history.srtt);
+        else
+            history.srtt = connectSeconds;
+        history.hasRtt = true;
+        history.failures -= FailureGain * history.failures;
+    });
+}
+
+void
+DestinationRtt::NoteFailure(const Ip::Address &address)
+{
+    UpdateRtt(address, [](DestinationRtt &history) {
+        history.failures += FailureGain * (1 - history.failures);
+    });
+}
+
+const DestinationRtt *
+DestinationRtt::Find(const Ip::Address &address)
+{
+    const auto rtts = Rtts();
+    return rtts ? rtts->get(MakeKey(address)) : nullptr;
+}
+
+double
+DestinationRtt::cost() const
+{
+    // a failed attempt usually costs us a connect_timeout wait
+    const auto failureCost = failures * Config.Timeout.connect;
+    return hasRtt ? (1 - failures) * srtt + failureCost : failureCost;
+}
+
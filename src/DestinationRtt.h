@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_DESTINATIONRTT_H
+#define SQUID_SRC_DESTINATIONRTT_H
+
+#include "ip/forward.h"
+
+/// Learned TCP connection establishment history of a single to-server
+/// destination IP address: Exponentially weighted moving averages of
+/// connection opening times and failures. HappyConnOpener uses these
+/// estimates to order same-family candidate paths and to shorten its wait
+/// for primary connections. The history of each worker is kept in a bounded
+/// map (see happy_eyeballs_rtt_cache_size).
+class DestinationRtt
+{
+public:
+    /// accounts for a successfully opened connection to the given address
+    static void NoteSuccess(const Ip::Address &, double connectSeconds);
+
+    /// accounts for a failed connection attempt to the given address
+    static void NoteFailure(const Ip::Address &);
+
+    /// \returns learned history of the given address (or nil)
+    /// The returned pointer is invalidated by other DestinationRtt calls.
+    static const DestinationRtt *Find(const Ip::Address &);
+
+    /// estimated connection opening time (in seconds), including expected
+    /// connection failure costs
+    double cost() const;
+
+    /// whether most recent connection attempts to this destination failed
+    bool failing() const { return failures >= 0.5; }
+
+    double srtt = 0; ///< smoothed successful connection opening time (seconds)
+    double failures = 0; ///< smoothed connection failure ratio [0, 1]
+    bool hasRtt = false; ///< whether srtt is based on at least one success
+};
+
+#endif /* SQUID_SRC_DESTINATIONRTT_H */
+
@@ -20,6 +20,7 @@
 #include "CachePeer.h"
 #include "client_side.h"
 #include "clients/forward.h"
+#include "clients/Http2Session.h"
 #include "clients/HttpTunneler.h"
 #include "clients/WhoisGateway.h"
 #include "comm/Connection.h"
@@ -55,6 +56,7 @@
 #include "ssl/PeekingPeerConnector.h"
 #include "Store.h"
 #include "StoreClient.h"
+#include "TransactionTrace.h"
 #include "urn.h"
 #if USE_OPENSSL
 #include "ssl/cert_validate_message.h"
@@ -109,6 +111,12 @@ FwdState::closeServerConnection(const char *reason)
 {
     debugs(17, 3, "because " << reason << "; " << serverConn);
     assert(Comm::IsConnOpen(serverConn));
+    if (flags.multiplexed) {
+        // other transactions use this connection; our HttpStateData job
+        // will notice the aborted entry and close its stream
+        unregister(serverConn);
+        return;
+    }
     comm_remove_close_handler(serverConn->fd, closeHandler);
     closeHandler = nullptr;
     fwdPconnPool->noteUses(fd_table[serverConn->fd].pconn.uses);
@@ -138,6 +146,7 @@ FwdState::FwdState(const Comm::ConnectionPointer &client, StoreEntry * e, HttpRe
     flags.dont_retry = false;
     flags.forward_completed = false;
     flags.destinationsFound = false;
+    flags.multiplexed = false;
     debugs(17, 3, "FwdState constructed, this=" << this);
 }
 
@@ -756,7 +765,8 @@ FwdState::serverClosed()
     if (Comm::IsConnOpen(serverConn)) {
         const auto uses = fd_table[serverConn->fd].pconn.uses;
         debugs(17, 3, "prior uses: " << uses);
-        fwdPconnPool->noteUses(uses); // XXX: May not have come from fwdPconnPool
+        if (!flags.multiplexed) // Http::Two::Session accounts for its uses
+            fwdPconnPool->noteUses(uses); // XXX: May not have come from fwdPconnPool
         serverConn->noteClosure();
     }
     serverConn = nullptr;
@@ -842,6 +852,7 @@ FwdState::noteConnection(HappyConnOpener::Answer &answer)
     assert(!destinationReceipt);
 
     transportWait.finish();
+    request->masterXaction->phases.stop(TransactionPhases::tcpConnect);
 
     updateAttempts(answer.n_tries);
 
@@ -868,6 +879,7 @@ FwdState::noteConnection(HappyConnOpener::Answer &answer)
         destinationReceipt = answer.conn;
         assert(destinationReceipt);
         // serverConn remains nil until syncWithServerConn()
+        TransactionTrace::Note(request->masterXaction, TransactionTrace::Milestone::connected);
     }
 
     if (error) {
@@ -1004,8 +1016,16 @@ FwdState::secureConnectionToPeer(const Comm::ConnectionPointer &conn)
         connector = new Ssl::PeekingPeerConnector(requestPointer, conn, clientConn, callback, al, sslNegotiationTimeout);
     else
 #endif
-        connector = new Security::BlindPeerConnector(requestPointer, conn, callback, al, sslNegotiationTimeout);
+    {
+        const auto blindConnector = new Security::BlindPeerConnector(requestPointer, conn, callback, al, sslNegotiationTimeout);
+#if USE_OPENSSL
+        if (!conn->getPeer() && Config.ssl_client.originEarlyData)
+            blindConnector->offerEarlyData(HttpStateData::EarlyRequest(request, entry, al));
+#endif
+        connector = blindConnector;
+    }
     connector->noteFwdPconnUse = true;
+    request->masterXaction->phases.start(TransactionPhases::tlsHandshake);
     encryptionWait.start(connector, callback);
 }
 
@@ -1014,6 +1034,7 @@ void
 FwdState::connectedToPeer(Security::EncryptorAnswer &answer)
 {
     encryptionWait.finish();
+    request->masterXaction->phases.stop(TransactionPhases::tlsHandshake);
 
     ErrorState *error = nullptr;
     if ((error = answer.error.get())) {
@@ -1066,6 +1087,7 @@ FwdState::syncWithServerConn(const Comm::ConnectionPointer &conn, const char *ho
 {
     Must(IsConnOpen(conn));
     serverConn = conn;
+    flags.multiplexed = false; // dispatch() decides
     // no effect on destinationReceipt (which may even be nil here)
 
     closeHandler = comm_add_close_handler(serverConn->fd,  fwdServerClosedWrapper, this);
@@ -1141,6 +1163,7 @@ FwdState::connectStart()
     cs->setRetriable(retriable);
     cs->allowPersistent(pconnRace != raceHappened);
     destinations->notificationPending = true; // start() is async
+    request->masterXaction->phases.start(TransactionPhases::tcpConnect);
     transportWait.start(cs, callback);
 }
 
@@ -1250,6 +1273,8 @@ FwdState::dispatch()
     if (const auto peer = serverConnection()->getPeer()) {
         ++peer->stats.fetches;
         request->prepForPeering(*peer);
+        // HappyConnOpener gives such requests fresh or HTTP/2 connections
+        flags.multiplexed = Http::Two::Session::CanForward(*request, *peer);
         httpStart(this);
     } else {
         assert(!request->flags.sslPeek);
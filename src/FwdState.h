@@ -137,6 +137,9 @@ public:
     /** return a ConnectionPointer to the current server connection (may or may not be open) */
     Comm::ConnectionPointer const & serverConnection() const { return serverConn; };
 
+    /// whether serverConnection() is shared with other transactions via HTTP/2
+    bool multiplexedServerConnection() const { return flags.multiplexed; }
+
 private:
     // hidden for safer management of self; use static fwdStart
     FwdState(const Comm::ConnectionPointer &client, StoreEntry *, HttpRequest *, const AccessLogEntryPointer &alp);
@@ -214,6 +217,7 @@ private:
         bool dont_retry;
         bool forward_completed;
         bool destinationsFound; ///< at least one candidate path found
+        bool multiplexed; ///< serverConn is owned by an Http::Two::Session
     } flags;
 
     /// waits for a transport connection to the peer to be established/opened
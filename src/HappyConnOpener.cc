@@ -11,12 +11,15 @@
 #include "base/AsyncCallbacks.h"
 #include "base/CodeContext.h"
 #include "CachePeer.h"
+#include "clients/Http2Session.h"
+#include "DestinationRtt.h"
 #include "errorpage.h"
 #include "FwdState.h"
 #include "HappyConnOpener.h"
 #include "HttpRequest.h"
 #include "ip/QosConfig.h"
 #include "neighbors.h"
+#include "OriginPoolMgr.h"
 #include "pconn.h"
 #include "PeerPoolMgr.h"
 #include "sbuf/Stream.h"
@@ -42,11 +45,12 @@ CBDATA_CLASS_INIT(HappyConnOpener);
 // be scheduled in vain because external factors would speed up (or make
 // unnecessary) spare connection attempts, canceling the wait.
 //
-// This optimization is possible only where each job needs to pause for the same
-// amount of time, creating a naturally ordered list of jobs waiting to be
-// resumed. This is why two HappyOrderEnforcers are needed to efficiently honor
-// both happy_eyeballs_connect_timeout and happy_eyeballs_connect_gap
-// directives.
+// This optimization is possible only where jobs are queued in the order of their
+// wait end times. When each job needs to pause for the same amount of time,
+// that order is natural. Otherwise, enqueue() finds the right place for the job,
+// usually near the end of the queue. This is why two HappyOrderEnforcers are
+// needed to efficiently honor both happy_eyeballs_connect_timeout (adjusted by
+// DestinationRtt) and happy_eyeballs_connect_gap directives.
 
 /// Efficiently drains a FIFO HappyConnOpener queue while delaying each "pop"
 /// event by the time determined by the top element currently in the queue. Its
@@ -72,6 +76,10 @@ protected:
     virtual bool readyNow(const HappyConnOpener &) const = 0;
     virtual AsyncCall::Pointer notify(const CbcPointer<HappyConnOpener> &) = 0;
 
+    /// when the given job wait should end; jobs_ are sorted by this value
+    /// the default zero value for all jobs preserves the FIFO queuing order
+    virtual HappyAbsoluteTime waitEnd(const HappyConnOpener &) const { return 0; }
+
     bool waiting() const { return waitEnd_ > 0; }
     bool startedWaiting(const HappyAbsoluteTime lastStart, const int cfgTimeoutMsec) const;
 
@@ -106,6 +114,7 @@ public:
 private:
     /* HappyOrderEnforcer API */
     AsyncCall::Pointer notify(const CbcPointer<HappyConnOpener> &) override;
+    HappyAbsoluteTime waitEnd(const HappyConnOpener &) const override;
 };
 
 /// enforces happy_eyeballs_connect_gap and happy_eyeballs_connect_limit
@@ -152,8 +161,18 @@ void
 HappyOrderEnforcer::enqueue(HappyConnOpener &job)
 {
     Must(!job.spareWaiting.callback);
-    jobs_.emplace_back(&job);
-    job.spareWaiting.position = std::prev(jobs_.end());
+
+    // keep jobs_ ordered by their wait end times (FIFO for equal times)
+    const auto jobWaitEnd = waitEnd(job);
+    auto pos = jobs_.end();
+    while (pos != jobs_.begin()) {
+        const auto previous = std::prev(pos)->valid();
+        if (!previous || waitEnd(*previous) <= jobWaitEnd)
+            break;
+        --pos;
+    }
+
+    job.spareWaiting.position = jobs_.emplace(pos, &job);
     job.spareWaiting.codeContext = CodeContext::Current();
 }
 
@@ -233,7 +252,14 @@ HappyOrderEnforcer::noteWaitOver()
 bool
 PrimeChanceGiver::readyNow(const HappyConnOpener &job) const
 {
-    return !startedWaiting(job.primeStart, Config.happyEyeballs.connect_timeout);
+    return !startedWaiting(job.primeStart, job.primeChanceTimeout);
+}
+
+HappyAbsoluteTime
+PrimeChanceGiver::waitEnd(const HappyConnOpener &job) const
+{
+    // mimics startedWaiting() calculations
+    return job.primeStart + static_cast<HappyAbsoluteTime>(job.primeChanceTimeout) * Config.workers / 1000.0;
 }
 
 AsyncCall::Pointer
@@ -559,7 +585,22 @@ HappyConnOpener::reuseOldConnection(PeerConnectionPointer &dest)
 {
     assert(allowPconn_);
 
-    if (const auto pconn = fwdPconnPool->pop(dest, host_, retriable_)) {
+    // HTTP/2 peer connections are shared rather than pooled
+    if (const auto peer = dest->getPeer()) {
+        if (Http::Two::Session::CanForward(*cause, *peer)) {
+            if (const auto shared = Http::Two::Session::Find(*dest)) {
+                ++n_tries;
+                dest.finalize(shared);
+                sendSuccess(dest, true, "shared HTTP/2 connection");
+                return true;
+            }
+            return false;
+        }
+    }
+
+    const auto pconn = fwdPconnPool->pop(dest, host_, retriable_);
+    OriginPoolMgr::NoteDemand(*cause, dest, host_, pconn);
+    if (pconn) {
         ++n_tries;
         dest.finalize(pconn);
         sendSuccess(dest, true, "reused connection");
@@ -590,6 +631,7 @@ HappyConnOpener::openFreshConnection(Attempt &attempt, PeerConnectionPointer &de
         cs->setHost(host_);
 
     attempt.path = dest; // but not the being-opened conn!
+    attempt.startTime = current_dtime;
     attempt.connWait.start(cs, callConnect);
 }
 
@@ -620,15 +662,19 @@ HappyConnOpener::handleConnOpenerAnswer(Attempt &attempt, const CommConnectCbPar
     // finalize the previously selected path before attempt.finish() forgets it
     auto handledPath = attempt.path;
     handledPath.finalize(params.conn); // closed on errors
+    const auto connectTime = current_dtime - attempt.startTime;
     attempt.finish();
 
     ++n_tries;
 
     if (params.flag == Comm::OK) {
+        DestinationRtt::NoteSuccess(params.conn->remote, connectTime);
         sendSuccess(handledPath, false, what);
         return;
     }
 
+    DestinationRtt::NoteFailure(params.conn->remote);
+
     debugs(17, 8, what << " failed: " << params.conn);
 
     // remember the last failure (we forward it if we cannot connect anywhere)
@@ -777,6 +823,30 @@ HappyConnOpener::noteSpareAllowance()
     startConnecting(spare, dest);
 }
 
+/// happy_eyeballs_connect_timeout adjusted for the learned connection history
+/// of the given prime destination
+static int
+PrimeChanceTimeout(const Comm::Connection &prime)
+{
+    const auto configured = Config.happyEyeballs.connect_timeout;
+    const auto history = DestinationRtt::Find(prime.remote);
+    if (!history)
+        return configured;
+
+    if (history->failing()) {
+        debugs(17, 7, "no prime chance for failing " << prime.remote);
+        return 0;
+    }
+
+    if (!history->hasRtt)
+        return configured;
+
+    // give the prime connection twice its usual opening time, but honor the
+    // RFC 8305 minimum of 10 milliseconds
+    const auto learned = static_cast<int>(2000 * history->srtt);
+    return std::min(configured, std::max(learned, 10));
+}
+
 /// starts a prime connection attempt if possible or does nothing otherwise
 void
 HappyConnOpener::maybeOpenPrimeConnection()
@@ -792,6 +862,7 @@ HappyConnOpener::maybeOpenPrimeConnection()
         Must(currentPeer);
         debugs(17, 7, "new peer " << *currentPeer);
         primeStart = current_dtime;
+        primeChanceTimeout = PrimeChanceTimeout(*currentPeer);
         startConnecting(prime, newPrime);
         if (done()) // probably reused a pconn
             return;
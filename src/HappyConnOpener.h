@@ -133,6 +133,10 @@ public:
     /// the start of the first connection attempt for the currentPeer
     HappyAbsoluteTime primeStart = 0;
 
+    /// happy_eyeballs_connect_timeout adjusted for the learned connection
+    /// history of the first currentPeer destination (in milliseconds)
+    int primeChanceTimeout = 0;
+
 private:
     /// a connection opening attempt in progress (or falsy)
     class Attempt {
@@ -152,6 +156,9 @@ private:
 
         PeerConnectionPointer path; ///< the destination we are connecting to
 
+        /// when we started connecting to the path (for DestinationRtt)
+        HappyAbsoluteTime startTime = 0;
+
         /// waits for a connection to the peer to be established/opened
         JobWait<Comm::ConnOpener> connWait;
 
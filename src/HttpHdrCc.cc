@@ -41,6 +41,7 @@ constexpr LookupTable<HttpHdrCcType>::Record attrsList[] = {
     {"min-fresh", HttpHdrCcType::CC_MIN_FRESH},
     {"only-if-cached", HttpHdrCcType::CC_ONLY_IF_CACHED},
     {"stale-if-error", HttpHdrCcType::CC_STALE_IF_ERROR},
+    {"stale-while-revalidate", HttpHdrCcType::CC_STALE_WHILE_REVALIDATE},
     {"immutable", HttpHdrCcType::CC_IMMUTABLE},
     {"Other,", HttpHdrCcType::CC_OTHER}, /* ',' will protect from matches */
     {nullptr, HttpHdrCcType::CC_ENUM_END}
@@ -193,6 +194,15 @@ HttpHdrCc::parse(const String & str)
             }
             break;
 
+        case HttpHdrCcType::CC_STALE_WHILE_REVALIDATE:
+            if (!p || !httpHeaderParseInt(p, &stale_while_revalidate) || stale_while_revalidate < 0) {
+                debugs(65, 2, "cc: invalid stale-while-revalidate specs near '" << item << "'");
+                clearStaleWhileRevalidate();
+            } else {
+                setMask(type,true);
+            }
+            break;
+
         case HttpHdrCcType::CC_PRIVATE: {
             String temp;
             if (!p)  {
@@ -322,6 +332,9 @@ HttpHdrCc::packInto(Packable * p) const
             case HttpHdrCcType::CC_STALE_IF_ERROR:
                 p->appendf("=%d", stale_if_error);
                 break;
+            case HttpHdrCcType::CC_STALE_WHILE_REVALIDATE:
+                p->appendf("=%d", stale_while_revalidate);
+                break;
             case HttpHdrCcType::CC_IMMUTABLE:
                 break;
             case HttpHdrCcType::CC_OTHER:
@@ -13,6 +13,7 @@
 #include "acl/FilledChecklist.h"
 #include "base/EnumIterator.h"
 #include "globals.h"
+#include "http/Compressor.h"
 #include "http/ContentLengthInterpreter.h"
 #include "HttpBody.h"
 #include "HttpHdrCc.h"
@@ -22,11 +23,14 @@
 #include "HttpRequest.h"
 #include "MemBuf.h"
 #include "sbuf/Stream.h"
+#include "sbuf/StringConvert.h"
 #include "SquidConfig.h"
 #include "SquidMath.h"
 #include "Store.h"
 #include "StrList.h"
 
+#include <optional>
+
 HttpReply::HttpReply():
     Http::Message(hoReply),
     date(0),
@@ -264,13 +268,27 @@ HttpReply::validatorsMatch(HttpReply const * otherRep) const
 HttpReply::Pointer
 HttpReply::recreateOnNotModified(const HttpReply &reply304) const
 {
+    // A 304 for a response we compressed carries the entity tag of the
+    // origin server representation. Keep the tag of the compressed one.
+    const HttpHeader *fresh = &reply304.header;
+    std::optional<HttpHeader> withoutETag;
+    if (fresh->has(Http::HdrType::ETAG)) {
+        auto ourTag = StringToSBuf(header.getStrOrList(Http::HdrType::ETAG));
+        if (Http::Compressor::RemoveETagCoding(ourTag, StringToSBuf(header.getList(Http::HdrType::CONTENT_ENCODING))) &&
+                ourTag == StringToSBuf(fresh->getStrOrList(Http::HdrType::ETAG))) {
+            withoutETag.emplace(*fresh);
+            withoutETag->delById(Http::HdrType::ETAG);
+            fresh = &withoutETag.value();
+        }
+    }
+
     // If enough 304s do not update, then this expensive checking is cheaper
     // than blindly storing reply prefix identical to the already stored one.
-    if (!header.needUpdate(&reply304.header))
+    if (!header.needUpdate(fresh))
         return nullptr;
 
     const Pointer cloned = clone();
-    cloned->header.update(&reply304.header);
+    cloned->header.update(fresh);
     cloned->hdrCacheClean();
     cloned->header.compact();
     cloned->hdrCacheInit();
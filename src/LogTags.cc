@@ -50,6 +50,8 @@ const char * LogTags::Str_[] = {
     "TCP_OFFLINE_HIT",
     "TCP_REDIRECT",
     "TCP_TUNNEL",
+    "TCP_PARTIAL_HIT",
+    "TCP_STALE_HIT",
     "UDP_HIT",
     "UDP_MISS",
     "UDP_DENIED",
@@ -117,7 +119,9 @@ LogTags::isTcpHit() const
         (oldType == LOG_TCP_REFRESH_UNMODIFIED) ||
         (oldType == LOG_TCP_NEGATIVE_HIT) ||
         (oldType == LOG_TCP_MEM_HIT) ||
-        (oldType == LOG_TCP_OFFLINE_HIT);
+        (oldType == LOG_TCP_OFFLINE_HIT) ||
+        (oldType == LOG_TCP_PARTIAL_HIT) ||
+        (oldType == LOG_TCP_STALE_HIT);
 }
 
 const char *
@@ -136,6 +140,8 @@ LogTags::cacheStatusSource() const
     case LOG_TCP_NEGATIVE_HIT:
     case LOG_TCP_MEM_HIT:
     case LOG_TCP_OFFLINE_HIT:
+    case LOG_TCP_PARTIAL_HIT:
+    case LOG_TCP_STALE_HIT:
         // We put LOG_TCP_REFRESH_UNMODIFIED and LOG_TCP_REFRESH_FAIL_OLD here
         // because the specs probably classify master transactions where the
         // client request did "go forward" but the to-client response was
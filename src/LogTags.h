@@ -57,6 +57,8 @@ typedef enum {
     LOG_TCP_OFFLINE_HIT,
     LOG_TCP_REDIRECT,
     LOG_TCP_TUNNEL, ///< an attempt to establish a bidirectional TCP tunnel
+    LOG_TCP_PARTIAL_HIT, ///< a Range request served from RangeCache
+    LOG_TCP_STALE_HIT, ///< a stale hit served while being refreshed in the background
     LOG_UDP_HIT,
     LOG_UDP_MISS,
     LOG_UDP_DENIED,
@@ -15,6 +15,7 @@
 #include "base/Lock.h"
 #include "base/RefCount.h"
 #include "comm/forward.h"
+#include "TransactionPhases.h"
 #include "XactionInitiator.h"
 
 /** Master transaction details.
@@ -71,6 +72,9 @@ public:
     /// whether we are currently creating a CONNECT header (to be sent to peer)
     bool generatingConnect = false;
 
+    /// time spent in various transaction processing phases
+    TransactionPhases phases;
+
     // TODO: add state from other Jobs in the transaction
 
 private:
@@ -29,6 +29,7 @@ typedef void STMCB (void *data, StoreIOBuffer wroteBuffer);
 
 class store_client;
 class PeerSelector;
+class RefreshPattern;
 
 class MemObject
 {
@@ -220,6 +221,15 @@ public:
 
     SBuf vary_headers;
 
+    /// the refresh_pattern rule matching storeId() (possibly nil) and the
+    /// refresh_pattern configuration generation it was looked up in
+    /// \sa refreshLimits(const MemObject &)
+    struct RefreshRule {
+        const RefreshPattern *rule = nullptr;
+        uint64_t generation = 0; ///< zero means "not looked up yet"
+    };
+    mutable RefreshRule refreshRule;
+
     void delayRead(const AsyncCallPointer &);
     void kickReads();
 
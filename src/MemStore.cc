@@ -14,6 +14,7 @@
 #include "HttpReply.h"
 #include "ipc/mem/Page.h"
 #include "ipc/mem/Pages.h"
+#include "md5.h"
 #include "MemObject.h"
 #include "MemStore.h"
 #include "mime_header.h"
@@ -163,6 +164,8 @@ ShmWriter::copyToShmSlice(Ipc::StoreMap::Slice &slice)
 
 MemStore::MemStore(): map(nullptr), lastWritingSlice(-1)
 {
+    if (Config.onoff.memory_cache_admission)
+        admission.reset(new Store::Admission("cache_mem"));
 }
 
 MemStore::~MemStore()
@@ -197,7 +200,7 @@ MemStore::init()
     extras = shm_old(Extras)(ExtrasLabel);
 
     Must(!map);
-    map = new MemStoreMap(SBuf(MapLabel));
+    map = new MemStoreMap(SBuf(MapLabel), Config.memCacheEviction);
     map->cleaner = this;
 }
 
@@ -257,6 +260,8 @@ MemStore::stat(StoreEntry &e) const
                 stats.dump(e);
             }
         }
+
+        map->packEvictionStatsInto(e);
     }
 }
 
@@ -649,6 +654,19 @@ MemStore::shouldCache(StoreEntry &e) const
         return false;
     }
 
+    if (admission) {
+        // without enough free pages, copyToShm() will purge other entries
+        const auto pagesNeeded = ramSize/Ipc::Mem::PageSize() + 1;
+        const auto full = Ipc::Mem::PagesAvailable(Ipc::Mem::PageId::cachePage) < pagesNeeded;
+        const auto key = reinterpret_cast<const cache_key *>(e.key);
+        cache_key victimKey[SQUID_MD5_DIGEST_LENGTH];
+        const auto victim = map->peekVictim(key, full, victimKey) ? victimKey : nullptr;
+        if (!admission->admit(key, victim)) {
+            debugs(20, 5, "not admitted: " << e);
+            return false;
+        }
+    }
+
     return true;
 }
 
@@ -1049,7 +1067,7 @@ MemStoreRr::create()
     Must(!spaceOwner);
     spaceOwner = shm_new(Ipc::Mem::PageStack)(SpaceLabel, spaceConfig);
     Must(!mapOwner);
-    mapOwner = MemStoreMap::Init(SBuf(MapLabel), entryLimit);
+    mapOwner = MemStoreMap::Init(SBuf(MapLabel), entryLimit, Config.memCacheEviction);
     Must(!extrasOwner);
     extrasOwner = shm_new(MemStoreMapExtras)(ExtrasLabel, entryLimit);
 }
@@ -13,8 +13,11 @@
 #include "ipc/mem/PageStack.h"
 #include "ipc/StoreMap.h"
 #include "Store.h"
+#include "store/Admission.h"
 #include "store/Controlled.h"
 
+#include <memory>
+
 // StoreEntry restoration info not already stored by Ipc::StoreMap
 struct MemStoreMapExtraItem {
     Ipc::Mem::PageId page; ///< shared memory page with entry slice content
@@ -99,6 +102,9 @@ private:
     Ipc::Mem::Pointer<Ipc::Mem::PageStack> freeSlots; ///< unused map slot IDs
     MemStoreMap *map; ///< index of mem-cached entries
 
+    /// memory_cache_admission filter (if configured)
+    std::unique_ptr<Store::Admission> admission;
+
     typedef MemStoreMapExtras Extras;
     Ipc::Mem::Pointer<Extras> extras; ///< IDs of pages with slice data
 
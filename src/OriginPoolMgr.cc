@@ -0,0 +1,322 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 48    Persistent Connections */
+
+#include "squid.h"
+#include "base/AsyncCallbacks.h"
+#include "comm/Connection.h"
+#include "comm/ConnOpener.h"
+#include "event.h"
+#include "FadingCounter.h"
+#include "fd.h"
+#include "fde.h"
+#include "FwdState.h"
+#include "globals.h"
+#include "HttpRequest.h"
+#include "MasterXaction.h"
+#include "neighbors.h"
+#include "OriginPoolMgr.h"
+#include "pconn.h"
+#include "sbuf/Algorithms.h"
+#include "sbuf/Stream.h"
+#include "security/BlindPeerConnector.h"
+#include "SquidConfig.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+CBDATA_CLASS_INIT(OriginConnPrewarmer);
+
+namespace {
+
+/// recent connection needs of a single origin server destination
+class OriginDemand
+{
+public:
+    OriginDemand(const Comm::ConnectionPointer &aProfile, const SBuf &aDomain, const bool aSecure):
+        profile(aProfile), domain(aDomain), secure(aSecure) {}
+
+    /// the domain parameter for PconnPool APIs
+    const char *poolDomain() { return domain.isEmpty() ? nullptr : domain.c_str(); }
+
+    Comm::ConnectionPointer profile; ///< destination address and local settings
+    SBuf domain; ///< origin server name; a part of fwdPconnPool key
+    bool secure; ///< whether connections to this destination use TLS
+
+    FadingCounter needs; ///< all recent connection needs
+    /// recent needs that fwdPconnPool could not satisfy with a previously
+    /// used connection (i.e. fresh connection openings and prewarmed reuses)
+    FadingCounter coldNeeds;
+
+    int opening = 0; ///< the number of running OriginConnPrewarmer jobs
+};
+
+using OriginDemands = std::unordered_map<SBuf, OriginDemand>;
+
+/// all tracked origin server destinations, indexed by OriginDemandKey()
+OriginDemands TheDemands;
+
+/// whether OriginPoolMaintain() event is pending
+bool MaintenanceScheduled = false;
+
+/// OriginPoolMaintain() event period (in seconds)
+const double MaintenanceInterval = 1.0;
+
+/// the maximum number of destinations we track at any given time
+const size_t MaxTrackedDestinations = 1024;
+
+/// destinations with fewer cold needs (within server_prewarm_window) are
+/// considered too cold for prewarming
+const int MinColdNeeds = 2;
+
+} // namespace
+
+/// OriginDemands key for the given destination
+static SBuf
+OriginDemandKey(const Comm::ConnectionPointer &dest, const char *domain)
+{
+    return ToSBuf(dest->remote, '/', (domain ? domain : ""));
+}
+
+/// the number of spare connections we want to have ready for the destination
+static int
+OriginDemandTarget(const OriginDemand &demand)
+{
+    const auto cold = demand.coldNeeds.remembered();
+    if (cold < MinColdNeeds)
+        return 0;
+
+    // expect as many cold needs during the next maintenance interval as we
+    // have seen per interval, on average, within the configured window
+    const auto window = std::max(static_cast<double>(Config.serverPrewarm.window), MaintenanceInterval);
+    return static_cast<int>(std::ceil(cold * MaintenanceInterval / window));
+}
+
+static EVH OriginPoolMaintain;
+
+static void
+ScheduleOriginPoolMaintenance()
+{
+    if (MaintenanceScheduled)
+        return;
+    eventAdd("OriginPoolMaintain", &OriginPoolMaintain, nullptr, MaintenanceInterval, 0, false);
+    MaintenanceScheduled = true;
+}
+
+/// forgets cold destinations and starts prewarming connections to hot ones
+static void
+OriginPoolMaintain(void *)
+{
+    MaintenanceScheduled = false;
+
+    const auto budget = Config.serverPrewarm.limit;
+    if (budget <= 0 || shutting_down) {
+        debugs(48, 5, "disabled; forgetting " << TheDemands.size() << " destinations");
+        TheDemands.clear();
+        return;
+    }
+
+    // hot destinations with their spare connection deficits
+    std::vector<std::pair<int, OriginDemands::iterator> > hot;
+    int spares = 0; // ready or being opened spare connections
+    for (auto it = TheDemands.begin(); it != TheDemands.end();) {
+        auto &demand = it->second;
+        // refresh possibly stale counts
+        const auto needs = demand.needs.count(0);
+        (void)demand.coldNeeds.count(0);
+        if (!needs && !demand.opening) {
+            debugs(48, 7, "forgetting " << it->first);
+            it = TheDemands.erase(it);
+            continue;
+        }
+
+        if (const auto target = OriginDemandTarget(demand)) {
+            const auto idle = fwdPconnPool->count(demand.profile, demand.poolDomain());
+            spares += std::min(idle, target) + demand.opening;
+            if (idle + demand.opening < target)
+                hot.emplace_back(target - idle - demand.opening, it);
+        }
+        ++it;
+    }
+
+    if (!hot.empty()) {
+        std::sort(hot.begin(), hot.end(), [](const auto &a, const auto &b) {
+            return a.second->second.coldNeeds.remembered() > b.second->second.coldNeeds.remembered();
+        });
+
+        for (auto &[deficit, it] : hot) {
+            auto &demand = it->second;
+            for (; deficit > 0 && spares < budget; --deficit, ++spares) {
+                if (fdUsageHigh()) {
+                    debugs(48, 5, "overwhelmed");
+                    break;
+                }
+                debugs(48, 5, "prewarming " << it->first << " with " << spares << '/' << budget << " spares");
+                ++demand.opening;
+                AsyncJob::Start(new OriginConnPrewarmer(it->first, demand.profile, demand.domain, demand.secure));
+            }
+        }
+    }
+
+    if (!TheDemands.empty())
+        ScheduleOriginPoolMaintenance();
+}
+
+/* OriginPoolMgr */
+
+void
+OriginPoolMgr::NoteDemand(const HttpRequest &request, const Comm::ConnectionPointer &dest, const char *domain, const Comm::ConnectionPointer &reused)
+{
+    if (Config.serverPrewarm.limit <= 0)
+        return;
+
+    // cache_peers have their own standby pools
+    if (dest->getPeer())
+        return;
+
+    // we cannot prewarm connections that depend on client TLS details
+    if (request.flags.sslBumped)
+        return;
+
+    const auto key = OriginDemandKey(dest, domain);
+    auto it = TheDemands.find(key);
+    if (it == TheDemands.end()) {
+        if (TheDemands.size() >= MaxTrackedDestinations) {
+            debugs(48, 7, "too many destinations to track " << key);
+            return;
+        }
+        const auto secure = request.url.getScheme() == AnyP::PROTO_HTTPS;
+        it = TheDemands.emplace(key, OriginDemand(dest->cloneProfile(), SBuf(domain ? domain : ""), secure)).first;
+    }
+
+    auto &demand = it->second;
+    demand.needs.configure(Config.serverPrewarm.window);
+    demand.coldNeeds.configure(Config.serverPrewarm.window);
+    demand.needs.count(1);
+
+    // A never-used reused connection has been opened by OriginConnPrewarmer.
+    // Counting its use as a cold need keeps its destination warm.
+    if (!reused || !fd_table[reused->fd].pconn.uses)
+        demand.coldNeeds.count(1);
+
+    ScheduleOriginPoolMaintenance();
+}
+
+/* OriginConnPrewarmer */
+
+OriginConnPrewarmer::OriginConnPrewarmer(const SBuf &aKey, const Comm::ConnectionPointer &aProfile, const SBuf &aDomain, const bool aSecure):
+    AsyncJob("OriginConnPrewarmer"),
+    key(aKey),
+    profile(aProfile),
+    domain(aDomain),
+    secure(aSecure)
+{
+    const auto mx = MasterXaction::MakePortless<XactionInitiator::initOriginPool>();
+
+    // ErrorState, getOutgoingAddress(), and TLS code may require a request.
+    request = secure ?
+              new HttpRequest(Http::METHOD_OPTIONS, AnyP::PROTO_HTTPS, "https", "*", mx) :
+              new HttpRequest(Http::METHOD_OPTIONS, AnyP::PROTO_HTTP, "http", "*", mx);
+    request->url.host(domain.c_str());
+}
+
+OriginConnPrewarmer::~OriginConnPrewarmer() = default;
+
+void
+OriginConnPrewarmer::start()
+{
+    AsyncJob::start();
+
+    const auto conn = profile->cloneProfile();
+    GetMarkingsToServer(request.getRaw(), *conn);
+
+    typedef CommCbMemFunT<OriginConnPrewarmer, CommConnectCbParams> Dialer;
+    AsyncCall::Pointer callback = JobCallback(48, 5, Dialer, this, OriginConnPrewarmer::handleOpenedConnection);
+    const auto cs = new Comm::ConnOpener(conn, callback, Config.Timeout.connect);
+    cs->setHost(domain.c_str());
+    transportWait.start(cs, callback);
+}
+
+bool
+OriginConnPrewarmer::doneAll() const
+{
+    return pushed && AsyncJob::doneAll();
+}
+
+void
+OriginConnPrewarmer::swanSong()
+{
+    const auto it = TheDemands.find(key);
+    if (it != TheDemands.end() && it->second.opening > 0)
+        --it->second.opening;
+    AsyncJob::swanSong();
+}
+
+void
+OriginConnPrewarmer::handleOpenedConnection(const CommConnectCbParams &params)
+{
+    transportWait.finish();
+
+    if (params.flag != Comm::OK) {
+        debugs(48, 3, "failed to prewarm " << key);
+        mustStop("connection opening failure");
+        return;
+    }
+
+    Must(params.conn != nullptr);
+
+    if (secure) {
+        // XXX: Exceptions orphan params.conn
+        const auto callback = asyncCallback(48, 4, OriginConnPrewarmer::handleSecuredConnection, this);
+        const int timeUsed = squid_curtime - params.conn->startTime();
+        const int timeLeft = positiveTimeout(Config.Timeout.connect - timeUsed);
+        const auto connector = new Security::BlindPeerConnector(request, params.conn, callback, nullptr, timeLeft);
+        encryptionWait.start(connector, callback);
+        return;
+    }
+
+    pushNewConnection(params.conn);
+}
+
+void
+OriginConnPrewarmer::handleSecuredConnection(Security::EncryptorAnswer &answer)
+{
+    encryptionWait.finish();
+
+    assert(!answer.tunneled);
+    if (answer.error.get()) {
+        assert(!answer.conn);
+        mustStop("connection securing failure");
+        return;
+    }
+
+    assert(answer.conn);
+
+    // The socket could get closed while our callback was queued. Sync
+    // Connection. XXX: Connection::fd may already be stale/invalid here.
+    if (answer.conn->isOpen() && fd_table[answer.conn->fd].closing()) {
+        answer.conn->noteClosure();
+        mustStop("external connection closure");
+        return;
+    }
+
+    pushNewConnection(answer.conn);
+}
+
+void
+OriginConnPrewarmer::pushNewConnection(const Comm::ConnectionPointer &conn)
+{
+    Must(Comm::IsConnOpen(conn));
+    debugs(48, 3, "prewarmed " << conn << " for " << key);
+    fwdPconnPool->push(conn, domain.isEmpty() ? nullptr : domain.c_str());
+    pushed = true;
+}
+
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_ORIGINPOOLMGR_H
+#define SQUID_SRC_ORIGINPOOLMGR_H
+
+#include "base/AsyncJob.h"
+#include "base/JobWait.h"
+#include "comm/forward.h"
+#include "http/forward.h"
+#include "sbuf/SBuf.h"
+#include "security/forward.h"
+
+class CommConnectCbParams;
+
+/// Maintains demand-driven "prewarmed" idle connections to busy origin
+/// servers in fwdPconnPool. Unlike PeerPoolMgr, there is no configured pool
+/// size: The number of spare connections to each origin destination follows
+/// the recently observed rate of connection needs that fwdPconnPool could not
+/// satisfy with previously used connections, within a global budget
+/// (server_prewarm_limit).
+class OriginPoolMgr
+{
+public:
+    /// Accounts for a to-origin connection need. The reused connection is nil
+    /// when fwdPconnPool had no suitable idle connection for the destination.
+    static void NoteDemand(const HttpRequest &, const Comm::ConnectionPointer &dest, const char *domain, const Comm::ConnectionPointer &reused);
+};
+
+/// Opens (and, for https origins, secures) one spare connection to an origin
+/// server and then donates that connection to fwdPconnPool.
+class OriginConnPrewarmer: public AsyncJob
+{
+    CBDATA_CHILD(OriginConnPrewarmer);
+
+public:
+    /// \param key the destination identifier used by OriginPoolMgr
+    /// \param profile describes the destination address and local settings
+    /// \param secure whether to perform a TLS handshake after connecting
+    OriginConnPrewarmer(const SBuf &key, const Comm::ConnectionPointer &profile, const SBuf &domain, bool secure);
+    ~OriginConnPrewarmer() override;
+
+protected:
+    /* AsyncJob API */
+    void start() override;
+    bool doneAll() const override;
+    void swanSong() override;
+
+private:
+    void handleOpenedConnection(const CommConnectCbParams &);
+    void handleSecuredConnection(Security::EncryptorAnswer &);
+    void pushNewConnection(const Comm::ConnectionPointer &);
+
+    const SBuf key; ///< OriginPoolMgr destination identifier
+    Comm::ConnectionPointer profile; ///< the connection opening template
+    SBuf domain; ///< origin server name used for pooling and SNI
+    const bool secure; ///< whether the origin speaks TLS
+
+    /// fake HTTP request for connection opening and TLS negotiation code
+    HttpRequestPointer request;
+
+    /// waits for a transport connection to the origin to be opened
+    JobWait<Comm::ConnOpener> transportWait;
+
+    /// waits for the established transport connection to be secured
+    JobWait<Security::BlindPeerConnector> encryptionWait;
+
+    bool pushed = false; ///< whether we have donated our connection
+};
+
+#endif /* SQUID_SRC_ORIGINPOOLMGR_H */
+
@@ -34,7 +34,20 @@ public:
     unsigned char bits_per_entry;
     unsigned char hash_func_count;
     short int reserved_short;
-    int reserved[32 - 6];
+
+    /// identifies mask contents; changes with every digest rewrite
+    /// (since version 6; zero if unknown)
+    int generation;
+
+    /// the generation of the mask that a delta applies to
+    /// (since version 6; zero in full digests)
+    int delta_base;
+
+    /// the number of toggled bit positions following a delta cblock
+    /// (since version 6)
+    int delta_size;
+
+    int reserved[32 - 9];
 };
 
 class HttpRequest;
@@ -57,6 +70,19 @@ public:
     HttpRequest *request;
     int offset;
     uint32_t mask_offset;
+
+    /// whether we are fetching changes to our current copy of the digest
+    /// (rather than the entire digest)
+    bool delta;
+
+    /// for delta fetches: the number of toggled bit positions in the body
+    uint32_t deltaSize;
+
+    /// for delta fetches: the number of toggled bit positions applied so far
+    uint32_t deltaOffset;
+
+    /// for delta fetches: the generation our digest will have after the delta
+    int deltaGeneration;
     time_t start_time;
     time_t resp_time;
     time_t expires;
@@ -88,10 +114,15 @@ public:
     const SBuf host; ///< copy of peer->host
     const char *req_result = nullptr;     /**< text status of the last request */
 
+    /// the generation of our digest copy (zero if unknown)
+    /// peers supporting digest deltas report non-zero generations
+    int generation = 0;
+
     struct {
         bool needed = false;          /**< there were requests for this digest */
         bool usable = false;          /**< can be used for lookups */
         bool requested = false;       /**< in process of receiving [fresh] digest */
+        bool needsFull = false;       ///< the next request must fetch the entire digest
     } flags;
 
     struct {
@@ -114,6 +145,8 @@ public:
             int msgs = 0;
             ByteCounter kbytes;
         } sent, recv;
+
+        int deltas = 0; ///< successfully applied digest deltas
     } stats;
 };
 
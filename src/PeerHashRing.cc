@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 39    Peer selection using consistent hashing rings */
+
+#include "squid.h"
+#include "base/RunnersRegistry.h"
+#include "base/TextException.h"
+#include "CachePeer.h"
+#include "debug/Stream.h"
+#include "neighbors.h"
+#include "PeerHashRing.h"
+#include "sbuf/SBuf.h"
+#include "sbuf/Stream.h"
+#include "SquidConfig.h"
+
+#include <algorithm>
+#include <vector>
+
+/// names of cache_peer groups that may use hashing rings
+static const char *GroupNames[] = { "carp", "sourcehash", "userhash" };
+
+/// all rings, for load accounting
+static std::vector<PeerHashRing *> &
+AllRings()
+{
+    static const auto rings = new std::vector<PeerHashRing *>();
+    return *rings;
+}
+
+bool
+PeerHashRing::Enabled(const char * const groupName)
+{
+    for (const auto &name: Config.peerHashRing.groups) {
+        if (name.cmp(groupName) == 0)
+            return true;
+    }
+    return false;
+}
+
+void
+PeerHashRing::NoteConnectionOpened(const CachePeer &peer)
+{
+    for (const auto ring: AllRings()) {
+        if (ring->memberSet.count(&peer))
+            ++ring->totalLoad;
+    }
+}
+
+void
+PeerHashRing::NoteConnectionClosed(const CachePeer &peer)
+{
+    for (const auto ring: AllRings()) {
+        if (ring->memberSet.count(&peer) && ring->totalLoad > 0)
+            --ring->totalLoad;
+    }
+}
+
+PeerHashRing::PeerHashRing()
+{
+    AllRings().push_back(this);
+}
+
+PeerHashRing::~PeerHashRing()
+{
+    auto &rings = AllRings();
+    rings.erase(std::remove(rings.begin(), rings.end(), this), rings.end());
+}
+
+void
+PeerHashRing::reset(const RawCachePeers &members)
+{
+    clear();
+    for (const auto p: members) {
+        ring.add(p->name, strlen(p->name), p->weight);
+        peers.emplace_back(p);
+        memberSet.insert(p);
+        totalLoad += p->stats.conn_open;
+    }
+    ring.seal();
+}
+
+void
+PeerHashRing::clear()
+{
+    ring.clear();
+    peers.clear();
+    memberSet.clear();
+    totalLoad = 0;
+}
+
+CachePeer *
+PeerHashRing::select(const SBuf &key, PeerSelector * const ps) const
+{
+    const auto balance = Config.peerHashRing.balance / 100.0;
+    const auto loadOf = [this](const HashRing::Member m) {
+        const auto p = peers[m].valid();
+        return static_cast<uint64_t>(p ? p->stats.conn_open : 0);
+    };
+    const auto usable = [this, ps](const HashRing::Member m) {
+        const auto p = peers[m].valid(); // nil if the peer is gone
+        return p && peerHTTPOkay(p, ps);
+    };
+
+    const auto member = ring.select(HashRing::Hash(key.rawContent(), key.length()), balance, totalLoad, loadOf, usable);
+    if (!member)
+        return nullptr;
+
+    const auto p = peers[*member].get();
+    debugs(39, 3, "key=" << key << " selected " << *p << " with " << p->stats.conn_open <<
+           " out of " << totalLoad << " connections");
+    return p;
+}
+
+/// validates peer_hash_ring configuration
+class PeerHashRingRr: public RegisteredRunner
+{
+public:
+    /* RegisteredRunner API */
+    void finalizeConfig() override;
+};
+
+DefineRunnerRegistrator(PeerHashRingRr);
+
+void
+PeerHashRingRr::finalizeConfig()
+{
+    for (const auto &name: Config.peerHashRing.groups) {
+        const auto known = std::any_of(std::begin(GroupNames), std::end(GroupNames), [&name](const char *groupName) {
+            return name.cmp(groupName) == 0;
+        });
+        if (!known)
+            throw TextException(ToSBuf("peer_hash_ring: unsupported cache_peer group: ", name), Here());
+    }
+
+    if (Config.peerHashRing.balance < 100)
+        throw TextException(ToSBuf("peer_hash_ring_balance must be at least 100, got ", Config.peerHashRing.balance), Here());
+
+    // a ring hashes one key per request, so carp cache_peers must agree on it
+    if (PeerHashRing::Enabled("carp")) {
+        const CachePeer *keyPeer = nullptr;
+        for (const auto &peer: CurrentCachePeers()) {
+            if (!peer->options.carp)
+                continue;
+            if (!keyPeer) {
+                keyPeer = peer.get();
+                continue;
+            }
+            const auto &mine = peer->options.carp_key;
+            const auto &theirs = keyPeer->options.carp_key;
+            if (mine.set != theirs.set || mine.scheme != theirs.scheme || mine.host != theirs.host ||
+                    mine.port != theirs.port || mine.path != theirs.path || mine.params != theirs.params)
+                throw TextException(ToSBuf("peer_hash_ring carp requires the same carp-key for all carp cache_peers; ",
+                                           "cache_peer ", *peer, " carp-key differs from cache_peer ", *keyPeer), Here());
+        }
+    }
+}
+
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_PEERHASHRING_H
+#define SQUID_SRC_PEERHASHRING_H
+
+#include "base/HashRing.h"
+#include "CachePeers.h"
+#include "sbuf/forward.h"
+
+#include <unordered_set>
+
+class PeerSelector;
+
+/// A group of hashing cache_peers (e.g., all carp parents) selected using a
+/// precomputed consistent hashing ring with bounded loads instead of
+/// per-request scoring of every group member. The load of a cache_peer is
+/// its current number of open connections. Enabled by peer_hash_ring.
+class PeerHashRing
+{
+public:
+    /// whether peer_hash_ring enables rings for the named group
+    static bool Enabled(const char *groupName);
+
+    /// updates group loads after opening a connection to the given cache_peer
+    static void NoteConnectionOpened(const CachePeer &);
+
+    /// updates group loads after closing a connection to the given cache_peer
+    static void NoteConnectionClosed(const CachePeer &);
+
+    PeerHashRing();
+    ~PeerHashRing();
+    PeerHashRing(PeerHashRing &&) = delete; // no copying or moving of any kind
+
+    /// (re)builds the ring for the given group members
+    void reset(const RawCachePeers &);
+
+    /// forgets all group members
+    void clear();
+
+    bool empty() const { return peers.empty(); }
+
+    /// group members in the order of their reset() addition
+    const SelectedCachePeers &members() const { return peers; }
+
+    /// the usable group member responsible for the given key (or nil)
+    CachePeer *select(const SBuf &key, PeerSelector *) const;
+
+private:
+    HashRing ring; ///< member placement
+
+    /// group members, indexed by HashRing::Member
+    SelectedCachePeers peers;
+
+    /// group members, for quick membership checks
+    std::unordered_set<const CachePeer *> memberSet;
+
+    /// the number of open connections to all group members
+    uint64_t totalLoad = 0;
+};
+
+#endif /* SQUID_SRC_PEERHASHRING_H */
+
@@ -16,6 +16,8 @@
 #include "http/Stream.h"
 #include "Pipeline.h"
 
+#include <algorithm>
+
 void
 Pipeline::add(const Http::StreamPointer &c)
 {
@@ -54,10 +56,10 @@ Pipeline::popMe(const Http::StreamPointer &which)
     if (requests.empty())
         return;
 
-    debugs(33, 3, "Pipeline " << (void*)this << " drop " << requests.front());
-    // in reality there may be multiple contexts doing processing in parallel.
-    // XXX: pipeline still assumes HTTP/1 FIFO semantics are obeyed.
-    assert(which == requests.front());
-    requests.pop_front();
+    debugs(33, 3, "Pipeline " << (void*)this << " drop " << which);
+    // HTTP/1 contexts leave in FIFO order, but HTTP/2 streams may not
+    const auto found = std::find(requests.begin(), requests.end(), which);
+    assert(found != requests.end());
+    requests.erase(found);
 }
 
@@ -29,7 +29,8 @@
  *
  * - HTTP/2 multiplexed streams can be processed and delivered in any order.
  *
- * For consistency we treat the pipeline as a FIFO queue in both cases.
+ * For consistency we treat the pipeline as a FIFO queue in both cases, but
+ * HTTP/2 streams may leave it out of order.
  */
 class Pipeline
 {
@@ -55,7 +56,7 @@ public:
     /// whether there are none or any requests currently pipelined
     bool empty() const {return requests.empty();}
 
-    /// deregister the front request from the pipeline
+    /// deregister the given request from the pipeline
     void popMe(const Http::StreamPointer &);
 
     /// Number of requests seen in this pipeline (so far).
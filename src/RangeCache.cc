@@ -0,0 +1,292 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 20    Storage Manager */
+
+#include "squid.h"
+#include "base/Packable.h"
+#include "base/RunnersRegistry.h"
+#include "debug/Stream.h"
+#include "ETag.h"
+#include "HttpHdrCc.h"
+#include "HttpHdrContRange.h"
+#include "HttpHeaderRange.h"
+#include "HttpRequest.h"
+#include "mgr/Registration.h"
+#include "RangeCache.h"
+#include "sbuf/Stream.h"
+#include "SquidConfig.h"
+#include "Store.h"
+#include "time/gadgets.h"
+
+#include <algorithm>
+#include <limits>
+
+/// a headers-only copy of the given reply, with cached header fields
+static HttpReplyPointer
+CopyHeaders(const HttpReply &rep)
+{
+    const HttpReplyPointer copy(new HttpReply);
+    copy->sline = rep.sline;
+    copy->header.append(&rep.header);
+    copy->hdrCacheInit();
+    return copy;
+}
+
+/* RangeCache */
+
+RangeCache &
+RangeCache::Instance()
+{
+    static const auto instance = new RangeCache();
+    return *instance;
+}
+
+uint64_t
+RangeCache::MemoryUsedBySparseObject(const SparseObject &object)
+{
+    // approximate: ignores map overheads
+    return object.body.bytes() + object.reply->header.len + object.validator.length() + sizeof(object);
+}
+
+/// an identifier of the response representation that is strong enough
+/// for combining partial responses (RFC 9111 Section 3.4), or nothing
+SBuf
+RangeCache::Validator(const HttpReply &rep)
+{
+    const auto etag = rep.header.getETag(Http::HdrType::ETAG);
+    if (etag.str && !etag.weak)
+        return SBuf(etag.str);
+
+    // a Last-Modified date at least 60 seconds older than the Date header is
+    // a strong validator (RFC 9110 Section 8.8.2.2)
+    if (rep.last_modified >= 0 && rep.date >= 0 && rep.date - rep.last_modified >= 60)
+        return ToSBuf("last-modified:", rep.last_modified);
+
+    return SBuf();
+}
+
+/// how long the given response stays fresh, in seconds
+/// \returns zero for responses without explicit freshness information
+int
+RangeCache::FreshnessLifetime(const HttpReply &rep)
+{
+    int64_t lifetime = 0;
+    int32_t maxAge = 0;
+    if (rep.cache_control && (rep.cache_control->hasSMaxAge(&maxAge) || rep.cache_control->hasMaxAge(&maxAge)))
+        lifetime = maxAge;
+    else if (rep.expires >= 0 && rep.date >= 0)
+        lifetime = rep.expires - rep.date;
+
+    const auto age = rep.header.getInt(Http::HdrType::AGE);
+    if (age > 0)
+        lifetime -= age;
+
+    return std::clamp<int64_t>(lifetime, 0, std::numeric_limits<int>::max());
+}
+
+void
+RangeCache::configure(const uint64_t memLimit)
+{
+    if (!memLimit) {
+        objects_.reset();
+        return;
+    }
+
+    if (objects_)
+        objects_->setMemLimit(memLimit);
+    else
+        objects_ = std::make_unique<SparseObjects>(memLimit, 0);
+}
+
+uint64_t
+RangeCache::maxBodySize() const
+{
+    return objects_ ? std::min<uint64_t>(objects_->memLimit(), SBuf::maxSize) : 0;
+}
+
+bool
+RangeCache::mayRemember(const HttpRequest &request, const HttpReply &rep) const
+{
+    if (!enabled())
+        return false;
+
+    if (request.method != Http::METHOD_GET || rep.sline.status() != Http::scPartialContent)
+        return false;
+
+    // multipart/byteranges responses have no Content-Range header
+    const auto contentRange = rep.contentRange();
+    if (!contentRange || contentRange->elength <= 0 ||
+            contentRange->spec.offset == HttpHdrRangeSpec::UnknownPosition ||
+            contentRange->spec.length <= 0)
+        return false;
+
+    if (static_cast<uint64_t>(contentRange->spec.length) > maxBodySize())
+        return false;
+
+    // no secondary keys for sparse objects
+    if (rep.header.has(Http::HdrType::VARY))
+        return false;
+
+    // cache deny
+    if (!request.flags.cachable)
+        return false;
+
+    if (request.flags.auth || (request.cache_control && request.cache_control->hasNoStore()))
+        return false;
+
+    if (const auto cc = rep.cache_control) {
+        if (cc->hasNoStore() || cc->hasPrivate() || cc->hasNoCache() || cc->hasMustRevalidate())
+            return false;
+    }
+
+    return !Validator(rep).isEmpty() && FreshnessLifetime(rep) > 0;
+}
+
+void
+RangeCache::remember(HttpRequest &request, const HttpReply &rep, const SBuf &body)
+{
+    if (body.isEmpty() || !mayRemember(request, rep))
+        return;
+
+    const auto contentRange = rep.contentRange();
+    const auto key = request.storeId();
+    const auto validator = Validator(rep);
+
+    SparseObject object;
+    if (const auto old = objects_->get(key)) {
+        // merged pieces must fit into an SBuf
+        if (old->body.bytes() + body.length() > SBuf::maxSize) {
+            debugs(20, 3, "restarting " << key);
+        } else if (old->validator == validator && old->length == contentRange->elength) {
+            object = *old;
+        } else {
+            debugs(20, 3, "replacing " << old->validator << " with " << validator << " for " << key);
+            ++stats_.replacements;
+        }
+    }
+
+    const auto age = std::max(rep.header.getInt(Http::HdrType::AGE), 0);
+    object.reply = CopyHeaders(rep);
+    object.validator = validator;
+    object.length = contentRange->elength;
+    object.timestamp = squid_curtime - age;
+    object.body.add(contentRange->spec.offset, body.substr(0, contentRange->spec.length));
+
+    ++stats_.stores;
+    if (!objects_->add(key, object, FreshnessLifetime(rep)))
+        debugs(20, 3, "cannot remember " << object.body.bytes() << " bytes of " << key);
+    else
+        debugs(20, 5, "remembered " << body.length() << " bytes at " << contentRange->spec.offset << " of " << key);
+}
+
+std::optional<RangeCache::Hit>
+RangeCache::find(HttpRequest &request)
+{
+    if (!enabled() || request.method != Http::METHOD_GET || !request.range || !request.flags.cachable)
+        return std::nullopt;
+
+    // leave conditional and revalidation requests to the server
+    const auto &header = request.header;
+    if (request.flags.noCache ||
+            header.has(Http::HdrType::IF_RANGE) ||
+            header.has(Http::HdrType::IF_MATCH) ||
+            header.has(Http::HdrType::IF_NONE_MATCH) ||
+            header.has(Http::HdrType::IF_MODIFIED_SINCE) ||
+            header.has(Http::HdrType::IF_UNMODIFIED_SINCE))
+        return std::nullopt;
+
+    const auto object = objects_->get(request.storeId());
+    if (!object) {
+        ++stats_.misses;
+        return std::nullopt;
+    }
+
+    int32_t maxAge = 0;
+    if (request.cache_control && request.cache_control->hasMaxAge(&maxAge) && squid_curtime - object->timestamp > maxAge) {
+        ++stats_.misses;
+        return std::nullopt;
+    }
+
+    HttpHdrRange range(*request.range);
+    if (range.canonize(object->length) != 1) {
+        ++stats_.misses; // TODO: Support multipart responses.
+        return std::nullopt;
+    }
+
+    const auto &spec = **range.begin();
+    auto bytes = object->body.get(spec.offset, spec.length);
+    if (!bytes) {
+        ++stats_.misses;
+        return std::nullopt;
+    }
+
+    const HttpReplyPointer reply(new HttpReply);
+    reply->sline = object->reply->sline;
+    reply->header.append(&object->reply->header);
+    reply->header.delById(Http::HdrType::CONTENT_RANGE);
+    reply->header.delById(Http::HdrType::CONTENT_LENGTH);
+    httpHeaderAddContRange(&reply->header, spec, object->length);
+    reply->header.putInt64(Http::HdrType::CONTENT_LENGTH, spec.length);
+    reply->hdrCacheInit();
+
+    Hit hit;
+    hit.reply = reply;
+    hit.body = *bytes;
+    hit.offset = spec.offset;
+    hit.timestamp = object->timestamp;
+    ++stats_.hits;
+    return hit;
+}
+
+void
+RangeCache::packStatsInto(Packable *p) const
+{
+    p->appendf("Range cache:\n");
+    if (!objects_) {
+        p->appendf("\tdisabled\n");
+        return;
+    }
+    p->appendf("\tsparse objects: %zu\n", objects_->entries());
+    p->appendf("\tmemory used: %" PRIu64 " of %" PRIu64 " bytes\n", objects_->memoryUsed(), objects_->memLimit());
+    p->appendf("\thits: %" PRIu64 "\n", stats_.hits);
+    p->appendf("\tmisses: %" PRIu64 "\n", stats_.misses);
+    p->appendf("\tstored responses: %" PRIu64 "\n", stats_.stores);
+    p->appendf("\treplaced objects: %" PRIu64 "\n", stats_.replacements);
+}
+
+/// cache manager range_cache report
+static void
+RangeCacheStats(StoreEntry *sentry)
+{
+    RangeCache::Instance().packStatsInto(sentry);
+}
+
+/// configures RangeCache and registers its cache manager report
+class RangeCacheRr: public RegisteredRunner
+{
+public:
+    /* RegisteredRunner API */
+    void useConfig() override;
+    void syncConfig() override;
+};
+DefineRunnerRegistrator(RangeCacheRr);
+
+void
+RangeCacheRr::useConfig()
+{
+    RangeCache::Instance().configure(Config.rangeCacheMem);
+    Mgr::RegisterAction("range_cache", "Range Cache Statistics", RangeCacheStats, 0, 1);
+}
+
+void
+RangeCacheRr::syncConfig()
+{
+    RangeCache::Instance().configure(Config.rangeCacheMem);
+}
+
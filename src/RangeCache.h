@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_RANGECACHE_H
+#define SQUID_SRC_RANGECACHE_H
+
+#include "base/ClpMap.h"
+#include "http/forward.h"
+#include "HttpReply.h"
+#include "sbuf/SBuf.h"
+#include "SparseBody.h"
+
+#include <memory>
+#include <optional>
+
+class Packable;
+
+/// Remembers the bodies of cachable 206 (Partial Content) responses as
+/// sparse objects: byte ranges of a response representation, keyed by the
+/// request store ID. Later requests for a range covered by a single
+/// remembered byte range are answered without contacting the server.
+/// Pieces of the same representation (as identified by its strong
+/// validator) are merged; a changed representation replaces the old
+/// pieces. Each worker keeps its own sparse objects in memory.
+class RangeCache
+{
+public:
+    /// a response assembled from remembered pieces
+    class Hit
+    {
+    public:
+        HttpReplyPointer reply; ///< 206 response headers
+        SBuf body; ///< the requested range bytes
+        int64_t offset = 0; ///< the representation offset of the first body byte
+        time_t timestamp = 0; ///< when the response was received; for Age
+    };
+
+    /// the configured range cache
+    static RangeCache &Instance();
+
+    /// applies (re)configured range_cache_mem limit; zero disables caching
+    void configure(uint64_t memLimit);
+
+    /// whether find() and remember() may be used
+    bool enabled() const { return bool(objects_); }
+
+    /// whether the body of the given response may be remember()ed
+    bool mayRemember(const HttpRequest &, const HttpReply &) const;
+
+    /// remembers a (possibly truncated) body of a mayRemember() response
+    void remember(HttpRequest &, const HttpReply &, const SBuf &body);
+
+    /// \returns a response to the given Range request (if possible)
+    std::optional<Hit> find(HttpRequest &);
+
+    /// the largest response body worth accumulating for remember()
+    uint64_t maxBodySize() const;
+
+    /// reports cache statistics to the cache manager
+    void packStatsInto(Packable *) const;
+
+private:
+    /// remembered byte ranges of a single representation
+    class SparseObject
+    {
+    public:
+        HttpReplyPointer reply; ///< the latest stored response headers
+        SBuf validator; ///< identifies the representation
+        int64_t length = 0; ///< the complete representation length
+        time_t timestamp = 0; ///< when the latest response was received
+        SparseBody body; ///< remembered byte ranges
+    };
+
+    static uint64_t MemoryUsedBySparseObject(const SparseObject &);
+    static SBuf Validator(const HttpReply &);
+    static int FreshnessLifetime(const HttpReply &);
+
+    using SparseObjects = ClpMap<SBuf, SparseObject, MemoryUsedBySparseObject>;
+
+    std::unique_ptr<SparseObjects> objects_; ///< nil when disabled
+
+    struct {
+        uint64_t hits = 0; ///< find() successes
+        uint64_t misses = 0; ///< find() failures
+        uint64_t stores = 0; ///< remember() calls
+        uint64_t replacements = 0; ///< changed representations
+    } stats_;
+};
+
+#endif /* SQUID_SRC_RANGECACHE_H */
+
@@ -36,6 +36,9 @@ public:
         min(0), pct(0.20), max(REFRESH_DEFAULT_MAX),
         next(nullptr),
         max_stale(-1),
+        stale_while_revalidate(-1),
+        prefetch(0),
+        prefetch_min_hits(10),
         regex_(std::move(aRegex))
     {
         memset(&flags, 0, sizeof(flags));
@@ -67,13 +70,23 @@ public:
 #endif
     } flags;
     int max_stale;
+    /// serve stale responses for this many seconds while refreshing them in
+    /// the background, unless they have a stale-while-revalidate directive
+    int stale_while_revalidate;
+    /// refresh popular responses in the background this many seconds before
+    /// they become stale
+    int prefetch;
+    /// the number of hits that makes a response popular enough for prefetch
+    int prefetch_min_hits;
 
     // statistics about how many matches this pattern has had
     mutable struct stats_ {
-        stats_() : matchTests(0), matchCount(0) {}
+        stats_() : matchTests(0), matchCount(0), reuseCount(0) {}
 
         uint64_t matchTests;
         uint64_t matchCount;
+        /// how many times a match remembered by a MemObject was reused
+        uint64_t reuseCount;
         // TODO: some stats to indicate how useful/less the flags are would be nice.
     } stats;
 
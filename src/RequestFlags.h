@@ -52,6 +52,11 @@ public:
     bool failOnValidationError = false;
     /** reply is stale if it is a hit */
     bool staleIfHit = false;
+    /// the cache hit should be refreshed in the background (because of
+    /// stale-while-revalidate or refresh_pattern prefetch)
+    bool refreshAfterHit = false;
+    /// a Squid-generated request refreshing a cached response in the background
+    bool backgroundRefresh = false;
     /** request to override no-cache directives
      *
      * always use noCacheHack() for reading.
@@ -119,6 +124,11 @@ public:
     /// whether to forward via TunnelStateData (instead of FwdState)
     bool forceTunnel = false;
 
+    /// whether the request was counted by a request_rate ACL keyed by client address
+    bool addressRateCounted = false;
+    /// whether the request was counted by a request_rate ACL keyed by user name
+    bool userRateCounted = false;
+
     /** clone the flags, resetting to default those which are not safe in
      *  a related (e.g. ICAP-adapted) request.
      */
@@ -10,10 +10,12 @@
 #include "CachePeer.h"
 #include "comm/Connection.h"
 #include "comm/ConnOpener.h"
+#include "DestinationRtt.h"
 #include "ResolvedPeers.h"
 #include "SquidConfig.h"
 
 #include <algorithm>
+#include <optional>
 
 ResolvedPeers::ResolvedPeers()
 {
@@ -113,7 +115,7 @@ PeerConnectionPointer
 ResolvedPeers::extractFront()
 {
     Must(!empty());
-    return extractFound("first: ", start());
+    return extractFound("first: ", preferred(start()));
 }
 
 PeerConnectionPointer
@@ -121,7 +123,7 @@ ResolvedPeers::extractPrime(const Comm::Connection &currentPeer)
 {
     const auto found = findPrime(currentPeer).first;
     if (found != paths_.end())
-        return extractFound("same-peer same-family match: ", found);
+        return extractFound("same-peer same-family match: ", preferred(found));
 
     debugs(17, 7, "no same-peer same-family paths");
     return nullptr;
@@ -132,12 +134,52 @@ ResolvedPeers::extractSpare(const Comm::Connection &currentPeer)
 {
     const auto found = findSpare(currentPeer).first;
     if (found != paths_.end())
-        return extractFound("same-peer different-family match: ", found);
+        return extractFound("same-peer different-family match: ", preferred(found));
 
     debugs(17, 7, "no same-peer different-family paths");
     return nullptr;
 }
 
+/// \returns the path with the best DestinationRtt history among the available
+/// same-peer same-family paths, starting with the given available path
+ResolvedPeers::Paths::iterator
+ResolvedPeers::preferred(const Paths::iterator &found)
+{
+    // limits the number of history lookups per extraction
+    const size_type maxCandidates = 16;
+
+    const auto peer = found->connection->getPeer();
+    const auto family = ConnectionFamily(*found->connection);
+
+    auto best = found;
+    std::optional<DestinationRtt> bestHistory;
+    if (const auto history = DestinationRtt::Find(found->connection->remote))
+        bestHistory = *history;
+
+    size_type candidates = 1;
+    for (auto path = found + 1; path != paths_.end() && candidates < maxCandidates; ++path) {
+        if (path->connection->getPeer() != peer)
+            break; // paths_ are grouped by peer
+        if (!path->available || ConnectionFamily(*path->connection) != family)
+            continue;
+        ++candidates;
+
+        // prefer DNS answer order unless history tells us otherwise
+        const auto history = DestinationRtt::Find(path->connection->remote);
+        const auto better = history ?
+                            (bestHistory && history->cost() < bestHistory->cost()) :
+                            (bestHistory && bestHistory->failing()); // try an unknown address
+        if (better) {
+            best = path;
+            bestHistory = history ? std::optional<DestinationRtt>(*history) : std::nullopt;
+        }
+    }
+
+    if (best != found)
+        debugs(17, 5, "prefer " << best->connection->remote << " over " << found->connection->remote);
+    return best;
+}
+
 /// convenience method to finish a successful extract*() call
 PeerConnectionPointer
 ResolvedPeers::extractFound(const char *description, const Paths::iterator &found)
@@ -0,0 +1,420 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 00    Client Database */
+
+#include "squid.h"
+#include "base/RunnersRegistry.h"
+#include "debug/Stream.h"
+#include "globals.h"
+#include "ip/Address.h"
+#include "ipc/Kids.h"
+#include "ipc/mem/FlexibleArray.h"
+#include "ipc/mem/Pointer.h"
+#include "ipc/mem/Segment.h"
+#include "md5.h"
+#include "sbuf/SBuf.h"
+#include "SharedClientDb.h"
+#include "SquidConfig.h"
+#include "time/gadgets.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+
+namespace SharedClientDb
+{
+
+/// the maximum number of slots examined when looking for a key
+static const int MaxProbes = 16;
+
+/// a table entry; the shared memory slot array element
+class Slot
+{
+public:
+    /// slot life cycle stages
+    enum State : uint32_t { empty = 0, writing, ready };
+
+    Slot();
+
+    /// counts a request received at the given time
+    void countRequest(time_t now);
+
+    /// the number of requests received during `seconds` before (and at) now
+    int recentRequests(time_t now, int seconds) const;
+
+    /// whether the slot is ready and holds the given key
+    bool matches(const Key &) const;
+
+    /// whether the slot key is set and may be compared
+    std::atomic<uint32_t> state;
+
+    /// Incremented by the writing state owner before it changes the key.
+    /// Lets readers detect a key that was reused while they compared it.
+    std::atomic<uint32_t> version;
+
+    /// the last time this entry was used
+    std::atomic<int64_t> lastSeen;
+
+    /// Per-second request counters, indexed by time modulo MaxRateWindow.
+    /// Each counter keeps its second in the high 32 bits and the number of
+    /// requests received during that second in the low 32 bits.
+    std::atomic<uint64_t> requests[MaxRateWindow];
+
+    Key key; ///< the entry key; only changed by the writing state owner
+};
+
+/// shared memory segment layout: an open addressing hash table
+class Shared
+{
+public:
+    explicit Shared(int aCapacity);
+
+    size_t sharedMemorySize() const { return SharedMemorySize(capacity); }
+    static size_t SharedMemorySize(const int aCapacity) { return sizeof(Shared) + size_t(aCapacity)*sizeof(Slot); }
+
+    const int capacity; ///< the number of slots
+    Ipc::Mem::FlexibleArray<Slot> slots; ///< all entries
+};
+
+/// Per-kid connection counters in a separate shared memory segment; the
+/// counter of slot s and kid k is at position s*kidSlots + k. Each kid
+/// maintains its own counters, so a restarted kid can forget connections of
+/// its predecessor.
+class Connections
+{
+public:
+    Connections(int aCapacity, int aKidSlots);
+
+    size_t sharedMemorySize() const { return SharedMemorySize(capacity, kidSlots); }
+    static size_t SharedMemorySize(const int aCapacity, const int aKidSlots) { return sizeof(Connections) + size_t(aCapacity)*aKidSlots*sizeof(std::atomic<int32_t>); }
+
+    /// the counter of the given slot and kid
+    std::atomic<int32_t> &counter(const int slot, const int kid) { return counters[slot*kidSlots + kid]; }
+
+    /// the number of connections accepted by all kids for the given slot
+    int total(int slot);
+
+    const int capacity; ///< the number of table slots
+    const int kidSlots; ///< the number of counters per slot
+    Ipc::Mem::FlexibleArray< std::atomic<int32_t> > counters; ///< all counters
+};
+
+} // namespace SharedClientDb
+
+using namespace SharedClientDb;
+
+/// shared memory segment labels
+static const char * const TableLabel = "client_db";
+static const char * const ConnectionsLabel = "client_db_connections";
+
+/// the table segment opened by this kid (if any)
+static Ipc::Mem::Pointer<Shared> TheTable;
+
+/// the connections segment opened by this kid (if any)
+static Ipc::Mem::Pointer<Connections> TheConnections;
+
+/// whether this kid maintains its connection counters
+static bool CountingConnections = false;
+
+/* SharedClientDb::Key */
+
+Key
+SharedClientDb::Key::Address(const Ip::Address &addr)
+{
+    Key key;
+    key.kind = address;
+    struct in6_addr raw;
+    addr.getInAddr(raw);
+    static_assert(sizeof(raw) == sizeof(key.bytes), "Key::bytes fit an IPv6 address");
+    memcpy(key.bytes, &raw, sizeof(key.bytes));
+    return key;
+}
+
+Key
+SharedClientDb::Key::User(const SBuf &name)
+{
+    Key key;
+    key.kind = user;
+    SquidMD5_CTX ctx;
+    SquidMD5Init(&ctx);
+    SquidMD5Update(&ctx, name.rawContent(), name.length());
+    static_assert(SQUID_MD5_DIGEST_LENGTH == sizeof(key.bytes), "Key::bytes fit an MD5 digest");
+    SquidMD5Final(key.bytes, &ctx);
+    return key;
+}
+
+bool
+SharedClientDb::Key::operator ==(const Key &other) const
+{
+    return kind == other.kind && memcmp(bytes, other.bytes, sizeof(bytes)) == 0;
+}
+
+uint32_t
+SharedClientDb::Key::hash() const
+{
+    // FNV-1a
+    uint32_t result = 2166136261U;
+    result = (result ^ kind) * 16777619U;
+    for (const auto byte: bytes)
+        result = (result ^ byte) * 16777619U;
+    return result;
+}
+
+/* SharedClientDb::Slot */
+
+SharedClientDb::Slot::Slot():
+    state(empty),
+    version(0),
+    lastSeen(0)
+{
+    for (auto &counter: requests)
+        counter.store(0, std::memory_order_relaxed);
+}
+
+void
+SharedClientDb::Slot::countRequest(const time_t now)
+{
+    const auto second = static_cast<uint32_t>(now);
+    auto &counter = requests[now % MaxRateWindow];
+    auto current = counter.load(std::memory_order_relaxed);
+    uint64_t updated;
+    do {
+        const auto count = (current >> 32) == second ? static_cast<uint32_t>(current) : 0;
+        updated = (static_cast<uint64_t>(second) << 32) | (count + 1);
+    } while (!counter.compare_exchange_weak(current, updated, std::memory_order_relaxed));
+    lastSeen.store(now, std::memory_order_relaxed);
+}
+
+int
+SharedClientDb::Slot::recentRequests(const time_t now, const int seconds) const
+{
+    const auto newest = static_cast<uint32_t>(now);
+    int64_t total = 0;
+    for (const auto &counter: requests) {
+        const auto value = counter.load(std::memory_order_relaxed);
+        const auto age = newest - static_cast<uint32_t>(value >> 32);
+        if (age < static_cast<uint32_t>(seconds))
+            total += static_cast<uint32_t>(value);
+    }
+    return static_cast<int>(std::min<int64_t>(total, std::numeric_limits<int>::max()));
+}
+
+bool
+SharedClientDb::Slot::matches(const Key &aKey) const
+{
+    // a seqlock-like check: the key is not atomic and may be rewritten by
+    // another kid while we compare it
+    const auto versionBefore = version.load(std::memory_order_acquire);
+    if (state.load(std::memory_order_acquire) != ready)
+        return false;
+    const auto same = key == aKey;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return same &&
+           state.load(std::memory_order_relaxed) == ready &&
+           version.load(std::memory_order_relaxed) == versionBefore;
+}
+
+/* SharedClientDb::Shared */
+
+SharedClientDb::Shared::Shared(const int aCapacity):
+    capacity(aCapacity),
+    slots(aCapacity)
+{
+}
+
+/* SharedClientDb::Connections */
+
+SharedClientDb::Connections::Connections(const int aCapacity, const int aKidSlots):
+    capacity(aCapacity),
+    kidSlots(aKidSlots),
+    counters(aCapacity*aKidSlots)
+{
+    for (int i = 0; i < capacity*kidSlots; ++i)
+        counters[i].store(0, std::memory_order_relaxed);
+}
+
+int
+SharedClientDb::Connections::total(const int slot)
+{
+    int result = 0;
+    for (int kid = 0; kid < kidSlots; ++kid)
+        result += counter(slot, kid).load(std::memory_order_relaxed);
+    return result;
+}
+
+/* lookups */
+
+/// whether the given slot holds an entry that nobody needs
+static bool
+Reusable(const int index, Slot &slot, const time_t now)
+{
+    if (now - slot.lastSeen.load(std::memory_order_relaxed) <= MaxRateWindow)
+        return false;
+    return TheConnections->total(index) == 0;
+}
+
+/// Finds the slot with the given key. If there is no such slot and
+/// `adding` is true, adds one, replacing an unused empty or stale entry.
+/// \returns the slot index or -1
+static int
+FindSlot(const Key &key, const bool adding)
+{
+    if (!TheTable)
+        return -1;
+
+    const auto now = squid_curtime;
+    const auto capacity = TheTable->capacity;
+    const auto start = static_cast<int>(key.hash() % static_cast<uint32_t>(capacity));
+    auto candidate = -1;
+    for (int probe = 0; probe < MaxProbes && probe < capacity; ++probe) {
+        const int index = (start + probe) % capacity;
+        auto &slot = TheTable->slots[index];
+        if (slot.matches(key))
+            return index;
+        const auto state = slot.state.load(std::memory_order_acquire);
+        if (candidate < 0 && (state == Slot::empty || (state == Slot::ready && Reusable(index, slot, now))))
+            candidate = index;
+    }
+
+    if (!adding || candidate < 0)
+        return -1;
+
+    auto &slot = TheTable->slots[candidate];
+    auto expected = slot.state.load(std::memory_order_relaxed);
+    if (expected == Slot::writing || !slot.state.compare_exchange_strong(expected, Slot::writing, std::memory_order_acquire))
+        return -1; // another kid is (re)using this slot
+
+    // a reader may have used the old entry since we checked it
+    if (expected == Slot::ready && !Reusable(candidate, slot, now)) {
+        slot.state.store(Slot::ready, std::memory_order_release);
+        return -1;
+    }
+
+    slot.version.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.key = key;
+    slot.lastSeen.store(now, std::memory_order_relaxed);
+    for (auto &counter: slot.requests)
+        counter.store(0, std::memory_order_relaxed);
+    slot.state.store(Slot::ready, std::memory_order_release);
+    debugs(0, 7, "added slot " << candidate << " kind=" << int(key.kind));
+    return candidate;
+}
+
+int
+SharedClientDb::Established(const Ip::Address &addr, const int delta)
+{
+    if (!CountingConnections)
+        return -1;
+
+    const auto index = FindSlot(Key::Address(addr), delta > 0);
+    if (index < 0) {
+        debugs(0, 3, "no room for " << addr);
+        return -1;
+    }
+
+    if (delta) {
+        // Only this kid updates its counter. Do not go below zero: a closing
+        // connection may not have been counted (e.g., the table was full when
+        // it was accepted), and the slot may have been reused since.
+        auto &counter = TheConnections->counter(index, KidIdentifier);
+        const auto current = counter.load(std::memory_order_relaxed);
+        const auto change = std::max<int>(delta, -current);
+        if (change != delta)
+            debugs(0, 5, "ignoring " << (change - delta) << " uncounted connection(s) from " << addr);
+        counter.fetch_add(change, std::memory_order_relaxed);
+        TheTable->slots[index].lastSeen.store(squid_curtime, std::memory_order_relaxed);
+    }
+    return TheConnections->total(index);
+}
+
+int
+SharedClientDb::CountRequest(const Key &key, const int seconds)
+{
+    const auto index = FindSlot(key, true);
+    if (index < 0)
+        return -1;
+
+    auto &slot = TheTable->slots[index];
+    slot.countRequest(squid_curtime);
+    return slot.recentRequests(squid_curtime, seconds);
+}
+
+int
+SharedClientDb::RecentRequests(const Key &key, const int seconds)
+{
+    const auto index = FindSlot(key, false);
+    if (index < 0)
+        return -1;
+
+    return TheTable->slots[index].recentRequests(squid_curtime, seconds);
+}
+
+/// creates and opens the shared client table segments
+class SharedClientDbRr: public Ipc::Mem::RegisteredRunner
+{
+public:
+    /* RegisteredRunner API */
+    void useConfig() override;
+    ~SharedClientDbRr() override;
+
+protected:
+    /* Ipc::Mem::RegisteredRunner API */
+    void create() override;
+    void open() override;
+
+private:
+    Ipc::Mem::Owner<Shared> *tableOwner = nullptr;
+    Ipc::Mem::Owner<Connections> *connectionsOwner = nullptr;
+};
+
+DefineRunnerRegistrator(SharedClientDbRr);
+
+void
+SharedClientDbRr::useConfig()
+{
+    if (Config.onoff.client_db && Config.sharedClientDb.size > 0 && Ipc::Mem::Segment::Enabled())
+        Ipc::Mem::RegisteredRunner::useConfig();
+}
+
+void
+SharedClientDbRr::create()
+{
+    const auto kidSlots = Ipc::KidSlots();
+    const auto capacity = Config.sharedClientDb.size;
+    debugs(0, 3, "capacity: " << capacity << " kid slots: " << kidSlots);
+    Must(!tableOwner && !connectionsOwner);
+    tableOwner = shm_new(Shared)(TableLabel, capacity);
+    connectionsOwner = shm_new(Connections)(ConnectionsLabel, capacity, kidSlots);
+}
+
+void
+SharedClientDbRr::open()
+{
+    Must(!TheTable && !TheConnections);
+    TheTable = shm_old(Shared)(TableLabel);
+    TheConnections = shm_old(Connections)(ConnectionsLabel);
+
+    // unexpected kids may look up but cannot maintain connection counts
+    CountingConnections = 0 <= KidIdentifier && KidIdentifier < TheConnections->kidSlots;
+    if (!CountingConnections)
+        return;
+
+    // a restarted kid does not inherit connections of its predecessor
+    for (int slot = 0; slot < TheConnections->capacity; ++slot)
+        TheConnections->counter(slot, KidIdentifier).store(0, std::memory_order_relaxed);
+}
+
+SharedClientDbRr::~SharedClientDbRr()
+{
+    delete tableOwner;
+    delete connectionsOwner;
+}
+
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_SHAREDCLIENTDB_H
+#define SQUID_SRC_SHAREDCLIENTDB_H
+
+#include "ip/forward.h"
+#include "sbuf/forward.h"
+
+#include <cstdint>
+
+/// Per-client counters shared by all kids (see shared_client_db_size).
+/// Unlike the kid-local client_db, these counters reflect client activity
+/// across all SMP workers. Clients are identified by their binary IP address
+/// or by a digest of their authenticated user name. All counters are
+/// atomic; no locks are used.
+namespace SharedClientDb
+{
+
+/// the longest supported request rate measurement period (in seconds)
+const int MaxRateWindow = 60;
+
+/// identifies a table entry
+class Key
+{
+public:
+    /// the kinds of identified clients
+    enum Kind : uint8_t { none = 0, address, user };
+
+    /// a key for the given client IP address
+    static Key Address(const Ip::Address &);
+
+    /// a key for the given authenticated user name
+    static Key User(const SBuf &name);
+
+    bool operator ==(const Key &other) const;
+
+    /// a hash value for finding the entry in the table
+    uint32_t hash() const;
+
+    Kind kind = none;
+    unsigned char bytes[16] = {}; ///< IPv6 (or v4-mapped) address or user name MD5 digest
+};
+
+/// Adjusts the number of connections this kid has accepted from the given
+/// client address. With zero delta, just reports the current total.
+/// \returns the number of such connections across all kids or, if the table
+/// is disabled or full, a negative number
+int Established(const Ip::Address &, int delta);
+
+/// counts a new request from the given client
+/// \returns the number of requests from that client during the last
+/// `seconds` (including this request) or, if the table is disabled or full,
+/// a negative number
+int CountRequest(const Key &, int seconds);
+
+/// \returns the number of requests from the given client during the last
+/// `seconds` or, if the table is disabled or has no such client, a negative number
+int RecentRequests(const Key &, int seconds);
+
+} // namespace SharedClientDb
+
+#endif /* SQUID_SRC_SHAREDCLIENTDB_H */
+
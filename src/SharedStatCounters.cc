@@ -0,0 +1,410 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 18    Cache Manager Statistics */
+
+#include "squid.h"
+#include "base/PackableStream.h"
+#include "base/RunnersRegistry.h"
+#include "debug/Stream.h"
+#include "event.h"
+#include "globals.h"
+#include "ipc/Kids.h"
+#include "ipc/mem/FlexibleArray.h"
+#include "ipc/mem/Pointer.h"
+#include "ipc/mem/Segment.h"
+#include "mgr/Registration.h"
+#include "StatCounters.h"
+#include "StatHist.h"
+#include "Store.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+// Kid statCounter snapshots in shared memory and their OpenMetrics export.
+//
+// Each kid periodically mirrors selected statCounter fields and service time
+// histograms into its own slot of a shared memory segment, using relaxed
+// atomic stores. The "metrics" cache manager report loads all slots, so the
+// kid receiving a scraper request answers it without querying other kids.
+
+namespace SharedStatCounters
+{
+
+/// an exported statCounter field
+class CounterDescription
+{
+public:
+    const char *name; ///< metric family name (without the "squid_" prefix)
+    const char *help; ///< metric family description
+    uint64_t (*value)(const StatCounters &); ///< extracts the current value
+};
+
+/// an exported statCounter service time histogram
+class HistogramDescription
+{
+public:
+    const char *name; ///< metric family name (without the "squid_" prefix)
+    const char *help; ///< metric family description
+    const StatHist &(*histogram)(const StatCounters &); ///< extracts the histogram
+    double scale; ///< converts histogram values to seconds
+};
+
+static uint64_t
+Bytes(const ByteCounter &counter)
+{
+    return (static_cast<uint64_t>(counter.kb) << 10) + counter.bytes;
+}
+
+static const CounterDescription Counters[] = {
+    { "client_http_requests", "HTTP requests received from clients",
+      [](const StatCounters &c) -> uint64_t { return c.client_http.requests; } },
+    { "client_http_hits", "HTTP requests satisfied from the cache",
+      [](const StatCounters &c) -> uint64_t { return c.client_http.hits; } },
+    { "client_http_errors", "HTTP requests that resulted in errors",
+      [](const StatCounters &c) -> uint64_t { return c.client_http.errors; } },
+    { "client_http_received_bytes", "bytes received from HTTP clients",
+      [](const StatCounters &c) { return Bytes(c.client_http.kbytes_in); } },
+    { "client_http_sent_bytes", "bytes sent to HTTP clients",
+      [](const StatCounters &c) { return Bytes(c.client_http.kbytes_out); } },
+    { "client_http_hit_sent_bytes", "cache hit bytes sent to HTTP clients",
+      [](const StatCounters &c) { return Bytes(c.client_http.hit_kbytes_out); } },
+    { "server_requests", "requests sent to servers and peers",
+      [](const StatCounters &c) -> uint64_t { return c.server.all.requests; } },
+    { "server_errors", "failed requests to servers and peers",
+      [](const StatCounters &c) -> uint64_t { return c.server.all.errors; } },
+    { "server_received_bytes", "bytes received from servers and peers",
+      [](const StatCounters &c) { return Bytes(c.server.all.kbytes_in); } },
+    { "server_sent_bytes", "bytes sent to servers and peers",
+      [](const StatCounters &c) { return Bytes(c.server.all.kbytes_out); } },
+    { "icp_received_packets", "ICP packets received",
+      [](const StatCounters &c) -> uint64_t { return c.icp.pkts_recv; } },
+    { "icp_sent_packets", "ICP packets sent",
+      [](const StatCounters &c) -> uint64_t { return c.icp.pkts_sent; } },
+    { "htcp_received_packets", "HTCP packets received",
+      [](const StatCounters &c) -> uint64_t { return c.htcp.pkts_recv; } },
+    { "htcp_sent_packets", "HTCP packets sent",
+      [](const StatCounters &c) -> uint64_t { return c.htcp.pkts_sent; } },
+    { "aborted_requests", "client requests aborted before completion",
+      [](const StatCounters &c) -> uint64_t { return c.aborted_requests; } },
+    { "swap_ins", "cache entries loaded from disk",
+      [](const StatCounters &c) -> uint64_t { return c.swap.ins; } },
+    { "swap_outs", "cache entries written to disk",
+      [](const StatCounters &c) -> uint64_t { return c.swap.outs; } },
+    { "hit_validation_attempts", "cache hit validation attempts",
+      [](const StatCounters &c) -> uint64_t { return c.hitValidation.attempts; } },
+    { "hit_validation_failures", "failed cache hit validations",
+      [](const StatCounters &c) -> uint64_t { return c.hitValidation.failures; } },
+    { "select_loops", "main I/O loop iterations",
+      [](const StatCounters &c) -> uint64_t { return c.select_loops; } },
+    { "page_faults", "page faults with physical I/O",
+      [](const StatCounters &c) -> uint64_t { return c.page_faults; } },
+};
+
+static const HistogramDescription Histograms[] = {
+    { "client_http_service_seconds", "HTTP transaction response times",
+      [](const StatCounters &c) -> const StatHist & { return c.client_http.allSvcTime; }, 1e-3 },
+    { "client_http_miss_service_seconds", "cache miss response times",
+      [](const StatCounters &c) -> const StatHist & { return c.client_http.missSvcTime; }, 1e-3 },
+    { "client_http_near_miss_service_seconds", "revalidated miss response times",
+      [](const StatCounters &c) -> const StatHist & { return c.client_http.nearMissSvcTime; }, 1e-3 },
+    { "client_http_near_hit_service_seconds", "revalidated hit response times",
+      [](const StatCounters &c) -> const StatHist & { return c.client_http.nearHitSvcTime; }, 1e-3 },
+    { "client_http_hit_service_seconds", "cache hit response times",
+      [](const StatCounters &c) -> const StatHist & { return c.client_http.hitSvcTime; }, 1e-3 },
+    { "dns_service_seconds", "DNS lookup response times",
+      [](const StatCounters &c) -> const StatHist & { return c.dns.svcTime; }, 1e-3 },
+    { "phase_client_read_seconds", "request header reading times",
+      [](const StatCounters &c) -> const StatHist & { return c.client_http.phaseTimes[TransactionPhases::clientRead]; }, 1e-3 },
+    { "phase_request_parse_seconds", "request parsing times",
+      [](const StatCounters &c) -> const StatHist & { return c.client_http.phaseTimes[TransactionPhases::requestParse]; }, 1e-3 },
+    { "phase_http_access_seconds", "http_access and adapted_http_access check times",
+      [](const StatCounters &c) -> const StatHist & { return c.client_http.phaseTimes[TransactionPhases::httpAccess]; }, 1e-3 },
+    { "phase_adaptation_seconds", "request and response adaptation times",
+      [](const StatCounters &c) -> const StatHist & { return c.client_http.phaseTimes[TransactionPhases::adaptation]; }, 1e-3 },
+    { "phase_peer_selection_seconds", "next hop selection times",
+      [](const StatCounters &c) -> const StatHist & { return c.client_http.phaseTimes[TransactionPhases::peerSelection]; }, 1e-3 },
+    { "phase_dns_seconds", "next hop DNS resolution times",
+      [](const StatCounters &c) -> const StatHist & { return c.client_http.phaseTimes[TransactionPhases::dns]; }, 1e-3 },
+    { "phase_tcp_connect_seconds", "to-server TCP connection opening times",
+      [](const StatCounters &c) -> const StatHist & { return c.client_http.phaseTimes[TransactionPhases::tcpConnect]; }, 1e-3 },
+    { "phase_tls_handshake_seconds", "to-server TLS handshake times",
+      [](const StatCounters &c) -> const StatHist & { return c.client_http.phaseTimes[TransactionPhases::tlsHandshake]; }, 1e-3 },
+    { "phase_origin_ttfb_seconds", "times to the first response byte from servers",
+      [](const StatCounters &c) -> const StatHist & { return c.client_http.phaseTimes[TransactionPhases::originTtfb]; }, 1e-3 },
+    { "phase_store_write_seconds", "response storing times",
+      [](const StatCounters &c) -> const StatHist & { return c.client_http.phaseTimes[TransactionPhases::storeWrite]; }, 1e-3 },
+    { "phase_client_write_drain_seconds", "times spent waiting for clients to accept response bytes",
+      [](const StatCounters &c) -> const StatHist & { return c.client_http.phaseTimes[TransactionPhases::clientWriteDrain]; }, 1e-3 },
+};
+
+static const size_t CounterCount = sizeof(Counters)/sizeof(Counters[0]);
+static const size_t HistogramCount = sizeof(Histograms)/sizeof(Histograms[0]);
+
+/// the maximum number of exported bins per histogram; the last exported bin
+/// also accounts for any extra histogram bins
+static const unsigned int MaxBins = 300;
+
+/// how often (in seconds) each kid mirrors its statCounter
+static const double MirrorPeriod = 1.0;
+
+/// counters mirrored by a single kid
+class KidCounters
+{
+public:
+    KidCounters();
+
+    /// the last time this kid mirrored its counters (or zero)
+    std::atomic<time_t> updated;
+
+    std::atomic<uint64_t> counters[CounterCount];
+
+    /// histogram bin counts, indexed by HistogramDescription position
+    std::atomic<uint64_t> bins[HistogramCount][MaxBins];
+};
+
+/// shared memory segment layout: KidCounters indexed by KidIdentifier
+class Shared
+{
+public:
+    explicit Shared(int kidSlots);
+
+    size_t sharedMemorySize() const { return SharedMemorySize(slots); }
+    static size_t SharedMemorySize(const int kidSlots) { return sizeof(Shared) + kidSlots*sizeof(KidCounters); }
+
+    /// the given kid counters (or nil for unexpected kid identifiers)
+    KidCounters *at(int kid);
+
+    const int slots; ///< the number of kid slots
+    Ipc::Mem::FlexibleArray<KidCounters> kids; ///< slots storage
+};
+
+} // namespace SharedStatCounters
+
+using namespace SharedStatCounters;
+
+/// shared memory segment label
+static const char * const SegmentLabel = "stat_counters";
+
+/// the segment opened by this kid (if any)
+static Ipc::Mem::Pointer<Shared> TheShared;
+
+SharedStatCounters::KidCounters::KidCounters():
+    updated(0)
+{
+    for (auto &counter: counters)
+        counter.store(0, std::memory_order_relaxed);
+    for (auto &histogram: bins) {
+        for (auto &bin: histogram)
+            bin.store(0, std::memory_order_relaxed);
+    }
+}
+
+SharedStatCounters::Shared::Shared(const int kidSlots):
+    slots(kidSlots),
+    kids(kidSlots)
+{
+}
+
+KidCounters *
+SharedStatCounters::Shared::at(const int kid)
+{
+    return (0 <= kid && kid < slots) ? &kids[kid] : nullptr;
+}
+
+/// the number of exported bins of the given histogram
+static unsigned int
+ExportedBins(const StatHist &histogram)
+{
+    return std::min(histogram.capacity(), MaxBins);
+}
+
+/// copies current statCounter values into the given slot
+static void
+Mirror(KidCounters &slot)
+{
+    for (size_t i = 0; i < CounterCount; ++i)
+        slot.counters[i].store(Counters[i].value(statCounter), std::memory_order_relaxed);
+
+    for (size_t h = 0; h < HistogramCount; ++h) {
+        const auto &histogram = Histograms[h].histogram(statCounter);
+        uint64_t counts[MaxBins] = {};
+        const auto lastBin = ExportedBins(histogram) - 1;
+        for (unsigned int bin = 0; bin < histogram.capacity(); ++bin)
+            counts[std::min(bin, lastBin)] += histogram.binCount(bin);
+        for (unsigned int bin = 0; bin < MaxBins; ++bin)
+            slot.bins[h][bin].store(counts[bin], std::memory_order_relaxed);
+    }
+
+    slot.updated.store(squid_curtime, std::memory_order_relaxed);
+}
+
+/// mirrors our statCounter if we have a slot
+static void
+MirrorOurs()
+{
+    if (!TheShared)
+        return;
+    if (const auto slot = TheShared->at(KidIdentifier))
+        Mirror(*slot);
+}
+
+static void
+MirrorEvent(void *)
+{
+    MirrorOurs();
+    eventAdd("SharedStatCounters::MirrorEvent", &MirrorEvent, nullptr, MirrorPeriod, 0, false);
+}
+
+/// writes the given kid slot label
+static std::ostream &
+KidLabel(std::ostream &os, const int kid)
+{
+    return os << "kid=\"" << kid << '"';
+}
+
+static void
+ExportCounters(std::ostream &os, Shared &shared)
+{
+    for (size_t i = 0; i < CounterCount; ++i) {
+        const auto name = Counters[i].name;
+        os << "# TYPE squid_" << name << " counter\n";
+        os << "# HELP squid_" << name << ' ' << Counters[i].help << "\n";
+        for (int kid = 0; kid < shared.slots; ++kid) {
+            const auto &slot = *shared.at(kid);
+            if (!slot.updated.load(std::memory_order_relaxed))
+                continue;
+            os << "squid_" << name << "_total{";
+            KidLabel(os, kid) << "} " << slot.counters[i].load(std::memory_order_relaxed) << "\n";
+        }
+    }
+}
+
+static void
+ExportHistograms(std::ostream &os, Shared &shared)
+{
+    for (size_t h = 0; h < HistogramCount; ++h) {
+        const auto &description = Histograms[h];
+        const auto name = description.name;
+        // all kids use the same bins as our own histogram
+        const auto &histogram = description.histogram(statCounter);
+        const auto bins = ExportedBins(histogram);
+
+        os << "# TYPE squid_" << name << " histogram\n";
+        os << "# UNIT squid_" << name << " seconds\n";
+        os << "# HELP squid_" << name << ' ' << description.help << "\n";
+        for (int kid = 0; kid < shared.slots; ++kid) {
+            const auto &slot = *shared.at(kid);
+            if (!slot.updated.load(std::memory_order_relaxed))
+                continue;
+
+            uint64_t cumulative = 0;
+            for (unsigned int bin = 0; bin < bins; ++bin) {
+                cumulative += slot.bins[h][bin].load(std::memory_order_relaxed);
+                os << "squid_" << name << "_bucket{";
+                KidLabel(os, kid) << ",le=\"";
+                if (bin + 1 < bins) {
+                    // the default six digits may merge neighboring bounds into one le value
+                    const auto savedPrecision = os.precision(std::numeric_limits<double>::max_digits10);
+                    os << histogram.binUpperBound(bin) * description.scale;
+                    (void)os.precision(savedPrecision);
+                } else
+                    os << "+Inf";
+                os << "\"} " << cumulative << "\n";
+            }
+            os << "squid_" << name << "_count{";
+            KidLabel(os, kid) << "} " << cumulative << "\n";
+        }
+    }
+}
+
+static void
+ExportUpdateTimes(std::ostream &os, Shared &shared)
+{
+    const auto name = "stat_counters_updated_timestamp_seconds";
+    os << "# TYPE squid_" << name << " gauge\n";
+    os << "# UNIT squid_" << name << " seconds\n";
+    os << "# HELP squid_" << name << " when the kid last published its counters\n";
+    for (int kid = 0; kid < shared.slots; ++kid) {
+        const auto updated = shared.at(kid)->updated.load(std::memory_order_relaxed);
+        if (!updated)
+            continue;
+        os << "squid_" << name << "{";
+        KidLabel(os, kid) << "} " << updated << "\n";
+    }
+}
+
+/// writes an OpenMetrics text exposition of all kids' counters
+static void
+Export(StoreEntry *entry)
+{
+    PackableStream os(*entry);
+    if (TheShared) {
+        // make our numbers current; other kids publish theirs on schedule
+        MirrorOurs();
+        ExportCounters(os, *TheShared);
+        ExportHistograms(os, *TheShared);
+        ExportUpdateTimes(os, *TheShared);
+    }
+    os << "# EOF\n";
+}
+
+/// creates and opens the shared counters segment
+class SharedStatCountersRr: public Ipc::Mem::RegisteredRunner
+{
+public:
+    /* RegisteredRunner API */
+    void useConfig() override;
+    ~SharedStatCountersRr() override;
+
+protected:
+    /* Ipc::Mem::RegisteredRunner API */
+    void create() override;
+    void open() override;
+
+private:
+    Ipc::Mem::Owner<Shared> *owner = nullptr;
+};
+
+DefineRunnerRegistrator(SharedStatCountersRr);
+
+void
+SharedStatCountersRr::useConfig()
+{
+    Mgr::RegisterAction("metrics",
+                        "Statistics of all kids in OpenMetrics format",
+                        Export, Mgr::Protected::no, Mgr::Atomic::yes,
+                        Mgr::Format::openMetrics, Mgr::Scope::allKids);
+
+    if (Ipc::Mem::Segment::Enabled())
+        Ipc::Mem::RegisteredRunner::useConfig();
+}
+
+void
+SharedStatCountersRr::create()
+{
+    const auto slots = Ipc::KidSlots();
+    debugs(18, 3, "slots: " << slots);
+    Must(!owner);
+    owner = shm_new(Shared)(SegmentLabel, slots);
+}
+
+void
+SharedStatCountersRr::open()
+{
+    Must(!TheShared);
+    TheShared = shm_old(Shared)(SegmentLabel);
+    MirrorEvent(nullptr);
+}
+
+SharedStatCountersRr::~SharedStatCountersRr()
+{
+    delete owner;
+}
+
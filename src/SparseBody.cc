@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "SparseBody.h"
+
+void
+SparseBody::add(int64_t offset, const SBuf &newBytes)
+{
+    auto bytes = newBytes;
+
+    // merge with the preceding piece that overlaps or touches the new one
+    auto next = pieces_.upper_bound(offset);
+    if (next != pieces_.begin()) {
+        const auto previous = std::prev(next);
+        const auto previousEnd = previous->first + previous->second.length();
+        if (previousEnd >= offset) {
+            auto merged = previous->second.substr(0, offset - previous->first);
+            merged.append(bytes);
+            const auto bytesEnd = offset + bytes.length();
+            if (previousEnd > bytesEnd)
+                merged.append(previous->second.substr(bytesEnd - previous->first));
+            offset = previous->first;
+            bytes = merged;
+            pieces_.erase(previous);
+        }
+    }
+
+    // absorb the following pieces that overlap or touch the new one
+    next = pieces_.lower_bound(offset);
+    while (next != pieces_.end() && next->first <= offset + static_cast<int64_t>(bytes.length())) {
+        const auto bytesEnd = offset + bytes.length();
+        const auto nextEnd = next->first + next->second.length();
+        if (nextEnd > bytesEnd)
+            bytes.append(next->second.substr(bytesEnd - next->first));
+        next = pieces_.erase(next);
+    }
+
+    pieces_.emplace(offset, bytes);
+}
+
+std::optional<SBuf>
+SparseBody::get(const int64_t offset, const int64_t size) const
+{
+    auto next = pieces_.upper_bound(offset);
+    if (next == pieces_.begin())
+        return std::nullopt;
+
+    const auto &piece = *std::prev(next);
+    if (piece.first + static_cast<int64_t>(piece.second.length()) < offset + size)
+        return std::nullopt; // a hole
+
+    return piece.second.substr(offset - piece.first, size);
+}
+
+uint64_t
+SparseBody::bytes() const
+{
+    uint64_t total = 0;
+    for (const auto &piece: pieces_)
+        total += piece.second.length();
+    return total;
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_SPARSEBODY_H
+#define SQUID_SRC_SPARSEBODY_H
+
+#include "sbuf/SBuf.h"
+
+#include <map>
+#include <optional>
+
+/// Known byte ranges of a message body (e.g., received in 206 responses).
+/// Overlapping and adjacent ranges are merged, so that any range of bytes
+/// that has been added is available as a single piece.
+class SparseBody
+{
+public:
+    /// stores body bytes starting at the given body offset; newer bytes
+    /// replace older ones stored at the same offsets
+    void add(int64_t offset, const SBuf &bytes);
+
+    /// the stored bytes covering the given range (if any)
+    std::optional<SBuf> get(int64_t offset, int64_t length) const;
+
+    /// the total number of stored bytes
+    uint64_t bytes() const;
+
+    /// the number of disjoint byte ranges
+    size_t pieces() const { return pieces_.size(); }
+
+private:
+    /// disjoint, non-adjacent byte ranges indexed by their offset
+    std::map<int64_t, SBuf> pieces_;
+};
+
+#endif /* SQUID_SRC_SPARSEBODY_H */
@@ -19,6 +19,7 @@
 #include "HeaderMangling.h"
 #include "helper/ChildConfig.h"
 #include "ip/Address.h"
+#include "ipc/forward.h"
 #if USE_DELAY_POOLS
 #include "MessageDelayPools.h"
 #endif
@@ -53,6 +54,7 @@ class HeaderManglers;
 class RefreshPattern;
 class RemovalPolicySettings;
 class HttpUpgradeProtocolAccess;
+class VaryNormalizer;
 
 namespace AnyP
 {
@@ -89,6 +91,8 @@ public:
     YesNoNone memShared; ///< whether the memory cache is shared among workers
     YesNoNone shmLocking; ///< shared_memory_locking
     size_t memMaxSize;
+    size_t rangeCacheMem; ///< range_cache_mem
+    Ipc::EvictionPolicy memCacheEviction; ///< memory_cache_eviction
 
     struct {
         int64_t min;
@@ -216,6 +220,12 @@ public:
     Helper::ChildConfig redirectChildren;
     Helper::ChildConfig storeIdChildren;
 
+    /// url_rewrite_cache_* and store_id_cache_* settings
+    struct {
+        time_t ttl; ///< how long to reuse a helper reply
+        size_t size; ///< the maximum memory used by remembered replies
+    } urlRewriteCache, storeIdCache;
+
     struct {
         char *surrogate_id;
     } Accel;
@@ -307,6 +317,7 @@ public:
 #if USE_CACHE_DIGESTS
 
         int digest_generation;
+        int digest_online_updates;
 #endif
 
         int vary_ignore_expire;
@@ -334,6 +345,7 @@ public:
         int WIN32_IpAddrChangeMonitor;
         int memory_cache_first;
         int memory_cache_disk;
+        int memory_cache_admission; ///< whether cache_mem uses Store::Admission
         int hostStrictVerify;
         int client_dst_passthru;
         int dns_mdns;
@@ -404,6 +416,7 @@ public:
         acl_access *forceRequestBodyContinuation;
         acl_access *serverPconnForNonretriable;
         acl_access *collapsedForwardingAccess;
+        acl_access *responseCompression;
     } accessList;
     AclDenyInfoList *denyInfoList;
 
@@ -467,6 +480,8 @@ public:
     HeaderWithAclList *reply_header_add;
     /// http_upgrade_request_protocols
     HttpUpgradeProtocolAccess *http_upgrade_request_protocols;
+    /// vary_normalize
+    VaryNormalizer *varyNormalizer;
     ///note
     Notes notes;
     char *coredump_dir;
@@ -507,7 +522,9 @@ public:
         // TODO: Remove when FuturePeerContext above becomes PeerContext
         /// \deprecated Legacy storage. Use defaultPeerContext instead.
         Security::ContextPointer *sslContext_;
+        size_t originSessionCacheSize; ///< tls_origin_session_cache_size
 #if USE_OPENSSL
+        int originEarlyData; ///< tls_origin_early_data
         char *foreignIntermediateCertsPath;
         acl_access *cert_error;
         sslproxy_cert_sign *cert_sign;
@@ -546,7 +563,36 @@ public:
         int connect_limit;
         int connect_gap;
         int connect_timeout;
+        size_t rtt_cache_size; ///< DestinationRtt memory limit
     } happyEyeballs;
+
+    struct {
+        int limit; ///< maximum number of spare to-origin connections
+        time_t window; ///< demand observation period
+    } serverPrewarm;
+
+    struct {
+        SBufList groups; ///< cache_peer groups selected using PeerHashRing
+        int balance; ///< maximum peer load relative to its fair share (percent)
+    } peerHashRing;
+
+    struct {
+        int size; ///< the number of milestone events each kid remembers
+    } transactionTrace;
+
+    struct {
+        int size; ///< the maximum number of shared client table entries
+    } sharedClientDb;
+
+    struct {
+        int size; ///< the maximum number of shared helper result table entries
+    } sharedHelperResults;
+
+    struct {
+        int64_t minSize; ///< smaller responses of known length are not compressed
+        int gzipLevel; ///< zlib compression level for gzip; zero disables gzip
+        int brLevel; ///< Brotli compression quality for br; zero disables br
+    } responseCompression;
 };
 
 extern SquidConfig Config;
@@ -12,6 +12,7 @@
 #include "base/ByteCounter.h"
 #include "comm/Incoming.h"
 #include "StatHist.h"
+#include "TransactionPhases.h"
 
 #if USE_CACHE_DIGESTS
 /** statistics for cache digests and other hit "predictors" */
@@ -50,6 +51,8 @@ public:
         StatHist nearHitSvcTime;
         StatHist hitSvcTime;
         StatHist allSvcTime;
+        /// milliseconds spent in each TransactionPhases phase
+        StatHist phaseTimes[TransactionPhases::phaseCount];
     } client_http;
 
     struct {
@@ -10,6 +10,7 @@
 #include "StatHist.h"
 
 #include <cmath>
+#include <limits>
 
 /* Local functions */
 static StatHistBinDumper statHistBinDumper;
@@ -87,6 +88,15 @@ StatHist::val(unsigned int bin) const
     return val_out((double) bin / scale_) + min_;
 }
 
+double
+StatHist::binUpperBound(const unsigned int bin) const
+{
+    if (bin + 1 >= capacity_)
+        return std::numeric_limits<double>::infinity();
+    // findBin() rounds to the nearest bin
+    return val_out((bin + 0.5) / scale_) + min_;
+}
+
 double
 statHistDeltaMedian(const StatHist & A, const StatHist & B)
 {
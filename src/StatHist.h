@@ -55,6 +55,15 @@ public:
      */
     double val(unsigned int bin) const;
 
+    /// the number of histogram bins
+    unsigned int capacity() const { return capacity_; }
+
+    /// the number of values counted in the given bin
+    bins_type binCount(unsigned int bin) const { return bins ? bins[bin] : 0; }
+
+    /// the largest value counted in the given bin (or infinity for the last bin)
+    double binUpperBound(unsigned int bin) const;
+
     /** increment the counter for the histogram entry
      * associated to the supplied value
      */
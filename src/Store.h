@@ -103,10 +103,12 @@ public:
     /// or similar instead.
     void clearPrivate();
     bool setPublicKey(const KeyScope keyScope = ksDefault);
-    /// Resets existing public key to a public key with default scope,
-    /// releasing the old default-scope entry (if any).
-    /// Does nothing if the existing public key already has default scope.
-    void clearPublicKeyScope();
+    /// Resets existing public key to a public key with default scope that
+    /// reflects response variance, releasing the old entry with that key (if
+    /// any). Does nothing if the existing public key already has default
+    /// scope and matches response variance. Makes the entry private on failures.
+    /// \returns whether the entry is still public
+    bool clearPublicKeyScope();
 
     /// \returns public key (if the entry has it) or nil (otherwise)
     const cache_key *publicKey() const {
@@ -244,6 +246,10 @@ public:
 
     swap_status_t swap_status:3;
 
+    /// the local cache digest epoch in which this entry was added to that
+    /// digest or zero (see store_digest.cc)
+    uint16_t digestEpoch;
+
 public:
     static size_t inUseCount();
 
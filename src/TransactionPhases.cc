@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "sbuf/SBuf.h"
+#include "TransactionPhases.h"
+
+#include <chrono>
+
+double
+TransactionPhases::totalMilliseconds(const Phase phase) const
+{
+    using milliseconds = std::chrono::duration<double, std::milli>;
+    return std::chrono::duration_cast<milliseconds>(total(phase)).count();
+}
+
+const char *
+TransactionPhases::Name(const Phase phase)
+{
+    static const char *Names[] = {
+        "client_read",
+        "request_parse",
+        "http_access",
+        "adaptation",
+        "peer_selection",
+        "dns",
+        "tcp_connect",
+        "tls_handshake",
+        "origin_ttfb",
+        "store_write",
+        "client_write_drain"
+    };
+    static_assert(sizeof(Names)/sizeof(Names[0]) == size_t(phaseCount), "all phases have names");
+    return size_t(phase) < size_t(phaseCount) ? Names[phase] : "unknown";
+}
+
+TransactionPhases::Phase
+TransactionPhases::FindByName(const SBuf &name)
+{
+    for (int i = 0; i < phaseCount; ++i) {
+        const auto phase = static_cast<Phase>(i);
+        if (name.cmp(Name(phase)) == 0)
+            return phase;
+    }
+    return phaseCount;
+}
+
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_TRANSACTIONPHASES_H
+#define SQUID_SRC_TRANSACTIONPHASES_H
+
+#include "base/Stopwatch.h"
+#include "sbuf/forward.h"
+
+/// Accumulates real time a master transaction spends in each of its
+/// well-known processing phases. A phase may be entered several times (e.g.,
+/// when retrying a failed to-server connection); the time of all such
+/// periods is summed. Phase times are reported via %phase_time logformat
+/// codes and per-phase statCounter histograms.
+class TransactionPhases
+{
+public:
+    /// measured transaction phases
+    enum Phase {
+        clientRead, ///< from the first request byte to the last request header byte
+        requestParse, ///< parsing request line and headers
+        httpAccess, ///< http_access and adapted_http_access checks
+        adaptation, ///< waiting for REQMOD and RESPMOD adaptation results
+        peerSelection, ///< choosing next hops (excluding DNS lookups)
+        dns, ///< resolving the selected next hops
+        tcpConnect, ///< opening to-server TCP connections
+        tlsHandshake, ///< encrypting to-server connections
+        originTtfb, ///< from sending the request to the first response byte
+        storeWrite, ///< storing response data in memory and disk caches
+        clientWriteDrain, ///< waiting for the client to accept response bytes
+        phaseCount ///< for iterations and validation
+    };
+
+    /// measures the given phase (if any) while in scope
+    class Scope
+    {
+    public:
+        Scope(TransactionPhases *phases, const Phase phase): phases_(phases), phase_(phase) { if (phases_) phases_->start(phase_); }
+        ~Scope() { if (phases_) phases_->stop(phase_); }
+
+        Scope(Scope &&) = delete; // no copying or moving of any kind
+
+    private:
+        TransactionPhases * const phases_; ///< the measuring transaction or nil
+        const Phase phase_; ///< the measured phase
+    };
+
+    /// starts a new period of the given phase (unless one is in progress)
+    void start(const Phase phase) {
+        auto &watch = stopwatches_[phase];
+        if (!watch.running())
+            watch.resume();
+    }
+
+    /// ends the current period of the given phase (if any)
+    void stop(const Phase phase) {
+        auto &watch = stopwatches_[phase];
+        if (watch.running())
+            watch.pause();
+    }
+
+    /// uses a phase measurement made before this transaction was created
+    void adopt(const Phase phase, const Stopwatch &measurement) { stopwatches_[phase] = measurement; }
+
+    /// whether the transaction has entered the given phase
+    bool entered(const Phase phase) const { return stopwatches_[phase].ran(); }
+
+    /// the time spent in the given phase so far, including the current period
+    Stopwatch::Clock::duration total(const Phase phase) const { return stopwatches_[phase].total(); }
+
+    /// the total time spent in the given phase so far (in milliseconds)
+    double totalMilliseconds(Phase) const;
+
+    /// a phase name suitable for configuration and reporting
+    static const char *Name(Phase);
+
+    /// the phase with the given Name() or phaseCount
+    static Phase FindByName(const SBuf &);
+
+private:
+    Stopwatch stopwatches_[phaseCount];
+};
+
+#endif /* SQUID_SRC_TRANSACTIONPHASES_H */
+
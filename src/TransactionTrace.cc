@@ -0,0 +1,307 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 18    Cache Manager Statistics */
+
+#include "squid.h"
+#include "base/PackableStream.h"
+#include "base/RunnersRegistry.h"
+#include "debug/Stream.h"
+#include "globals.h"
+#include "ipc/Kids.h"
+#include "ipc/mem/FlexibleArray.h"
+#include "ipc/mem/Pointer.h"
+#include "ipc/mem/Segment.h"
+#include "MasterXaction.h"
+#include "mgr/Registration.h"
+#include "SquidConfig.h"
+#include "Store.h"
+#include "TransactionTrace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <vector>
+
+namespace TransactionTrace
+{
+
+/// a recorded milestone; the shared memory ring element
+class Event
+{
+public:
+    Event(): sequence(0) {}
+
+    /// Kid-specific event number (or zero for unused and changing slots).
+    /// Zeroed before and set after each event update, so readers in other
+    /// kids copy the event and then check that its sequence has not changed.
+    std::atomic<uint64_t> sequence;
+
+    uint64_t xaction = 0; ///< MasterXaction::id
+    int64_t microseconds = 0; ///< event time since the epoch
+    Milestone milestone = Milestone::none;
+};
+
+/// shared memory segment layout: per-kid event rings, indexed by KidIdentifier
+class Shared
+{
+public:
+    Shared(int kidSlots, int ringCapacity);
+
+    size_t sharedMemorySize() const { return SharedMemorySize(slots, capacity); }
+    static size_t SharedMemorySize(const int kidSlots, const int ringCapacity) { return sizeof(Shared) + size_t(kidSlots)*ringCapacity*sizeof(Event); }
+
+    /// the first event of the given kid ring (or nil for unexpected kids)
+    Event *ring(int kid);
+
+    const int slots; ///< the number of kid rings
+    const int capacity; ///< the number of events in each ring
+    Ipc::Mem::FlexibleArray<Event> events; ///< all rings
+};
+
+} // namespace TransactionTrace
+
+using namespace TransactionTrace;
+
+/// shared memory segment label
+static const char * const SegmentLabel = "transaction_trace";
+
+/// the segment opened by this kid (if any)
+static Ipc::Mem::Pointer<Shared> TheShared;
+
+/// the ring of this kid (or nil when tracing is disabled)
+static Event *OurRing = nullptr;
+
+/// the number of events in OurRing
+static uint64_t OurCapacity = 0;
+
+/// the sequence number of the next event recorded by this kid
+static uint64_t NextSequence = 1;
+
+static const char *
+MilestoneName(const Milestone milestone)
+{
+    static const char *Names[] = {
+        "none",
+        "accepted",
+        "parsed",
+        "access_checked",
+        "resolved",
+        "connected",
+        "store_hit",
+        "store_miss",
+        "first_byte",
+        "last_byte"
+    };
+    static_assert(sizeof(Names)/sizeof(Names[0]) == size_t(Milestone::end), "all milestones have names");
+    const auto index = static_cast<size_t>(milestone);
+    return index < size_t(Milestone::end) ? Names[index] : "unknown";
+}
+
+TransactionTrace::Shared::Shared(const int kidSlots, const int ringCapacity):
+    slots(kidSlots),
+    capacity(ringCapacity),
+    events(kidSlots*ringCapacity)
+{
+}
+
+TransactionTrace::Event *
+TransactionTrace::Shared::ring(const int kid)
+{
+    return (0 <= kid && kid < slots) ? &events[kid*capacity] : nullptr;
+}
+
+void
+TransactionTrace::Note(const MasterXaction &mx, const Milestone milestone, const struct timeval &when)
+{
+    if (!OurRing)
+        return;
+
+    const auto sequence = NextSequence++;
+    auto &event = OurRing[sequence % OurCapacity];
+    event.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    event.xaction = mx.id.value;
+    event.microseconds = static_cast<int64_t>(when.tv_sec)*1000000 + when.tv_usec;
+    event.milestone = milestone;
+    event.sequence.store(sequence, std::memory_order_release);
+}
+
+void
+TransactionTrace::Note(const MasterXaction &mx, const Milestone milestone)
+{
+    Note(mx, milestone, current_time);
+}
+
+void
+TransactionTrace::Note(const MasterXaction::Pointer &mx, const Milestone milestone)
+{
+    if (mx)
+        Note(*mx, milestone, current_time);
+}
+
+/// a copy of a recorded Event
+class EventCopy
+{
+public:
+    int kid;
+    uint64_t sequence;
+    uint64_t xaction;
+    int64_t microseconds;
+    Milestone milestone;
+};
+
+/// writes the given time interval or timestamp in seconds
+static std::ostream &
+PrintSeconds(std::ostream &os, const int64_t microseconds)
+{
+    const auto sign = microseconds < 0 ? "-" : "";
+    const auto magnitude = microseconds < 0 ? -microseconds : microseconds;
+    return os << sign << (magnitude / 1000000) << '.' <<
+           std::setw(6) << std::setfill('0') << (magnitude % 1000000) << std::setfill(' ');
+}
+
+/// copies complete events from the given kid ring, skipping events that
+/// the kid is recording or overwrites while we are copying them
+static void
+CopyEvents(const int kid, std::vector<EventCopy> &events)
+{
+    const auto ring = TheShared->ring(kid);
+    for (int i = 0; i < TheShared->capacity; ++i) {
+        const auto &event = ring[i];
+        const auto sequence = event.sequence.load(std::memory_order_acquire);
+        if (!sequence)
+            continue; // unused or being written
+
+        const EventCopy copy{kid, sequence, event.xaction, event.microseconds, event.milestone};
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (event.sequence.load(std::memory_order_relaxed) != sequence)
+            continue; // changed while we were copying
+
+        events.push_back(copy);
+    }
+}
+
+/// reports recent transactions of all kids, one transaction at a time
+static void
+DumpTrace(StoreEntry *entry)
+{
+    PackableStream yaml(*entry);
+    const auto indent = "  ";
+
+    if (!TheShared) {
+        yaml << "transactions: [] # tracing is disabled\n";
+        return;
+    }
+
+    std::vector<EventCopy> events;
+    events.reserve(size_t(TheShared->slots)*TheShared->capacity);
+    for (int kid = 0; kid < TheShared->slots; ++kid)
+        CopyEvents(kid, events);
+
+    // MasterXaction IDs are kid-specific
+    const auto sameXaction = [](const EventCopy &a, const EventCopy &b) {
+        return a.kid == b.kid && a.xaction == b.xaction;
+    };
+
+    // group events by transaction, ordering transactions by their start time
+    std::sort(events.begin(), events.end(), [](const EventCopy &a, const EventCopy &b) {
+        if (a.kid != b.kid)
+            return a.kid < b.kid;
+        return a.xaction != b.xaction ? a.xaction < b.xaction : a.sequence < b.sequence;
+    });
+    std::vector<std::pair<size_t, size_t>> groups; // [first, last) event positions
+    for (size_t i = 0; i < events.size(); ++i) {
+        if (groups.empty() || !sameXaction(events[groups.back().first], events[i]))
+            groups.emplace_back(i, i);
+        groups.back().second = i + 1;
+    }
+    std::stable_sort(groups.begin(), groups.end(), [&events](const std::pair<size_t, size_t> &a, const std::pair<size_t, size_t> &b) {
+        return events[a.first].microseconds < events[b.first].microseconds;
+    });
+
+    yaml << "transactions:\n";
+    for (const auto &group: groups) {
+        const auto &first = events[group.first];
+        const auto &last = events[group.second - 1];
+        yaml << indent << "- id: master" << first.xaction << "\n";
+        yaml << indent << indent << "kid: " << first.kid << "\n";
+        yaml << indent << indent << "start: ";
+        PrintSeconds(yaml, first.microseconds) << "\n";
+        yaml << indent << indent << "duration: ";
+        PrintSeconds(yaml, last.microseconds - first.microseconds) << "\n";
+        yaml << indent << indent << "milestones:\n";
+        for (auto i = group.first; i < group.second; ++i) {
+            yaml << indent << indent << indent << "- [" << MilestoneName(events[i].milestone) << ", ";
+            PrintSeconds(yaml, events[i].microseconds - first.microseconds) << "]\n";
+        }
+    }
+}
+
+/// creates and opens the transaction trace segment
+class TransactionTraceRr: public Ipc::Mem::RegisteredRunner
+{
+public:
+    /* RegisteredRunner API */
+    void useConfig() override;
+    ~TransactionTraceRr() override;
+
+protected:
+    /* Ipc::Mem::RegisteredRunner API */
+    void create() override;
+    void open() override;
+
+private:
+    Ipc::Mem::Owner<Shared> *owner = nullptr;
+};
+
+DefineRunnerRegistrator(TransactionTraceRr);
+
+void
+TransactionTraceRr::useConfig()
+{
+    Mgr::RegisterAction("transaction_trace",
+                        "Recent Transaction Milestones",
+                        DumpTrace, Mgr::Protected::no, Mgr::Atomic::yes,
+                        Mgr::Format::yaml, Mgr::Scope::allKids);
+
+    if (Config.transactionTrace.size > 0 && Ipc::Mem::Segment::Enabled())
+        Ipc::Mem::RegisteredRunner::useConfig();
+}
+
+void
+TransactionTraceRr::create()
+{
+    const auto slots = Ipc::KidSlots();
+    const auto capacity = Config.transactionTrace.size;
+    debugs(18, 3, "slots: " << slots << " capacity: " << capacity);
+    Must(!owner);
+    owner = shm_new(Shared)(SegmentLabel, slots, capacity);
+}
+
+void
+TransactionTraceRr::open()
+{
+    Must(!TheShared);
+    TheShared = shm_old(Shared)(SegmentLabel);
+    OurRing = TheShared->ring(KidIdentifier);
+    if (!OurRing)
+        return;
+    OurCapacity = TheShared->capacity;
+
+    // a restarted kid continues the numbering of its predecessor
+    for (uint64_t i = 0; i < OurCapacity; ++i)
+        NextSequence = std::max(NextSequence, OurRing[i].sequence.load(std::memory_order_relaxed) + 1);
+}
+
+TransactionTraceRr::~TransactionTraceRr()
+{
+    delete owner;
+}
+
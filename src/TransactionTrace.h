@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_TRANSACTIONTRACE_H
+#define SQUID_SRC_TRANSACTIONTRACE_H
+
+#include "base/RefCount.h"
+
+#include <cstdint>
+
+class MasterXaction;
+
+/// Always-on record of master transaction milestones. Each kid appends
+/// compact binary events to its own fixed-size ring in shared memory (see
+/// transaction_trace_size). Recording an event costs a few stores; nothing
+/// is formatted until the transaction_trace cache manager report is
+/// requested, making it possible to reconstruct the timeline of a slow
+/// transaction after the fact.
+namespace TransactionTrace
+{
+
+/// recorded transaction milestones
+enum class Milestone : uint32_t {
+    none = 0, ///< an unused ring slot
+    accepted, ///< started reading the request
+    parsed, ///< parsed request headers
+    accessChecked, ///< finished http_access checks
+    resolved, ///< finished a DNS lookup for a selected destination
+    connected, ///< obtained an open to-server connection
+    storeHit, ///< decided to serve a cache hit
+    storeMiss, ///< decided to forward a cache miss
+    firstByte, ///< received the first response byte from the server
+    lastByte, ///< finished the client transaction
+    end ///< for iterations and validation
+};
+
+/// records a milestone of the given transaction reached at the given time
+void Note(const MasterXaction &, Milestone, const struct timeval &when);
+
+/// records a milestone of the given transaction reached now
+void Note(const MasterXaction &, Milestone);
+
+/// Note() wrapper for callers with a possibly nil transaction pointer
+void Note(const RefCount<MasterXaction> &, Milestone);
+
+} // namespace TransactionTrace
+
+#endif /* SQUID_SRC_TRANSACTIONTRACE_H */
+
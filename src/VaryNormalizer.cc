@@ -0,0 +1,229 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "acl/FilledChecklist.h"
+#include "acl/Gadgets.h"
+#include "base/TextException.h"
+#include "cache_cf.h"
+#include "ConfigParser.h"
+#include "debug/Stream.h"
+#include "http/WeightedList.h"
+#include "HttpHeader.h"
+#include "HttpRequest.h"
+#include "sbuf/Algorithms.h"
+#include "sbuf/List.h"
+#include "sbuf/Stream.h"
+#include "Store.h"
+#include "VaryNormalizer.h"
+
+#include <algorithm>
+
+/// adds comma-separated items to the given list
+static void
+ParseCommaList(const char *raw, SBufList &list)
+{
+    const SBuf items(raw);
+    SBuf::size_type start = 0;
+    while (start < items.length()) {
+        auto end = items.find(',', start);
+        if (end == SBuf::npos)
+            end = items.length();
+        if (end > start) {
+            auto item = items.substr(start, end - start);
+            item.toLower();
+            list.push_back(item);
+        }
+        start = end + 1;
+    }
+}
+
+VaryNormalizer::~VaryNormalizer()
+{
+    for (auto &rule: rules) {
+        for (auto &headerClass: rule.classes)
+            aclDestroyAclList(&headerClass.acls);
+    }
+}
+
+VaryNormalizer::Rule &
+VaryNormalizer::findOrAddRule(const SBuf &header, const Method method)
+{
+    const auto found = std::find_if(rules.begin(), rules.end(), [&header](const Rule &rule) {
+        return rule.header == header;
+    });
+    if (found == rules.end()) {
+        rules.emplace_back();
+        rules.back().header = header;
+        rules.back().method = method;
+        return rules.back();
+    }
+
+    // only "class" rules may span several directives
+    if (found->method != method || method != Method::classes)
+        throw TextException(ToSBuf("conflicting vary_normalize rules for ", header), Here());
+    return *found;
+}
+
+void
+VaryNormalizer::configure(ConfigParser &parser)
+{
+    const auto rawHeader = parser.NextToken();
+    if (!rawHeader)
+        throw TextException("expected a request header name", Here());
+    SBuf header(rawHeader);
+    header.toLower();
+
+    const auto rawMethod = parser.NextToken();
+    if (!rawMethod)
+        throw TextException("expected tokens, language, or class", Here());
+    const SBuf methodName(rawMethod);
+
+    if (methodName.cmp("tokens") == 0) {
+        auto &rule = findOrAddRule(header, Method::tokens);
+        while (const auto option = parser.NextToken()) {
+            if (strncmp(option, "only=", 5) == 0)
+                ParseCommaList(option + 5, rule.only);
+            else
+                throw TextException(ToSBuf("unsupported vary_normalize tokens option: ", option), Here());
+        }
+        return;
+    }
+
+    if (methodName.cmp("language") == 0) {
+        auto &rule = findOrAddRule(header, Method::language);
+        while (const auto option = parser.NextToken()) {
+            if (strncmp(option, "default=", 8) == 0) {
+                rule.defaultLanguage = SBuf(option + 8);
+                rule.defaultLanguage.toLower();
+            } else {
+                ParseCommaList(option, rule.languages);
+            }
+        }
+        if (rule.languages.empty())
+            throw TextException(ToSBuf("vary_normalize ", rawHeader, " language: expected at least one supported language tag"), Here());
+        return;
+    }
+
+    if (methodName.cmp("class") == 0) {
+        auto &rule = findOrAddRule(header, Method::classes);
+        const auto className = parser.NextToken();
+        if (!className)
+            throw TextException(ToSBuf("vary_normalize ", rawHeader, " class: expected a class name"), Here());
+        HeaderClass headerClass;
+        headerClass.name = SBuf(className);
+        if (!aclParseAclList(parser, &headerClass.acls, className))
+            throw TextException(ToSBuf("vary_normalize ", rawHeader, " class ", className, ": expected ACL names"), Here());
+        rule.classes.push_back(headerClass);
+        return;
+    }
+
+    throw TextException(ToSBuf("unsupported vary_normalize method: ", rawMethod), Here());
+}
+
+void
+VaryNormalizer::dump(StoreEntry *entry, const char *directiveName) const
+{
+    for (const auto &rule: rules) {
+        SBufStream os;
+        switch (rule.method) {
+        case Method::tokens:
+            os << directiveName << ' ' << rule.header << " tokens";
+            if (!rule.only.empty())
+                os << " only=" << JoinContainerToSBuf(rule.only.begin(), rule.only.end(), SBuf(","));
+            os << "\n";
+            break;
+
+        case Method::language:
+            os << directiveName << ' ' << rule.header << " language " <<
+               JoinContainerToSBuf(rule.languages.begin(), rule.languages.end(), SBuf(","));
+            if (!rule.defaultLanguage.isEmpty())
+                os << " default=" << rule.defaultLanguage;
+            os << "\n";
+            break;
+
+        case Method::classes:
+            for (const auto &headerClass: rule.classes) {
+                const auto line = ToSBuf(directiveName, ' ', rule.header, " class ", headerClass.name);
+                entry->append(line.rawContent(), line.length());
+                dump_acl_list(entry, headerClass.acls);
+                entry->append("\n", 1);
+            }
+            break;
+        }
+        const auto buf = os.buf();
+        entry->append(buf.rawContent(), buf.length());
+    }
+}
+
+void
+VaryNormalizer::normalize(const SBuf &name, HttpRequest &request, SBuf &value) const
+{
+    const auto rule = std::find_if(rules.begin(), rules.end(), [&name](const Rule &r) {
+        return r.header == name;
+    });
+    if (rule == rules.end())
+        return;
+
+    value = Apply(*rule, request, value);
+    debugs(11, 5, name << ": " << value);
+}
+
+void
+VaryNormalizer::normalizeForwarded(HttpRequest &request, HttpHeader &header) const
+{
+    for (const auto &rule: rules) {
+        // class names are not header values the next hop would understand
+        if (rule.method == Method::classes)
+            continue;
+
+        String raw;
+        if (!header.hasNamed(rule.header, &raw))
+            continue;
+
+        const auto value = Apply(rule, request, SBuf(raw.termedBuf()));
+        debugs(11, 5, "forwarding " << rule.header << ": " << value);
+        header.delByName(rule.header);
+        // an empty value selects the response for requests without the field
+        if (!value.isEmpty()) {
+            auto id = Http::HeaderLookupTable.lookup(rule.header).id;
+            if (id == Http::HdrType::BAD_HDR)
+                id = Http::HdrType::OTHER;
+            auto valueCopy = value; // until HttpHeaderEntry::value becomes SBuf
+            header.addEntry(new HttpHeaderEntry(id, rule.header, valueCopy.c_str()));
+        }
+    }
+}
+
+/// the canonical form of the given header value
+SBuf
+VaryNormalizer::Apply(const Rule &rule, HttpRequest &request, const SBuf &value)
+{
+    switch (rule.method) {
+    case Method::tokens:
+        return Http::CanonicalTokens(value, rule.only);
+    case Method::language:
+        return Http::LookupLanguage(value, rule.languages, rule.defaultLanguage);
+    case Method::classes:
+        return MatchClass(rule, request);
+    }
+    return value; // not reached
+}
+
+/// the name of the first configured class matching the request (or nothing)
+SBuf
+VaryNormalizer::MatchClass(const Rule &rule, HttpRequest &request)
+{
+    ACLFilledChecklist checklist(nullptr, &request);
+    for (const auto &headerClass: rule.classes) {
+        if (checklist.fastCheck(headerClass.acls).allowed())
+            return headerClass.name;
+    }
+    return SBuf();
+}
+
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_VARYNORMALIZER_H
+#define SQUID_SRC_VARYNORMALIZER_H
+
+#include "acl/forward.h"
+#include "http/forward.h"
+#include "sbuf/SBuf.h"
+
+#include <vector>
+
+class ConfigParser;
+class StoreEntry;
+
+/// vary_normalize configuration: Reduces request header values to canonical
+/// forms before they become a part of a Vary-based cache key (a.k.a. the
+/// vary mark) so that requests with equivalent header values share cached
+/// response variants.
+class VaryNormalizer
+{
+public:
+    VaryNormalizer() = default;
+    ~VaryNormalizer();
+    VaryNormalizer(VaryNormalizer &&) = delete; // no copying of any kind
+
+    /// parses a single vary_normalize directive
+    void configure(ConfigParser &);
+
+    /// reports configuration using squid.conf syntax
+    void dump(StoreEntry *, const char *directiveName) const;
+
+    /// replaces the given value of the named request header with its
+    /// canonical form (if the header has a normalization rule)
+    /// \param name a lowercase header name
+    void normalize(const SBuf &name, HttpRequest &, SBuf &value) const;
+
+    /// replaces the values of to-server request header fields that have
+    /// tokens or language rules with their canonical forms so that the next
+    /// hop selects its response using the values that key cached variants
+    void normalizeForwarded(HttpRequest &, HttpHeader &) const;
+
+private:
+    /// how a Rule reduces header values
+    enum class Method { tokens, language, classes };
+
+    /// a request header class defined by a "class" rule
+    class HeaderClass
+    {
+    public:
+        SBuf name; ///< the class name used as a normalized header value
+        ACLList *acls = nullptr; ///< requests matching these ACLs belong to the class
+    };
+
+    /// normalization rule for one request header
+    class Rule
+    {
+    public:
+        SBuf header; ///< the lowercase header name
+        Method method = Method::tokens;
+        SBufList only; ///< tokens: the list members to keep (or empty to keep all)
+        SBufList languages; ///< language: the supported language tags
+        SBuf defaultLanguage; ///< language: the tag for unsupported languages
+        std::vector<HeaderClass> classes; ///< classes: in configuration order
+    };
+
+    Rule &findOrAddRule(const SBuf &header, Method);
+
+    static SBuf Apply(const Rule &, HttpRequest &, const SBuf &value);
+    static SBuf MatchClass(const Rule &, HttpRequest &);
+
+    std::vector<Rule> rules; ///< at most one rule per header
+};
+
+#endif /* SQUID_SRC_VARYNORMALIZER_H */
+
@@ -21,6 +21,7 @@ XactionInitiator::ParseInitiators(const char *name)
     static InitiatorsMap SupportedInitiators = {
         {"client", initClient},
         {"peer-pool", initPeerPool},
+        {"origin-pool", initOriginPool},
         {"certificate-fetching", initCertFetcher},
         {"cache-digest", initCacheDigest},
         {"server", initServer},
@@ -31,6 +32,7 @@ XactionInitiator::ParseInitiators(const char *name)
         {"adaptation", initAdaptation},
         {"icon", initIcon},
         {"peer-mcast", initPeerMcast},
+        {"background-refresh", initBackgroundRefresh},
         {"internal", InternalInitiators()},
         {"all", AllInitiators()}
     };
@@ -18,6 +18,7 @@ public:
         initClient = 1 << 0, ///< HTTP or FTP client
         initPeerPool = 1 << 1, ///< PeerPool manager
         initCertFetcher = 1 << 2, ///< Missing intermediate certificates fetching code
+        initOriginPool = 1 << 3, ///< OriginPoolMgr connection prewarming
         initCacheDigest = 1 << 4, ///< Cache Digest fetching code
         initHtcp = 1<< 5, ///< HTCP client
         initIcp = 1 << 6, ///< the ICP/neighbors subsystem
@@ -27,6 +28,7 @@ public:
         initIcon = 1 << 11, ///< internal icons
         initPeerMcast = 1 << 12, ///< neighbor multicast
         initServer = 1 << 13, ///< HTTP/2 push request (not yet supported by Squid)
+        initBackgroundRefresh = 1 << 14, ///< refreshing cached responses in the background
 
         initAdaptationOrphan_ = 1 << 31 ///< eCAP-created HTTP message w/o an associated HTTP transaction (not ACL-detectable)
     };
@@ -46,7 +48,7 @@ public:
 
     /// internally generated requests
     static Initiators InternalInitiators() {
-        return initPeerPool | initCertFetcher | initCacheDigest | initIcp | initIcmp | initIpc | initAdaptation | initIcon | initPeerMcast;
+        return initPeerPool | initOriginPool | initCertFetcher | initCacheDigest | initIcp | initIcmp | initIpc | initAdaptation | initIcon | initPeerMcast | initBackgroundRefresh;
     }
 
     /// all initiators
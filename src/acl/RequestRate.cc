@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 28    Access Control */
+
+#include "squid.h"
+#include "acl/FilledChecklist.h"
+#include "acl/RequestRate.h"
+#include "ConfigParser.h"
+#include "debug/Stream.h"
+#include "HttpRequest.h"
+#include "parser/Tokenizer.h"
+#include "sbuf/Stream.h"
+#include "SharedClientDb.h"
+#include "SquidConfig.h"
+#if USE_AUTH
+#include "auth/Acl.h"
+#include "auth/UserRequest.h"
+#endif
+
+Acl::RequestRate::RequestRate(TypeName aTypeName):
+    typeName_(aTypeName)
+{
+}
+
+char const *
+Acl::RequestRate::typeString() const
+{
+    return typeName_;
+}
+
+const Acl::Options &
+Acl::RequestRate::options()
+{
+    static const Acl::BooleanOption ByUser("-u");
+    static const Acl::Options MyOptions = { &ByUser };
+    ByUser.linkWith(&byUser);
+    return MyOptions;
+}
+
+void
+Acl::RequestRate::parse()
+{
+    const auto t = ConfigParser::strtokFile();
+    if (!t)
+        throw TextException(ToSBuf("acl ", typeString(), " requires a requests[/seconds] limit"), Here());
+
+    Parser::Tokenizer tok{SBuf(t)};
+    int64_t requests = 0;
+    int64_t period = 1;
+    if (!tok.int64(requests, 10, false) || requests <= 0 || requests > std::numeric_limits<int>::max())
+        throw TextException(ToSBuf("acl ", typeString(), ": malformed or zero request limit: ", t), Here());
+    if (tok.skip('/') && (!tok.int64(period, 10, false) || period <= 0 || period > SharedClientDb::MaxRateWindow))
+        throw TextException(ToSBuf("acl ", typeString(), ": period must be between 1 and ", SharedClientDb::MaxRateWindow, " seconds: ", t), Here());
+    if (!tok.atEnd())
+        throw TextException(ToSBuf("acl ", typeString(), ": expected requests[/seconds] but got ", t), Here());
+
+    limit = static_cast<int>(requests);
+    seconds = static_cast<int>(period);
+
+    if (ConfigParser::strtokFile())
+        throw TextException(ToSBuf("acl ", typeString(), " accepts a single limit"), Here());
+}
+
+int
+Acl::RequestRate::matchClient(const SharedClientDb::Key &key, bool &counted) const
+{
+    // count each request once, even if it is checked against several ACLs
+    const auto requests = counted ?
+                          SharedClientDb::RecentRequests(key, seconds) :
+                          SharedClientDb::CountRequest(key, seconds);
+    counted = true;
+
+    if (requests < 0) {
+        debugs(28, 3, "no shared client table entry");
+        return 0;
+    }
+
+    debugs(28, 5, requests << " requests in " << seconds << "s vs. limit " << limit);
+    return requests > limit ? 1 : 0;
+}
+
+int
+Acl::RequestRate::match(ACLChecklist *cl)
+{
+    const auto checklist = Filled(cl);
+    auto &request = *checklist->request;
+
+    if (!byUser)
+        return matchClient(SharedClientDb::Key::Address(checklist->src_addr), request.flags.addressRateCounted);
+
+#if USE_AUTH
+    const auto answer = AuthenticateAcl(checklist, *this);
+    if (answer.allowed()) {
+        const SBuf userName(checklist->auth_user_request->username());
+        checklist->auth_user_request = nullptr;
+        return matchClient(SharedClientDb::Key::User(userName), request.flags.userRateCounted);
+    }
+
+    if (answer.denied())
+        return 0;
+
+    // authentication is required or has failed; we are done
+    if (checklist->keepMatching())
+        checklist->markFinished(answer, "AuthenticateAcl exception");
+    return -1;
+#else
+    return 0;
+#endif
+}
+
+SBufList
+Acl::RequestRate::dump() const
+{
+    SBufList sl;
+    sl.push_back(ToSBuf(limit, '/', seconds));
+    return sl;
+}
+
+void
+Acl::RequestRate::prepareForUse()
+{
+    if (!Config.onoff.client_db)
+        debugs(28, DBG_CRITICAL, "WARNING: '" << typeString() << "' ACL (" << name << ") won't work with client_db disabled");
+    else if (Config.sharedClientDb.size <= 0)
+        debugs(28, DBG_CRITICAL, "WARNING: '" << typeString() << "' ACL (" << name << ") won't work with shared_client_db_size set to zero");
+#if !USE_AUTH
+    if (byUser)
+        debugs(28, DBG_CRITICAL, "WARNING: '" << typeString() << "' ACL (" << name << ") cannot track users without authentication support");
+#endif
+}
+
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_ACL_REQUESTRATE_H
+#define SQUID_SRC_ACL_REQUESTRATE_H
+
+#include "acl/Node.h"
+#include "acl/Options.h"
+
+namespace SharedClientDb
+{
+class Key;
+}
+
+namespace Acl
+{
+
+/// request_rate ACL: matches requests of clients that sent more than the
+/// configured number of requests during a recent period, counting requests
+/// received by all kids (see SharedClientDb)
+class RequestRate : public Acl::Node
+{
+    MEMPROXY_CLASS(RequestRate);
+
+public:
+    explicit RequestRate(TypeName);
+
+    /* Acl::Node API */
+    char const *typeString() const override;
+    const Acl::Options &options() override;
+    void parse() override;
+    int match(ACLChecklist *) override;
+    SBufList dump() const override;
+    bool empty() const override { return false; }
+    bool valid() const override { return limit > 0; }
+    bool requiresRequest() const override { return true; }
+    void prepareForUse() override;
+
+private:
+    /// match() helper for the given client identity
+    int matchClient(const SharedClientDb::Key &, bool &counted) const;
+
+    TypeName typeName_; ///< the configured ACL type name
+
+    /// whether to track authenticated user names instead of client addresses
+    Acl::BooleanOptionValue byUser;
+
+    int limit = 0; ///< the maximum number of allowed requests
+    int seconds = 1; ///< the measurement period
+};
+
+} // namespace Acl
+
+#endif /* SQUID_SRC_ACL_REQUESTRATE_H */
+
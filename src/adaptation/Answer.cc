@@ -31,6 +31,16 @@ Adaptation::Answer::Forward(Http::Message *aMsg)
     return answer;
 }
 
+Adaptation::Answer
+Adaptation::Answer::Echo(Http::Message *aMsg)
+{
+    Answer answer(akForward);
+    answer.message = aMsg;
+    answer.unmodified = true;
+    debugs(93, 4, "echoing: " << (void*)aMsg);
+    return answer;
+}
+
 Adaptation::Answer
 Adaptation::Answer::Block(const SBuf &aRule)
 {
@@ -55,7 +65,7 @@ Adaptation::Answer::print(std::ostream &os) const
     return os << kind; // TODO: add more details
 }
 
-Adaptation::Answer::Answer(Kind aKind): final(true), kind(aKind)
+Adaptation::Answer::Answer(Kind aKind): final(true), unmodified(false), kind(aKind)
 {
 }
 
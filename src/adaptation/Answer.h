@@ -33,6 +33,7 @@ public:
 
     static Answer Error(bool final); ///< create an akError answer
     static Answer Forward(Http::Message *aMsg); ///< create an akForward answer
+    static Answer Echo(Http::Message *aMsg); ///< create an akForward answer with an unmodified message
     static Answer Block(const SBuf &aRule); ///< create an akBlock answer
 
     /// creates an Acl::Answer from akBlock answer
@@ -44,6 +45,7 @@ public:
     Http::MessagePointer message; ///< HTTP request or response to forward
     std::optional<SBuf> ruleId; ///< ACL (or similar rule) name that blocked forwarding
     bool final; ///< whether the error, if any, cannot be bypassed
+    bool unmodified; ///< whether the forwarded message is equivalent to the virgin one
     Kind kind; ///< the type of the answer
 
 private:
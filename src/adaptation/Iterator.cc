@@ -31,7 +31,8 @@ Adaptation::Iterator::Iterator(
     al(alp),
     theLauncher(nullptr),
     iterations(0),
-    adapted(false)
+    adapted(false),
+    modified(false)
 {
     if (theCause != nullptr)
         HTTPMSGLOCK(theCause);
@@ -76,7 +77,7 @@ void Adaptation::Iterator::step()
     Must(!theLauncher);
 
     if (thePlan.exhausted()) { // nothing more to do
-        sendAnswer(Answer::Forward(theMsg));
+        sendAnswer(forwardAnswer());
         Must(done());
         return;
     }
@@ -116,6 +117,8 @@ Adaptation::Iterator::noteAdaptationAnswer(const Answer &answer)
 {
     switch (answer.kind) {
     case Answer::akForward:
+        if (!answer.unmodified)
+            modified = true;
         handleAdaptedHeader(const_cast<Http::Message*>(answer.message.getRaw()));
         break;
 
@@ -196,7 +199,7 @@ void Adaptation::Iterator::handleAdaptationError(bool final)
 
     if (canIgnore && srcIntact && adapted) {
         debugs(85,3, "responding with older adapted msg");
-        sendAnswer(Answer::Forward(theMsg));
+        sendAnswer(forwardAnswer());
         mustStop("sent older adapted msg");
         return;
     }
@@ -207,6 +210,12 @@ void Adaptation::Iterator::handleAdaptationError(bool final)
     mustStop("group failure");
 }
 
+Adaptation::Answer
+Adaptation::Iterator::forwardAnswer() const
+{
+    return modified ? Answer::Forward(theMsg) : Answer::Echo(theMsg);
+}
+
 bool Adaptation::Iterator::doneAll() const
 {
     return Adaptation::Initiate::doneAll() && thePlan.exhausted();
@@ -63,6 +63,9 @@ protected:
     void handleAdaptationBlock(const Answer &answer);
     void handleAdaptationError(bool final);
 
+    /// an akForward answer with the current message
+    Answer forwardAnswer() const;
+
     ServiceGroupPointer theGroup; ///< the service group we are iterating
     ServicePlan thePlan; ///< which services to use and in what order
     Http::Message *theMsg; ///< the message being adapted (virgin for each step)
@@ -71,6 +74,7 @@ protected:
     CbcPointer<Adaptation::Initiate> theLauncher; ///< current transaction launcher
     int iterations; ///< number of steps initiated
     bool adapted; ///< whether the virgin message has been replaced
+    bool modified; ///< whether some service changed the virgin message
 };
 
 } // namespace Adaptation
@@ -20,7 +20,7 @@
 Adaptation::ServiceConfig::ServiceConfig():
     port(-1), method(methodNone), point(pointNone),
     bypass(false), maxConn(-1), onOverload(srvWait),
-    routing(false), ipv6(false)
+    routing(false), ipv6(false), noContentTtl(0), speculationWindow(0)
 {}
 
 const char *
@@ -136,6 +136,10 @@ Adaptation::ServiceConfig::parse()
                 debugs(3, DBG_PARSE_NOTE(DBG_IMPORTANT), "WARNING: IPv6 is disabled. ICAP service option ignored.");
         } else if (strcmp(name, "max-conn") == 0)
             grokked = grokLong(maxConn, name, value);
+        else if (strcmp(name, "cache-204") == 0)
+            grokked = grokLong(noContentTtl, name, value);
+        else if (strcmp(name, "speculate") == 0)
+            grokked = grokLong(speculationWindow, name, value);
         else if (strcmp(name, "on-overload") == 0) {
             grokked = grokOnOverload(onOverload, value);
             onOverloadSet = true;
@@ -165,6 +169,12 @@ Adaptation::ServiceConfig::parse()
     if (!onOverloadSet)
         onOverload = bypass ? srvBypass : srvWait;
 
+    if (speculationWindow && (method != methodRespmod || point != pointPreCache)) {
+        debugs(3, DBG_PARSE_NOTE(DBG_IMPORTANT), "WARNING: " << cfg_filename << ':' << config_lineno << ": " <<
+               "speculate option only applies to respmod_precache services; ignoring it");
+        speculationWindow = 0;
+    }
+
     // disable the TLS NPN extension if encrypted.
     // Squid advertises "http/1.1", which is wrong for ICAPS.
     if (secure.encryptTransport)
@@ -48,6 +48,8 @@ public:
     SrvBehaviour onOverload; ///< how to handle Max-Connections feature
     bool routing; ///< whether this service may determine the next service(s)
     bool ipv6;    ///< whether this service uses IPv6 transport (default IPv4)
+    long noContentTtl; ///< how long to reuse 204 (No Content) decisions (seconds)
+    long speculationWindow; ///< virgin body bytes to forward before the service answers
 
     // security settings for adaptation service
     Security::PeerOptions secure;
@@ -124,6 +124,20 @@ Adaptation::ServiceGroup::finalizeMsg(const char *msg, const String &culprit,
            id << "'");
 }
 
+uint64_t
+Adaptation::ServiceGroup::speculationWindow() const
+{
+    uint64_t window = 0;
+    for (Pos pos = 0; has(pos); ++pos) {
+        const auto service = at(pos);
+        if (!service || service->cfg().speculationWindow <= 0)
+            return 0;
+        const auto serviceWindow = static_cast<uint64_t>(service->cfg().speculationWindow);
+        window = pos ? min(window, serviceWindow) : serviceWindow;
+    }
+    return window;
+}
+
 Adaptation::ServicePointer Adaptation::ServiceGroup::at(const Pos pos) const
 {
     return FindService(services[pos]);
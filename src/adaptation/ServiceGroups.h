@@ -40,6 +40,10 @@ public:
 
     bool wants(const ServiceFilter &filter) const;
 
+    /// the number of virgin body bytes that may be forwarded before the
+    /// group answers: the smallest speculate value of group services
+    uint64_t speculationWindow() const;
+
 protected:
     ///< whether this group has a service at the specified pos
     bool has(const Pos pos) const {
@@ -413,7 +413,7 @@ Adaptation::Ecap::XactionRep::useVirgin()
     Must(!theVirginRep.raw().header->body_pipe == !clone->body_pipe);
 
     updateHistory(clone);
-    sendAnswer(Answer::Forward(clone));
+    sendAnswer(Answer::Echo(clone));
     Must(done());
 }
 
@@ -557,8 +557,7 @@ Adaptation::Ecap::XactionRep::vbContent(libecap::size_type o, libecap::size_type
     const BodyPipePointer &p = theVirginRep.raw().body_pipe;
     Must(p != nullptr);
 
-    // TODO: make MemBuf use size_t?
-    const size_t haveSize = static_cast<size_t>(p->buf().contentSize());
+    const size_t haveSize = p->buf().length();
 
     // convert to Squid types; XXX: check for overflow
     const uint64_t offset = static_cast<uint64_t>(o);
@@ -569,7 +568,7 @@ Adaptation::Ecap::XactionRep::vbContent(libecap::size_type o, libecap::size_type
                         haveSize - offset : static_cast<size_t>(s);
 
     // XXX: optimize by making theBody a shared_ptr (see Area::FromTemp*() src)
-    return libecap::Area::FromTempBuffer(p->buf().content() + offset,
+    return libecap::Area::FromTempBuffer(p->buf().rawContent() + offset,
                                          min(static_cast<size_t>(haveSize - offset), size));
 }
 
@@ -583,7 +582,7 @@ Adaptation::Ecap::XactionRep::vbContentShift(libecap::size_type n)
     BodyPipePointer &p = theVirginRep.raw().body_pipe;
     Must(p != nullptr);
     const size_t size = static_cast<size_t>(n); // XXX: check for overflow
-    const size_t haveSize = static_cast<size_t>(p->buf().contentSize()); // TODO: make MemBuf use size_t?
+    const size_t haveSize = p->buf().length();
     p->consume(min(size, haveSize));
 }
 
@@ -37,6 +37,7 @@ public:
     int client_username_encode;
     acl_access *repeat; ///< icap_retry ACL in squid.conf
     int repeat_limit; ///< icap_retry_limit in squid.conf
+    size_t no_content_cache_size; ///< icap_204_cache_size in squid.conf
 
     Config();
     ~Config() override;
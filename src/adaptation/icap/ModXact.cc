@@ -43,6 +43,8 @@ CBDATA_NAMESPACED_CLASS_INIT(Adaptation::Icap, ModXact);
 CBDATA_NAMESPACED_CLASS_INIT(Adaptation::Icap, ModXactLauncher);
 
 static constexpr auto TheBackupLimit = BodyPipe::MaxCapacity;
+// make sure TheBackupLimit is in-sync with the buffer size
+static_assert(TheBackupLimit <= BodyPipe::MaxCapacity, "virgin body backup must fit into the pipe buffer");
 
 const SBuf Adaptation::Icap::ChunkExtensionValueParser::UseOriginalBodyName("use-original-body");
 
@@ -98,6 +100,12 @@ void Adaptation::Icap::ModXact::start()
 
     canStartBypass = service().cfg().bypass;
 
+    if (service().cfg().noContentTtl > 0 && service().up() &&
+            service().cachedNoContent(noContentKey())) {
+        useCachedNoContent();
+        return;
+    }
+
     // it is an ICAP violation to send request to a service w/o known OPTIONS
     // and the service may is too busy for us: honor Max-Connections and such
     if (service().up() && service().availableForNew())
@@ -278,7 +286,7 @@ void Adaptation::Icap::ModXact::writePreviewBody()
     Must(state.writing == State::writingPreview);
     Must(virgin.body_pipe != nullptr);
 
-    const size_t sizeMax = (size_t)virgin.body_pipe->buf().contentSize();
+    const size_t sizeMax = virgin.body_pipe->buf().length();
     const size_t size = min(preview.debt(), sizeMax);
     writeSomeBody("preview body", size);
 
@@ -307,7 +315,7 @@ void Adaptation::Icap::ModXact::writePrimeBody()
     Must(state.writing == State::writingPrime);
     Must(virginBodyWriting.active());
 
-    const size_t size = (size_t)virgin.body_pipe->buf().contentSize();
+    const size_t size = virgin.body_pipe->buf().length();
     writeSomeBody("prime virgin body", size);
 
     if (virginBodyEndReached(virginBodyWriting)) {
@@ -335,7 +343,7 @@ void Adaptation::Icap::ModXact::writeSomeBody(const char *label, size_t size)
                "-byte chunk of " << label);
 
         openChunk(writeBuf, chunkSize, false);
-        writeBuf.append(virginContentData(virginBodyWriting), chunkSize);
+        writeBuf.append(virginContent(virginBodyWriting).rawContent(), chunkSize);
         closeChunk(writeBuf);
 
         virginBodyWriting.progress(chunkSize);
@@ -407,18 +415,19 @@ size_t Adaptation::Icap::ModXact::virginContentSize(const Adaptation::Icap::Virg
     // absolute start of unprocessed data
     const uint64_t dataStart = act.offset();
     // absolute end of buffered data
-    const uint64_t dataEnd = virginConsumed + virgin.body_pipe->buf().contentSize();
+    const uint64_t dataEnd = virginConsumed + virgin.body_pipe->buf().length();
     Must(virginConsumed <= dataStart && dataStart <= dataEnd);
     return static_cast<size_t>(dataEnd - dataStart);
 }
 
-// pointer to buffered virgin body data available for the specified activity
-const char *Adaptation::Icap::ModXact::virginContentData(const Adaptation::Icap::VirginBodyAct &act) const
+// buffered virgin body data available for the specified activity
+// the result shares storage with the virgin body pipe buffer
+SBuf Adaptation::Icap::ModXact::virginContent(const Adaptation::Icap::VirginBodyAct &act) const
 {
     Must(act.active());
     const uint64_t dataStart = act.offset();
     Must(virginConsumed <= dataStart);
-    return virgin.body_pipe->buf().content() + static_cast<size_t>(dataStart-virginConsumed);
+    return virgin.body_pipe->buf().substr(static_cast<size_t>(dataStart-virginConsumed));
 }
 
 void Adaptation::Icap::ModXact::virginConsume()
@@ -435,7 +444,7 @@ void Adaptation::Icap::ModXact::virginConsume()
     BodyPipe &bp = *virgin.body_pipe;
     const bool wantToPostpone = isRepeatable || canStartBypass || protectGroupBypass;
 
-    if (wantToPostpone && bp.buf().potentialSpaceSize() > 0) {
+    if (wantToPostpone && bp.spaceSize() > 0) {
         // Postponing may increase memory footprint and slow the HTTP side
         // down. Not postponing may increase the number of ICAP errors
         // if the ICAP service fails. Should the trade-off be configurable?
@@ -443,7 +452,7 @@ void Adaptation::Icap::ModXact::virginConsume()
         return;
     }
 
-    const size_t have = static_cast<size_t>(bp.buf().contentSize());
+    const size_t have = bp.buf().length();
     const uint64_t end = virginConsumed + have;
     uint64_t offset = end;
 
@@ -548,7 +557,7 @@ void Adaptation::Icap::ModXact::readMore()
 
     // do not fill readBuf if we have no space to store the result
     if (adapted.body_pipe != nullptr &&
-            !adapted.body_pipe->buf().hasPotentialSpace()) {
+            !adapted.body_pipe->spaceSize()) {
         debugs(93,3, "not reading because ICAP reply pipe is full");
         return;
     }
@@ -581,7 +590,7 @@ void Adaptation::Icap::ModXact::echoMore()
            adapted.body_pipe->status());
 
     if (sizeMax > 0) {
-        const size_t size = adapted.body_pipe->putMoreData(virginContentData(virginBodySending), sizeMax);
+        const size_t size = adapted.body_pipe->putMoreData(virginContent(virginBodySending));
         debugs(93,5, "echoed " << size << " out of " << sizeMax <<
                " bytes");
         virginBodySending.progress(size);
@@ -595,7 +604,7 @@ void Adaptation::Icap::ModXact::echoMore()
         stopSending(true);
     } else {
         debugs(93, 5, "has " <<
-               virgin.body_pipe->buf().contentSize() << " bytes " <<
+               virgin.body_pipe->buf().length() << " bytes " <<
                "and expects more to echo" << status());
         // TODO: timeout if virgin or adapted pipes are broken
     }
@@ -766,7 +775,8 @@ void Adaptation::Icap::ModXact::startSending()
 {
     disableRepeats("sent headers");
     disableBypass("sent headers", true);
-    sendAnswer(Answer::Forward(adapted.header));
+    // echoed messages let the initiator keep speculatively forwarded content
+    sendAnswer(al.icap.outcome == xoEcho ? Answer::Echo(adapted.header) : Answer::Forward(adapted.header));
 
     if (state.sending == State::sendingVirgin)
         echoMore();
@@ -920,6 +930,35 @@ void Adaptation::Icap::ModXact::handle204NoContent()
 {
     stopParsing();
     prepEchoing();
+    if (service().cfg().noContentTtl > 0)
+        service().cacheNoContent(noContentKey());
+}
+
+/// echoes the virgin message without contacting the service that has
+/// recently allowed an equivalent message without modification
+void Adaptation::Icap::ModXact::useCachedNoContent()
+{
+    debugs(93, 5, "reusing a recent 204 decision" << status());
+    prepEchoing();
+    startSending();
+    stopParsing(false);
+    stopWriting(false);
+}
+
+/// describes the virgin message for the purpose of caching 204 decisions
+SBuf Adaptation::Icap::ModXact::noContentKey() const
+{
+    const auto &request = virginRequest();
+    SBuf key;
+    key.append(request.method.image());
+    key.append(' ');
+    key.append(request.effectiveRequestUri());
+    if (const auto reply = dynamic_cast<const HttpReply*>(virgin.header))
+        key.appendf("\n%d", reply->sline.status());
+    key.append('\n');
+    if (const auto contentType = virgin.header->header.getStr(Http::HdrType::CONTENT_TYPE))
+        key.append(contentType);
+    return key;
 }
 
 void Adaptation::Icap::ModXact::handle206PartialContent()
@@ -1027,7 +1066,7 @@ void Adaptation::Icap::ModXact::prepPartialBodyEchoing(uint64_t pos)
 
     // check that use-original-body=N does not point beyond buffered data
     const uint64_t virginDataEnd = virginConsumed +
-                                   virgin.body_pipe->buf().contentSize();
+                                   virgin.body_pipe->buf().length();
     Must(pos <= virginDataEnd);
     virginBodySending.progress(static_cast<size_t>(pos));
 
@@ -1163,17 +1202,17 @@ void Adaptation::Icap::ModXact::parseBody()
 
     // the parser will throw on errors
     BodyPipeCheckout bpc(*adapted.body_pipe);
-    bodyParser->setPayloadBuffer(&bpc.buf);
+    bodyParser->setPayloadBuffer(&bpc.buf, BodyPipe::MaxCapacity);
     const bool parsed = bodyParser->parse(readBuf);
     readBuf = bodyParser->remaining(); // sync buffers after parse
     bpc.checkIn();
 
     debugs(93, 5, "have " << readBuf.length() << " body bytes after parsed all: " << parsed);
-    replyHttpBodySize += adapted.body_pipe->buf().contentSize();
+    replyHttpBodySize += adapted.body_pipe->buf().length();
 
     // TODO: expose BodyPipe::putSize() to make this check simpler and clearer
     // TODO: do we really need this if we disable when sending headers?
-    if (adapted.body_pipe->buf().contentSize() > 0) { // parsed something sometime
+    if (!adapted.body_pipe->buf().isEmpty()) { // parsed something sometime
         disableRepeats("sent adapted content");
         disableBypass("sent adapted content", true);
     }
@@ -1200,7 +1239,7 @@ void Adaptation::Icap::ModXact::parseBody()
 
     if (bodyParser->needsMoreSpace()) {
         Must(!doneSending()); // can hope for more space
-        Must(adapted.body_pipe->buf().contentSize() > 0); // paranoid
+        Must(!adapted.body_pipe->buf().isEmpty()); // paranoid
         // TODO: there should be a timeout in case the sink is broken
         // or cannot consume partial content (while we need more space)
     }
@@ -1841,9 +1880,6 @@ void Adaptation::Icap::ModXact::estimateVirginBody()
         Must(msg->body_pipe != nullptr);
         Must(msg->body_pipe == virgin.body_pipe);
         Must(virgin.body_pipe->setConsumerIfNotLate(this));
-
-        // make sure TheBackupLimit is in-sync with the buffer size
-        Must(TheBackupLimit <= static_cast<size_t>(msg->body_pipe->buf().max_capacity));
     } else {
         debugs(93, 6, "does not expect virgin body");
         Must(msg->body_pipe == nullptr);
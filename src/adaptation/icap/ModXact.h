@@ -208,7 +208,7 @@ private:
     bool doneWriting() const override { return state.doneWriting(); }
 
     size_t virginContentSize(const VirginBodyAct &act) const;
-    const char *virginContentData(const VirginBodyAct &act) const;
+    SBuf virginContent(const VirginBodyAct &act) const;
     bool virginBodyEndReached(const VirginBodyAct &act) const;
 
     void makeRequestHeaders(MemBuf &buf);
@@ -247,6 +247,8 @@ private:
     bool validate200Ok();
     void handle200Ok();
     void handle204NoContent();
+    void useCachedNoContent();
+    SBuf noContentKey() const;
     void handle206PartialContent();
     void handleUnknownScode();
 
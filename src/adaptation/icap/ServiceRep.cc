@@ -15,6 +15,8 @@
 #include "adaptation/icap/Options.h"
 #include "adaptation/icap/OptXact.h"
 #include "adaptation/icap/ServiceRep.h"
+#include "adaptation/icap/SharedServices.h"
+#include "base/ClpMap.h"
 #include "base/TextException.h"
 #include "comm/Connection.h"
 #include "compat/netdb.h"
@@ -24,13 +26,41 @@
 #include "globals.h"
 #include "HttpReply.h"
 #include "ip/tools.h"
+#include "sbuf/Algorithms.h"
+#include "sbuf/StringConvert.h"
 #include "SquidConfig.h"
 
+#include <memory>
+
 #define DEFAULT_ICAP_PORT   1344
 #define DEFAULT_ICAPS_PORT 11344
 
 CBDATA_NAMESPACED_CLASS_INIT(Adaptation::Icap, ServiceRep);
 
+/// recent 204 (No Content) decisions of all services with cache-204 option
+using NoContentDecisions = ClpMap<SBuf, bool>;
+
+/// remembered 204 decisions or nil (when caching is disabled)
+static NoContentDecisions *TheNoContentDecisions = nullptr;
+
+/// TheNoContentDecisions, (re)configured in accordance with icap_204_cache_size
+static NoContentDecisions *
+NoContentDecisionsCache()
+{
+    const auto limit = Adaptation::Icap::TheConfig.no_content_cache_size;
+    if (!limit) {
+        delete TheNoContentDecisions;
+        TheNoContentDecisions = nullptr;
+        return nullptr;
+    }
+
+    if (!TheNoContentDecisions)
+        TheNoContentDecisions = new NoContentDecisions(limit);
+    else if (TheNoContentDecisions->memLimit() != limit)
+        TheNoContentDecisions->setMemLimit(limit);
+    return TheNoContentDecisions;
+}
+
 Adaptation::Icap::ServiceRep::ServiceRep(const ServiceConfigPointer &svcCfg):
     AsyncJob("Adaptation::Icap::ServiceRep"), Adaptation::Service(svcCfg),
     tlsContext(writeableCfg().secure, sslContext),
@@ -41,11 +71,15 @@ Adaptation::Icap::ServiceRep::ServiceRep(const ServiceConfigPointer &svcCfg):
     theIdleConns(nullptr),
     isSuspended(nullptr), notifying(false),
     updateScheduled(false),
+    awaitingSharedOptions(false),
+    recheckScheduled(false),
+    theSharedSlot(-1),
     wasAnnouncedUp(true), // do not announce an "up" service at startup
     isDetached(false)
 {
     setMaxConnections();
     theIdleConns = new IdleConnList("ICAP Service", nullptr);
+    theIdleConns->onIdleClosure([this]() { shareConnections(); });
 }
 
 Adaptation::Icap::ServiceRep::~ServiceRep()
@@ -141,6 +175,7 @@ Adaptation::Icap::ServiceRep::getIdleConnection(const bool retriableXact)
 
     ++theBusyConns;
     debugs(93,3, "got connection: " << connection);
+    shareConnections();
     return connection;
 }
 
@@ -167,6 +202,7 @@ void Adaptation::Icap::ServiceRep::putConnection(const Comm::ConnectionPointer &
     --theBusyConns;
     // a connection slot released. Check if there are waiters....
     busyCheckpoint();
+    shareConnections();
 }
 
 // a wrapper to avoid exposing theIdleConns
@@ -180,6 +216,7 @@ void Adaptation::Icap::ServiceRep::noteConnectionFailed(const char *comment)
 {
     debugs(93, 3, "Connection failed: " << comment);
     --theBusyConns;
+    shareConnections();
 }
 
 void Adaptation::Icap::ServiceRep::setMaxConnections()
@@ -193,24 +230,62 @@ void Adaptation::Icap::ServiceRep::setMaxConnections()
         return;
     }
 
-    if (::Config.workers > 1 )
+    // SMP workers that share connection counts enforce the limit together
+    if (::Config.workers > 1 && sharedSlot() < 0)
         theMaxConnections /= ::Config.workers;
 }
 
+int
+Adaptation::Icap::ServiceRep::sharedSlot() const
+{
+    // a detached service yields shared state to its reconfigured replacement
+    if (detached())
+        return -1;
+
+    if (theSharedSlot < 0)
+        theSharedSlot = SharedServices::Find(cfg().key, cfg().uri);
+    return theSharedSlot;
+}
+
+void
+Adaptation::Icap::ServiceRep::shareConnections()
+{
+    const auto slot = sharedSlot();
+    if (slot >= 0)
+        SharedServices::NoteConnections(slot, theBusyConns, theIdleConns->count());
+}
+
+void
+Adaptation::Icap::ServiceRep::countConnections(int &busy, int &idle) const
+{
+    const auto slot = sharedSlot();
+    if (slot < 0) {
+        busy = theBusyConns;
+        idle = theIdleConns->count();
+        return;
+    }
+
+    // shareConnections() has already published our own counters
+    SharedServices::CountConnections(slot, busy, idle);
+}
+
 int Adaptation::Icap::ServiceRep::availableConnections() const
 {
     if (theMaxConnections < 0)
         return -1;
 
+    int busy, idle;
+    countConnections(busy, idle);
+
     // we are available if we can open or reuse connections
     // in other words, if we will not create debt
-    int available = max(0, theMaxConnections - theBusyConns);
+    int available = max(0, theMaxConnections - busy);
 
     if (!available && !connOverloadReported) {
         debugs(93, DBG_IMPORTANT, "WARNING: ICAP Max-Connections limit " <<
                "exceeded for service " << cfg().uri << ". Open connections now: " <<
-               theBusyConns + theIdleConns->count() << ", including " <<
-               theIdleConns->count() << " idle persistent connections.");
+               busy + idle << ", including " <<
+               idle << " idle persistent connections.");
         connOverloadReported = true;
     }
 
@@ -229,7 +304,9 @@ int Adaptation::Icap::ServiceRep::excessConnections() const
     // Waiters affect the number of needed connections but a needed
     // connection may still be excessive from Max-Connections p.o.v.
     // so we should not account for waiting transaction needs here.
-    const int debt =  theBusyConns + theIdleConns->count() - theMaxConnections;
+    int busy, idle;
+    countConnections(busy, idle);
+    const int debt =  busy + idle - theMaxConnections;
     if (debt > 0)
         return debt;
     else
@@ -275,6 +352,38 @@ void Adaptation::Icap::ServiceRep::busyCheckpoint()
         i.callback = nullptr;
         --freed;
     }
+
+    // other workers do not notify us when they release connection slots
+    if (!theNotificationWaiters.empty() && sharedSlot() >= 0)
+        scheduleRecheck();
+}
+
+static void
+ServiceRep_noteTimeToRecheck(void *data)
+{
+    Adaptation::Icap::ServiceRep *service = static_cast<Adaptation::Icap::ServiceRep*>(data);
+    Must(service);
+    service->noteTimeToRecheck();
+}
+
+void
+Adaptation::Icap::ServiceRep::scheduleRecheck()
+{
+    if (recheckScheduled)
+        return;
+
+    // XXX: move hard-coded constants from here to Adaptation::Icap::TheConfig
+    const double recheckDelay = 0.1; // seconds
+    eventAdd("Adaptation::Icap::ServiceRep::noteTimeToRecheck",
+             &ServiceRep_noteTimeToRecheck, this, recheckDelay, 0, true);
+    recheckScheduled = true;
+}
+
+void
+Adaptation::Icap::ServiceRep::noteTimeToRecheck()
+{
+    recheckScheduled = false;
+    busyCheckpoint();
 }
 
 void Adaptation::Icap::ServiceRep::suspend(const char *reason)
@@ -369,6 +478,7 @@ void Adaptation::Icap::ServiceRep::noteTimeToUpdate()
 {
     if (!detached())
         updateScheduled = false;
+    awaitingSharedOptions = false;
 
     if (detached() || theOptionsFetcher.set()) {
         debugs(93,5, "ignores options update " << status());
@@ -432,7 +542,7 @@ void Adaptation::Icap::ServiceRep::callWhenReady(AsyncCall::Pointer &cb)
     i.callback = cb;
     theClients.push_back(i);
 
-    if (theOptionsFetcher.set() || notifying)
+    if (theOptionsFetcher.set() || awaitingSharedOptions || notifying)
         return; // do nothing, we will be picked up in noteTimeToNotify()
 
     if (needNewOptions())
@@ -539,6 +649,8 @@ void Adaptation::Icap::ServiceRep::noteAdaptationAnswer(const Answer &answer)
 {
     Must(initiated(theOptionsFetcher));
     clearAdaptation(theOptionsFetcher);
+    if (theSharedSlot >= 0)
+        SharedServices::StopFetching(theSharedSlot);
 
     if (answer.kind == Answer::akError) {
         debugs(93,3, "failed to fetch options " << status());
@@ -556,6 +668,8 @@ void Adaptation::Icap::ServiceRep::noteAdaptationAnswer(const Answer &answer)
     if (const HttpReply *r = dynamic_cast<const HttpReply*>(msg)) {
         newOptions = new Adaptation::Icap::Options;
         newOptions->configure(r);
+        if (newOptions->valid())
+            shareOptions(*r);
     } else {
         debugs(93, DBG_IMPORTANT, "ICAP service got wrong options message " << status());
     }
@@ -568,6 +682,8 @@ void Adaptation::Icap::ServiceRep::noteAdaptationAnswer(const Answer &answer)
 void Adaptation::Icap::ServiceRep::callException(const std::exception &e)
 {
     clearAdaptation(theOptionsFetcher);
+    if (theSharedSlot >= 0)
+        SharedServices::StopFetching(theSharedSlot);
     debugs(93,2, "ICAP probably failed to fetch options (" << e.what() <<
            ")" << status());
     handleNewOptions(nullptr);
@@ -590,6 +706,7 @@ void Adaptation::Icap::ServiceRep::handleNewOptions(Adaptation::Icap::Options *n
         const int n = min(excess, theIdleConns->count());
         debugs(93,5, "closing " << n << " pconns to relief debt");
         theIdleConns->closeN(n);
+        shareConnections();
     }
 
     scheduleNotification();
@@ -600,6 +717,18 @@ void Adaptation::Icap::ServiceRep::startGettingOptions()
     Must(!theOptionsFetcher);
     debugs(93,6, "will get new options " << status());
 
+    if (adoptSharedOptions())
+        return;
+
+    const auto slot = sharedSlot();
+    const auto leaseDuration = TheConfig.connect_timeout(cfg().bypass) + TheConfig.io_timeout(cfg().bypass);
+    if (slot >= 0 && !SharedServices::StartFetching(slot, leaseDuration)) {
+        debugs(93, 5, "waiting for another worker to fetch options " << status());
+        scheduleUpdate(squid_curtime + 1);
+        awaitingSharedOptions = true;
+        return;
+    }
+
     // XXX: "this" here is "self"; works until refcounting API changes
     theOptionsFetcher = initiateAdaptation(
                             new Adaptation::Icap::OptXactLauncher(this));
@@ -607,6 +736,87 @@ void Adaptation::Icap::ServiceRep::startGettingOptions()
     // Such a timeout should probably be a generic AsyncStart feature.
 }
 
+/// uses fresh OPTIONS fetched by another SMP worker (if any)
+/// \returns whether the options were adopted
+bool
+Adaptation::Icap::ServiceRep::adoptSharedOptions()
+{
+    const auto slot = sharedSlot();
+    if (slot < 0)
+        return false;
+
+    // a suspended service needs a fresh probe rather than recent options
+    if (isSuspended)
+        return false;
+
+    SBuf raw;
+    if (!SharedServices::PublishedOptions(slot, theLastUpdate, raw))
+        return false;
+
+    HttpReply::Pointer reply(new HttpReply);
+    Http::StatusCode error = Http::scNone;
+    if (!reply->parse(raw.c_str(), raw.length(), true, &error)) {
+        debugs(93, 2, "cannot parse shared options: " << error);
+        return false;
+    }
+
+    std::unique_ptr<Options> newOptions(new Options);
+    newOptions->configure(reply.getRaw());
+    if (!newOptions->valid() || newOptions->expire() <= squid_curtime + 20) // see optionsFetchTime()
+        return false;
+
+    debugs(93, 5, "adopts options fetched by another worker " << status());
+    handleNewOptions(newOptions.release());
+    return true;
+}
+
+/// makes the given valid OPTIONS response available to other SMP workers
+void
+Adaptation::Icap::ServiceRep::shareOptions(const HttpReply &reply)
+{
+    const auto slot = sharedSlot();
+    if (slot < 0)
+        return;
+
+    MemBuf mb;
+    mb.init();
+    reply.packHeadersUsingSlowPacker(mb);
+    SharedServices::PublishOptions(slot, SBuf(mb.content(), mb.contentSize()));
+}
+
+bool
+Adaptation::Icap::ServiceRep::cachedNoContent(const SBuf &messageKey) const
+{
+    if (cfg().noContentTtl <= 0 || !hasOptions())
+        return false;
+
+    const auto cache = NoContentDecisionsCache();
+    return cache && cache->get(noContentCacheKey(messageKey));
+}
+
+void
+Adaptation::Icap::ServiceRep::cacheNoContent(const SBuf &messageKey)
+{
+    if (cfg().noContentTtl <= 0 || !hasOptions())
+        return;
+
+    if (const auto cache = NoContentDecisionsCache())
+        cache->add(noContentCacheKey(messageKey), true, static_cast<NoContentDecisions::Ttl>(cfg().noContentTtl));
+}
+
+SBuf
+Adaptation::Icap::ServiceRep::noContentCacheKey(const SBuf &messageKey) const
+{
+    Must(hasOptions());
+    // a new ISTag means that the service may now decide differently
+    auto key = StringToSBuf(cfg().key);
+    key.append('\n');
+    key.append(StringToSBuf(theOptions->istag));
+    key.append('\n');
+    key.append(messageKey);
+    return key;
+}
+
 void Adaptation::Icap::ServiceRep::scheduleUpdate(time_t when)
 {
     if (updateScheduled) {
@@ -91,6 +91,14 @@ public:
     void noteConnectionUse(const Comm::ConnectionPointer &conn);
     void noteConnectionFailed(const char *comment);
 
+    /// Whether the service has recently allowed an equivalent virgin message
+    /// without modification; see the cache-204 service option.
+    /// \param messageKey describes the virgin message
+    bool cachedNoContent(const SBuf &messageKey) const;
+    /// remembers that the service allowed the described virgin message
+    /// without modification
+    void cacheNoContent(const SBuf &messageKey);
+
     void noteFailure() override; // called by transactions to report service failure
 
     void noteNewWaiter() {theAllWaiters++;} ///< New xaction waiting for service to be up or available
@@ -107,6 +115,7 @@ public:
 public: // treat these as private, they are for callbacks only
     void noteTimeToUpdate();
     void noteTimeToNotify();
+    void noteTimeToRecheck();
 
     // receive either an ICAP OPTIONS response header or an abort message
     void noteAdaptationAnswer(const Answer &answer) override;
@@ -149,6 +158,11 @@ private:
 
     bool notifying; // may be true in any state except for the initial
     bool updateScheduled; // time-based options update has been scheduled
+    bool awaitingSharedOptions; ///< another SMP worker is fetching OPTIONS for us
+    bool recheckScheduled; ///< a noteTimeToRecheck() event is pending
+
+    /// SharedServices slot of this service or -1 (not shared or not found yet)
+    mutable int theSharedSlot;
 
 private:
     ICAP::Method parseMethod(const char *) const;
@@ -164,6 +178,8 @@ private:
     void scheduleNotification();
 
     void startGettingOptions();
+    bool adoptSharedOptions();
+    void shareOptions(const HttpReply &);
     void handleNewOptions(Options *newOptions);
     void changeOptions(Options *newOptions);
     void checkOptions();
@@ -185,6 +201,21 @@ private:
      */
     void busyCheckpoint();
 
+    /// the SharedServices slot of this service or -1 if the state of this
+    /// service is not shared among SMP workers
+    int sharedSlot() const;
+    /// Updates our SharedServices connection counters (if any). Must be
+    /// called whenever theBusyConns or theIdleConns size changes.
+    void shareConnections();
+    /// the number of busy and idle connections used by all SMP workers
+    /// (or just by us if the service state is not shared)
+    void countConnections(int &busy, int &idle) const;
+    /// periodically calls busyCheckpoint() while waiting for connection
+    /// slots released by other SMP workers
+    void scheduleRecheck();
+    /// the full cache-204 key for the described virgin message
+    SBuf noContentCacheKey(const SBuf &messageKey) const;
+
     const char *status() const override;
 
     mutable bool wasAnnouncedUp; // prevent sequential same-state announcements
@@ -0,0 +1,373 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 93    ICAP (RFC 3507) Client */
+
+#include "squid.h"
+#include "adaptation/icap/Config.h"
+#include "adaptation/icap/SharedServices.h"
+#include "base/RunnersRegistry.h"
+#include "debug/Stream.h"
+#include "globals.h"
+#include "ipc/Kids.h"
+#include "ipc/mem/FlexibleArray.h"
+#include "ipc/mem/Pointer.h"
+#include "ipc/mem/Segment.h"
+#include "sbuf/SBuf.h"
+#include "SquidString.h"
+#include "time/gadgets.h"
+#include "tools.h"
+
+#include <atomic>
+#include <cstring>
+
+namespace Adaptation
+{
+namespace Icap
+{
+namespace SharedServices
+{
+
+/// the longest service key (i.e. name and URI) that can be shared
+static const size_t MaxKeyLength = 2047;
+
+/// the largest OPTIONS response header that can be shared
+static const size_t MaxOptionsSize = 8*1024;
+
+/// the number of slots reserved for services added during reconfiguration
+static const int ReservedSlots = 16;
+
+/// the shared state of one ICAP service; the shared memory slot array element
+class Service
+{
+public:
+    /// slot life cycle stages
+    enum State : uint32_t { empty = 0, writing, ready };
+
+    Service();
+
+    /// whether the slot key is set and may be compared
+    std::atomic<uint32_t> state;
+
+    /// the time until which some worker is fetching OPTIONS (or zero)
+    std::atomic<int64_t> fetchingUntil;
+
+    /// Odd while the OPTIONS response header is being published. Readers
+    /// discard copies made while this value was odd or has changed.
+    std::atomic<uint32_t> version;
+
+    /// when the current OPTIONS response header was published (or zero)
+    std::atomic<int64_t> published;
+
+    uint32_t optionsSize; ///< the number of used options[] bytes
+    char options[MaxOptionsSize]; ///< raw OPTIONS response header
+
+    /// Nil-terminated service name and URI, separated by a space. A
+    /// service reconfigured to use another URI gets a new slot so that
+    /// workers do not mix OPTIONS and connections of different servers.
+    char key[MaxKeyLength + 1];
+};
+
+/// shared memory segment layout: an open addressing hash table
+class Services
+{
+public:
+    explicit Services(int aCapacity);
+
+    size_t sharedMemorySize() const { return SharedMemorySize(capacity); }
+    static size_t SharedMemorySize(const int aCapacity) { return sizeof(Services) + size_t(aCapacity)*sizeof(Service); }
+
+    const int capacity; ///< the number of slots
+    Ipc::Mem::FlexibleArray<Service> slots; ///< all services
+};
+
+/// the connections one worker uses for one service
+class ConnectionCounts
+{
+public:
+    ConnectionCounts(): busy(0), idle(0) {}
+
+    std::atomic<int32_t> busy; ///< connections given to active transactions
+    std::atomic<int32_t> idle; ///< idle persistent connections
+};
+
+/// Per-kid connection counters in a separate shared memory segment; the
+/// counters of slot s and kid k are at position s*kidSlots + k. Each kid
+/// maintains its own counters, so a restarted kid forgets connections of its
+/// predecessor.
+class Connections
+{
+public:
+    Connections(int aCapacity, int aKidSlots);
+
+    size_t sharedMemorySize() const { return SharedMemorySize(capacity, kidSlots); }
+    static size_t SharedMemorySize(const int aCapacity, const int aKidSlots) { return sizeof(Connections) + size_t(aCapacity)*aKidSlots*sizeof(ConnectionCounts); }
+
+    /// the counters of the given slot and kid
+    ConnectionCounts &counts(const int slot, const int kid) { return counters[slot*kidSlots + kid]; }
+
+    const int capacity; ///< the number of table slots
+    const int kidSlots; ///< the number of counters per slot
+    Ipc::Mem::FlexibleArray<ConnectionCounts> counters; ///< all counters
+};
+
+} // namespace SharedServices
+} // namespace Icap
+} // namespace Adaptation
+
+using namespace Adaptation::Icap::SharedServices;
+
+/// shared memory segment labels
+static const char * const ServicesLabel = "icap_services";
+static const char * const ConnectionsLabel = "icap_connections";
+
+/// the services segment opened by this kid (if any)
+static Ipc::Mem::Pointer<Services> TheServices;
+
+/// the connections segment opened by this kid (if any)
+static Ipc::Mem::Pointer<Connections> TheConnections;
+
+/// whether this kid maintains its connection counters
+static bool CountingConnections = false;
+
+/* Adaptation::Icap::SharedServices::Service */
+
+Adaptation::Icap::SharedServices::Service::Service():
+    state(empty),
+    fetchingUntil(0),
+    version(0),
+    published(0),
+    optionsSize(0)
+{
+    key[0] = '\0';
+}
+
+/* Adaptation::Icap::SharedServices::Services */
+
+Adaptation::Icap::SharedServices::Services::Services(const int aCapacity):
+    capacity(aCapacity),
+    slots(aCapacity)
+{
+}
+
+/* Adaptation::Icap::SharedServices::Connections */
+
+Adaptation::Icap::SharedServices::Connections::Connections(const int aCapacity, const int aKidSlots):
+    capacity(aCapacity),
+    kidSlots(aKidSlots),
+    counters(aCapacity*aKidSlots)
+{
+}
+
+/* Adaptation::Icap::SharedServices API */
+
+/// FNV-1a hash of the given service key
+static uint32_t
+KeyHash(const SBuf &key)
+{
+    uint32_t result = 2166136261U;
+    for (const auto c: key)
+        result = (result ^ static_cast<unsigned char>(c)) * 16777619U;
+    return result;
+}
+
+int
+Adaptation::Icap::SharedServices::Find(const String &serviceName, const String &serviceUri)
+{
+    if (!TheServices)
+        return -1;
+
+    SBuf key;
+    key.append(serviceName.rawBuf(), serviceName.size());
+    key.append(' ');
+    key.append(serviceUri.rawBuf(), serviceUri.size());
+    const auto length = key.length();
+    if (!serviceName.size() || length > MaxKeyLength) {
+        debugs(93, 3, "cannot share " << key);
+        return -1;
+    }
+
+    const auto capacity = TheServices->capacity;
+    const auto start = static_cast<int>(KeyHash(key) % static_cast<uint32_t>(capacity));
+    for (int probe = 0; probe < capacity; ++probe) {
+        const int index = (start + probe) % capacity;
+        auto &slot = TheServices->slots[index];
+        auto state = slot.state.load(std::memory_order_acquire);
+
+        if (state == Service::empty && slot.state.compare_exchange_strong(state, Service::writing, std::memory_order_acquire)) {
+            memcpy(slot.key, key.rawContent(), length);
+            slot.key[length] = '\0';
+            slot.state.store(Service::ready, std::memory_order_release);
+            debugs(93, 5, "added " << key << " at " << index);
+            return index;
+        }
+
+        // another kid may be adding this or another service to this slot
+        while (state == Service::writing)
+            state = slot.state.load(std::memory_order_acquire);
+
+        if (strncmp(slot.key, key.rawContent(), length) == 0 && slot.key[length] == '\0')
+            return index;
+    }
+
+    static bool warned = false;
+    if (!warned) {
+        debugs(93, DBG_IMPORTANT, "WARNING: No room to share the state of ICAP service " << serviceName <<
+               " among SMP workers; restart Squid to share the state of all services");
+        warned = true;
+    }
+    return -1;
+}
+
+bool
+Adaptation::Icap::SharedServices::StartFetching(const int slot, const time_t leaseDuration)
+{
+    auto &service = TheServices->slots[slot];
+    auto current = service.fetchingUntil.load(std::memory_order_relaxed);
+    if (current >= squid_curtime)
+        return false;
+    return service.fetchingUntil.compare_exchange_strong(current, squid_curtime + leaseDuration, std::memory_order_relaxed);
+}
+
+void
+Adaptation::Icap::SharedServices::StopFetching(const int slot)
+{
+    TheServices->slots[slot].fetchingUntil.store(0, std::memory_order_relaxed);
+}
+
+void
+Adaptation::Icap::SharedServices::PublishOptions(const int slot, const SBuf &rawHeader)
+{
+    if (rawHeader.length() > MaxOptionsSize) {
+        debugs(93, 3, "cannot share " << rawHeader.length() << "-byte OPTIONS response header");
+        return;
+    }
+
+    auto &service = TheServices->slots[slot];
+    auto version = service.version.load(std::memory_order_relaxed);
+    if ((version & 1) || !service.version.compare_exchange_strong(version, version + 1, std::memory_order_acquire)) {
+        debugs(93, 3, "another worker is publishing options");
+        return;
+    }
+
+    memcpy(service.options, rawHeader.rawContent(), rawHeader.length());
+    service.optionsSize = rawHeader.length();
+    service.published.store(squid_curtime, std::memory_order_relaxed);
+    service.version.store(version + 2, std::memory_order_release);
+    debugs(93, 5, "published " << rawHeader.length() << " bytes for " << service.key);
+}
+
+bool
+Adaptation::Icap::SharedServices::PublishedOptions(const int slot, const time_t after, SBuf &rawHeader)
+{
+    auto &service = TheServices->slots[slot];
+    const auto version = service.version.load(std::memory_order_acquire);
+    if (version & 1)
+        return false; // being published
+
+    if (service.published.load(std::memory_order_relaxed) <= after)
+        return false; // nothing new
+
+    const auto size = service.optionsSize;
+    if (size > MaxOptionsSize)
+        return false; // being published
+
+    SBuf copy(service.options, size);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (service.version.load(std::memory_order_relaxed) != version)
+        return false; // changed while we were copying
+
+    rawHeader = copy;
+    return true;
+}
+
+void
+Adaptation::Icap::SharedServices::NoteConnections(const int slot, const int busy, const int idle)
+{
+    if (!CountingConnections)
+        return;
+
+    auto &counts = TheConnections->counts(slot, KidIdentifier);
+    counts.busy.store(busy, std::memory_order_relaxed);
+    counts.idle.store(idle, std::memory_order_relaxed);
+}
+
+void
+Adaptation::Icap::SharedServices::CountConnections(const int slot, int &busy, int &idle)
+{
+    busy = 0;
+    idle = 0;
+    for (int kid = 0; kid < TheConnections->kidSlots; ++kid) {
+        const auto &counts = TheConnections->counts(slot, kid);
+        busy += counts.busy.load(std::memory_order_relaxed);
+        idle += counts.idle.load(std::memory_order_relaxed);
+    }
+}
+
+/// creates and opens the shared ICAP service table segments
+class IcapSharedServicesRr: public Ipc::Mem::RegisteredRunner
+{
+public:
+    /* RegisteredRunner API */
+    void useConfig() override;
+    ~IcapSharedServicesRr() override;
+
+protected:
+    /* Ipc::Mem::RegisteredRunner API */
+    void create() override;
+    void open() override;
+
+private:
+    Ipc::Mem::Owner<Services> *servicesOwner = nullptr;
+    Ipc::Mem::Owner<Connections> *connectionsOwner = nullptr;
+};
+
+DefineRunnerRegistrator(IcapSharedServicesRr);
+
+void
+IcapSharedServicesRr::useConfig()
+{
+    if (Adaptation::Icap::TheConfig.onoff && !Adaptation::Icap::TheConfig.serviceConfigs.empty() &&
+            UsingSmp() && Ipc::Mem::Segment::Enabled())
+        Ipc::Mem::RegisteredRunner::useConfig();
+}
+
+void
+IcapSharedServicesRr::create()
+{
+    const auto kidSlots = Ipc::KidSlots();
+    const auto capacity = static_cast<int>(Adaptation::Icap::TheConfig.serviceConfigs.size()) + ReservedSlots;
+    debugs(93, 3, "capacity: " << capacity << " kid slots: " << kidSlots);
+    Must(!servicesOwner && !connectionsOwner);
+    servicesOwner = shm_new(Services)(ServicesLabel, capacity);
+    connectionsOwner = shm_new(Connections)(ConnectionsLabel, capacity, kidSlots);
+}
+
+void
+IcapSharedServicesRr::open()
+{
+    Must(!TheServices && !TheConnections);
+    TheServices = shm_old(Services)(ServicesLabel);
+    TheConnections = shm_old(Connections)(ConnectionsLabel);
+
+    // unexpected kids may count but cannot maintain connection counts
+    CountingConnections = 0 <= KidIdentifier && KidIdentifier < TheConnections->kidSlots;
+    if (!CountingConnections)
+        return;
+
+    // a restarted kid does not inherit connections of its predecessor
+    for (int slot = 0; slot < TheConnections->capacity; ++slot)
+        NoteConnections(slot, 0, 0);
+}
+
+IcapSharedServicesRr::~IcapSharedServicesRr()
+{
+    delete servicesOwner;
+    delete connectionsOwner;
+}
+
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_ADAPTATION_ICAP_SHAREDSERVICES_H
+#define SQUID_SRC_ADAPTATION_ICAP_SHAREDSERVICES_H
+
+#include "sbuf/forward.h"
+
+#include <ctime>
+
+class String;
+
+namespace Adaptation
+{
+namespace Icap
+{
+
+/// ICAP service state shared by all SMP workers: The last OPTIONS response
+/// received by any worker and the number of connections each worker uses.
+/// Services are identified by their squid.conf names and URIs and found
+/// using the slot index returned by Find(). The table is disabled in
+/// non-SMP mode.
+namespace SharedServices
+{
+
+/// \returns the table slot of the named service with the given URI or, if
+/// the table is disabled or full, a negative number
+int Find(const String &serviceName, const String &serviceUri);
+
+/// Reserves the right to fetch service OPTIONS for the given number of
+/// seconds, preventing other workers from fetching the same OPTIONS.
+/// \returns false if another worker is fetching OPTIONS now
+bool StartFetching(int slot, time_t leaseDuration);
+
+/// ends the OPTIONS fetching period started by StartFetching()
+void StopFetching(int slot);
+
+/// makes the given OPTIONS response header available to all workers
+void PublishOptions(int slot, const SBuf &rawHeader);
+
+/// Copies the OPTIONS response header published after the given time.
+/// \returns false if there is no such header
+bool PublishedOptions(int slot, time_t after, SBuf &rawHeader);
+
+/// records the number of busy and idle connections used by this worker
+void NoteConnections(int slot, int busy, int idle);
+
+/// the number of busy and idle connections used by all workers
+void CountConnections(int slot, int &busy, int &idle);
+
+} // namespace SharedServices
+
+} // namespace Icap
+} // namespace Adaptation
+
+#endif /* SQUID_SRC_ADAPTATION_ICAP_SHAREDSERVICES_H */
+
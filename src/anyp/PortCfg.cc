@@ -41,6 +41,7 @@ AnyP::PortCfg::PortCfg() :
     vport(0),
     disable_pmtu_discovery(0),
     workerQueues(false),
+    http2(false),
     listenConn()
 {
 }
@@ -72,6 +73,7 @@ AnyP::PortCfg::PortCfg(const PortCfg &other):
     vport(other.vport),
     disable_pmtu_discovery(other.disable_pmtu_discovery),
     workerQueues(other.workerQueues),
+    http2(other.http2),
     tcp_keepalive(other.tcp_keepalive),
     listenConn(), // special case; see assert() below
     secure(other.secure)
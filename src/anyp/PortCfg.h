@@ -56,6 +56,7 @@ public:
     int vport;               ///< virtual port support. -1 if dynamic, >0 static
     int disable_pmtu_discovery;
     bool workerQueues; ///< whether listening queues should be worker-specific
+    bool http2; ///< whether to accept HTTP/2 clients
 
     Comm::TcpKeepAlive tcp_keepalive;
 
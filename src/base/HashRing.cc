@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "base/HashRing.h"
+
+/// SplitMix64 finalizer: spreads similar inputs across the whole ring
+static HashRing::Point
+Mix(HashRing::Point x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+HashRing::Point
+HashRing::Hash(const char * const data, const size_t length)
+{
+    // 64-bit FNV-1a
+    Point h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < length; ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 0x100000001b3ULL;
+    }
+    return Mix(h);
+}
+
+void
+HashRing::clear()
+{
+    nodes_.clear();
+    weights_.clear();
+    nameHashes_.clear();
+    totalWeight_ = 0;
+    visitMarks_.clear();
+    visitMark_ = 0;
+}
+
+void
+HashRing::add(const char * const name, const size_t nameLength, const int weight)
+{
+    weights_.push_back(std::max(weight, 1));
+    nameHashes_.push_back(Hash(name, nameLength));
+    totalWeight_ += weights_.back();
+}
+
+void
+HashRing::seal()
+{
+    nodes_.clear();
+    visitMarks_.clear();
+    visitMark_ = 0;
+    if (weights_.empty())
+        return;
+
+    const auto maxWeight = *std::max_element(weights_.begin(), weights_.end());
+    for (Member member = 0; member < members(); ++member) {
+        const auto share = static_cast<double>(weights_[member]) / maxWeight;
+        const auto points = std::max<size_t>(1, std::lround(share * MaxPointsPerMember));
+        for (size_t i = 0; i < points; ++i)
+            nodes_.push_back(Node{Mix(nameHashes_[member] + (i + 1) * 0x9e3779b97f4a7c15ULL), member});
+    }
+    std::sort(nodes_.begin(), nodes_.end());
+
+    visitMarks_.assign(members(), 0);
+    visitMark_ = 0;
+}
+
+uint64_t
+HashRing::capacity(const Member member, const double balance, const uint64_t totalLoad) const
+{
+    // the load of the member after it accepts the key being placed
+    const auto fairShare = static_cast<double>(totalLoad + 1) * weights_.at(member) / totalWeight_;
+    return static_cast<uint64_t>(std::ceil(std::max(balance, 1.0) * fairShare));
+}
+
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_BASE_HASHRING_H
+#define SQUID_SRC_BASE_HASHRING_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/// A consistent hashing ring with bounded loads (Mirrokni, Thorup, and
+/// Zadimoghaddam, "Consistent Hashing with Bounded Loads", SODA 2018).
+///
+/// Each member owns a number of ring points proportional to its weight. A key
+/// is mapped to the member owning the first ring point at or after the key
+/// hash. When that member is unusable or already carries more than its share
+/// of the current total load (scaled by the configured balance factor), the
+/// search continues clockwise, so only keys of unusable or overloaded members
+/// are remapped. Ring lookups take O(log(points)) time.
+///
+/// Members are identified by caller-assigned indexes in [0, members()).
+/// Lookups are not reentrant: select() reuses per-ring bookkeeping.
+class HashRing
+{
+public:
+    using Member = size_t;
+    using Point = uint64_t;
+
+    /// the number of ring points owned by a member with the highest weight
+    static constexpr size_t MaxPointsPerMember = 160;
+
+    /// a stable (across processes and platforms) hash of the given bytes
+    static Point Hash(const char *data, size_t length);
+
+    /// forgets all members
+    void clear();
+
+    /// adds the next member (with index members()) using the given member
+    /// name to place its ring points; call seal() after the last addition
+    void add(const char *name, size_t nameLength, int weight);
+
+    /// prepares the ring for lookups after add() calls
+    void seal();
+
+    /// the number of added members
+    size_t members() const { return weights_.size(); }
+
+    bool empty() const { return weights_.empty(); }
+
+    /// The usable member responsible for the key with the given hash (or
+    /// nothing if no member is usable). Prefers members that do not exceed
+    /// their bounded load but falls back to an overloaded usable member.
+    /// \param balance the maximum member load relative to its fair share (at least 1)
+    /// \param totalLoad the sum of all member loads
+    /// \param loadOf returns the current load of the given member
+    /// \param usable returns whether the given member may be selected
+    template <class LoadOf, class Usable>
+    std::optional<Member> select(Point key, double balance, uint64_t totalLoad, const LoadOf &loadOf, const Usable &usable) const;
+
+    /// the maximum load of the given member before it is considered overloaded
+    uint64_t capacity(Member, double balance, uint64_t totalLoad) const;
+
+private:
+    /// a ring position owned by a member
+    class Node
+    {
+    public:
+        bool operator <(const Node &other) const { return point < other.point || (point == other.point && member < other.member); }
+
+        Point point;
+        Member member;
+    };
+
+    /// all members' points, sorted by seal()
+    std::vector<Node> nodes_;
+
+    /// member weights, indexed by Member
+    std::vector<int> weights_;
+
+    /// hashes of member names, indexed by Member (to place ring points)
+    std::vector<Point> nameHashes_;
+
+    /// the sum of all member weights
+    uint64_t totalWeight_ = 0;
+
+    /// select() visit marks, indexed by Member and sized by seal(); a member
+    /// was visited by the ongoing select() if its mark equals visitMark_
+    mutable std::vector<uint32_t> visitMarks_;
+
+    /// the visitMarks_ value of members visited by the ongoing select()
+    mutable uint32_t visitMark_ = 0;
+};
+
+template <class LoadOf, class Usable>
+std::optional<HashRing::Member>
+HashRing::select(const Point key, const double balance, const uint64_t totalLoad, const LoadOf &loadOf, const Usable &usable) const
+{
+    if (nodes_.empty())
+        return std::nullopt;
+
+    const auto start = std::lower_bound(nodes_.begin(), nodes_.end(), Node{key, 0});
+    const auto startIndex = static_cast<size_t>(start - nodes_.begin());
+
+    // start a new visit without clearing marks of the previous ones
+    if (++visitMark_ == 0) {
+        std::fill(visitMarks_.begin(), visitMarks_.end(), 0);
+        visitMark_ = 1;
+    }
+
+    auto unvisited = members();
+    std::optional<Member> overloaded;
+    for (size_t i = 0; i < nodes_.size() && unvisited; ++i) {
+        const auto member = nodes_[(startIndex + i) % nodes_.size()].member;
+        auto &mark = visitMarks_[member];
+        if (mark == visitMark_)
+            continue;
+        mark = visitMark_;
+        --unvisited;
+
+        if (!usable(member))
+            continue;
+
+        if (loadOf(member) < capacity(member, balance, totalLoad))
+            return member;
+
+        if (!overloaded)
+            overloaded = member;
+    }
+    return overloaded;
+}
+
+#endif /* SQUID_SRC_BASE_HASHRING_H */
+
@@ -37,6 +37,9 @@ public:
     /// whether this is an "any single character" regex (".")
     bool isDot() const { return pattern.length() == 1 && pattern[0] == '.'; }
 
+    /// the regular expression in the text form, without flags
+    const SBuf &text() const { return pattern; }
+
     bool match(const char *str) const {return regexec(&regex,str,0,nullptr,0)==0;}
 
     /// Attempts to reproduce this regex (context-sensitive) configuration.
@@ -49,6 +49,7 @@
 #include "ip/QosConfig.h"
 #include "ip/tools.h"
 #include "ipc/Kids.h"
+#include "ipc/StoreMapEviction.h"
 #include "log/Config.h"
 #include "log/CustomLog.h"
 #include "MemBuf.h"
@@ -66,6 +67,7 @@
 #include "rfc1738.h"
 #include "sbuf/List.h"
 #include "sbuf/Stream.h"
+#include "security/SessionResumption.h"
 #include "SquidConfig.h"
 #include "SquidString.h"
 #include "ssl/ProxyCerts.h"
@@ -73,6 +75,7 @@
 #include "store/Disks.h"
 #include "tools.h"
 #include "util.h"
+#include "VaryNormalizer.h"
 #include "wordlist.h"
 /* wccp2 has its own conditional definitions */
 #include "wccp2.h"
@@ -257,6 +260,9 @@ static void ParseAclWithAction(acl_access **access, const Acl::Answer &action, c
 static void parse_http_upgrade_request_protocols(HttpUpgradeProtocolAccess **protoGuards);
 static void dump_http_upgrade_request_protocols(StoreEntry *entry, const char *name, HttpUpgradeProtocolAccess *protoGuards);
 static void free_http_upgrade_request_protocols(HttpUpgradeProtocolAccess **protoGuards);
+static void parse_vary_normalize(VaryNormalizer **);
+static void dump_vary_normalize(StoreEntry *, const char *, VaryNormalizer *);
+static void free_vary_normalize(VaryNormalizer **);
 
 /*
  * LegacyParser is a parser for legacy code that uses the global
@@ -796,6 +802,16 @@ configDoConfigure(void)
         Config.connect_retries = 10;
     }
 
+    if (Config.responseCompression.gzipLevel < 0 || Config.responseCompression.gzipLevel > 9) {
+        debugs(0, DBG_CRITICAL, "WARNING: response_compression_gzip_level must be between 0 and 9. Resetting to 6.");
+        Config.responseCompression.gzipLevel = 6;
+    }
+
+    if (Config.responseCompression.brLevel < 0 || Config.responseCompression.brLevel > 11) {
+        debugs(0, DBG_CRITICAL, "WARNING: response_compression_br_level must be between 0 and 11. Resetting to 5.");
+        Config.responseCompression.brLevel = 5;
+    }
+
     requirePathnameExists("MIME Config Table", Config.mimeTablePathname);
 #if USE_UNLINKD
 
@@ -959,6 +975,7 @@ configDoConfigure(void)
         }
 #if USE_OPENSSL
         Ssl::useSquidUntrusted(Config.ssl_client.sslContext_->get());
+        Security::SetOriginSessionCallbacks(*Config.ssl_client.sslContext_);
 #endif
         Config.ssl_client.defaultPeerContext = new Security::FuturePeerContext(Security::ProxyOutgoingConfig(), *Config.ssl_client.sslContext_);
     }
@@ -977,6 +994,12 @@ configDoConfigure(void)
                 self_destruct();
                 return;
             }
+#if USE_OPENSSL
+            if (p->options.http2) {
+                static const unsigned char protocols[] = "\x02h2";
+                SSL_CTX_set_alpn_protos(p->sslContext.get(), protocols, sizeof(protocols) - 1);
+            }
+#endif
         }
     }
 
@@ -2322,6 +2345,8 @@ parse_peer(CachePeers **peers)
             p->standby.limit = xatoi(token + 8);
         } else if (!strcmp(token, "originserver")) {
             p->options.originserver = true;
+        } else if (!strcmp(token, "http2")) {
+            p->options.http2 = true;
         } else if (!strncmp(token, "name=", 5)) {
             p->rename(token + 5);
         } else if (!strncmp(token, "forceddomain=", 13)) {
@@ -2672,6 +2697,12 @@ dump_refreshpattern(StoreEntry * entry, const char *name, RefreshPattern * head)
         if (head->max_stale >= 0)
             storeAppendPrintf(entry, " max-stale=%d", head->max_stale);
 
+        if (head->stale_while_revalidate >= 0)
+            storeAppendPrintf(entry, " stale-while-revalidate=%d", head->stale_while_revalidate);
+
+        if (head->prefetch > 0)
+            storeAppendPrintf(entry, " prefetch=%d prefetch-min-hits=%d", head->prefetch, head->prefetch_min_hits);
+
         if (head->flags.refresh_ims)
             storeAppendPrintf(entry, " refresh-ims");
 
@@ -2715,6 +2746,9 @@ parse_refreshpattern(RefreshPattern ** head)
     int refresh_ims = 0;
     int store_stale = 0;
     int max_stale = -1;
+    int stale_while_revalidate = -1;
+    int prefetch = 0;
+    int prefetch_min_hits = 10;
 
 #if USE_HTTP_VIOLATIONS
 
@@ -2769,6 +2803,12 @@ parse_refreshpattern(RefreshPattern ** head)
             store_stale = 1;
         } else if (!strncmp(token, "max-stale=", 10)) {
             max_stale = xatoi(token + 10);
+        } else if (!strncmp(token, "stale-while-revalidate=", 23)) {
+            stale_while_revalidate = xatoi(token + 23);
+        } else if (!strncmp(token, "prefetch=", 9)) {
+            prefetch = xatoi(token + 9);
+        } else if (!strncmp(token, "prefetch-min-hits=", 18)) {
+            prefetch_min_hits = xatoi(token + 18);
 
 #if USE_HTTP_VIOLATIONS
 
@@ -2813,6 +2853,9 @@ parse_refreshpattern(RefreshPattern ** head)
         t->flags.store_stale = true;
 
     t->max_stale = max_stale;
+    t->stale_while_revalidate = stale_while_revalidate;
+    t->prefetch = prefetch < 0 ? 0 : prefetch;
+    t->prefetch_min_hits = prefetch_min_hits;
 
 #if USE_HTTP_VIOLATIONS
 
@@ -3288,6 +3331,64 @@ dump_memcachemode(StoreEntry * entry, const char *name, SquidConfig &)
     storeAppendPrintf(entry, "\n");
 }
 
+static void
+free_admission(int *var)
+{
+    *var = 0;
+}
+
+static void
+parse_admission(int *var)
+{
+    const auto token = ConfigParser::NextToken();
+    if (!token) {
+        self_destruct();
+        return;
+    }
+
+    if (strcmp(token, "tinylfu") == 0) {
+        *var = 1;
+    } else if (strcmp(token, "none") == 0) {
+        *var = 0;
+    } else {
+        debugs(3, DBG_CRITICAL, "ERROR: Invalid admission policy '" << token << "': expected 'tinylfu' or 'none'.");
+        self_destruct();
+    }
+}
+
+static void
+dump_admission(StoreEntry * entry, const char *name, int var)
+{
+    storeAppendPrintf(entry, "%s %s\n", name, var ? "tinylfu" : "none");
+}
+
+static void
+free_eviction(Ipc::EvictionPolicy *var)
+{
+    *var = Ipc::EvictionPolicy::hashOrder;
+}
+
+static void
+parse_eviction(Ipc::EvictionPolicy *var)
+{
+    const auto token = ConfigParser::NextToken();
+    if (!token) {
+        self_destruct();
+        return;
+    }
+
+    if (!Ipc::ParseEvictionPolicy(token, *var)) {
+        debugs(3, DBG_CRITICAL, "ERROR: Invalid eviction policy '" << token << "': expected 'hash', 'clock', or 's3fifo'.");
+        self_destruct();
+    }
+}
+
+static void
+dump_eviction(StoreEntry * entry, const char *name, const Ipc::EvictionPolicy var)
+{
+    storeAppendPrintf(entry, "%s %s\n", name, Ipc::EvictionPolicyName(var));
+}
+
 #include "cf_parser.cci"
 
 peer_t
@@ -3688,6 +3789,8 @@ parse_port_option(AnyP::PortCfgPointer &s, char *token)
         throw TexcHere(ToSBuf(cfg_directive, ' ', token, " option requires building Squid where SO_REUSEPORT is supported by the TCP stack"));
 #endif
         s->workerQueues = true;
+    } else if (strcmp(token, "http2") == 0) {
+        s->http2 = true;
     } else {
         debugs(3, DBG_CRITICAL, "FATAL: Unknown " << cfg_directive << " option '" << token << "'.");
         self_destruct();
@@ -3774,6 +3877,11 @@ parsePortCfg(AnyP::PortCfgPointer *head, const char *optionName)
             self_destruct();
             return;
         }
+        if (s->http2) {
+            debugs(3, DBG_CRITICAL, "FATAL: http2 option is not supported on ftp_port.");
+            self_destruct();
+            return;
+        }
     }
 
     if (s->secure.encryptTransport) {
@@ -3878,6 +3986,9 @@ dump_generic_port(StoreEntry * e, const char *n, const AnyP::PortCfgPointer &s)
         }
     }
 
+    if (s->http2)
+        storeAppendPrintf(e, " http2");
+
 #if USE_OPENSSL
     if (s->flags.tunnelSslBumping)
         storeAppendPrintf(e, " ssl-bump");
@@ -4935,3 +5046,29 @@ free_http_upgrade_request_protocols(HttpUpgradeProtocolAccess **protoGuardsPtr)
     protoGuards = nullptr;
 }
 
+static void
+parse_vary_normalize(VaryNormalizer **normalizerPtr)
+{
+    assert(normalizerPtr);
+    auto &normalizer = *normalizerPtr;
+    if (!normalizer)
+        normalizer = new VaryNormalizer();
+    normalizer->configure(LegacyParser);
+}
+
+static void
+dump_vary_normalize(StoreEntry *entry, const char *name, VaryNormalizer *normalizer)
+{
+    if (normalizer)
+        normalizer->dump(entry, name);
+}
+
+static void
+free_vary_normalize(VaryNormalizer **normalizerPtr)
+{
+    assert(normalizerPtr);
+    auto &normalizer = *normalizerPtr;
+    delete normalizer;
+    normalizer = nullptr;
+}
+
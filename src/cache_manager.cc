@@ -339,7 +339,7 @@ CacheManager::start(const Comm::ConnectionPointer &client, HttpRequest *request,
         return;
     }
 
-    if (UsingSmp() && IamWorkerProcess()) {
+    if (UsingSmp() && IamWorkerProcess() && !cmd->profile->coversAllKids) {
         // is client the right connection to pass here?
         AsyncJob::Start(new Mgr::Forwarder(client, cmd->params, request, entry, ale));
         return;
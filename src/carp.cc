@@ -16,6 +16,7 @@
 #include "HttpRequest.h"
 #include "mgr/Registration.h"
 #include "neighbors.h"
+#include "PeerHashRing.h"
 #include "PeerSelectState.h"
 #include "SquidConfig.h"
 #include "Store.h"
@@ -32,6 +33,14 @@ CarpPeers()
     return *carpPeers;
 }
 
+/// CARP cache_peers placed on a consistent hashing ring (if enabled)
+static auto &
+CarpRing()
+{
+    static const auto carpRing = new PeerHashRing();
+    return *carpRing;
+}
+
 static OBJH carpCachemgr;
 
 static int
@@ -57,6 +66,7 @@ carpInit(void)
     /* Clean up */
 
     CarpPeers().clear();
+    CarpRing().clear();
 
     /* initialize cache manager before we have a chance to leave the execution path */
     carpRegisterWithCacheManager();
@@ -83,6 +93,9 @@ carpInit(void)
     if (rawCarpPeers.empty())
         return;
 
+    if (PeerHashRing::Enabled("carp"))
+        CarpRing().reset(rawCarpPeers);
+
     /* calculate hashes and load factors */
     for (const auto p: rawCarpPeers) {
         /* calculate this peers hash */
@@ -146,6 +159,46 @@ public:
 
 DefineRunnerRegistrator(CarpRr);
 
+/// the CARP hash key of the request, as configured by the given peer carp-key
+static SBuf
+carpKey(const CachePeer &peer, HttpRequest &request)
+{
+    SBuf key;
+    if (peer.options.carp_key.set) {
+        // this code follows URI syntax pattern.
+        // corner cases should use the full effective request URI
+        if (peer.options.carp_key.scheme) {
+            key.append(request.url.getScheme().image());
+            if (key.length()) //if the scheme is not empty
+                key.append("://");
+        }
+        if (peer.options.carp_key.host) {
+            key.append(request.url.host());
+        }
+        if (peer.options.carp_key.port) {
+            key.appendf(":%hu", request.url.port().value_or(0));
+        }
+        if (peer.options.carp_key.path) {
+            // XXX: fix when path and query are separate
+            key.append(request.url.absolutePath().substr(0,request.url.absolutePath().find('?'))); // 0..N
+        }
+        if (peer.options.carp_key.params) {
+            // XXX: fix when path and query are separate
+            SBuf::size_type pos;
+            if ((pos=request.url.absolutePath().find('?')) != SBuf::npos)
+                key.append(request.url.absolutePath().substr(pos)); // N..npos
+        }
+    }
+    // if the url-based key is empty, e.g. because the user is
+    // asking to balance on the path but the request doesn't supply any,
+    // then fall back to the effective request URI
+
+    if (key.isEmpty())
+        key=request.effectiveRequestUri();
+
+    return key;
+}
+
 CachePeer *
 carpSelectParent(PeerSelector *ps)
 {
@@ -161,6 +214,14 @@ carpSelectParent(PeerSelector *ps)
     if (CarpPeers().empty())
         return nullptr;
 
+    if (!CarpRing().empty()) {
+        // ring members share one carp-key (see PeerHashRingRr::finalizeConfig())
+        const auto &keyPeer = CarpRing().members().front();
+        if (!keyPeer)
+            return nullptr; // peer gone; wait for reconfiguration to complete
+        return CarpRing().select(carpKey(*keyPeer, *request), ps);
+    }
+
     /* calculate hash key */
     debugs(39, 2, "carpSelectParent: Calculating hash for " << request->effectiveRequestUri());
 
@@ -169,38 +230,7 @@ carpSelectParent(PeerSelector *ps)
         if (!tp)
             continue; // peer gone
 
-        SBuf key;
-        if (tp->options.carp_key.set) {
-            // this code follows URI syntax pattern.
-            // corner cases should use the full effective request URI
-            if (tp->options.carp_key.scheme) {
-                key.append(request->url.getScheme().image());
-                if (key.length()) //if the scheme is not empty
-                    key.append("://");
-            }
-            if (tp->options.carp_key.host) {
-                key.append(request->url.host());
-            }
-            if (tp->options.carp_key.port) {
-                key.appendf(":%hu", request->url.port().value_or(0));
-            }
-            if (tp->options.carp_key.path) {
-                // XXX: fix when path and query are separate
-                key.append(request->url.absolutePath().substr(0,request->url.absolutePath().find('?'))); // 0..N
-            }
-            if (tp->options.carp_key.params) {
-                // XXX: fix when path and query are separate
-                SBuf::size_type pos;
-                if ((pos=request->url.absolutePath().find('?')) != SBuf::npos)
-                    key.append(request->url.absolutePath().substr(pos)); // N..npos
-            }
-        }
-        // if the url-based key is empty, e.g. because the user is
-        // asking to balance on the path but the request doesn't supply any,
-        // then fall back to the effective request URI
-
-        if (key.isEmpty())
-            key=request->effectiveRequestUri();
+        const auto key = carpKey(*tp, *request);
 
         for (const char *c = key.rawContent(), *e=key.rawContent()+key.length(); c < e; ++c)
             user_hash += ROTATE_LEFT(user_hash, 19) + *c;
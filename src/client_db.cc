@@ -18,6 +18,7 @@
 #include "ip/Address.h"
 #include "log/access_log.h"
 #include "mgr/Registration.h"
+#include "SharedClientDb.h"
 #include "SquidConfig.h"
 #include "SquidMath.h"
 #include "StatCounters.h"
@@ -200,7 +201,9 @@ clientdbEstablished(const Ip::Address &addr, int delta)
 
     c->n_established += delta;
 
-    return c->n_established;
+    // prefer the number of connections accepted by all kids
+    const auto total = SharedClientDb::Established(addr, delta);
+    return total >= 0 ? total : c->n_established;
 }
 
 #define CUTOFF_SECONDS 3600
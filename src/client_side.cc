@@ -119,6 +119,7 @@
 #include "Store.h"
 #include "TimeOrTag.h"
 #include "tools.h"
+#include "TransactionTrace.h"
 
 #if USE_AUTH
 #include "auth/UserRequest.h"
@@ -188,6 +189,7 @@ static int clientIsRequestBodyTooLargeForPolicy(int64_t bodyLength);
 static void clientUpdateStatHistCounters(const LogTags &logType, int svc_time);
 static void clientUpdateStatCounters(const LogTags &logType);
 static void clientUpdateHierCounters(HierarchyLogEntry *);
+static void clientUpdatePhaseCounters(const TransactionPhases &);
 static bool clientPingHasFinished(ping_data const *aPing);
 void prepareLogWithRequestDetails(HttpRequest *, const AccessLogEntryPointer &);
 static void ClientSocketContextPushDeferredIfNeeded(Http::StreamPointer deferredRequest, ConnStateData * conn);
@@ -235,6 +237,10 @@ clientUpdateStatHistCounters(const LogTags &logType, int svc_time)
     case LOG_TCP_MEM_HIT:
 
     case LOG_TCP_OFFLINE_HIT:
+
+    case LOG_TCP_PARTIAL_HIT:
+
+    case LOG_TCP_STALE_HIT:
         statCounter.client_http.hitSvcTime.count(svc_time);
         break;
 
@@ -250,6 +256,17 @@ clientUpdateStatHistCounters(const LogTags &logType, int svc_time)
     }
 }
 
+/// accounts for the time a finished transaction spent in each phase
+void
+clientUpdatePhaseCounters(const TransactionPhases &phases)
+{
+    for (int i = 0; i < TransactionPhases::phaseCount; ++i) {
+        const auto phase = static_cast<TransactionPhases::Phase>(i);
+        if (phases.entered(phase))
+            statCounter.client_http.phaseTimes[phase].count(phases.totalMilliseconds(phase));
+    }
+}
+
 bool
 clientPingHasFinished(ping_data const *aPing)
 {
@@ -315,6 +332,8 @@ ClientHttpRequest::updateCounters()
     clientUpdateStatHistCounters(loggingTags(),
                                  tvSubMsec(al->cache.start_time, current_time));
 
+    clientUpdatePhaseCounters(request->masterXaction->phases);
+
     clientUpdateHierCounters(&request->hier);
 }
 
@@ -376,6 +395,9 @@ ClientHttpRequest::logRequest()
     if (!out.size && loggingTags().oldType == LOG_TAG_NONE)
         debugs(33, 5, "logging half-baked transaction: " << log_uri);
 
+    if (request)
+        TransactionTrace::Note(request->masterXaction, TransactionTrace::Milestone::lastByte);
+
     al->icp.opcode = ICP_INVALID;
     al->url = log_uri;
     debugs(33, 9, "clientLogRequest: al.url='" << al->url << "'");
@@ -818,13 +840,19 @@ clientSocketRecipient(clientStreamNode * node, ClientHttpRequest * http,
 
     /* TODO: check offset is what we asked for */
 
-    // TODO: enforces HTTP/1 MUST on pipeline order, but is irrelevant to HTTP/2
-    if (context != http->getConn()->pipeline.front())
+    http->getConn()->handleStreamReply(context, node, rep, receivedData);
+}
+
+void
+ConnStateData::handleStreamReply(const Http::StreamPointer &context, clientStreamNode *node, HttpReply *rep, StoreIOBuffer receivedData)
+{
+    // enforces HTTP/1 MUST on pipeline order
+    if (context != pipeline.front())
         context->deferRecipientForLater(node, rep, receivedData);
-    else if (http->getConn()->cbControlMsgSent) // 1xx to the user is pending
+    else if (cbControlMsgSent) // 1xx to the user is pending
         context->deferRecipientForLater(node, rep, receivedData);
     else
-        http->getConn()->handleReply(rep, receivedData);
+        handleReply(rep, receivedData);
 }
 
 /**
@@ -1284,6 +1312,12 @@ ConnStateData::parseHttpRequest(const Http1::RequestParserPointer &hp)
         }
     }
 
+    return streamForParsedRequest(hp);
+}
+
+Http::Stream *
+ConnStateData::streamForParsedRequest(const Http1::RequestParserPointer &hp)
+{
     /* We know the whole request is in parser now */
     debugs(11, 2, "HTTP Client " << clientConnection);
     debugs(11, 2, "HTTP Client REQUEST:\n---------\n" <<
@@ -1868,8 +1902,17 @@ ConnStateData::parseRequests()
             assert(!preservingClientData_);
         }
 
-        if (Http::StreamPointer context = parseOneRequest()) {
+        // the request header reading phase starts with the first request byte
+        if (!requestReadingTime_.running())
+            requestReadingTime_.resume();
+
+        requestParsingTime_.resume();
+        Http::StreamPointer context = parseOneRequest();
+        requestParsingTime_.pause();
+
+        if (context) {
             debugs(33, 5, clientConnection << ": done parsing a request");
+            requestReadingTime_.pause();
             extendLifetime();
             context->registerWithConn();
 
@@ -1880,6 +1923,11 @@ ConnStateData::parseRequests()
 
             processParsedRequest(context);
 
+            // processParsedRequest() has given these measurements to the
+            // parsed request master transaction (if any)
+            requestReadingTime_ = Stopwatch();
+            requestParsingTime_ = Stopwatch();
+
             if (context->mayUseConnection()) {
                 debugs(33, 3, "Not parsing new requests, as this request may need the connection");
                 break;
@@ -1963,7 +2011,7 @@ ConnStateData::handleRequestBodyData()
         }
     } else { // identity encoding
         debugs(33,5, "handling plain request body for " << clientConnection);
-        const auto putSize = bodyPipe->putMoreData(inBuf.rawContent(), inBuf.length());
+        const auto putSize = bodyPipe->putMoreData(inBuf);
         if (putSize > 0)
             consumeInput(putSize);
 
@@ -2001,7 +2049,7 @@ ConnStateData::handleChunkedRequestBody()
             return ERR_NONE;
 
         BodyPipeCheckout bpc(*bodyPipe);
-        bodyParser->setPayloadBuffer(&bpc.buf);
+        bodyParser->setPayloadBuffer(&bpc.buf, BodyPipe::MaxCapacity);
         const bool parsed = bodyParser->parse(inBuf);
         inBuf = bodyParser->remaining(); // sync buffers
         bpc.checkIn();
@@ -2020,7 +2068,7 @@ ConnStateData::handleChunkedRequestBody()
         Must(!bodyParser->needsMoreData() || bodyPipe->mayNeedMoreData());
 
         // if parser needs more space and we can consume nothing, we will stall
-        Must(!bodyParser->needsMoreSpace() || bodyPipe->buf().hasContent());
+        Must(!bodyParser->needsMoreSpace() || !bodyPipe->buf().isEmpty());
     } catch (...) { // TODO: be more specific
         debugs(33, 3, "malformed chunks" << bodyPipe->status());
         return ERR_INVALID_REQ;
@@ -13,6 +13,7 @@
 
 #include "acl/ChecklistFiller.h"
 #include "base/RunnersRegistry.h"
+#include "base/Stopwatch.h"
 #include "clientStreamForward.h"
 #include "comm.h"
 #include "error/Error.h"
@@ -172,11 +173,11 @@ public:
     void expectNoForwarding(); ///< cleans up virgin request [body] forwarding state
 
     /* BodyPipe API */
-    BodyPipe::Pointer expectRequestBody(int64_t size);
+    virtual BodyPipe::Pointer expectRequestBody(int64_t size);
     void noteMoreBodySpaceAvailable(BodyPipe::Pointer) override = 0;
     void noteBodyConsumerAborted(BodyPipe::Pointer) override = 0;
 
-    bool handleRequestBodyData();
+    virtual bool handleRequestBodyData();
 
     /// parameters for the async notePinnedConnectionBecameIdle() call
     class PinnedIdleContext
@@ -242,7 +243,7 @@ public:
 
     /// Changes state so that we close the connection and quit after serving
     /// the client-side-detected error response instead of getting stuck.
-    void quitAfterError(HttpRequest *request); // meant to be private
+    virtual void quitAfterError(HttpRequest *request); // meant to be private
 
     /// The caller assumes responsibility for connection closure detection.
     void stopPinnedConnectionMonitoring();
@@ -321,6 +322,11 @@ public:
     /// for the current Http::Stream.
     virtual void handleReply(HttpReply *header, StoreIOBuffer receivedData) = 0;
 
+    /// ClientStream calls this to supply response header (once) and data
+    /// for the given Http::Stream. By default, defers delivery to streams
+    /// other than the current one, as required by HTTP/1 pipelining.
+    virtual void handleStreamReply(const Http::StreamPointer &, clientStreamNode *, HttpReply *, StoreIOBuffer receivedData);
+
     /// remove no longer needed leading bytes from the input buffer
     void consumeInput(const size_t byteCount);
 
@@ -410,6 +416,10 @@ protected:
     /// TODO: Move to HttpServer. Warning: Move requires large code nonchanges!
     Http::Stream *parseHttpRequest(const Http1::RequestParserPointer &);
 
+    /// creates a Http::Stream for a request fully parsed by the given parser
+    /// without consulting inBuf
+    Http::Stream *streamForParsedRequest(const Http1::RequestParserPointer &);
+
     /// parse input buffer prefix into a single transfer protocol request
     /// return NULL to request more header bytes (after checking any limits)
     /// use abortRequestParsing() to handle parsing errors w/o creating request
@@ -433,6 +443,12 @@ protected:
     /// whether preservedClientData is valid and should be kept up to date
     bool preservingClientData_ = false;
 
+    /// TransactionPhases::clientRead measurement for the being-parsed request
+    Stopwatch requestReadingTime_;
+
+    /// TransactionPhases::requestParse measurement for the being-parsed request
+    Stopwatch requestParsingTime_;
+
     bool tunnelOnError(const err_type);
 
 private:
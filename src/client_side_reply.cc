@@ -12,6 +12,7 @@
 #include "acl/FilledChecklist.h"
 #include "acl/Gadgets.h"
 #include "anyp/PortCfg.h"
+#include "BackgroundRefresh.h"
 #include "client_side_reply.h"
 #include "clientStream.h"
 #include "errorpage.h"
@@ -22,6 +23,8 @@
 #include "FwdState.h"
 #include "globals.h"
 #include "HeaderMangling.h"
+#include "http.h"
+#include "http/Compressor.h"
 #include "http/Stream.h"
 #include "HttpHeaderTools.h"
 #include "HttpReply.h"
@@ -32,13 +35,16 @@
 #include "MemObject.h"
 #include "mime_header.h"
 #include "neighbors.h"
+#include "RangeCache.h"
 #include "refresh.h"
 #include "RequestFlags.h"
+#include "sbuf/StringConvert.h"
 #include "SquidConfig.h"
 #include "SquidMath.h"
 #include "Store.h"
 #include "StrList.h"
 #include "tools.h"
+#include "TransactionTrace.h"
 #if USE_AUTH
 #include "auth/UserRequest.h"
 #endif
@@ -282,10 +288,7 @@ clientReplyContext::processExpired()
     saveState();
 
     // TODO: Consider also allowing regular (non-collapsed) revalidation hits.
-    // TODO: support collapsed revalidation for Vary-controlled entries
-    bool collapsingAllowed = Config.onoff.collapsed_forwarding &&
-                             !Store::Controller::SmpAware() &&
-                             http->request->vary_headers.isEmpty();
+    bool collapsingAllowed = Config.onoff.collapsed_forwarding;
 
     StoreEntry *entry = nullptr;
     if (collapsingAllowed) {
@@ -309,6 +312,9 @@ clientReplyContext::processExpired()
         entry = storeCreateEntry(url,
                                  http->log_uri, http->request->flags, http->request->method);
         /* NOTE, don't call StoreEntry->lock(), storeCreateEntry() does it */
+        // FwdState would do this later, but the revalidation key of a
+        // Vary-controlled entry must already reflect the revalidated variant
+        entry->mem_obj->request = http->request;
 
         if (collapsingAllowed && mayInitiateCollapsing() &&
                 Store::Root().allowCollapsing(entry, http->request->flags, http->request->method)) {
@@ -329,8 +335,13 @@ clientReplyContext::processExpired()
 
     if (!http->request->header.has(Http::HdrType::IF_NONE_MATCH)) {
         ETag etag = {nullptr, -1}; // TODO: make that a default ETag constructor
-        if (old_entry->hasEtag(etag) && !etag.weak)
-            http->request->etag = etag.str;
+        if (old_entry->hasEtag(etag) && !etag.weak) {
+            // validate responses we compressed using the origin server tag
+            SBuf tag(etag.str);
+            if (const auto oldReply = old_entry->hasFreshestReply())
+                (void)Http::Compressor::RemoveETagCoding(tag, StringToSBuf(oldReply->header.getList(Http::HdrType::CONTENT_ENCODING)));
+            http->request->etag = SBufToString(tag);
+        }
     }
 
     debugs(88, 5, "lastmod " << entry->lastModified());
@@ -398,6 +409,17 @@ clientReplyContext::sendClientOldEntry()
     sendMoreData(lastStreamBufferedBytes);
 }
 
+/// whether our request may use the response of the collapsed revalidation
+/// entry, which the initiator request variance (if any) was computed for
+bool
+clientReplyContext::slaveMatchesVariant() const
+{
+    const auto &mem = http->storeEntry()->mem();
+    if (mem.vary_headers.isEmpty())
+        return true; // the response does not vary
+    return httpMakeVaryMark(http->request, &mem.freshestReply()).cmp(mem.vary_headers) == 0;
+}
+
 /* This is the workhorse of the HandleIMSReply callback.
  *
  * It is called when we've got data back from the origin following our
@@ -426,8 +448,25 @@ clientReplyContext::handleIMSReply(const StoreIOBuffer result)
         return;
     }
 
+    // the new response may vary on headers that the revalidated variant did not
+    if (collapsedRevalidation == crSlave && !slaveMatchesVariant()) {
+        debugs(88, 3, "CF slave request does not match the new variant in " << *http->storeEntry() << ". MISS");
+        restoreState();
+        http->updateLoggingTags(LOG_TCP_MISS);
+        processMiss();
+        return;
+    }
+
     // request to origin was aborted
     if (EBIT_TEST(http->storeEntry()->flags, ENTRY_ABORTED)) {
+        // e.g., another worker revalidated without sharing its response
+        if (collapsedRevalidation == crSlave && http->request->flags.failOnValidationError) {
+            debugs(88, 3, "CF slave lost revalidation " << *http->storeEntry() << " but must not serve stale. MISS");
+            restoreState();
+            http->updateLoggingTags(LOG_TCP_MISS);
+            processMiss();
+            return;
+        }
         debugs(88, 3, "request to origin aborted '" << http->storeEntry()->url() << "', sending old entry to client");
         http->updateLoggingTags(LOG_TCP_REFRESH_FAIL_OLD);
         sendClientOldEntry();
@@ -526,6 +565,8 @@ clientReplyContext::cacheHit(const StoreIOBuffer result)
         return;
     }
 
+    TransactionTrace::Note(http->request->masterXaction, TransactionTrace::Milestone::storeHit);
+
     StoreEntry *e = http->storeEntry();
 
     HttpRequest *r = http->request;
@@ -673,7 +714,12 @@ clientReplyContext::cacheHit(const StoreIOBuffer result)
             processMiss();
         }
         return;
-    } else if (r->conditional()) {
+    }
+
+    if (r->flags.refreshAfterHit)
+        BackgroundRefresh::Start(*e, *r);
+
+    if (r->conditional()) {
         debugs(88, 5, "conditional HIT");
         if (processConditional())
             return;
@@ -689,7 +735,9 @@ clientReplyContext::cacheHit(const StoreIOBuffer result)
         http->updateLoggingTags(LOG_TCP_MISS);
     else
 #endif
-        if (e->mem_status == IN_MEMORY)
+        if (r->flags.refreshAfterHit && r->flags.staleIfHit)
+            http->updateLoggingTags(LOG_TCP_STALE_HIT);
+        else if (e->mem_status == IN_MEMORY)
             http->updateLoggingTags(LOG_TCP_MEM_HIT);
         else if (Config.onoff.offline)
             http->updateLoggingTags(LOG_TCP_OFFLINE_HIT);
@@ -722,6 +770,12 @@ clientReplyContext::processMiss()
         removeClientStoreReference(&sc, http);
     }
 
+    /** Check if the requested range was remembered by RangeCache. */
+    if (!http->redirect.status && sendPartialHit())
+        return;
+
+    TransactionTrace::Note(r->masterXaction, TransactionTrace::Milestone::storeMiss);
+
     /** Check if its a PURGE request to be actioned. */
     if (r->method == Http::METHOD_PURGE) {
         purgeRequest();
@@ -844,6 +898,13 @@ clientReplyContext::processConditional()
 /// whether squid.conf send_hit prevents us from serving this hit
 bool
 clientReplyContext::blockedHit() const
+{
+    return blockedHit(http->storeEntry()->mem().freshestReply());
+}
+
+/// whether send_hit prohibits sending the given cached response
+bool
+clientReplyContext::blockedHit(const HttpReply &hitReply) const
 {
     if (!Config.accessList.sendHit)
         return false; // hits are not blocked by default
@@ -854,7 +915,7 @@ clientReplyContext::blockedHit() const
     {
         ACLFilledChecklist chl(Config.accessList.sendHit, nullptr);
         clientAclChecklistFill(chl, http);
-        chl.updateReply(&http->storeEntry()->mem().freshestReply());
+        chl.updateReply(&hitReply);
         return !chl.fastCheck().allowed(); // when in doubt, block
     }
 }
@@ -1807,6 +1868,39 @@ clientReplyContext::sendNotModified()
     triggerInitialStoreRead();
 }
 
+/// sends a response to a Range request assembled by RangeCache (if possible)
+/// \returns whether the response is being sent
+bool
+clientReplyContext::sendPartialHit()
+{
+    const auto hit = RangeCache::Instance().find(*http->request);
+    if (!hit)
+        return false;
+
+    if (blockedHit(*hit->reply)) {
+        debugs(88, 5, "send_hit prohibits a range cache hit");
+        return false;
+    }
+
+    debugs(88, 3, "range cache hit for " << http->uri);
+    TransactionTrace::Note(http->request->masterXaction, TransactionTrace::Milestone::storeHit);
+    http->updateLoggingTags(LOG_TCP_PARTIAL_HIT);
+    // the response already contains just the requested range
+    http->request->ignoreRange("responding with a RangeCache hit");
+    createStoreEntry(http->request->method, RequestFlags());
+    const auto e = http->storeEntry();
+    e->replaceHttpReply(hit->reply, false); // no write until timestampsSet()
+    // use the remembered response time so that the reply gets a meaningful Age
+    e->timestampsSet();
+    e->timestamp = hit->timestamp;
+    e->startWriting();
+    // like Client::storeReplyBody(), store 206 body bytes at their Content-Range offset
+    e->write(StoreIOBuffer(hit->body.length(), hit->offset, const_cast<char*>(hit->body.rawContent())));
+    e->completeSuccessfully("RangeCache stored the entire response");
+    triggerInitialStoreRead();
+    return true;
+}
+
 /// send 304 (Not Modified) or 412 (Precondition Failed) to client
 /// depending on request method
 void
@@ -2081,6 +2175,9 @@ clientReplyContext::createStoreEntry(const HttpRequestMethod& m, RequestFlags re
     }
 
     StoreEntry *e = storeCreateEntry(storeId(), http->log_uri, reqFlags, m);
+    // FwdState would do this later, but the public key of a Vary-controlled
+    // entry must already reflect the requested variant
+    e->mem_obj->request = http->request;
 
     // Make entry collapsible ASAP, to increase collapsing chances for others,
     // TODO: every must-revalidate and similar request MUST reach the origin,
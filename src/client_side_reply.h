@@ -109,6 +109,7 @@ private:
     void noteStreamBufferredBytes(const StoreIOBuffer &);
     void cacheHit(StoreIOBuffer result);
     void handleIMSReply(StoreIOBuffer result);
+    bool slaveMatchesVariant() const;
     void sendMoreData(StoreIOBuffer result);
     void triggerInitialStoreRead(STCB = SendMoreData);
     void requestMoreBodyFromStore();
@@ -121,6 +122,7 @@ private:
     void purgeDoPurge();
     void forgetHit();
     bool blockedHit() const;
+    bool blockedHit(const HttpReply &) const;
     const char *storeLookupString(bool found) const { return found ? "match" : "mismatch"; }
     void detailStoreLookup(const char *detail);
 
@@ -128,6 +130,7 @@ private:
     void sendPreconditionFailedError();
     void sendNotModified();
     void sendNotModifiedOrPreconditionFailedError();
+    bool sendPartialHit();
     void sendClientUpstreamResponse(const StoreIOBuffer &upstreamResponse);
 
     /// Reduces a chance of an accidental direct storeClientCopy() call that
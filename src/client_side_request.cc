@@ -57,6 +57,7 @@
 #include "Store.h"
 #include "StrList.h"
 #include "tools.h"
+#include "TransactionTrace.h"
 #include "wordlist.h"
 #if USE_AUTH
 #include "auth/UserRequest.h"
@@ -534,6 +535,8 @@ ClientRequestContext::hostHeaderVerify()
 void
 ClientRequestContext::clientAccessCheck()
 {
+    http->request->masterXaction->phases.start(TransactionPhases::httpAccess);
+
 #if FOLLOW_X_FORWARDED_FOR
     if (!http->request->flags.doneFollowXff() &&
             Config.accessList.followXFF &&
@@ -570,6 +573,8 @@ ClientRequestContext::clientAccessCheck()
 void
 ClientRequestContext::clientAccessCheck2()
 {
+    http->request->masterXaction->phases.start(TransactionPhases::httpAccess);
+
     if (Config.accessList.adapted_http) {
         auto acl_checklist = clientAclChecklistCreate(Config.accessList.adapted_http, http);
         ACLFilledChecklist::NonBlockingCheck(std::move(acl_checklist), clientAccessCheckDoneWrapper, this);
@@ -593,6 +598,9 @@ ClientRequestContext::clientAccessCheckDone(const Acl::Answer &answer)
     debugs(85, 2, "The request " << http->request->method << ' ' <<
            http->uri << " is " << answer <<
            "; last ACL checked: " << answer.lastCheckDescription());
+    if (!adapted_http_access_done) // http_access rather than adapted_http_access
+        TransactionTrace::Note(http->request->masterXaction, TransactionTrace::Milestone::accessChecked);
+    http->request->masterXaction->phases.stop(TransactionPhases::httpAccess);
 
 #if USE_AUTH
     char const *proxy_auth_msg = "<null>";
@@ -805,6 +813,12 @@ clientCheckPinning(ClientHttpRequest * http)
     if (!http_conn)
         return;
 
+    // Multiplexed HTTP/2 streams cannot share a pinned to-server connection.
+    if (http_conn->transferProtocol.major >= 2) {
+        request->flags.connectionAuthDisabled = true;
+        return;
+    }
+
     request->flags.connectionAuthDisabled = http_conn->port->connection_auth_disabled;
     if (!request->flags.connectionAuthDisabled) {
         if (Comm::IsConnOpen(http_conn->pinning.serverConnection)) {
@@ -1807,6 +1821,7 @@ ClientHttpRequest::startAdaptation(const Adaptation::ServiceGroupPointer &g)
     debugs(85, 3, "adaptation needed for " << this);
     assert(!virginHeadSource);
     assert(!adaptedBodySource);
+    request->masterXaction->phases.start(TransactionPhases::adaptation);
     virginHeadSource = initiateAdaptation(
                            new Adaptation::Iterator(request, nullptr, al, g));
 
@@ -1818,6 +1833,7 @@ ClientHttpRequest::startAdaptation(const Adaptation::ServiceGroupPointer &g)
 void
 ClientHttpRequest::noteAdaptationAnswer(const Adaptation::Answer &answer)
 {
+    request->masterXaction->phases.stop(TransactionPhases::adaptation);
     clearAdaptation(virginHeadSource);
     assert(!adaptedBodySource);
 
@@ -1917,7 +1933,7 @@ ClientHttpRequest::noteMoreBodyDataAvailable(BodyPipe::Pointer)
     assert(request_satisfaction_mode);
     assert(adaptedBodySource != nullptr);
 
-    if (size_t contentSize = adaptedBodySource->buf().contentSize()) {
+    if (size_t contentSize = adaptedBodySource->buf().length()) {
         const size_t spaceAvailable = storeEntry()->bytesWanted(Range<size_t>(0,contentSize));
 
         if (spaceAvailable < contentSize ) {
@@ -1935,7 +1951,7 @@ ClientHttpRequest::noteMoreBodyDataAvailable(BodyPipe::Pointer)
             contentSize = spaceAvailable;
 
         BodyPipeCheckout bpc(*adaptedBodySource);
-        const StoreIOBuffer ioBuf(&bpc.buf, request_satisfaction_offset, contentSize);
+        const StoreIOBuffer ioBuf(contentSize, request_satisfaction_offset, const_cast<char*>(bpc.buf.rawContent()));
         storeEntry()->write(ioBuf);
         // assume StoreEntry::write() writes the entire ioBuf
         request_satisfaction_offset += ioBuf.length;
@@ -17,9 +17,13 @@
 #include "error/Detail.h"
 #include "errorpage.h"
 #include "fd.h"
+#include "http/Compressor.h"
+#include "HttpHdrCc.h"
 #include "HttpHdrContRange.h"
 #include "HttpReply.h"
 #include "HttpRequest.h"
+#include "RangeCache.h"
+#include "sbuf/StringConvert.h"
 #include "SquidConfig.h"
 #include "StatCounters.h"
 #include "Store.h"
@@ -67,6 +71,8 @@ Client::~Client()
 void
 Client::swanSong()
 {
+    rememberPartialReply();
+
     // get rid of our piping obligations
     if (requestBodySource != nullptr)
         stopConsumingFrom(requestBodySource);
@@ -139,7 +145,8 @@ Client::setFinalReply(HttpReply *rep)
 
     assert(!theFinalReply);
     assert(rep);
-    theFinalReply = rep;
+    const HttpReplyPointer givenReply(rep); // rep may be an unlocked clone
+    theFinalReply = maybeCompressReply(rep);
     HTTPMSGLOCK(theFinalReply);
     if (fwd->al)
         fwd->al->reply = theFinalReply;
@@ -147,8 +154,16 @@ Client::setFinalReply(HttpReply *rep)
     // give entry the reply because haveParsedReplyHeaders() expects it there
     entry->replaceHttpReply(theFinalReply, false); // but do not write yet
     haveParsedReplyHeaders(); // update the entry/reply (e.g., set timestamps)
-    if (!EBIT_TEST(entry->flags, RELEASE_REQUEST) && blockCaching())
-        entry->release();
+
+    // store_miss applies to both the cache and RangeCache
+    const auto mayStore = !EBIT_TEST(entry->flags, RELEASE_REQUEST);
+    const auto mayRememberRange = RangeCache::Instance().mayRemember(*request, *theFinalReply);
+    if ((mayStore || mayRememberRange) && blockCaching()) {
+        if (mayStore)
+            entry->release();
+    } else if (mayRememberRange) {
+        partialReplyBody.emplace();
+    }
     entry->startWriting(); // write the updated entry to store
 
     return theFinalReply;
@@ -232,8 +247,10 @@ Client::completeForwarding()
         storedWholeReply = receivedWholeAdaptedReply ? "receivedWholeAdaptedReply" : nullptr;
 #endif
 
-    if (storedWholeReply)
+    if (storedWholeReply) {
+        finishCompression();
         fwd->markStoredReplyAsWhole(storedWholeReply);
+    }
 
     doneWithFwd = "completeForwarding()";
     fwd->complete();
@@ -430,13 +447,19 @@ Client::sendMoreRequestBody()
         debugs(9,3, "will write " << buf.contentSize() << " request body bytes");
         typedef CommCbMemFunT<Client, CommIoCbParams> Dialer;
         requestSender = JobCallback(93,3, Dialer, this, Client::sentRequestBody);
-        Comm::Write(conn, &buf, requestSender);
+        writeRequestBody(buf);
     } else {
         debugs(9,3, "will wait for more request body bytes or eof");
         requestSender = nullptr;
     }
 }
 
+void
+Client::writeRequestBody(MemBuf &buf)
+{
+    Comm::Write(dataConnection(), &buf, requestSender);
+}
+
 /// either fill buf with available [encoded] request body bytes or return false
 bool
 Client::getMoreRequestBody(MemBuf &buf)
@@ -515,6 +538,106 @@ purgeEntriesByHeader(HttpRequest *req, const char *reqUrl, Http::Message *rep, H
     purgeEntriesByUrl(req, absUrl);
 }
 
+/// Prepares to compress the final reply body if response_compression_access
+/// allows that. Eligible replies vary on Accept-Encoding, even when the
+/// client does not accept any of the codings we can apply.
+/// \returns an adjusted copy of an eligible reply or the given reply
+HttpReply *
+Client::maybeCompressReply(HttpReply *rep)
+{
+    const auto acl = Config.accessList.responseCompression;
+    if (!acl)
+        return rep;
+
+    const auto req = originalRequest();
+    if (req->method != Http::METHOD_GET || rep->sline.status() != Http::scOkay)
+        return rep;
+
+    if (rep->header.has(Http::HdrType::CONTENT_ENCODING) || rep->header.has(Http::HdrType::CONTENT_RANGE))
+        return rep;
+
+    if ((rep->cache_control && rep->cache_control->hasNoTransform()) ||
+            (req->cache_control && req->cache_control->hasNoTransform()))
+        return rep;
+
+    if (rep->header.hasListMember(Http::HdrType::VARY, "*", ','))
+        return rep;
+
+    if (rep->content_length >= 0 && rep->content_length < Config.responseCompression.minSize)
+        return rep;
+
+    ACLFilledChecklist ch(acl, req.getRaw());
+    ch.updateAle(fwd->al);
+    ch.updateReply(rep);
+    if (!ch.fastCheck().allowed())
+        return rep;
+
+    const auto &settings = Config.responseCompression;
+    const auto coding = Http::Compressor::Negotiate(StringToSBuf(req->header.getList(Http::HdrType::ACCEPT_ENCODING)),
+                        settings.gzipLevel, settings.brLevel);
+
+    const auto adjusted = rep->clone();
+    auto &header = adjusted->header;
+
+    if (!header.hasListMember(Http::HdrType::VARY, "Accept-Encoding", ',')) {
+        auto vary = header.getList(Http::HdrType::VARY);
+        if (vary.size())
+            vary.append(", ");
+        vary.append("Accept-Encoding");
+        header.delById(Http::HdrType::VARY);
+        header.putStr(Http::HdrType::VARY, vary.termedBuf());
+    }
+
+    if (coding != Http::Compressor::Coding::identity) {
+        const auto name = Http::Compressor::Name(coding);
+        compressor = Http::Compressor::Make(coding, coding == Http::Compressor::Coding::gzip ? settings.gzipLevel : settings.brLevel);
+        debugs(11, 3, "compressing using " << name);
+
+        header.putStr(Http::HdrType::CONTENT_ENCODING, name);
+        header.delById(Http::HdrType::CONTENT_LENGTH);
+        adjusted->content_length = -1;
+
+        // the compressed representation needs its own entity tag
+        auto etag = StringToSBuf(header.getStrOrList(Http::HdrType::ETAG));
+        if (Http::Compressor::AddETagCoding(etag, coding)) {
+            header.delById(Http::HdrType::ETAG);
+            header.putStr(Http::HdrType::ETAG, etag.c_str());
+        }
+    }
+
+    return adjusted;
+}
+
+/// stores the remainder of the compressed reply body
+void
+Client::finishCompression()
+{
+    if (!compressor)
+        return;
+
+    SBuf tail;
+    compressor->finish(tail);
+    debugs(11, 5, "compressed " << compressor->bytesIn() << " body bytes into " << compressor->bytesOut());
+    compressor.reset();
+
+    if (!tail.isEmpty()) {
+        entry->write(StoreIOBuffer(tail.length(), currentOffset, const_cast<char*>(tail.rawContent())));
+        currentOffset += tail.length();
+    }
+}
+
+/// gives RangeCache the stored 206 reply body bytes, even if the transaction
+/// was aborted: Content-Range specifies where the received bytes belong
+void
+Client::rememberPartialReply()
+{
+    if (!partialReplyBody)
+        return;
+
+    RangeCache::Instance().remember(*request, *theFinalReply, *partialReplyBody);
+    partialReplyBody.reset();
+}
+
 // some HTTP methods should purge matching cache entries
 void
 Client::maybePurgeOthers()
@@ -596,10 +719,71 @@ Client::startAdaptation(const Adaptation::ServiceGroupPointer &group, HttpReques
             virginBodyDestination->setBodySize(size);
     }
 
+    request->masterXaction->phases.start(TransactionPhases::adaptation);
     adaptedHeadSource = initiateAdaptation(
                             new Adaptation::Iterator(vrep, cause, fwd->al, group));
     startedAdaptation = initiated(adaptedHeadSource);
     Must(startedAdaptation);
+
+    speculationWindow = group->speculationWindow();
+    if (speculationWindow > 0)
+        startSpeculating();
+}
+
+/// Stores the virgin reply header without waiting for the adaptation answer.
+/// The client starts receiving the response while adaptation services are
+/// still looking at it. Only unmodified adaptation answers keep that response.
+void
+Client::startSpeculating()
+{
+    debugs(11, 5, "speculating up to " << speculationWindow << " body bytes");
+    const auto rep = virginReply()->clone();
+    rep->body_pipe = nullptr; // the virgin body goes to adaptation
+    speculating = true;
+    setFinalReply(rep);
+}
+
+/// stores virgin reply body bytes that fit into the speculation window
+void
+Client::speculateVirginReplyBody(const char *data, const size_t len)
+{
+    if (!speculating || speculativeBodySize >= speculationWindow)
+        return;
+
+    const auto size = static_cast<size_t>(min(static_cast<uint64_t>(len), speculationWindow - speculativeBodySize));
+    if (!size)
+        return;
+
+    storeReplyBody(data, size);
+    speculativeBodySize += size;
+}
+
+/// Handles adaptation answers that modify a speculatively stored response.
+/// Other answers are handled as usual: Unmodified answers keep the stored
+/// response while block and error handlers abort it.
+/// \returns whether the answer has been handled
+bool
+Client::handledSpeculationAnswer(const Adaptation::Answer &answer)
+{
+    speculating = false;
+
+    if (answer.kind != Adaptation::Answer::akForward)
+        return false;
+
+    if (answer.unmodified) {
+        debugs(11, 5, "adaptation kept " << speculativeBodySize << " speculatively stored body bytes");
+        return false;
+    }
+
+    // the client has seen the virgin response already
+    if (answer.message->body_pipe != nullptr)
+        answer.message->body_pipe->expectNoConsumption();
+    if (request) {
+        static const auto d = MakeNamedErrorDetail("RESPMOD_SPECULATION_LATE");
+        request->detailError(ERR_ICAP_FAILURE, d);
+    }
+    abortAll("adaptation modified a speculatively stored response");
+    return true;
 }
 
 // properly cleans up ICAP-related state
@@ -699,8 +883,12 @@ Client::noteBodyConsumerAborted(BodyPipe::Pointer)
 void
 Client::noteAdaptationAnswer(const Adaptation::Answer &answer)
 {
+    request->masterXaction->phases.stop(TransactionPhases::adaptation);
     clearAdaptation(adaptedHeadSource); // we do not expect more messages
 
+    if (speculating && handledSpeculationAnswer(answer))
+        return;
+
     switch (answer.kind) {
     case Adaptation::Answer::akForward:
         handleAdaptedHeader(const_cast<Http::Message*>(answer.message.getRaw()));
@@ -733,8 +921,12 @@ Client::handleAdaptedHeader(Http::Message *msg)
 
     HttpReply *rep = dynamic_cast<HttpReply*>(msg);
     assert(rep);
-    debugs(11,5, this << " setting adapted reply to " << rep);
-    setFinalReply(rep);
+    if (speculationWindow > 0) {
+        debugs(11,5, this << " keeping speculatively stored reply " << theFinalReply);
+    } else {
+        debugs(11,5, this << " setting adapted reply to " << rep);
+        setFinalReply(rep);
+    }
 
     assert(!adaptedBodySource);
     if (rep->body_pipe != nullptr) {
@@ -776,7 +968,14 @@ Client::handleMoreAdaptedBodyAvailable()
 
     assert(entry);
 
-    size_t contentSize = adaptedBodySource->buf().contentSize();
+    size_t contentSize = adaptedBodySource->buf().length();
+
+    // skip the echoed virgin body bytes we have stored speculatively
+    if (adaptedBodySource->consumedSize() < speculativeBodySize) {
+        const auto skipSize = static_cast<size_t>(min(static_cast<uint64_t>(contentSize), speculativeBodySize - adaptedBodySource->consumedSize()));
+        adaptedBodySource->consume(skipSize);
+        contentSize -= skipSize;
+    }
 
     if (!contentSize)
         return; // XXX: bytesWanted asserts on zero-size ranges
@@ -807,9 +1006,7 @@ Client::handleMoreAdaptedBodyAvailable()
            "response body at offset " << adaptedBodySource->consumedSize());
 
     BodyPipeCheckout bpc(*adaptedBodySource);
-    const StoreIOBuffer ioBuf(&bpc.buf, currentOffset, contentSize);
-    currentOffset += ioBuf.length;
-    entry->write(ioBuf);
+    storeReplyBody(bpc.buf.rawContent(), contentSize);
     bpc.buf.consume(contentSize);
     bpc.checkIn();
 }
@@ -1058,6 +1255,7 @@ Client::addVirginReplyBody(const char *data, ssize_t len)
 #if USE_ADAPTATION
     assert(!adaptationAccessCheckPending); // or would need to buffer while waiting
     if (startedAdaptation) {
+        speculateVirginReplyBody(data, len);
         adaptVirginReplyBody(data, len);
         return;
     }
@@ -1065,10 +1263,42 @@ Client::addVirginReplyBody(const char *data, ssize_t len)
     storeReplyBody(data, len);
 }
 
+void
+Client::addVirginReplyBody(const SBuf &data)
+{
+#if USE_ADAPTATION
+    assert(!adaptationAccessCheckPending); // or would need to buffer while waiting
+    if (startedAdaptation && virginBodyDestination && !responseBodyBuffer) {
+        adjustBodyBytesRead(data.length());
+        speculateVirginReplyBody(data.rawContent(), data.length());
+        const auto putSize = virginBodyDestination->putMoreData(data);
+        // buffer the excess, if any
+        if (putSize < data.length())
+            adaptVirginReplyBody(data.rawContent() + putSize, data.length() - putSize);
+        return;
+    }
+#endif
+    addVirginReplyBody(data.rawContent(), data.length());
+}
+
 // writes virgin or adapted reply body to store
 void
 Client::storeReplyBody(const char *data, ssize_t len)
 {
+    if (partialReplyBody && len > 0) {
+        if (partialReplyBody->length() + static_cast<uint64_t>(len) > RangeCache::Instance().maxBodySize())
+            partialReplyBody.reset(); // a misbehaving server or reconfiguration
+        else
+            partialReplyBody->append(data, len);
+    }
+
+    SBuf compressed;
+    if (compressor && len > 0) {
+        compressor->compress(data, len, compressed);
+        data = compressed.rawContent();
+        len = compressed.length();
+    }
+
     // write even if len is zero to push headers towards the client side
     entry->write (StoreIOBuffer(len, currentOffset, (char*)data));
 
@@ -1097,7 +1327,7 @@ Client::calcBufferSpaceToReserve(size_t space, const size_t wantSpace) const
          * There is no code to keep pumping data into the pipe once
          * response ends and serverComplete() is called.
          */
-        const size_t adaptor_space = virginBodyDestination->buf().potentialSpaceSize();
+        const size_t adaptor_space = virginBodyDestination->spaceSize();
 
         debugs(11,9, "Client may read up to min(" <<
                adaptor_space << ", " << space << ") bytes");
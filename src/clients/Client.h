@@ -14,7 +14,12 @@
 #include "CommCalls.h"
 #include "FwdState.h"
 #include "http/forward.h"
+#include "sbuf/SBuf.h"
 #include "StoreIOBuffer.h"
+
+#include <memory>
+#include <optional>
+
 #if USE_ADAPTATION
 #include "adaptation/forward.h"
 #include "adaptation/Initiator.h"
@@ -102,6 +107,9 @@ protected:
 
     // sending of the request body to the server
     void sendMoreRequestBody();
+    /// sends the given request body bytes to the server, calling requestSender
+    /// afterwards; kids using non-Comm transports override
+    virtual void writeRequestBody(MemBuf &);
     // has body; kids overwrite to increment I/O stats counters
     virtual void sentRequestBody(const CommIoCbParams &io) = 0;
     virtual void doneSendingRequestBody() = 0;
@@ -125,6 +133,9 @@ protected:
 #if USE_ADAPTATION
     void startAdaptation(const Adaptation::ServiceGroupPointer &group, HttpRequest *cause);
     void adaptVirginReplyBody(const char *buf, ssize_t len);
+    void startSpeculating();
+    void speculateVirginReplyBody(const char *buf, size_t len);
+    bool handledSpeculationAnswer(const Adaptation::Answer &answer);
     void cleanAdaptation();
     virtual bool doneWithAdaptation() const;   /**< did we end ICAP communication? */
 
@@ -159,6 +170,8 @@ protected:
     // Kids use these to stuff data into the response instead of messing with the entry directly
     void adaptOrFinalizeReply();
     void addVirginReplyBody(const char *buf, ssize_t len);
+    /// addVirginReplyBody() that may share buffer storage with adaptation
+    void addVirginReplyBody(const SBuf &);
     void storeReplyBody(const char *buf, ssize_t len);
     /// determine how much space the buffer needs to reserve
     size_t calcBufferSpaceToReserve(const size_t space, const size_t wantSpace) const;
@@ -196,6 +209,16 @@ protected:
     bool receivedWholeAdaptedReply = false;
 
     bool adaptedReplyAborted = false; ///< handleAdaptedBodyProducerAborted() has been called
+
+    /// the maximum number of virgin body bytes to store before the adaptation answer
+    uint64_t speculationWindow = 0;
+
+    /// the number of virgin body bytes stored before the adaptation answer
+    uint64_t speculativeBodySize = 0;
+
+    /// whether the virgin reply header was stored before the adaptation answer
+    /// and that answer is still pending
+    bool speculating = false;
 #endif
     bool receivedWholeRequestBody = false; ///< handleRequestBodyProductionEnded called
 
@@ -213,9 +236,18 @@ protected:
 private:
     void sendBodyIsTooLargeError();
     void maybePurgeOthers();
+    HttpReply *maybeCompressReply(HttpReply *);
+    void finishCompression();
+    void rememberPartialReply();
 
     HttpReply *theVirginReply = nullptr;       /**< reply received from the origin server */
     HttpReply *theFinalReply = nullptr;        /**< adapted reply from ICAP or virgin reply */
+
+    /// applies response_compression_access to stored reply body bytes (or nil)
+    std::unique_ptr<Http::Compressor> compressor;
+
+    /// stored 206 reply body bytes for RangeCache (if it may remember them)
+    std::optional<SBuf> partialReplyBody;
 };
 
 #endif /* SQUID_SRC_CLIENTS_CLIENT_H */
@@ -0,0 +1,1320 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 11    Hypertext Transfer Protocol (HTTP) */
+
+#include "squid.h"
+#include "base/AsyncJobCalls.h"
+#include "base/IoManip.h"
+#include "CachePeer.h"
+#include "clients/Http2Session.h"
+#include "comm.h"
+#include "comm/Connection.h"
+#include "comm/Read.h"
+#include "comm/Write.h"
+#include "fde.h"
+#include "FwdState.h"
+#include "HttpHeader.h"
+#include "HttpRequest.h"
+#include "MemBuf.h"
+#include "parser/Tokenizer.h"
+#include "pconn.h"
+#include "SquidConfig.h"
+
+#include <algorithm>
+#include <cstring>
+#include <list>
+#include <ostream>
+
+CBDATA_NAMESPACED_CLASS_INIT(Http2, Session);
+
+/// our SETTINGS_INITIAL_WINDOW_SIZE; limits response bytes buffered per stream
+static const int64_t StreamWindow = 256*1024;
+
+/// our connection flow control window for DATA we receive
+static const int64_t ConnectionWindow = 16*1024*1024;
+
+/// running sessions
+static std::list<Http::Two::Session*> TheSessions;
+
+/* Http::Two::Session */
+
+bool
+Http::Two::Session::CanForward(const HttpRequest &request, const CachePeer &peer)
+{
+    return peer.options.http2 &&
+           request.method != Http::METHOD_CONNECT &&
+           !request.flags.sslBumped && // tunneled through the peer
+           !request.flags.pinned &&
+           !request.header.has(Http::HdrType::UPGRADE); // HTTP/2 cannot switch protocols
+}
+
+Http::Two::Session::Pointer
+Http::Two::Session::Get(const Comm::ConnectionPointer &conn)
+{
+    for (const auto session: TheSessions) {
+        if (session->conn_ == conn)
+            return session;
+    }
+
+    const Pointer session = new Session(conn);
+    AsyncJob::Start(session);
+    return session;
+}
+
+Comm::ConnectionPointer
+Http::Two::Session::Find(const Comm::Connection &destination)
+{
+    Session *best = nullptr;
+    for (const auto session: TheSessions) {
+        if (!session->acceptsStreams())
+            continue;
+        const auto &conn = *session->conn_;
+        if (conn.getPeer() != destination.getPeer() || conn.remote != destination.remote)
+            continue;
+        if (!best || session->activeStreams() > best->activeStreams())
+            best = session;
+    }
+    return best ? best->conn_ : nullptr;
+}
+
+void
+Http::Two::Session::Dump(std::ostream &yaml)
+{
+    yaml << "pool HTTP/2 sessions:\n";
+    AtMostOnce heading("  open sessions list:\n");
+    for (const auto session: TheSessions) {
+        if (!Comm::IsConnOpen(session->conn_))
+            continue;
+        const auto &conn = *session->conn_;
+        yaml << heading <<
+             "    \"" << conn.remote << (conn.getPeer() ? "/" : "") << (conn.getPeer() ? conn.getPeer()->name : "") << "\": " <<
+             "{active streams: " << session->activeStreams() <<
+             ", waiting streams: " << session->waiting_.size() <<
+             ", started streams: " << session->streamsStarted_ <<
+             ", concurrency limit: " << session->peerMaxStreams_ <<
+             (session->goingAway_ ? ", going away: true" : "") <<
+             "}\n";
+    }
+}
+
+Http::Two::Session::Session(const Comm::ConnectionPointer &conn):
+    AsyncJob("Http2::Session"),
+    conn_(conn),
+    decoder_(DefaultHeaderTableSize, Config.maxReplyHeaderSize),
+    idleSince_(squid_curtime)
+{
+    debugs(11, 5, "constructed, this=" << static_cast<void*>(this));
+}
+
+Http::Two::Session::~Session()
+{
+    debugs(11, 5, "destructed, this=" << static_cast<void*>(this));
+}
+
+void
+Http::Two::Session::start()
+{
+    AsyncJob::start();
+
+    Must(Comm::IsConnOpen(conn_));
+
+#if USE_OPENSSL
+    // a TLS peer that ignores our ALPN offer may wait for an HTTP/1 request
+    if (const auto &tls = fd_table[conn_->fd].ssl) {
+        const unsigned char *protocol = nullptr;
+        unsigned int protocolLength = 0;
+        SSL_get0_alpn_selected(tls.get(), &protocol, &protocolLength);
+        if (protocolLength != 2 || memcmp(protocol, "h2", 2) != 0) {
+            debugs(11, DBG_IMPORTANT, "ERROR: Cannot forward over HTTP/2: The peer did not select h2 via TLS ALPN" <<
+                   Debug::Extra << "connection: " << conn_);
+            conn_->close();
+            return;
+        }
+    }
+#endif
+
+    TheSessions.push_back(this);
+
+    typedef CommCbMemFunT<Session, CommCloseCbParams> Dialer;
+    closer_ = JobCallback(11, 5, Dialer, this, Http2::Session::noteClosure);
+    comm_add_close_handler(conn_->fd, closer_);
+
+    debugs(11, 3, "HTTP/2 session with " << conn_);
+    outBuf_.append(ClientPreface());
+
+    SBuf settings;
+    PutUint16(settings, sEnablePush);
+    PutUint32(settings, 0);
+    PutUint16(settings, sInitialWindowSize);
+    PutUint32(settings, StreamWindow);
+    PutUint16(settings, sMaxHeaderListSize);
+    PutUint32(settings, Config.maxReplyHeaderSize);
+    PackFrame(outBuf_, ftSettings, 0, 0, settings);
+    PackWindowUpdate(outBuf_, 0, ConnectionWindow - DefaultWindowSize);
+
+    readMore();
+    writeSomeData();
+    scheduleTimeout();
+}
+
+bool
+Http::Two::Session::doneAll() const
+{
+    return !Comm::IsConnOpen(conn_);
+}
+
+void
+Http::Two::Session::swanSong()
+{
+    TheSessions.remove(this);
+
+    if (closer_) {
+        if (Comm::IsConnOpen(conn_))
+            comm_remove_close_handler(conn_->fd, closer_);
+        closer_ = nullptr;
+    }
+
+    // the streams cannot continue without us
+    if (conn_)
+        failStreams();
+
+    if (Comm::IsConnOpen(conn_))
+        conn_->close();
+
+    AsyncJob::swanSong();
+}
+
+const char *
+Http::Two::Session::status() const
+{
+    static MemBuf buf;
+    buf.reset();
+
+    buf.appendf(" [streams: %zu", streams_.size());
+    if (goingAway_)
+        buf.append(" going away", 11);
+    if (stopReason != nullptr)
+        buf.appendf(" stopped, reason: %s", stopReason);
+    if (conn_ != nullptr)
+        buf.appendf(" FD %d", conn_->fd);
+    buf.appendf(" %s%u]", id.prefix(), id.value);
+    buf.terminate();
+
+    return buf.content();
+}
+
+/// the number of started streams that have not ended in both directions
+uint32_t
+Http::Two::Session::activeStreams() const
+{
+    return std::count_if(streams_.begin(), streams_.end(), [](const Streams::value_type &i) {
+        const auto &s = i.second;
+        return s.started && !s.failed && !(s.localClosed && s.remoteClosed);
+    });
+}
+
+/// whether Find() may offer this session for another stream
+bool
+Http::Two::Session::acceptsStreams() const
+{
+    return Comm::IsConnOpen(conn_) && !fd_table[conn_->fd].closing() &&
+           !goingAway_ && !closing_ &&
+           nextStreamId_ < 0x7fffffff &&
+           activeStreams() + waiting_.size() < peerMaxStreams_;
+}
+
+uint32_t
+Http::Two::Session::addStream()
+{
+    if (goingAway_ || closing_ || nextStreamId_ >= 0x7fffffff || !Comm::IsConnOpen(conn_)) {
+        debugs(11, 3, "no new streams on " << conn_);
+        return 0;
+    }
+
+    const auto streamId = nextStreamId_;
+    nextStreamId_ += 2;
+    streams_[streamId];
+    debugs(11, 5, "stream " << streamId << " on " << conn_);
+    scheduleTimeout();
+    return streamId;
+}
+
+void
+Http::Two::Session::sendHeaders(const uint32_t streamId, const HttpRequest &request, const HttpHeader &header, const bool endStream, const AsyncCall::Pointer &writer)
+{
+    const auto it = streams_.find(streamId);
+    if (it == streams_.end()) {
+        debugs(11, 3, "ignoring HEADERS for closed stream " << streamId);
+        return;
+    }
+
+    auto &s = it->second;
+    Must(!s.started);
+    Must(!s.writer);
+    s.writer = writer;
+    s.requestEnds = endStream;
+
+    auto &fields = s.requestFields;
+    fields.emplace_back(SBuf(":method"), request.method.image());
+    fields.emplace_back(SBuf(":scheme"), request.url.getScheme().image());
+    const auto host = header.getStr(Http::HdrType::HOST);
+    fields.emplace_back(SBuf(":authority"), host ? SBuf(host) : request.url.authority());
+    fields.emplace_back(SBuf(":path"), request.url.originForm());
+
+    HttpHeaderPos pos = HttpHeaderInitPos;
+    while (const auto e = header.getEntry(&pos)) {
+        switch (e->id) {
+        case Http::HdrType::HOST:
+        case Http::HdrType::CONNECTION:
+        case Http::HdrType::KEEP_ALIVE:
+        case Http::HdrType::PROXY_CONNECTION:
+        case Http::HdrType::TE:
+        case Http::HdrType::TRANSFER_ENCODING:
+        case Http::HdrType::UPGRADE:
+            continue; // connection-specific fields are prohibited in HTTP/2
+        default:
+            break;
+        }
+        fields.emplace_back(ToLower(e->name), SBuf(e->value.rawBuf(), e->value.size()));
+    }
+
+    waiting_.push_back(streamId);
+    startStreams();
+    writeSomeData();
+}
+
+/// starts waiting streams allowed by the peer concurrency limit
+void
+Http::Two::Session::startStreams()
+{
+    auto active = activeStreams();
+    while (!waiting_.empty() && !closing_ && active < peerMaxStreams_) {
+        const auto streamId = waiting_.front();
+        waiting_.pop_front();
+        const auto it = streams_.find(streamId);
+        if (it == streams_.end() || it->second.failed)
+            continue;
+        startStream(streamId, it->second);
+        ++active;
+    }
+}
+
+/// queues request HEADERS for the given stream
+void
+Http::Two::Session::startStream(const uint32_t streamId, StreamState &s)
+{
+    SBuf block;
+    encoder_.startBlock(block);
+    for (const auto &field: s.requestFields) {
+        // do not expose credentials to HPACK compression state probing
+        const auto sensitive = field.name.cmp("authorization") == 0 || field.name.cmp("proxy-authorization") == 0;
+        encoder_.encode(block, field.name, field.value, sensitive ? HpackEncoder::idxNever : HpackEncoder::idxIncremental);
+    }
+    s.requestFields.clear();
+
+    const auto before = outBuf_.length();
+    PackHeaderBlock(outBuf_, streamId, block, s.requestEnds, peerMaxFrameSize_);
+    s.bytesQueued += outBuf_.length() - before;
+    s.writeSize = outBuf_.length() - before;
+    s.started = true;
+    s.localClosed = s.requestEnds;
+    s.recvWindow = StreamWindow;
+    s.sendWindow = peerInitialWindow_;
+    ++streamsStarted_;
+
+    debugs(11, 5, "stream " << streamId << " HEADERS: " << block.length() << " HPACK bytes");
+    frameRequestData(); // write() may have been called before we started
+}
+
+void
+Http::Two::Session::write(const uint32_t streamId, const char *buf, const size_t size, const bool endStream, const AsyncCall::Pointer &writer)
+{
+    const auto it = streams_.find(streamId);
+    if (it == streams_.end()) {
+        debugs(11, 3, "ignoring DATA for closed stream " << streamId);
+        return;
+    }
+
+    auto &s = it->second;
+    Must(!s.writer);
+    s.writer = writer;
+    s.writeSize = size;
+
+    if (s.failed) {
+        notifyWriter(s, Comm::COMM_ERROR);
+        return;
+    }
+
+    if (s.localClosed) {
+        // the peer has reset the stream after a complete response
+        debugs(11, 5, "discarding " << size << " request body bytes for stream " << streamId);
+        notifyWriter(s, Comm::OK);
+        return;
+    }
+
+    s.pendingData.append(buf, size);
+    s.pendingEnd = endStream;
+    frameRequestData();
+    writeSomeData();
+    checkWritten(s);
+}
+
+void
+Http::Two::Session::read(const uint32_t streamId, const AsyncCall::Pointer &reader)
+{
+    const auto it = streams_.find(streamId);
+    if (it == streams_.end()) {
+        debugs(11, 3, "ignoring a read for closed stream " << streamId);
+        return;
+    }
+
+    auto &s = it->second;
+    Must(!s.reader);
+    s.reader = reader;
+    notifyReader(streamId, s);
+}
+
+Comm::Flag
+Http::Two::Session::readNow(const uint32_t streamId, CommIoCbParams &params, SBuf &buf)
+{
+    params.xerrno = 0;
+    const auto it = streams_.find(streamId);
+    if (it == streams_.end() || it->second.failed) {
+        params.size = 0;
+        params.xerrno = ECONNRESET;
+        params.flag = Comm::COMM_ERROR;
+        return params.flag;
+    }
+
+    auto &s = it->second;
+    if (s.inData.isEmpty()) {
+        params.size = 0;
+        params.flag = s.remoteClosed ? Comm::ENDFILE : Comm::INPROGRESS;
+        return params.flag;
+    }
+
+    auto size = s.inData.length();
+    if (params.size > 0 && static_cast<size_t>(params.size) < size)
+        size = params.size;
+    buf.append(s.inData.rawContent(), size);
+    s.inData.consume(size);
+
+    const auto headerPart = std::min(s.headerBytes, size);
+    s.headerBytes -= headerPart;
+    s.consumed += size - headerPart;
+
+    // credit the stream window in large steps to avoid tiny WINDOW_UPDATEs
+    if (!s.remoteClosed && s.consumed >= StreamWindow/2) {
+        PackWindowUpdate(outBuf_, streamId, s.consumed);
+        s.recvWindow += s.consumed;
+        s.consumed = 0;
+        writeSomeData();
+    }
+
+    params.size = size;
+    params.flag = Comm::OK;
+    return params.flag;
+}
+
+void
+Http::Two::Session::setTimeout(const uint32_t streamId, const time_t timeout, const AsyncCall::Pointer &callback)
+{
+    const auto it = streams_.find(streamId);
+    if (it == streams_.end())
+        return;
+
+    auto &s = it->second;
+    if (timeout < 0) {
+        s.timeoutHandler = nullptr;
+        s.deadline = 0;
+    } else {
+        if (callback)
+            s.timeoutHandler = callback;
+        s.deadline = squid_curtime + timeout;
+    }
+    scheduleTimeout();
+}
+
+void
+Http::Two::Session::closeStream(const uint32_t streamId)
+{
+    const auto it = streams_.find(streamId);
+    if (it == streams_.end())
+        return;
+
+    const auto &s = it->second;
+    if (s.started && !s.failed && !(s.localClosed && s.remoteClosed)) {
+        debugs(11, 5, "canceling stream " << streamId);
+        PackRstStream(outBuf_, streamId, ecCancel);
+    }
+    streams_.erase(it);
+    waiting_.erase(std::remove(waiting_.begin(), waiting_.end(), streamId), waiting_.end());
+
+    if (streams_.empty()) {
+        idleSince_ = squid_curtime;
+        if (goingAway_) {
+            closeAfterWriting();
+            return;
+        }
+    }
+
+    startStreams();
+    writeSomeData();
+    scheduleTimeout();
+}
+
+void
+Http::Two::Session::readMore()
+{
+    if (reader_ || closing_ || !Comm::IsConnOpen(conn_) || fd_table[conn_->fd].closing())
+        return;
+
+    typedef CommCbMemFunT<Session, CommIoCbParams> Dialer;
+    reader_ = JobCallback(11, 5, Dialer, this, Http2::Session::noteRead);
+    Comm::Read(conn_, reader_);
+}
+
+void
+Http::Two::Session::noteRead(const CommIoCbParams &io)
+{
+    reader_ = nullptr;
+
+    if (io.flag == Comm::ERR_CLOSING)
+        return;
+
+    SBufReservationRequirements requirements;
+    requirements.minSpace = FrameHeaderSize + DefaultMaxFrameSize; // at least one frame
+    requirements.idealSpace = SQUID_TCP_SO_RCVBUF;
+    requirements.maxCapacity = SBuf::maxSize;
+    requirements.allowShared = true; // allow because inBuf_ is used immediately
+    inBuf_.reserve(requirements);
+
+    CommIoCbParams rd(this);
+    rd.conn = io.conn;
+    rd.size = inBuf_.spaceSize();
+    switch (Comm::ReadNow(rd, inBuf_)) {
+    case Comm::INPROGRESS:
+        readMore();
+        return;
+
+    case Comm::OK:
+        parseFrames();
+        readMore();
+        return;
+
+    case Comm::ENDFILE:
+        debugs(11, 3, "peer closed " << conn_);
+        conn_->close();
+        return;
+
+    default:
+        debugs(11, 2, conn_ << ": read failure: " << xstrerr(rd.xerrno));
+        conn_->close();
+        return;
+    }
+}
+
+/// processes complete frames in inBuf_
+void
+Http::Two::Session::parseFrames()
+{
+    while (!closing_ && inBuf_.length() >= FrameHeaderSize) {
+        const auto header = FrameHeader::Parse(inBuf_.rawContent());
+        if (header.length > DefaultMaxFrameSize) {
+            connectionError(ecFrameSizeError, "frame exceeds SETTINGS_MAX_FRAME_SIZE");
+            break;
+        }
+        if (inBuf_.length() < FrameHeaderSize + header.length)
+            break; // wait for the rest of the frame
+
+        const auto payload = inBuf_.substr(FrameHeaderSize, header.length);
+        inBuf_.consume(FrameHeaderSize + header.length);
+        processFrame(header, payload);
+    }
+
+    if (closing_)
+        inBuf_.clear();
+
+    writeSomeData();
+}
+
+void
+Http::Two::Session::processFrame(const FrameHeader &header, const SBuf &payload)
+{
+    debugs(11, 7, header);
+
+    if (!sawSettings_ && (header.type != ftSettings || header.hasFlag(ffAck))) {
+        connectionError(ecProtocolError, "server connection preface lacks SETTINGS");
+        return;
+    }
+
+    if (headerBlockStream_ && header.type != ftContinuation) {
+        connectionError(ecProtocolError, "interrupted header block");
+        return;
+    }
+
+    switch (header.type) {
+    case ftData:
+        processData(header, payload);
+        return;
+
+    case ftHeaders:
+        processHeaders(header, payload);
+        return;
+
+    case ftContinuation:
+        processContinuation(header, payload);
+        return;
+
+    case ftSettings:
+        processSettings(header, payload);
+        return;
+
+    case ftPing:
+        if (header.streamId)
+            connectionError(ecProtocolError, "PING on a stream");
+        else if (header.length != 8)
+            connectionError(ecFrameSizeError, "bad PING size");
+        else if (!header.hasFlag(ffAck))
+            PackFrame(outBuf_, ftPing, ffAck, 0, payload);
+        return;
+
+    case ftWindowUpdate:
+        processWindowUpdate(header, payload);
+        return;
+
+    case ftRstStream:
+        processRstStream(header, payload);
+        return;
+
+    case ftGoAway:
+        processGoAway(header, payload);
+        return;
+
+    case ftPushPromise:
+        connectionError(ecProtocolError, "PUSH_PROMISE despite SETTINGS_ENABLE_PUSH=0");
+        return;
+
+    case ftPriority:
+    default:
+        // unknown frames must be ignored
+        return;
+    }
+}
+
+/// removes frame padding (if any) from the payload
+/// \returns false after a connection error
+bool
+Http::Two::Session::unpad(const FrameHeader &header, SBuf &payload)
+{
+    if (!header.hasFlag(ffPadded))
+        return true;
+
+    if (payload.isEmpty()) {
+        connectionError(ecFrameSizeError, "missing Pad Length");
+        return false;
+    }
+
+    const auto padLength = static_cast<uint8_t>(payload[0]);
+    if (padLength >= payload.length()) {
+        connectionError(ecProtocolError, "excessive padding");
+        return false;
+    }
+
+    payload = payload.substr(1, payload.length() - 1 - padLength);
+    return true;
+}
+
+void
+Http::Two::Session::processData(const FrameHeader &header, const SBuf &payload)
+{
+    const auto streamId = header.streamId;
+    if (!streamId) {
+        connectionError(ecProtocolError, "DATA on stream 0");
+        return;
+    }
+
+    SBuf data(payload);
+    if (!unpad(header, data))
+        return;
+
+    // stream windows limit buffering; credit the connection window on receipt
+    consumed_ += header.length;
+    if (consumed_ >= ConnectionWindow/2) {
+        PackWindowUpdate(outBuf_, 0, consumed_);
+        consumed_ = 0;
+    }
+
+    const auto it = streams_.find(streamId);
+    if (it == streams_.end()) {
+        if (streamId >= nextStreamId_)
+            connectionError(ecProtocolError, "DATA on an idle stream");
+        else
+            debugs(11, 5, "ignoring DATA for closed stream " << streamId);
+        return;
+    }
+
+    auto &s = it->second;
+    if (!s.started) {
+        connectionError(ecProtocolError, "DATA on an idle stream");
+        return;
+    }
+
+    if (s.failed)
+        return;
+
+    if (s.remoteClosed) {
+        failStream(streamId, ecStreamClosed, true);
+        return;
+    }
+
+    if (!s.sawFinalHeaders) {
+        failStream(streamId, ecProtocolError, true);
+        return;
+    }
+
+    if (header.length > s.recvWindow) {
+        failStream(streamId, ecFlowControlError, true);
+        return;
+    }
+    s.recvWindow -= header.length;
+
+    // padding never reaches the reader; credit it with the next read bytes
+    s.consumed += header.length - data.length();
+    s.inData.append(data);
+    s.remoteClosed = header.hasFlag(ffEndStream);
+    notifyReader(streamId, s);
+}
+
+void
+Http::Two::Session::processHeaders(const FrameHeader &header, const SBuf &payload)
+{
+    const auto streamId = header.streamId;
+    if (!streamId || !(streamId & 1) || streamId >= nextStreamId_) {
+        connectionError(ecProtocolError, "HEADERS on a bad stream");
+        return;
+    }
+
+    SBuf block(payload);
+    if (!unpad(header, block))
+        return;
+
+    if (header.hasFlag(ffPriority)) {
+        if (block.length() < 5) {
+            connectionError(ecFrameSizeError, "truncated HEADERS priority");
+            return;
+        }
+        block.consume(5); // we do not prioritize streams
+    }
+
+    headerBlock_ = block;
+    headerBlockStream_ = streamId;
+    headerBlockEndsStream_ = header.hasFlag(ffEndStream);
+
+    if (header.hasFlag(ffEndHeaders))
+        processHeaderBlock();
+}
+
+void
+Http::Two::Session::processContinuation(const FrameHeader &header, const SBuf &payload)
+{
+    if (!headerBlockStream_ || header.streamId != headerBlockStream_) {
+        connectionError(ecProtocolError, "unexpected CONTINUATION");
+        return;
+    }
+
+    headerBlock_.append(payload);
+    if (headerBlock_.length() > Config.maxReplyHeaderSize) {
+        connectionError(ecEnhanceYourCalm, "header block exceeds reply_header_max_size");
+        return;
+    }
+
+    if (header.hasFlag(ffEndHeaders))
+        processHeaderBlock();
+}
+
+/// decodes a complete response header (or trailer) block
+void
+Http::Two::Session::processHeaderBlock()
+{
+    const auto streamId = headerBlockStream_;
+    const auto endStream = headerBlockEndsStream_;
+    const SBuf block = headerBlock_;
+    headerBlock_.clear();
+    headerBlockStream_ = 0;
+
+    // always decode to keep the HPACK decoding context in sync
+    HeaderFields fields;
+    if (!decoder_.decode(block, fields)) {
+        connectionError(ecCompressionError, "cannot decode a header block");
+        return;
+    }
+
+    const auto it = streams_.find(streamId);
+    if (it == streams_.end()) {
+        debugs(11, 5, "ignoring HEADERS for closed stream " << streamId);
+        return;
+    }
+
+    auto &s = it->second;
+    if (!s.started) {
+        connectionError(ecProtocolError, "HEADERS on an idle stream");
+        return;
+    }
+
+    if (s.failed)
+        return;
+
+    if (s.remoteClosed) {
+        failStream(streamId, ecStreamClosed, true);
+        return;
+    }
+
+    if (s.sawFinalHeaders) {
+        // response trailers; we do not forward them
+        if (!endStream) {
+            failStream(streamId, ecProtocolError, true);
+            return;
+        }
+        debugs(11, 5, "ignoring " << fields.size() << " trailer fields on stream " << streamId);
+        s.remoteClosed = true;
+        notifyReader(streamId, s);
+        return;
+    }
+
+    SBuf converted;
+    int status = 0;
+    if (!convertResponse(fields, converted, status) || (status < 200 && endStream)) {
+        debugs(11, 3, "malformed response on stream " << streamId);
+        failStream(streamId, ecProtocolError, true);
+        return;
+    }
+
+    s.sawFinalHeaders = status >= 200;
+    s.inData.append(converted);
+    s.headerBytes += converted.length();
+    s.remoteClosed = endStream;
+    notifyReader(streamId, s);
+}
+
+/// converts the given response header fields into an HTTP/1.1 response header
+/// \returns false for malformed responses
+bool
+Http::Two::Session::convertResponse(const HeaderFields &fields, SBuf &header, int &status) const
+{
+    SBuf statusValue;
+    SBuf headers;
+    bool sawRegular = false;
+
+    for (const auto &field: fields) {
+        const auto &name = field.name;
+        const auto &value = field.value;
+
+        if (!ValidFieldValue(value))
+            return false;
+
+        if (name.startsWith(SBuf(":"))) {
+            if (sawRegular || name.cmp(":status") != 0 || !statusValue.isEmpty())
+                return false; // misplaced, unknown, request, or repeated pseudo-header
+            statusValue = value;
+            continue;
+        }
+
+        sawRegular = true;
+        if (!ValidFieldName(name))
+            return false;
+
+        // connection-specific fields are prohibited (RFC 9113 Section 8.2.2);
+        // our HTTP/1 response parser would also misinterpret Transfer-Encoding
+        if (name.cmp("connection") == 0 || name.cmp("keep-alive") == 0 ||
+                name.cmp("proxy-connection") == 0 || name.cmp("transfer-encoding") == 0 ||
+                name.cmp("upgrade") == 0)
+            return false;
+
+        headers.append(name).append(": ").append(value).append("\r\n");
+    }
+
+    Parser::Tokenizer tok(statusValue);
+    int64_t code = 0;
+    if (statusValue.length() != 3 || !tok.int64(code, 10, false) || !tok.atEnd() ||
+            code < 100 || code == Http::scSwitchingProtocols)
+        return false;
+
+    status = static_cast<int>(code);
+    header.appendf("HTTP/1.1 %d %s\r\n", status, Http::StatusCodeString(static_cast<Http::StatusCode>(status)));
+    header.append(headers);
+    header.append("\r\n");
+    return true;
+}
+
+void
+Http::Two::Session::processSettings(const FrameHeader &header, const SBuf &payload)
+{
+    if (header.streamId) {
+        connectionError(ecProtocolError, "SETTINGS on a stream");
+        return;
+    }
+
+    if (header.hasFlag(ffAck)) {
+        if (header.length)
+            connectionError(ecFrameSizeError, "SETTINGS ACK with a payload");
+        return;
+    }
+
+    if (header.length % 6) {
+        connectionError(ecFrameSizeError, "bad SETTINGS size");
+        return;
+    }
+
+    for (SBuf::size_type pos = 0; pos < payload.length(); pos += 6) {
+        const auto setting = GetUint16(payload.rawContent() + pos);
+        const auto value = GetUint32(payload.rawContent() + pos + 2);
+        debugs(11, 5, "setting " << setting << '=' << value);
+        switch (setting) {
+        case sHeaderTableSize:
+            encoder_.setMaxTableSize(value);
+            break;
+
+        case sEnablePush:
+            if (value > 1) {
+                connectionError(ecProtocolError, "bad SETTINGS_ENABLE_PUSH");
+                return;
+            }
+            break;
+
+        case sMaxConcurrentStreams:
+            peerMaxStreams_ = value;
+            break;
+
+        case sInitialWindowSize: {
+            if (value > MaxWindowSize) {
+                connectionError(ecFlowControlError, "bad SETTINGS_INITIAL_WINDOW_SIZE");
+                return;
+            }
+            const auto delta = static_cast<int64_t>(value) - peerInitialWindow_;
+            for (auto &i: streams_) {
+                if (!i.second.started)
+                    continue;
+                i.second.sendWindow += delta;
+                if (i.second.sendWindow > MaxWindowSize) {
+                    connectionError(ecFlowControlError, "stream window overflow");
+                    return;
+                }
+            }
+            peerInitialWindow_ = value;
+            break;
+        }
+
+        case sMaxFrameSize:
+            if (value < DefaultMaxFrameSize || value > MaxFrameSizeLimit) {
+                connectionError(ecProtocolError, "bad SETTINGS_MAX_FRAME_SIZE");
+                return;
+            }
+            peerMaxFrameSize_ = value;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    sawSettings_ = true;
+    PackFrameHeader(outBuf_, ftSettings, ffAck, 0, 0);
+    startStreams(); // the concurrency limit may have grown
+    frameRequestData(); // stream windows may have grown
+}
+
+void
+Http::Two::Session::processWindowUpdate(const FrameHeader &header, const SBuf &payload)
+{
+    if (header.length != 4) {
+        connectionError(ecFrameSizeError, "bad WINDOW_UPDATE size");
+        return;
+    }
+
+    const int64_t increment = GetUint32(payload.rawContent()) & 0x7fffffff;
+
+    if (!header.streamId) {
+        if (!increment) {
+            connectionError(ecProtocolError, "zero WINDOW_UPDATE");
+            return;
+        }
+        sendWindow_ += increment;
+        if (sendWindow_ > MaxWindowSize) {
+            connectionError(ecFlowControlError, "connection window overflow");
+            return;
+        }
+    } else {
+        const auto it = streams_.find(header.streamId);
+        if (it == streams_.end() || !it->second.started || it->second.failed)
+            return; // a closed stream
+
+        if (!increment) {
+            failStream(header.streamId, ecProtocolError, true);
+            return;
+        }
+        it->second.sendWindow += increment;
+        if (it->second.sendWindow > MaxWindowSize) {
+            failStream(header.streamId, ecFlowControlError, true);
+            return;
+        }
+    }
+
+    frameRequestData();
+}
+
+void
+Http::Two::Session::processRstStream(const FrameHeader &header, const SBuf &payload)
+{
+    const auto streamId = header.streamId;
+    if (!streamId || streamId >= nextStreamId_) {
+        connectionError(ecProtocolError, "RST_STREAM on an idle stream");
+        return;
+    }
+
+    if (header.length != 4) {
+        connectionError(ecFrameSizeError, "bad RST_STREAM size");
+        return;
+    }
+
+    const auto it = streams_.find(streamId);
+    if (it == streams_.end())
+        return;
+
+    auto &s = it->second;
+    const auto error = GetUint32(payload.rawContent());
+    debugs(11, 3, "peer reset stream " << streamId << ": " << ErrorCodeName(error));
+
+    if (error == ecNoError && s.remoteClosed) {
+        // the peer does not need the rest of our request (RFC 9113 Section 8.1)
+        s.localClosed = true;
+        s.pendingData.clear();
+        s.pendingEnd = false;
+        notifyWriter(s, Comm::OK);
+        return;
+    }
+
+    failStream(streamId, static_cast<ErrorCode>(error), false);
+}
+
+void
+Http::Two::Session::processGoAway(const FrameHeader &header, const SBuf &payload)
+{
+    if (header.streamId) {
+        connectionError(ecProtocolError, "GOAWAY on a stream");
+        return;
+    }
+
+    if (header.length < 8) {
+        connectionError(ecFrameSizeError, "bad GOAWAY size");
+        return;
+    }
+
+    peerLastStreamId_ = GetUint32(payload.rawContent()) & 0x7fffffff;
+    const auto error = GetUint32(payload.rawContent() + 4);
+    debugs(11, (error == ecNoError ? 3 : 2), "peer is going away after stream " << peerLastStreamId_ << ": " << ErrorCodeName(error));
+    goingAway_ = true;
+
+    // the peer did not and will not process later streams; they are safe to retry
+    for (auto &i: streams_) {
+        if (i.first > peerLastStreamId_ && !i.second.failed)
+            failStream(i.first, ecRefusedStream, false);
+    }
+    waiting_.clear();
+
+    if (streams_.empty())
+        closeAfterWriting();
+}
+
+/// frames buffered request bodies allowed by flow control windows, taking
+/// turns among streams so that one large upload does not delay others
+void
+Http::Two::Session::frameRequestData()
+{
+    if (closing_)
+        return;
+
+    auto framed = true;
+    while (framed && sendWindow_ > 0) {
+        framed = false;
+        for (auto &i: streams_) {
+            const auto streamId = i.first;
+            auto &s = i.second;
+            if (!s.started || s.failed)
+                continue;
+
+            if (!s.pendingData.isEmpty() && s.sendWindow > 0 && sendWindow_ > 0) {
+                const auto size = std::min<int64_t>({
+                    static_cast<int64_t>(s.pendingData.length()),
+                    s.sendWindow,
+                    sendWindow_,
+                    static_cast<int64_t>(peerMaxFrameSize_)
+                });
+                const auto last = s.pendingEnd && size == static_cast<int64_t>(s.pendingData.length());
+                PackFrameHeader(outBuf_, ftData, last ? ffEndStream : 0, streamId, size);
+                outBuf_.append(s.pendingData.rawContent(), size);
+                s.pendingData.consume(size);
+                s.sendWindow -= size;
+                sendWindow_ -= size;
+                s.bytesQueued += FrameHeaderSize + size;
+                if (last) {
+                    s.pendingEnd = false;
+                    s.localClosed = true;
+                }
+                framed = true;
+            } else if (s.pendingData.isEmpty() && s.pendingEnd) {
+                PackFrameHeader(outBuf_, ftData, ffEndStream, streamId, 0);
+                s.bytesQueued += FrameHeaderSize;
+                s.pendingEnd = false;
+                s.localClosed = true;
+            }
+        }
+    }
+}
+
+void
+Http::Two::Session::writeSomeData()
+{
+    if (writer_ || outBuf_.isEmpty() || !Comm::IsConnOpen(conn_) || fd_table[conn_->fd].closing())
+        return;
+
+    for (auto &i: streams_) {
+        i.second.bytesWriting += i.second.bytesQueued;
+        i.second.bytesQueued = 0;
+    }
+
+    writeBuf_ = outBuf_;
+    outBuf_.clear();
+
+    typedef CommCbMemFunT<Session, CommIoCbParams> Dialer;
+    writer_ = JobCallback(11, 5, Dialer, this, Http2::Session::noteWrote);
+    Comm::Write(conn_, writeBuf_.rawContent(), writeBuf_.length(), writer_, nullptr);
+}
+
+void
+Http::Two::Session::noteWrote(const CommIoCbParams &io)
+{
+    writer_ = nullptr;
+    writeBuf_.clear();
+
+    if (io.flag == Comm::ERR_CLOSING)
+        return;
+
+    if (io.flag) {
+        debugs(11, 2, conn_ << ": write failure: " << xstrerr(io.xerrno));
+        conn_->close();
+        return;
+    }
+
+    if (closing_ && outBuf_.isEmpty()) {
+        conn_->close();
+        return;
+    }
+
+    for (auto &i: streams_) {
+        i.second.bytesWriting = 0;
+        checkWritten(i.second);
+    }
+
+    writeSomeData();
+}
+
+/// tells the stream writer that its bytes have been written (if they have)
+void
+Http::Two::Session::checkWritten(StreamState &s)
+{
+    if (s.writer && s.started && !s.bytesQueued && !s.bytesWriting && s.pendingData.isEmpty() && !s.pendingEnd)
+        notifyWriter(s, Comm::OK);
+}
+
+/// calls the stream reader if it has something to read
+void
+Http::Two::Session::notifyReader(const uint32_t streamId, StreamState &s)
+{
+    if (!s.reader)
+        return;
+
+    if (s.inData.isEmpty() && !s.remoteClosed && !s.failed)
+        return;
+
+    debugs(11, 7, "stream " << streamId << " has " << s.inData.length() << " bytes");
+    AsyncCall::Pointer reader = s.reader;
+    s.reader = nullptr;
+    auto &params = GetCommParams<CommIoCbParams>(reader);
+    params.conn = conn_;
+    params.fd = conn_->fd;
+    params.flag = Comm::OK;
+    params.size = 0;
+    params.xerrno = 0;
+    ScheduleCallHere(reader);
+}
+
+void
+Http::Two::Session::notifyWriter(StreamState &s, const Comm::Flag flag)
+{
+    if (!s.writer)
+        return;
+
+    AsyncCall::Pointer writer = s.writer;
+    s.writer = nullptr;
+    auto &params = GetCommParams<CommIoCbParams>(writer);
+    params.conn = conn_;
+    params.fd = conn_->fd;
+    params.flag = flag;
+    params.size = flag == Comm::OK ? s.writeSize : 0;
+    params.xerrno = flag == Comm::OK ? 0 : ECONNRESET;
+    s.writeSize = 0;
+    ScheduleCallHere(writer);
+}
+
+/// terminates the stream and tells its transaction about the failure
+void
+Http::Two::Session::failStream(const uint32_t streamId, const ErrorCode error, const bool resetPeer)
+{
+    const auto it = streams_.find(streamId);
+    if (it == streams_.end())
+        return;
+
+    auto &s = it->second;
+    debugs(11, 3, "stream " << streamId << " failed: " << ErrorCodeName(error));
+    if (resetPeer && s.started && !(s.localClosed && s.remoteClosed))
+        PackRstStream(outBuf_, streamId, error);
+    s.failed = true;
+    s.pendingData.clear();
+    s.pendingEnd = false;
+    notifyReader(streamId, s);
+    notifyWriter(s, Comm::COMM_ERROR);
+    writeSomeData();
+}
+
+/// fails and forgets all streams when the session cannot continue
+void
+Http::Two::Session::failStreams()
+{
+    outBuf_.clear(); // no more frames, including RST_STREAMs
+    while (!streams_.empty()) {
+        const auto streamId = streams_.begin()->first;
+        failStream(streamId, ecCancel, false);
+        streams_.erase(streamId);
+    }
+    waiting_.clear();
+}
+
+/// sends GOAWAY and closes the connection after writing it
+void
+Http::Two::Session::connectionError(const ErrorCode error, const char *reason)
+{
+    debugs(11, 2, "HTTP/2 connection error " << ErrorCodeName(error) << " on " << conn_ << ": " << reason);
+    if (closing_)
+        return;
+
+    goingAway_ = true;
+    PackGoAway(outBuf_, 0, error); // we never accept peer-initiated streams
+    inBuf_.clear();
+    headerBlock_.clear();
+    headerBlockStream_ = 0;
+    closeAfterWriting();
+}
+
+/// stops reading and closes the connection after writing outBuf_
+void
+Http::Two::Session::closeAfterWriting()
+{
+    closing_ = true;
+    if (reader_) {
+        if (Comm::IsConnOpen(conn_))
+            Comm::ReadCancel(conn_->fd, reader_);
+        reader_ = nullptr;
+    }
+
+    if (!writer_ && outBuf_.isEmpty()) {
+        if (Comm::IsConnOpen(conn_))
+            conn_->close();
+        return;
+    }
+
+    writeSomeData();
+}
+
+void
+Http::Two::Session::noteClosure(const CommCloseCbParams &)
+{
+    debugs(11, 3, conn_);
+    closer_ = nullptr;
+    reader_ = nullptr;
+    writer_ = nullptr;
+    fwdPconnPool->noteUses(fd_table[conn_->fd].pconn.uses);
+    failStreams();
+    conn_->noteClosure();
+    conn_ = nullptr;
+    mustStop("connection closed");
+}
+
+void
+Http::Two::Session::noteTimeout(const CommTimeoutCbParams &)
+{
+    armedDeadline_ = 0;
+
+    if (streams_.empty()) {
+        debugs(11, 3, "idle session timeout on " << conn_);
+        conn_->close();
+        return;
+    }
+
+    for (auto &i: streams_) {
+        auto &s = i.second;
+        if (!s.timeoutHandler || s.deadline > squid_curtime)
+            continue;
+
+        debugs(11, 3, "stream " << i.first << " timeout on " << conn_);
+        AsyncCall::Pointer call = s.timeoutHandler;
+        s.timeoutHandler = nullptr;
+        s.deadline = 0;
+        auto &params = GetCommParams<CommTimeoutCbParams>(call);
+        params.conn = conn_;
+        params.fd = conn_->fd;
+        ScheduleCallHere(call);
+    }
+
+    scheduleTimeout();
+}
+
+/// arms the connection timeout for the nearest stream deadline or, when
+/// there are no streams, for the idle session timeout
+void
+Http::Two::Session::scheduleTimeout()
+{
+    if (!Comm::IsConnOpen(conn_))
+        return;
+
+    time_t deadline = 0;
+    if (streams_.empty()) {
+        deadline = idleSince_ + Config.Timeout.serverIdlePconn;
+    } else {
+        for (const auto &i: streams_) {
+            const auto &s = i.second;
+            if (s.timeoutHandler && (!deadline || s.deadline < deadline))
+                deadline = s.deadline;
+        }
+    }
+
+    if (deadline == armedDeadline_)
+        return;
+
+    armedDeadline_ = deadline;
+    if (!deadline) {
+        commUnsetConnTimeout(conn_);
+        return;
+    }
+
+    typedef CommCbMemFunT<Session, CommTimeoutCbParams> TimeoutDialer;
+    AsyncCall::Pointer call = JobCallback(11, 5, TimeoutDialer, this, Http2::Session::noteTimeout);
+    commSetConnTimeout(conn_, std::max<time_t>(deadline - squid_curtime, 0), call);
+}
+
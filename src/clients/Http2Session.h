@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_CLIENTS_HTTP2SESSION_H
+#define SQUID_SRC_CLIENTS_HTTP2SESSION_H
+
+#include "base/AsyncJob.h"
+#include "base/CbcPointer.h"
+#include "CommCalls.h"
+#include "comm/forward.h"
+#include "http/two/Frame.h"
+#include "http/two/Hpack.h"
+
+#include <deque>
+#include <iosfwd>
+#include <map>
+
+class CachePeer;
+class HttpHeader;
+class HttpRequest;
+
+namespace Http
+{
+namespace Two
+{
+
+/// An HTTP/2 connection to a cache_peer with the http2 option. Many
+/// concurrent HttpStateData transactions share the connection, each using
+/// its own stream.
+///
+/// Transactions use streams much like they use a Comm::Connection: they get
+/// their callbacks with CommIoCbParams and CommTimeoutCbParams, and read
+/// response HEADERS converted into an HTTP/1.1 response header followed by
+/// the response body. The session owns the connection; transactions must
+/// never close it. Idle sessions close after server_idle_pconn_timeout.
+class Session: virtual public AsyncJob
+{
+    CBDATA_CHILD(Session);
+
+public:
+    typedef CbcPointer<Session> Pointer;
+
+    /// the maximum number of concurrent streams we open before the peer
+    /// tells us its SETTINGS_MAX_CONCURRENT_STREAMS
+    static const uint32_t DefaultMaxConcurrentStreams = 100;
+
+    /// whether the given request may be sent to the given peer over HTTP/2
+    static bool CanForward(const HttpRequest &, const CachePeer &);
+
+    /// the session that owns the given connection; starts a new session
+    /// for a fresh connection
+    static Pointer Get(const Comm::ConnectionPointer &);
+
+    /// an open connection to the given destination with a session ready for
+    /// another stream (or nil); prefers busier sessions so that unneeded
+    /// sessions become idle and close
+    static Comm::ConnectionPointer Find(const Comm::Connection &destination);
+
+    /// reports open sessions (for the pconn cache manager report)
+    static void Dump(std::ostream &);
+
+    explicit Session(const Comm::ConnectionPointer &);
+    ~Session() override;
+
+    /// allocates a stream for the next request
+    /// \returns zero if the session cannot carry new streams
+    uint32_t addStream();
+
+    /// sends request HEADERS on an addStream() stream; streams beyond the
+    /// peer concurrency limit wait for their turn
+    /// \param writer called after the header block has been written
+    void sendHeaders(uint32_t streamId, const HttpRequest &, const HttpHeader &, bool endStream, const AsyncCall::Pointer &writer);
+
+    /// sends request body bytes, subject to flow control
+    /// \param endStream whether these are the last request body bytes
+    /// \param writer called after all the given bytes have been written
+    void write(uint32_t streamId, const char *buf, size_t size, bool endStream, const AsyncCall::Pointer &writer);
+
+    /// calls the reader when the stream has response bytes, ended, or failed
+    void read(uint32_t streamId, const AsyncCall::Pointer &reader);
+
+    /// a Comm::ReadNow() equivalent: moves up to params.size buffered
+    /// response bytes into buf, returning Comm::ENDFILE after the response
+    /// end and Comm::COMM_ERROR after a stream error
+    Comm::Flag readNow(uint32_t streamId, CommIoCbParams &params, SBuf &buf);
+
+    /// a commSetConnTimeout() equivalent for the stream
+    /// \param callback the timeout handler; nil keeps the current one
+    void setTimeout(uint32_t streamId, time_t timeout, const AsyncCall::Pointer &callback);
+
+    /// forgets the stream, resetting it if it has not ended yet
+    void closeStream(uint32_t streamId);
+
+protected:
+    /* AsyncJob API */
+    void start() override;
+    bool doneAll() const override;
+    void swanSong() override;
+    const char *status() const override;
+
+private:
+    /// HTTP/2 state of a request stream
+    class StreamState
+    {
+    public:
+        HeaderFields requestFields; ///< request header fields waiting for our turn
+        bool requestEnds = false; ///< whether requestFields end the request
+        bool started = false; ///< request HEADERS were queued
+        bool localClosed = false; ///< we queued END_STREAM
+        bool remoteClosed = false; ///< the peer sent END_STREAM
+        bool failed = false; ///< the stream was reset or is malformed
+        bool sawFinalHeaders = false; ///< received a non-1xx response header
+
+        SBuf inData; ///< converted response header(s) and body bytes for the reader
+        SBuf::size_type headerBytes = 0; ///< inData prefix with converted header(s)
+        int64_t recvWindow = 0; ///< stream flow control window for DATA we receive
+        int64_t consumed = 0; ///< response body bytes read but not yet credited
+
+        int64_t sendWindow = DefaultWindowSize; ///< stream flow control window for DATA we send
+        SBuf pendingData; ///< request body bytes blocked by flow control
+        bool pendingEnd = false; ///< END_STREAM follows pendingData
+        size_t bytesQueued = 0; ///< stream bytes in outBuf_
+        size_t bytesWriting = 0; ///< stream bytes being written
+        size_t writeSize = 0; ///< the size of the being-sent write() chunk
+
+        AsyncCall::Pointer reader; ///< read() callback
+        AsyncCall::Pointer writer; ///< sendHeaders() or write() callback
+        AsyncCall::Pointer timeoutHandler; ///< setTimeout() callback
+        time_t deadline = 0; ///< when timeoutHandler should be called
+    };
+
+    typedef std::map<uint32_t, StreamState> Streams;
+
+    void startStreams();
+    void startStream(uint32_t streamId, StreamState &);
+    uint32_t activeStreams() const;
+    bool acceptsStreams() const;
+
+    void readMore();
+    void noteRead(const CommIoCbParams &);
+    void parseFrames();
+    void processFrame(const FrameHeader &, const SBuf &payload);
+    void processData(const FrameHeader &, const SBuf &payload);
+    void processHeaders(const FrameHeader &, const SBuf &payload);
+    void processContinuation(const FrameHeader &, const SBuf &payload);
+    void processHeaderBlock();
+    void processSettings(const FrameHeader &, const SBuf &payload);
+    void processWindowUpdate(const FrameHeader &, const SBuf &payload);
+    void processRstStream(const FrameHeader &, const SBuf &payload);
+    void processGoAway(const FrameHeader &, const SBuf &payload);
+    bool unpad(const FrameHeader &, SBuf &payload);
+    bool convertResponse(const HeaderFields &, SBuf &header, int &status) const;
+
+    void frameRequestData();
+    void writeSomeData();
+    void noteWrote(const CommIoCbParams &);
+    void notifyReader(uint32_t streamId, StreamState &);
+    void notifyWriter(StreamState &, Comm::Flag);
+    void checkWritten(StreamState &);
+    void failStream(uint32_t streamId, ErrorCode, bool resetPeer);
+    void failStreams();
+    void connectionError(ErrorCode, const char *reason);
+    void closeAfterWriting();
+
+    void noteClosure(const CommCloseCbParams &);
+    void noteTimeout(const CommTimeoutCbParams &);
+    void scheduleTimeout();
+
+    Comm::ConnectionPointer conn_; ///< the connection to the peer
+    AsyncCall::Pointer closer_; ///< connection closure handler
+    AsyncCall::Pointer reader_; ///< Comm::Read() callback
+    AsyncCall::Pointer writer_; ///< Comm::Write() callback
+
+    Streams streams_; ///< streams with transactions using them
+    std::deque<uint32_t> waiting_; ///< streams waiting for the peer concurrency limit
+
+    HpackDecoder decoder_; ///< decodes response header blocks
+    HpackEncoder encoder_; ///< encodes request header blocks
+
+    SBuf inBuf_; ///< received bytes, starting with an incomplete frame (if any)
+    SBuf outBuf_; ///< frames waiting to be written to the peer
+    SBuf writeBuf_; ///< frames being written to the peer
+
+    /// a partially received header block (i.e. not ending with END_HEADERS)
+    SBuf headerBlock_;
+    uint32_t headerBlockStream_ = 0; ///< the headerBlock_ stream (or zero)
+    bool headerBlockEndsStream_ = false; ///< whether headerBlock_ HEADERS had END_STREAM
+
+    uint32_t nextStreamId_ = 1; ///< the ID of the next addStream() stream
+    uint32_t peerMaxStreams_ = DefaultMaxConcurrentStreams; ///< peer SETTINGS_MAX_CONCURRENT_STREAMS
+
+    bool sawSettings_ = false; ///< the peer has sent its SETTINGS
+    bool goingAway_ = false; ///< no new streams: sent or received GOAWAY
+    bool closing_ = false; ///< closing the connection after writing outBuf_
+    uint32_t peerLastStreamId_ = 0; ///< the last stream the peer will process (after its GOAWAY)
+
+    int64_t sendWindow_ = DefaultWindowSize; ///< connection flow control window for DATA we send
+    int64_t consumed_ = 0; ///< received DATA bytes not yet credited to the connection window
+    int64_t peerInitialWindow_ = DefaultWindowSize; ///< peer SETTINGS_INITIAL_WINDOW_SIZE
+    uint32_t peerMaxFrameSize_ = DefaultMaxFrameSize; ///< peer SETTINGS_MAX_FRAME_SIZE
+
+    uint64_t streamsStarted_ = 0; ///< the number of streams ever started
+    time_t idleSince_; ///< when the last stream ended (or the session started)
+    time_t armedDeadline_ = 0; ///< when the connection timeout fires (or zero)
+};
+
+} // namespace Two
+} // namespace Http
+
+#endif /* SQUID_SRC_CLIENTS_HTTP2SESSION_H */
+
@@ -337,7 +337,7 @@ Comm::ConnOpener::connected()
      * even if the connection may fail.
      */
     if (CachePeer *peer=(conn_->getPeer()))
-        ++peer->stats.conn_open;
+        peer->noteConnectionOpened();
 
     lookupLocalAddress();
 
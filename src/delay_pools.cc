@@ -38,6 +38,9 @@
 #include "sbuf/SBuf.h"
 #include "Store.h"
 #include "StoreClient.h"
+#include "time/gadgets.h"
+
+#include <algorithm>
 
 /// \ingroup DelayPoolsInternal
 class Aggregate : public CompositePoolNode
@@ -47,14 +50,12 @@ class Aggregate : public CompositePoolNode
 public:
     typedef RefCount<Aggregate> Pointer;
     Aggregate();
-    ~Aggregate() override;
     virtual DelaySpec *rate() {return &spec;}
 
     virtual DelaySpec const *rate() const {return &spec;}
 
     void stats(StoreEntry * sentry) override;
     void dump(StoreEntry *entry) const override;
-    void update(int incr) override;
     void parse() override;
 
     DelayIdComposite::Pointer id(CompositeSelectionDetails &) override;
@@ -112,13 +113,10 @@ public:
     typedef RefCount<VectorPool> Pointer;
     void dump(StoreEntry *entry) const override;
     void parse() override;
-    void update(int incr) override;
     void stats(StoreEntry * sentry) override;
 
     DelayIdComposite::Pointer id(CompositeSelectionDetails &) override;
     VectorMap<unsigned char, DelayBucket> buckets;
-    VectorPool();
-    ~VectorPool() override;
 
 protected:
     bool keyAllocated (unsigned char const key) const;
@@ -179,7 +177,7 @@ public:
     bool individualAllocated (unsigned char host) const;
     unsigned char hostPosition (DelaySpec &rate, unsigned char const host);
     void initHostIndex (DelaySpec &rate, unsigned char index, unsigned char host);
-    void update (DelaySpec const &, int incr);
+    void refill(DelaySpec const &);
     void stats(StoreEntry *)const;
 
     DelayBucket net;
@@ -195,12 +193,9 @@ public:
     typedef RefCount<ClassCHostPool> Pointer;
     void dump(StoreEntry *entry) const override;
     void parse() override;
-    void update(int incr) override;
     void stats(StoreEntry * sentry) override;
 
     DelayIdComposite::Pointer id(CompositeSelectionDetails &) override;
-    ClassCHostPool();
-    ~ClassCHostPool() override;
 
 protected:
     bool keyAllocated (unsigned char const key) const;
@@ -311,13 +306,10 @@ CommonPool::CommonPool()
 {}
 
 void
-ClassCBucket::update (DelaySpec const &rate, int incr)
+ClassCBucket::refill(DelaySpec const &rate)
 {
-    /* If we aren't active, don't try to update us ! */
-    assert (rate.restore_bps != -1);
-
     for (unsigned int j = 0; j < individuals.size(); ++j)
-        individuals.values[j].update (rate, incr);
+        individuals.values[j].refill(rate);
 }
 
 void
@@ -377,12 +369,6 @@ ClassCBucket::initHostIndex (DelaySpec &rate, unsigned char index, unsigned char
 Aggregate::Aggregate()
 {
     theBucket.init (*rate());
-    DelayPools::registerForUpdates (this);
-}
-
-Aggregate::~Aggregate()
-{
-    DelayPools::deregisterForUpdates (this);
 }
 
 void
@@ -395,6 +381,7 @@ Aggregate::stats(StoreEntry * sentry)
 
     storeAppendPrintf(sentry, "\t\tCurrent: ");
 
+    theBucket.refill(*rate());
     theBucket.stats(sentry);
 
     storeAppendPrintf(sentry, "\n\n");
@@ -406,13 +393,6 @@ Aggregate::dump(StoreEntry *entry) const
     rate()->dump (entry);
 }
 
-void
-Aggregate::update(int incr)
-{
-    theBucket.update(*rate(), incr);
-    kickReads();
-}
-
 void
 Aggregate::parse()
 {
@@ -434,18 +414,19 @@ Aggregate::AggregateId::AggregateId(RefCount<Aggregate> anAggregate) : theAggreg
 int
 Aggregate::AggregateId::bytesWanted (int min, int max) const
 {
+    theAggregate->theBucket.refill(*theAggregate->rate());
     return theAggregate->theBucket.bytesWanted(min, max);
 }
 
 void
 Aggregate::AggregateId::bytesIn(int qty)
 {
+    theAggregate->theBucket.refill(*theAggregate->rate());
     theAggregate->theBucket.bytesIn(qty);
     theAggregate->kickReads();
 }
 
 DelayPool *DelayPools::delay_data = nullptr;
-time_t DelayPools::LastUpdate = 0;
 unsigned short DelayPools::pools_ (0);
 
 void
@@ -457,7 +438,6 @@ DelayPools::RegisterWithCacheManager(void)
 void
 DelayPools::Init()
 {
-    LastUpdate = getCurrentTime();
     RegisterWithCacheManager();
 }
 
@@ -468,8 +448,6 @@ DelayPools::InitDelayData()
         return;
 
     DelayPools::delay_data = new DelayPool[pools()];
-
-    eventAdd("DelayPools::Update", DelayPools::Update, nullptr, 1.0, 1);
 }
 
 void
@@ -480,62 +458,43 @@ DelayPools::FreeDelayData()
 }
 
 void
-DelayPools::Update(void *)
+DelayPools::scheduleWakeup(CompositePoolNode *node)
 {
-    // To prevent stuck transactions, stop updates only after no new transactions can
-    // register (because the pools were disabled) and the last registered transaction is gone.
-    if (!pools() && toUpdate.empty())
-        return;
-
-    eventAdd("DelayPools::Update", Update, nullptr, 1.0, 1);
+    toWake.push_back(node);
 
-    int incr = squid_curtime - LastUpdate;
-
-    if (incr < 1)
+    if (WakeupScheduled)
         return;
 
-    LastUpdate = squid_curtime;
-
-    std::vector<Updateable *>::iterator pos = toUpdate.begin();
-
-    while (pos != toUpdate.end()) {
-        (*pos)->update(incr);
-        ++pos;
-    }
+    // buckets gain bytes when squid_curtime changes; wake up right after that
+    const auto delay = (squid_curtime + 1) - current_dtime;
+    eventAdd("DelayPools::Wakeup", Wakeup, nullptr, delay, 1);
+    WakeupScheduled = true;
 }
 
 void
-DelayPools::registerForUpdates(Updateable *anObject)
+DelayPools::cancelWakeup(CompositePoolNode *node)
 {
-    /* Assume no doubles */
-    toUpdate.push_back(anObject);
+    const auto pos = std::find(toWake.begin(), toWake.end(), node);
+    if (pos != toWake.end())
+        toWake.erase(pos);
 }
 
 void
-DelayPools::deregisterForUpdates (Updateable *anObject)
+DelayPools::Wakeup(void *)
 {
-    std::vector<Updateable *>::iterator pos = toUpdate.begin();
-
-    while (pos != toUpdate.end() && *pos != anObject) {
-        ++pos;
-    }
+    WakeupScheduled = false;
 
-    if (pos != toUpdate.end()) {
-        /* move all objects down one */
-        std::vector<Updateable *>::iterator temp = pos;
-        ++pos;
-
-        while (pos != toUpdate.end()) {
-            *temp = *pos;
-            ++temp;
-            ++pos;
-        }
-
-        toUpdate.pop_back();
-    }
+    // nodes delaying reads while we are kicking them must wait for the next
+    // refill, so we only kick nodes that were waiting before this call
+    std::vector<CompositePoolNode *> nodes;
+    nodes.swap(toWake);
+    debugs(77, 5, "waking up " << nodes.size() << " pool nodes");
+    for (const auto node: nodes)
+        node->wakeup();
 }
 
-std::vector<Updateable *> DelayPools::toUpdate;
+std::vector<CompositePoolNode *> DelayPools::toWake;
+bool DelayPools::WakeupScheduled = false;
 
 void
 DelayPools::Stats(StoreEntry * sentry)
@@ -605,16 +564,6 @@ VectorMap<Key,Value>::insert (Key const key)
     return index;
 }
 
-VectorPool::VectorPool()
-{
-    DelayPools::registerForUpdates (this);
-}
-
-VectorPool::~VectorPool()
-{
-    DelayPools::deregisterForUpdates (this);
-}
-
 void
 VectorPool::stats(StoreEntry * sentry)
 {
@@ -629,6 +578,7 @@ VectorPool::stats(StoreEntry * sentry)
 
     for (unsigned int i = 0; i < buckets.size(); ++i) {
         storeAppendPrintf(sentry, " %d:", buckets.key_map[i]);
+        buckets.values[i].refill(*rate());
         buckets.values[i].stats(sentry);
     }
 
@@ -644,16 +594,6 @@ VectorPool::dump(StoreEntry *entry) const
     rate()->dump (entry);
 }
 
-void
-VectorPool::update(int incr)
-{
-    if (rate()->restore_bps == -1)
-        return;
-
-    for (unsigned int i = 0; i< buckets.size(); ++i)
-        buckets.values[i].update (*rate(), incr);
-}
-
 void
 VectorPool::parse()
 {
@@ -717,13 +657,17 @@ VectorPool::Id::Id(VectorPool::Pointer aPool, int anIndex) : theVector (aPool),
 int
 VectorPool::Id::bytesWanted (int min, int max) const
 {
-    return theVector->buckets.values[theIndex].bytesWanted (min, max);
+    auto &bucket = theVector->buckets.values[theIndex];
+    bucket.refill(*theVector->rate());
+    return bucket.bytesWanted (min, max);
 }
 
 void
 VectorPool::Id::bytesIn(int qty)
 {
-    theVector->buckets.values[theIndex].bytesIn (qty);
+    auto &bucket = theVector->buckets.values[theIndex];
+    bucket.refill(*theVector->rate());
+    bucket.bytesIn (qty);
 }
 
 unsigned int
@@ -750,16 +694,6 @@ ClassCNetPool::makeKey(Ip::Address &src_addr) const
     return ( (ntohl(net.s_addr) >> 8) & 0xff);
 }
 
-ClassCHostPool::ClassCHostPool()
-{
-    DelayPools::registerForUpdates (this);
-}
-
-ClassCHostPool::~ClassCHostPool()
-{
-    DelayPools::deregisterForUpdates (this);
-}
-
 void
 ClassCHostPool::stats(StoreEntry * sentry)
 {
@@ -772,6 +706,7 @@ ClassCHostPool::stats(StoreEntry * sentry)
 
     for (unsigned int index = 0; index < buckets.size(); ++index) {
         storeAppendPrintf(sentry, "\t\tCurrent [Network %d]:", buckets.key_map[index]);
+        buckets.values[index].refill(*rate());
         buckets.values[index].stats (sentry);
         storeAppendPrintf(sentry, "\n");
     }
@@ -788,16 +723,6 @@ ClassCHostPool::dump(StoreEntry *entry) const
     rate()->dump (entry);
 }
 
-void
-ClassCHostPool::update(int incr)
-{
-    if (rate()->restore_bps == -1)
-        return;
-
-    for (unsigned int i = 0; i< buckets.size(); ++i)
-        buckets.values[i].update (*rate(), incr);
-}
-
 void
 ClassCHostPool::parse()
 {
@@ -869,13 +794,17 @@ ClassCHostPool::Id::Id (ClassCHostPool::Pointer aPool, unsigned char aNet, unsig
 int
 ClassCHostPool::Id::bytesWanted (int min, int max) const
 {
-    return theClassCHost->buckets.values[theNet].individuals.values[theHost].bytesWanted (min, max);
+    auto &bucket = theClassCHost->buckets.values[theNet].individuals.values[theHost];
+    bucket.refill(*theClassCHost->rate());
+    return bucket.bytesWanted (min, max);
 }
 
 void
 ClassCHostPool::Id::bytesIn(int qty)
 {
-    theClassCHost->buckets.values[theNet].individuals.values[theHost].bytesIn (qty);
+    auto &bucket = theClassCHost->buckets.values[theNet].individuals.values[theHost];
+    bucket.refill(*theClassCHost->rate());
+    bucket.bytesIn (qty);
 }
 
 #endif /* USE_DELAY_POOLS */
@@ -198,7 +198,8 @@ typedef enum {
     DIGEST_READ_NONE,
     DIGEST_READ_REPLY,
     DIGEST_READ_CBLOCK,
-    DIGEST_READ_MASK
+    DIGEST_READ_MASK,
+    DIGEST_READ_DELTA
 } digest_read_state_t;
 
 /* CygWin & Windows NT Port */
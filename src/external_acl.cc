@@ -204,6 +204,8 @@ parse_externalAclHelper(external_acl ** list)
             a->children.n_idle = atoi(token + 14);
         } else if (strncmp(token, "concurrency=", 12) == 0) {
             a->children.concurrency = atoi(token + 12);
+        } else if (strncmp(token, "concurrency-min=", 16) == 0) {
+            a->children.concurrencyMin = atoi(token + 16);
         } else if (strncmp(token, "queue-size=", 11) == 0) {
             a->children.queue_size = atoi(token + 11);
             a->children.defaultQueueSize = false;
@@ -251,6 +253,10 @@ parse_externalAclHelper(external_acl ** list)
     if (a->children.n_idle < 1)
         a->children.n_idle = 1;
 
+    /* check that adaptive concurrency bounds are sane. */
+    if (a->children.concurrencyMin > a->children.concurrency)
+        a->children.concurrencyMin = a->children.concurrency;
+
     if (a->negative_ttl == -1)
         a->negative_ttl = a->ttl;
 
@@ -400,6 +406,9 @@ dump_externalAclHelper(StoreEntry * sentry, const char *name, const external_acl
         if (node->children.concurrency != 0)
             storeAppendPrintf(sentry, " concurrency=%d", node->children.concurrency);
 
+        if (node->children.concurrencyMin != 0)
+            storeAppendPrintf(sentry, " concurrency-min=%u", node->children.concurrencyMin);
+
         if (node->cache)
             storeAppendPrintf(sentry, " cache=%d", node->cache_size);
 
@@ -168,6 +168,7 @@ typedef enum {
     LFT_TOTAL_SERVER_SIDE_RESPONSE_TIME,
     LFT_DNS_WAIT_TIME,
     LFT_BUSY_TIME,
+    LFT_PHASE_TIME,
 
     /* Squid internal processing details */
     LFT_SQUID_STATUS,
@@ -621,6 +621,21 @@ Format::Format::assemble(MemBuf &mb, const AccessLogEntry::Pointer &al, int logS
         }
         break;
 
+        case LFT_PHASE_TIME:
+            if (al->request) {
+                const auto &phases = al->request->masterXaction->phases;
+                const auto phase = static_cast<TransactionPhases::Phase>(fmt->data.phase);
+                if (phases.entered(phase)) {
+                    using namespace std::chrono_literals;
+                    const auto duration = phases.total(phase);
+                    outtv.tv_sec = std::chrono::duration_cast<std::chrono::seconds>(duration).count();
+                    const auto totalUsec = std::chrono::duration_cast<std::chrono::microseconds>(duration);
+                    outtv.tv_usec = (totalUsec % std::chrono::microseconds(1s)).count();
+                    doMsec = 1;
+                }
+            }
+            break;
+
         case LFT_TIME_TO_HANDLE_REQUEST:
             outtv = al->cache.trTime;
             doMsec = 1;
@@ -16,6 +16,7 @@
 #include "sbuf/Stream.h"
 #include "SquidConfig.h"
 #include "Store.h"
+#include "TransactionPhases.h"
 
 // Due to token overlaps between 1 and 2 letter tokens (Bug 3310)
 // We split the token table into sets determined by the token length
@@ -69,6 +70,7 @@ static TokenTableEntry TokenTable2C[] = {
     TokenTableEntry("<tt", LFT_TOTAL_SERVER_SIDE_RESPONSE_TIME),
     TokenTableEntry("dt", LFT_DNS_WAIT_TIME),
     TokenTableEntry("busy_time", LFT_BUSY_TIME),
+    TokenTableEntry("phase_time", LFT_PHASE_TIME),
 
     TokenTableEntry(">ha", LFT_ADAPTED_REQUEST_HEADER),
     TokenTableEntry(">ha", LFT_ADAPTED_REQUEST_ALL_HEADERS),
@@ -665,6 +667,14 @@ Format::Token::parse(const char *def, Quoting *quoting)
 
         break;
 
+    case LFT_PHASE_TIME:
+        if (!data.string)
+            throw TextException("logformat %phase_time requires a phase name parameter (e.g., %{dns}phase_time)", Here());
+        data.phase = TransactionPhases::FindByName(SBuf(data.string));
+        if (data.phase == TransactionPhases::phaseCount)
+            throw TextException(ToSBuf("logformat %phase_time does not support ", data.string, " phase"), Here());
+        [[fallthrough]];
+
     case LFT_TIME_TO_HANDLE_REQUEST:
     case LFT_PEER_RESPONSE_TIME:
     case LFT_TOTAL_SERVER_SIDE_RESPONSE_TIME:
@@ -754,6 +764,7 @@ Format::Token::Token() : type(LFT_NONE),
     data.header.separator = ',';
     data.headerId = ProxyProtocol::Two::htUnknown;
     data.byteValue = 0;
+    data.phase = 0;
 }
 
 Format::Token::~Token()
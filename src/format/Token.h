@@ -62,6 +62,8 @@ public:
         } header;
 
         uint8_t byteValue; // %byte{} parameter or zero
+
+        int phase; ///< %phase_time{} parameter (a TransactionPhases::Phase)
     } data;
     int widthMin; ///< minimum field width
     int widthMax; ///< maximum field width
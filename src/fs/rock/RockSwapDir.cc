@@ -40,7 +40,7 @@
 #endif
 
 Rock::SwapDir::SwapDir(): ::SwapDir("rock"),
-    slotSize(HeaderSize), filePath(nullptr), map(nullptr), io(nullptr),
+    slotSize(HeaderSize), eviction(Ipc::EvictionPolicy::hashOrder), filePath(nullptr), map(nullptr), io(nullptr),
     waitingForPage(nullptr)
 {
 }
@@ -289,7 +289,7 @@ Rock::SwapDir::init()
     freeSlots = shm_old(Ipc::Mem::PageStack)(freeSlotsPath());
 
     Must(!map);
-    map = new DirMap(inodeMapPath());
+    map = new DirMap(inodeMapPath(), eviction);
     map->cleaner = this;
 
     const char *ioModule = needsDiskStrand() ? "IpcIo" : "Blocking";
@@ -376,6 +376,7 @@ Rock::SwapDir::getOptionTree() const
         vector->options.push_back(new ConfigOptionAdapter<SwapDir>(*const_cast<SwapDir *>(this), &SwapDir::parseSizeOption, &SwapDir::dumpSizeOption));
         vector->options.push_back(new ConfigOptionAdapter<SwapDir>(*const_cast<SwapDir *>(this), &SwapDir::parseTimeOption, &SwapDir::dumpTimeOption));
         vector->options.push_back(new ConfigOptionAdapter<SwapDir>(*const_cast<SwapDir *>(this), &SwapDir::parseRateOption, &SwapDir::dumpRateOption));
+        vector->options.push_back(new ConfigOptionAdapter<SwapDir>(*const_cast<SwapDir *>(this), &SwapDir::parseEvictionOption, &SwapDir::dumpEvictionOption));
     } else {
         // we don't know how to handle copt, as it's not a ConfigOptionVector.
         // free it (and return nullptr)
@@ -389,6 +390,7 @@ bool
 Rock::SwapDir::allowOptionReconfigure(const char *const option) const
 {
     return strcmp(option, "slot-size") != 0 &&
+           strcmp(option, "eviction") != 0 &&
            ::SwapDir::allowOptionReconfigure(option);
 }
 
@@ -537,6 +539,39 @@ Rock::SwapDir::dumpSizeOption(StoreEntry * e) const
     storeAppendPrintf(e, " slot-size=%" PRId64, slotSize);
 }
 
+/// parses the eviction policy option
+bool
+Rock::SwapDir::parseEvictionOption(char const *option, const char *value, int reconfig)
+{
+    if (strcmp(option, "eviction") != 0)
+        return false;
+
+    Ipc::EvictionPolicy newPolicy;
+    if (!value || !Ipc::ParseEvictionPolicy(value, newPolicy)) {
+        debugs(3, DBG_CRITICAL, "FATAL: cache_dir " << path << ' ' << option << " must be hash, clock, or s3fifo; got: " << (value ? value : "nothing"));
+        self_destruct();
+        return false;
+    }
+
+    if (!reconfig)
+        eviction = newPolicy;
+    else if (eviction != newPolicy) {
+        debugs(3, DBG_IMPORTANT, "WARNING: cache_dir " << path << ' ' << option
+               << " cannot be changed dynamically, value left unchanged: " <<
+               Ipc::EvictionPolicyName(eviction));
+    }
+
+    return true;
+}
+
+/// reports the eviction policy option
+void
+Rock::SwapDir::dumpEvictionOption(StoreEntry * e) const
+{
+    if (eviction != Ipc::EvictionPolicy::hashOrder)
+        storeAppendPrintf(e, " eviction=%s", Ipc::EvictionPolicyName(eviction));
+}
+
 /// check the results of the configuration; only level-0 debugging works here
 void
 Rock::SwapDir::validateOptions()
@@ -605,10 +640,22 @@ Rock::SwapDir::canStore(const StoreEntry &e, int64_t diskSpaceNeeded, int &load)
     if (io->shedLoad())
         return false;
 
+    if (!admits(e, diskSpaceNeeded))
+        return false;
+
     load = io->load();
     return true;
 }
 
+bool
+Rock::SwapDir::peekVictim(const StoreEntry &e, const int64_t diskSpaceNeeded, cache_key *victimKey) const
+{
+    // without enough free slots, writing will purge other entries
+    const auto slotsNeeded = diskSpaceNeeded > 0 ? (diskSpaceNeeded + slotSize - 1)/slotSize : 1;
+    const auto full = freeSlots->size() < slotsNeeded;
+    return map->peekVictim(reinterpret_cast<const cache_key *>(e.key), full, victimKey);
+}
+
 StoreIOState::Pointer
 Rock::SwapDir::createStoreIO(StoreEntry &e, StoreIOState::STIOCB * const cbIo, void * const cbData)
 {
@@ -1079,6 +1126,9 @@ Rock::SwapDir::statfs(StoreEntry &e) const
         }
     }
 
+    if (map)
+        map->packEvictionStatsInto(e);
+
     storeAppendPrintf(&e, "Pending operations: %d out of %d\n",
                       store_open_disk_fd, Config.max_open_disk_fds);
 
@@ -1127,7 +1177,7 @@ void Rock::SwapDirRr::create()
             const int64_t capacity = sd->slotLimitActual();
 
             SwapDir::DirMap::Owner *const mapOwner =
-                SwapDir::DirMap::Init(sd->inodeMapPath(), capacity);
+                SwapDir::DirMap::Init(sd->inodeMapPath(), capacity, sd->eviction);
             mapOwners.push_back(mapOwner);
 
             // TODO: somehow remove pool id and counters from PageStack?
@@ -81,6 +81,7 @@ public:
     void noteFreeMapSlice(const Ipc::StoreMapSliceId fileno) override;
 
     uint64_t slotSize; ///< all db slots are of this size
+    Ipc::EvictionPolicy eviction; ///< which entries the map purges first
 
 protected:
     /* Store API */
@@ -93,6 +94,7 @@ protected:
     ConfigOption *getOptionTree() const override;
     bool allowOptionReconfigure(const char *const option) const override;
     bool canStore(const StoreEntry &e, int64_t diskSpaceNeeded, int &load) const override;
+    bool peekVictim(const StoreEntry &, int64_t diskSpaceNeeded, cache_key *victimKey) const override;
     StoreIOState::Pointer createStoreIO(StoreEntry &, StoreIOState::STIOCB *, void *) override;
     StoreIOState::Pointer openStoreIO(StoreEntry &, StoreIOState::STIOCB *, void *) override;
     void maintain() override;
@@ -117,6 +119,8 @@ protected:
     void dumpRateOption(StoreEntry * e) const;
     bool parseSizeOption(char const *option, const char *value, int reconfiguring);
     void dumpSizeOption(StoreEntry * e) const;
+    bool parseEvictionOption(char const *option, const char *value, int reconfiguring);
+    void dumpEvictionOption(StoreEntry * e) const;
 
     bool full() const; ///< no more entries can be stored without purging
     void trackReferences(StoreEntry &e); ///< add to replacement policy scope
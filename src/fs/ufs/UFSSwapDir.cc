@@ -21,8 +21,10 @@
 #include "FileMap.h"
 #include "fs_io.h"
 #include "globals.h"
+#include "md5.h"
 #include "Parsing.h"
 #include "RebuildState.h"
+#include "RemovalPolicy.h"
 #include "SquidConfig.h"
 #include "SquidMath.h"
 #include "StatCounters.h"
@@ -31,6 +33,7 @@
 #include "tools.h"
 #include "UFSSwapDir.h"
 
+#include <algorithm>
 #include <cerrno>
 #include <cmath>
 #if HAVE_SYS_STAT_H
@@ -120,10 +123,29 @@ Fs::Ufs::UFSSwapDir::canStore(const StoreEntry &e, int64_t diskSpaceNeeded, int
     if (IO->shedLoad())
         return false;
 
+    if (!admits(e, diskSpaceNeeded))
+        return false;
+
     load = IO->load();
     return true;
 }
 
+bool
+Fs::Ufs::UFSSwapDir::peekVictim(const StoreEntry &, const int64_t diskSpaceNeeded, cache_key *victimKey) const
+{
+    // maintain() starts evicting entries above the low-water mark
+    if (currentSize() + std::max(diskSpaceNeeded, int64_t(0)) < minSize())
+        return false;
+
+    // the first walked entry is the next one to be purged
+    const auto walker = repl->WalkInit(repl);
+    const auto victim = walker->Next(walker);
+    if (victim && victim->key)
+        memcpy(victimKey, victim->key, SQUID_MD5_DIGEST_LENGTH);
+    walker->Done(walker);
+    return victim && victim->key;
+}
+
 static void
 FreeObject(void *address)
 {
@@ -54,6 +54,7 @@ public:
     void evictCached(StoreEntry &) override;
     void evictIfFound(const cache_key *) override;
     bool canStore(const StoreEntry &e, int64_t diskSpaceNeeded, int &load) const override;
+    bool peekVictim(const StoreEntry &, int64_t diskSpaceNeeded, cache_key *victimKey) const override;
     void reference(StoreEntry &) override;
     bool dereference(StoreEntry &) override;
     StoreIOState::Pointer createStoreIO(StoreEntry &, StoreIOState::STIOCB *, void *) override;
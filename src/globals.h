@@ -65,6 +65,7 @@ extern int hot_obj_count;   /* 0 */
 extern int CacheDigestHashFuncCount;    /* 4 */
 extern CacheDigest *store_digest;   /* NULL */
 extern const char *StoreDigestFileName;     /* "store_digest" */
+extern const char *StoreDigestDeltaFileName;     /* "store_digest_delta" */
 extern const char *StoreDigestMimeStr;  /* "application/cache-digest" */
 
 extern const char *MultipartMsgBoundaryStr; /* "Unique-Squid-Separator" */
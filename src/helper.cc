@@ -48,6 +48,7 @@ static void Enqueue(Helper::Client *, Helper::Xaction *);
 static Helper::Session *GetFirstAvailable(const Helper::Client::Pointer &);
 static helper_stateful_server *StatefulGetFirstAvailable(const statefulhelper::Pointer &);
 static void helperDispatch(Helper::Session *, Helper::Xaction *);
+static void helperFlushQueued(Helper::Session *);
 static void helperStatefulDispatch(helper_stateful_server * srv, Helper::Xaction * r);
 static void helperKickQueue(const Helper::Client::Pointer &);
 static void helperStatefulKickQueue(const statefulhelper::Pointer &);
@@ -169,6 +170,57 @@ Helper::Session::dropQueued()
     requestsIndex.clear();
 }
 
+unsigned int
+Helper::Session::inFlightLimit() const
+{
+    const auto &childs = parent->childs;
+    if (!childs.concurrency)
+        return 1;
+
+    if (!childs.concurrencyMin)
+        return childs.concurrency;
+
+    const auto limit = static_cast<unsigned int>(adaptive.limit);
+    return std::min(std::max(limit, childs.concurrencyMin), childs.concurrency);
+}
+
+/// Implements additive increase, multiplicative decrease of inFlightLimit().
+/// A service time close to that of an unloaded helper grows the limit by
+/// about one request per limit-worth of replies. A slower reply means that
+/// the requests are waiting inside the helper, so the limit shrinks, but at
+/// most once per round trip: replies to requests sent before the last
+/// decrease do not reflect it yet.
+void
+Helper::Session::noteServiceTime(const double msec, const struct timeval &dispatchTime)
+{
+    const auto &childs = parent->childs;
+    if (!childs.concurrencyMin)
+        return;
+
+    // the floor is the fastest reply of the previous epoch so that it
+    // follows changes in helper speed that are unrelated to our load
+    const uint64_t epochLength = 1000; // replies
+    if (adaptive.epochFloor < 0 || msec < adaptive.epochFloor)
+        adaptive.epochFloor = msec;
+    if (adaptive.floor < 0 || msec < adaptive.floor)
+        adaptive.floor = msec;
+    if (++adaptive.epochReplies >= epochLength) {
+        adaptive.floor = adaptive.epochFloor;
+        adaptive.epochFloor = -1;
+        adaptive.epochReplies = 0;
+    }
+
+    const auto current = std::min(std::max(adaptive.limit, double(childs.concurrencyMin)), double(childs.concurrency));
+    const double toleratedMsec = 2 * adaptive.floor + 1; // queuing we ignore
+    if (msec <= toleratedMsec) {
+        adaptive.limit = std::min(current + 1 / current, double(childs.concurrency));
+    } else if (tvSubMsec(adaptive.lastDecrease, dispatchTime) >= 0) {
+        adaptive.limit = std::max(current * 0.9, double(childs.concurrencyMin));
+        adaptive.lastDecrease = current_time;
+        debugs(84, 5, "srv-" << index << " took " << msec << " msec; limit: " << current << " -> " << adaptive.limit);
+    }
+}
+
 helper_stateful_server::~helper_stateful_server()
 {
     /* TODO: walk the local queue of requests and carry them all out */
@@ -455,9 +507,10 @@ statefulhelper::openSessions()
 void
 Helper::Client::submitRequest(Helper::Xaction * const r)
 {
-    if (const auto srv = GetFirstAvailable(this))
+    if (const auto srv = GetFirstAvailable(this)) {
         helperDispatch(srv, r);
-    else
+        helperFlushQueued(srv);
+    } else
         Enqueue(this, r);
 
     syncQueueStats();
@@ -553,6 +606,9 @@ Helper::Client::prepSubmit()
 bool
 Helper::Client::trySubmit(const char * const buf, HLPCB * const callback, void * const data)
 {
+    if (answerFromCache(buf, callback, data))
+        return true; // no need to submit
+
     if (!prepSubmit())
         return false; // request was dropped
 
@@ -569,6 +625,27 @@ Helper::Client::submit(const char * const buf, HLPCB * const callback, void * co
     debugs(84, DBG_DATA, Raw("buf", buf, strlen(buf)));
 }
 
+/// answers the request with a remembered reply to an identical request
+/// \returns whether the request was answered
+bool
+Helper::Client::answerFromCache(const char * const buf, HLPCB * const callback, void * const data)
+{
+    if (!resultCache.enabled() || !buf)
+        return false;
+
+    const auto rawReply = resultCache.find(SBuf(buf));
+    if (!rawReply)
+        return false;
+
+    debugs(84, 3, id_name << " reply found in the result cache");
+    Xaction r(callback, data, buf);
+    if (!r.reply.accumulate(rawReply->rawContent(), rawReply->length()))
+        return false;
+    r.reply.finalize();
+    callBack(r);
+    return true;
+}
+
 void
 Helper::Client::callBack(Xaction &r)
 {
@@ -704,6 +781,14 @@ Helper::Client::packStatsInto(Packable * const p, const char * const label) cons
     p->appendf("  requests timedout: %d\n", stats.timedout);
     p->appendf("  queue length: %d\n", stats.queue_size);
     p->appendf("  avg service time: %d msec\n", stats.avg_svc_time);
+    resultCache.packStatsInto(p);
+    if (childs.concurrencyMin)
+        p->appendf("  adaptive concurrency: %u to %u\n", childs.concurrencyMin, childs.concurrency);
+    p->append("  service time histogram:\n", 26);
+    for (unsigned int bin = 0; bin < svcTimes.capacity(); ++bin) {
+        if (const auto count = svcTimes.binCount(bin))
+            p->appendf("\t<= %10.3f msec: %" PRIu64 "\n", svcTimes.binUpperBound(bin), count);
+    }
     p->append("\n",1);
     p->appendf("%7s\t%7s\t%7s\t%11s\t%11s\t%11s\t%6s\t%7s\t%7s\t%7s\n",
                "ID #",
@@ -747,6 +832,19 @@ Helper::Client::packStatsInto(Packable * const p, const char * const label) cons
               "   R\tRESERVED\n"
               "   S\tSHUTDOWN PENDING\n"
               "   P\tPLACEHOLDER\n", 101);
+
+    if (childs.concurrencyMin) {
+        p->append("\nConcurrency limits:\n", 21);
+        for (dlink_node *link = servers.head; link; link = link->next) {
+            const auto srv = dynamic_cast<const Session *>(static_cast<SessionBase *>(link->data));
+            if (!srv)
+                continue; // stateful helpers do not support concurrency
+            p->appendf("%7u\t%7u\t(unloaded service time: %.3f msec)\n",
+                       srv->index.value,
+                       srv->inFlightLimit(),
+                       srv->adaptive.floor < 0 ? 0.0 : srv->adaptive.floor);
+        }
+    }
 }
 
 bool
@@ -754,6 +852,13 @@ Helper::Client::willOverload() const {
     return queueFull() && !(childs.needNew() || GetFirstAvailable(this));
 }
 
+Helper::Client::Client(const char * const name):
+    id_name(name),
+    resultCache(name)
+{
+    svcTimes.logInit(30, 0.0, 60000.0);
+}
+
 Helper::Client::Pointer
 Helper::Client::Make(const char * const name)
 {
@@ -973,11 +1078,16 @@ helperReturnBuffer(Helper::Session * srv, const Helper::Client::Pointer &hlp, ch
 
         bool retry = false;
         if (cbdataReferenceValid(r->request.data)) {
+            // finalize() modifies the accumulated reply
+            const auto rawReply = hlp->resultCache.enabled() ?
+                                  SBuf(r->reply.other().content(), r->reply.other().contentSize()) : SBuf();
             r->reply.finalize();
             if (r->reply.result == Helper::BrokenHelper && r->request.retries < MAX_RETRIES) {
                 debugs(84, DBG_IMPORTANT, "ERROR: helper: " << r->reply << ", attempt #" << (r->request.retries + 1) << " of 2");
                 retry = true;
             } else {
+                if (hlp->resultCache.enabled() && r->reply.result != Helper::BrokenHelper)
+                    hlp->resultCache.remember(SBuf(r->request.buf), rawReply);
                 hlp->callBack(*r);
             }
         }
@@ -996,6 +1106,10 @@ helperReturnBuffer(Helper::Session * srv, const Helper::Client::Pointer &hlp, ch
                              tvSubMsec(r->request.dispatch_time, current_time),
                              hlp->stats.replies, REDIRECT_AV_FACTOR);
 
+        const auto svcTime = tvSubDsec(r->request.dispatch_time, current_time) * 1000;
+        hlp->svcTimes.count(svcTime);
+        srv->noteServiceTime(svcTime, r->request.dispatch_time);
+
         // release or re-submit parsedRequestXaction object
         srv->replyXaction = nullptr;
         if (retry) {
@@ -1004,7 +1118,12 @@ helperReturnBuffer(Helper::Session * srv, const Helper::Client::Pointer &hlp, ch
         } else
             delete r;
     }
+}
 
+/// reacts to helper replies parsed by helperHandleRead()
+static void
+helperRepliesDone(Helper::Session * const srv, const Helper::Client::Pointer &hlp)
+{
     if (hlp->timeout && hlp->childs.concurrency)
         srv->checkForTimedOutRequests(hlp->retryTimedOut);
 
@@ -1053,11 +1172,14 @@ helperHandleRead(const Comm::ConnectionPointer &conn, char *, size_t len, Comm::
         return;
     }
 
+    // Parse all replies in the buffer before reacting to them so that the
+    // freed capacity is refilled with a single write per helper process.
     bool needsMore = false;
     char *msg = srv->rbuf;
+    const auto end = srv->rbuf + srv->roffset;
     while (*msg && !needsMore) {
         int skip = 0;
-        char *eom = strchr(msg, hlp->eom);
+        auto eom = static_cast<char *>(memchr(msg, hlp->eom, end - msg));
         if (eom) {
             skip = 1;
             debugs(84, 3, "helperHandleRead: end of reply found");
@@ -1111,6 +1233,9 @@ helperHandleRead(const Comm::ConnectionPointer &conn, char *, size_t len, Comm::
             assert(skip == 0 && eom == nullptr);
     }
 
+    if (!srv->flags.closing)
+        helperRepliesDone(srv, hlp);
+
     if (needsMore) {
         size_t msgSize = (srv->roffset - (msg - srv->rbuf));
         assert(msgSize <= srv->rbuf_sz);
@@ -1226,6 +1351,7 @@ helperStatefulHandleRead(const Comm::ConnectionPointer &conn, char *, size_t len
             Math::intAverage(hlp->stats.avg_svc_time,
                              tvSubMsec(srv->dispatch_time, current_time),
                              hlp->stats.replies, REDIRECT_AV_FACTOR);
+        hlp->svcTimes.count(tvSubDsec(srv->dispatch_time, current_time) * 1000);
 
         if (called)
             helperStatefulServerDone(srv);
@@ -1331,6 +1457,9 @@ GetFirstAvailable(const Helper::Client::Pointer &hlp)
         if (srv->flags.shutdown)
             continue;
 
+        if (srv->stats.pending >= srv->inFlightLimit())
+            continue;
+
         if (!srv->stats.pending)
             return srv;
 
@@ -1347,7 +1476,7 @@ GetFirstAvailable(const Helper::Client::Pointer &hlp)
         return nullptr;
     }
 
-    if (selected->stats.pending >= (hlp->childs.concurrency ? hlp->childs.concurrency : 1)) {
+    if (selected->stats.pending >= selected->inFlightLimit()) {
         debugs(84, 3, "GetFirstAvailable: Least-loaded helper is fully loaded!");
         return nullptr;
     }
@@ -1416,16 +1545,27 @@ helperDispatchWriteDone(const Comm::ConnectionPointer &, char *, size_t, Comm::F
         return;
     }
 
-    if (!srv->wqueue->isNull()) {
-        srv->writebuf = srv->wqueue;
-        srv->wqueue = new MemBuf;
-        srv->flags.writing = true;
-        AsyncCall::Pointer call = commCbCall(5,5, "helperDispatchWriteDone",
-                                             CommIoCbPtrFun(helperDispatchWriteDone, srv));
-        Comm::Write(srv->writePipe, srv->writebuf->content(), srv->writebuf->contentSize(), call, nullptr);
-    }
+    helperFlushQueued(srv);
 }
 
+/// writes all requests accumulated by helperDispatch() with a single Comm::Write()
+static void
+helperFlushQueued(Helper::Session * const srv)
+{
+    if (srv->flags.writing || srv->wqueue->isNull() || !srv->wqueue->contentSize())
+        return;
+
+    assert(nullptr == srv->writebuf);
+    srv->writebuf = srv->wqueue;
+    srv->wqueue = new MemBuf;
+    srv->flags.writing = true;
+    debugs(84, 5, "writing " << srv->writebuf->contentSize() << " bytes to " << srv->parent->id_name << " #" << srv->index);
+    AsyncCall::Pointer call = commCbCall(5,5, "helperDispatchWriteDone",
+                                         CommIoCbPtrFun(helperDispatchWriteDone, srv));
+    Comm::Write(srv->writePipe, srv->writebuf->content(), srv->writebuf->contentSize(), call, nullptr);
+}
+
+/// assigns the request to the helper and adds it to the helper write queue
 static void
 helperDispatch(Helper::Session * const srv, Helper::Xaction * const r)
 {
@@ -1452,17 +1592,8 @@ helperDispatch(Helper::Session * const srv, Helper::Xaction * const r)
     } else
         srv->wqueue->append(r->request.buf, strlen(r->request.buf));
 
-    if (!srv->flags.writing) {
-        assert(nullptr == srv->writebuf);
-        srv->writebuf = srv->wqueue;
-        srv->wqueue = new MemBuf;
-        srv->flags.writing = true;
-        AsyncCall::Pointer call = commCbCall(5,5, "helperDispatchWriteDone",
-                                             CommIoCbPtrFun(helperDispatchWriteDone, srv));
-        Comm::Write(srv->writePipe, srv->writebuf->content(), srv->writebuf->contentSize(), call, nullptr);
-    }
-
-    debugs(84, 5, "helperDispatch: Request sent to " << hlp->id_name << " #" << srv->index << ", " << strlen(r->request.buf) << " bytes");
+    // the caller calls helperFlushQueued() after dispatching all it can
+    debugs(84, 5, "helperDispatch: Request queued for " << hlp->id_name << " #" << srv->index << ", " << strlen(r->request.buf) << " bytes");
 
     ++ srv->stats.uses;
     ++ srv->stats.pending;
@@ -1530,6 +1661,10 @@ helperKickQueue(const Helper::Client::Pointer &hlp)
     while ((srv = GetFirstAvailable(hlp)) && (r = hlp->nextRequest()))
         helperDispatch(srv, r);
 
+    // send each helper all of its newly dispatched requests at once
+    for (dlink_node *n = hlp->servers.head; n; n = n->next)
+        helperFlushQueued(static_cast<Helper::Session *>(n->data));
+
     if (!hlp->childs.n_active)
         hlp->dropQueued();
 }
@@ -1572,6 +1707,9 @@ Helper::Session::checkForTimedOutRequests(bool const retry)
         requestsIndex.erase(it);
         requests.pop_front();
         debugs(84, 2, "Request " << r->request.Id << " timed-out, remove it from queue");
+        const auto svcTime = tvSubDsec(r->request.dispatch_time, current_time) * 1000;
+        parent->svcTimes.count(svcTime);
+        noteServiceTime(svcTime, r->request.dispatch_time);
         bool retried = false;
         if (retry && r->request.retries < MAX_RETRIES && cbdataReferenceValid(r->request.data)) {
             debugs(84, 2, "Retry request " << r->request.Id);
@@ -22,8 +22,10 @@
 #include "helper/Reply.h"
 #include "helper/Request.h"
 #include "helper/ReservationId.h"
+#include "helper/ResultCache.h"
 #include "ip/Address.h"
 #include "sbuf/SBuf.h"
+#include "StatHist.h"
 
 #include <list>
 #include <map>
@@ -137,15 +139,22 @@ public:
         int avg_svc_time = 0;
     } stats;
 
+    /// distribution of request service times (msec), including timeouts
+    StatHist svcTimes;
+
+    /// remembered replies to recent requests (disabled by default)
+    ResultCache resultCache;
+
 protected:
     /// \param name admin-visible helper category (with this process lifetime)
-    explicit Client(const char * const name): id_name(name) {}
+    explicit Client(const char *name);
 
     bool queueFull() const;
     bool overloaded() const;
     void syncQueueStats();
     bool prepSubmit();
     void submit(const char *buf, HLPCB * callback, void *data);
+    bool answerFromCache(const char *buf, HLPCB *callback, void *data);
 };
 
 } // namespace Helper
@@ -284,8 +293,24 @@ public:
     typedef std::map<uint64_t, Requests::iterator> RequestIndex;
     RequestIndex requestsIndex; ///< maps request IDs to requests
 
+    /// adaptive concurrency state (used with concurrency-min=N only)
+    struct {
+        double limit = 0; ///< current in-flight limit (fractional during growth)
+        double floor = -1; ///< service time (msec) of an unloaded helper; negative if unknown
+        double epochFloor = -1; ///< the smallest service time seen during this epoch
+        uint64_t epochReplies = 0; ///< service times seen during this epoch
+        struct timeval lastDecrease = {}; ///< when the limit was last lowered
+    } adaptive;
+
     ~Session() override;
 
+    /// the maximum number of requests this helper may be working on now
+    unsigned int inFlightLimit() const;
+
+    /// adjusts inFlightLimit() using the service time of a finished request
+    /// \param dispatchTime when the finished request was sent to the helper
+    void noteServiceTime(double msec, const struct timeval &dispatchTime);
+
     /// Search in queue for the request with requestId, return the related
     /// Xaction object and remove it from queue.
     /// If concurrency is disabled then the requestId is ignored and the
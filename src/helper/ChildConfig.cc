@@ -50,6 +50,7 @@ Helper::ChildConfig::updateLimits(const Helper::ChildConfig &rhs)
     n_startup = rhs.n_startup;
     n_idle = rhs.n_idle;
     concurrency = rhs.concurrency;
+    concurrencyMin = rhs.concurrencyMin;
     queue_size = rhs.queue_size;
     onPersistentOverload = rhs.onPersistentOverload;
     defaultQueueSize = rhs.defaultQueueSize;
@@ -100,6 +101,8 @@ Helper::ChildConfig::parseConfig()
             }
         } else if (strncmp(token, "concurrency=", 12) == 0) {
             concurrency = xatoui(token + 12);
+        } else if (strncmp(token, "concurrency-min=", 16) == 0) {
+            concurrencyMin = xatoui(token + 16);
         } else if (strncmp(token, "queue-size=", 11) == 0) {
             queue_size = xatoui(token + 11);
             defaultQueueSize = false;
@@ -135,6 +138,16 @@ Helper::ChildConfig::parseConfig()
         n_idle = n_max;
     }
 
+    if (concurrencyMin && !concurrency) {
+        debugs(0, DBG_CRITICAL, "WARNING: OVERRIDE: Ignoring concurrency-min=" << concurrencyMin << " without concurrency=N");
+        concurrencyMin = 0;
+    }
+
+    if (concurrencyMin > concurrency) {
+        debugs(0, DBG_CRITICAL, "WARNING: OVERRIDE: Capping concurrency-min=" << concurrencyMin << " to the defined concurrency (" << concurrency <<")");
+        concurrencyMin = concurrency;
+    }
+
     if (defaultQueueSize)
         queue_size = 2 * n_max;
 }
@@ -71,6 +71,14 @@ public:
      */
     unsigned int concurrency;
 
+    /**
+     * The smallest number of concurrent requests a child is trusted with
+     * when Squid adjusts per-child concurrency based on observed service
+     * times. Set via the concurrency-min=N option.
+     * Default: 0  - no adjustments; each child gets up to concurrency requests.
+     */
+    unsigned int concurrencyMin = 0;
+
     /* derived from active operations */
 
     /**
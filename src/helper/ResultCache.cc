@@ -0,0 +1,306 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 84    Helper process maintenance */
+
+#include "squid.h"
+#include "base/Packable.h"
+#include "base/RunnersRegistry.h"
+#include "debug/Stream.h"
+#include "helper/ResultCache.h"
+#include "ipc/mem/FlexibleArray.h"
+#include "ipc/mem/Pointer.h"
+#include "ipc/mem/Segment.h"
+#include "md5.h"
+#include "SquidConfig.h"
+#include "time/gadgets.h"
+#include "tools.h"
+#include "wordlist.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <limits>
+
+/// the longest reply stored in the shared table; longer ones stay local
+static const size_t MaxSharedReplySize = 1024;
+
+/// the maximum number of shared table slots examined for a request
+static const int MaxProbes = 4;
+
+/// a shared table key: the MD5 digest of the helper scope and request line
+using SharedResultKey = std::array<unsigned char, SQUID_MD5_DIGEST_LENGTH>;
+
+namespace Helper
+{
+
+/// a shared table entry
+class SharedResultSlot
+{
+public:
+    SharedResultSlot(): version(0) {}
+
+    /// Incremented before and after each slot update, so it is odd while a
+    /// kid is writing the slot. Readers copy the slot and then check that
+    /// the version has not changed.
+    std::atomic<uint32_t> version;
+
+    SharedResultKey key = {}; ///< request digest
+    int64_t expires = 0; ///< when the reply becomes stale; zero for empty slots
+    uint16_t length = 0; ///< reply size
+    char reply[MaxSharedReplySize]; ///< raw reply bytes
+};
+
+/// shared memory segment layout: a hash table with overwritten collisions
+class SharedResults
+{
+public:
+    explicit SharedResults(const int aCapacity): capacity(aCapacity), slots(aCapacity) {}
+
+    size_t sharedMemorySize() const { return SharedMemorySize(capacity); }
+    static size_t SharedMemorySize(const int aCapacity) { return sizeof(SharedResults) + size_t(aCapacity)*sizeof(SharedResultSlot); }
+
+    const int capacity; ///< the number of slots
+    Ipc::Mem::FlexibleArray<SharedResultSlot> slots; ///< all entries
+};
+
+} // namespace Helper
+
+/// shared memory segment label
+static const char * const SharedResultsLabel = "helper_results";
+
+/// the shared table opened by this kid (if any)
+static Ipc::Mem::Pointer<Helper::SharedResults> TheSharedResults;
+
+/// the shared table key for the given helper request line
+static SharedResultKey
+SharedKey(const SBuf &scope, const SBuf &request)
+{
+    SharedResultKey key;
+    SquidMD5_CTX ctx;
+    SquidMD5Init(&ctx);
+    SquidMD5Update(&ctx, scope.rawContent(), scope.length());
+    SquidMD5Update(&ctx, request.rawContent(), request.length());
+    SquidMD5Final(key.data(), &ctx);
+    return key;
+}
+
+/// the first shared table slot to examine for the given key
+static int
+SharedStart(const SharedResultKey &key)
+{
+    uint32_t hash;
+    memcpy(&hash, key.data(), sizeof(hash));
+    return static_cast<int>(hash % static_cast<uint32_t>(TheSharedResults->capacity));
+}
+
+/// \returns a fresh shared reply to the given request (if any)
+/// \param expires is set to the time when the returned reply becomes stale
+static std::optional<SBuf>
+FindShared(const SBuf &scope, const SBuf &request, time_t &expires)
+{
+    if (!TheSharedResults)
+        return std::nullopt;
+
+    const auto key = SharedKey(scope, request);
+    const auto start = SharedStart(key);
+    const auto capacity = TheSharedResults->capacity;
+    const auto slots = TheSharedResults->slots.raw();
+    for (int probe = 0; probe < MaxProbes && probe < capacity; ++probe) {
+        auto &slot = slots[(start + probe) % capacity];
+        const auto version = slot.version.load(std::memory_order_acquire);
+        if (version & 1)
+            continue; // being written
+
+        if (slot.key != key)
+            continue;
+
+        expires = slot.expires;
+        const auto length = std::min<size_t>(slot.length, MaxSharedReplySize);
+        SBuf reply(slot.reply, length);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.version.load(std::memory_order_relaxed) != version)
+            continue; // changed while we were copying
+
+        if (expires < squid_curtime)
+            return std::nullopt;
+
+        return reply;
+    }
+    return std::nullopt;
+}
+
+/// shares the reply to the given request with other kids
+static void
+RememberShared(const SBuf &scope, const SBuf &request, const SBuf &reply, const time_t expires)
+{
+    if (!TheSharedResults || reply.length() > MaxSharedReplySize)
+        return;
+
+    const auto key = SharedKey(scope, request);
+    const auto start = SharedStart(key);
+    const auto capacity = TheSharedResults->capacity;
+    const auto slots = TheSharedResults->slots.raw();
+
+    // prefer our own entry, then an empty or stale one, then the first one
+    auto victim = start;
+    auto foundFree = false;
+    for (int probe = 0; probe < MaxProbes && probe < capacity; ++probe) {
+        const auto index = (start + probe) % capacity;
+        const auto &slot = slots[index];
+        if (slot.key == key) {
+            victim = index;
+            break;
+        }
+        if (!foundFree && slot.expires < squid_curtime) {
+            victim = index;
+            foundFree = true;
+        }
+    }
+
+    auto &slot = slots[victim];
+    auto version = slot.version.load(std::memory_order_relaxed);
+    if ((version & 1) || !slot.version.compare_exchange_strong(version, version + 1, std::memory_order_acq_rel))
+        return; // another kid is updating this slot
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.key = key;
+    slot.expires = expires;
+    slot.length = reply.length();
+    std::copy_n(reply.rawContent(), reply.length(), slot.reply);
+
+    slot.version.store(version + 2, std::memory_order_release);
+}
+
+/* Helper::ResultCache */
+
+/// converts the given lifetime to ClpMap TTL
+static Helper::ResultCache::Ttl
+LocalTtl(const time_t seconds)
+{
+    return static_cast<Helper::ResultCache::Ttl>(std::min<time_t>(seconds, std::numeric_limits<Helper::ResultCache::Ttl>::max()));
+}
+
+void
+Helper::ResultCache::configure(const time_t ttl, const uint64_t memLimit, const wordlist * const cmdline)
+{
+    ttl_ = ttl;
+
+    // the new configuration may produce different replies
+    local_.reset();
+    if (ttl > 0 && memLimit)
+        local_ = std::make_unique<Replies>(memLimit);
+
+    // Other kids use the same configuration after they reconfigure. Kids
+    // that have not reconfigured yet cannot share replies with us.
+    scope_.assign(name_, strlen(name_) + 1); // with the terminator
+    for (auto word = cmdline; word; word = word->next) {
+        scope_.append(word->key);
+        scope_.append('\0');
+    }
+}
+
+std::optional<SBuf>
+Helper::ResultCache::find(const SBuf &request)
+{
+    if (!enabled())
+        return std::nullopt;
+
+    if (local_) {
+        if (const auto reply = local_->get(request)) {
+            ++stats_.hits;
+            return *reply;
+        }
+    }
+
+    time_t expires = 0;
+    if (auto reply = FindShared(scope_, request, expires)) {
+        ++stats_.sharedHits;
+        if (local_)
+            local_->add(request, *reply, LocalTtl(expires - squid_curtime));
+        return reply;
+    }
+
+    ++stats_.misses;
+    return std::nullopt;
+}
+
+void
+Helper::ResultCache::remember(const SBuf &request, const SBuf &reply)
+{
+    if (!enabled())
+        return;
+
+    ++stats_.stores;
+    if (local_)
+        local_->add(request, reply, LocalTtl(ttl_));
+    RememberShared(scope_, request, reply, squid_curtime + ttl_);
+}
+
+void
+Helper::ResultCache::packStatsInto(Packable * const p) const
+{
+    if (!enabled())
+        return;
+
+    p->appendf("  result cache TTL: %d seconds\n", static_cast<int>(ttl_));
+    if (local_)
+        p->appendf("  result cache: %zu entries, %" PRIu64 " of %" PRIu64 " bytes\n", local_->entries(), local_->memoryUsed(), local_->memLimit());
+    p->appendf("  result cache hits: %" PRIu64 " local, %" PRIu64 " shared\n", stats_.hits, stats_.sharedHits);
+    p->appendf("  result cache misses: %" PRIu64 "\n", stats_.misses);
+    p->appendf("  result cache stores: %" PRIu64 "\n", stats_.stores);
+}
+
+/// creates and opens the shared helper result table
+class SharedHelperResultsRr: public Ipc::Mem::RegisteredRunner
+{
+public:
+    /* RegisteredRunner API */
+    void useConfig() override;
+    ~SharedHelperResultsRr() override;
+
+protected:
+    /* Ipc::Mem::RegisteredRunner API */
+    void create() override;
+    void open() override;
+
+private:
+    Ipc::Mem::Owner<Helper::SharedResults> *owner = nullptr;
+};
+
+DefineRunnerRegistrator(SharedHelperResultsRr);
+
+void
+SharedHelperResultsRr::useConfig()
+{
+    if (Config.sharedHelperResults.size > 0 && UsingSmp() && Ipc::Mem::Segment::Enabled())
+        Ipc::Mem::RegisteredRunner::useConfig();
+}
+
+void
+SharedHelperResultsRr::create()
+{
+    debugs(84, 3, "capacity: " << Config.sharedHelperResults.size);
+    Must(!owner);
+    owner = shm_new(Helper::SharedResults)(SharedResultsLabel, Config.sharedHelperResults.size);
+}
+
+void
+SharedHelperResultsRr::open()
+{
+    Must(!TheSharedResults);
+    TheSharedResults = shm_old(Helper::SharedResults)(SharedResultsLabel);
+}
+
+SharedHelperResultsRr::~SharedHelperResultsRr()
+{
+    delete owner;
+}
+
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_HELPER_RESULTCACHE_H
+#define SQUID_SRC_HELPER_RESULTCACHE_H
+
+#include "base/ClpMap.h"
+#include "sbuf/Algorithms.h"
+#include "sbuf/SBuf.h"
+
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+class Packable;
+class wordlist;
+
+namespace Helper
+{
+
+/// ClpMap MemoryUsedBy() for raw helper replies
+inline uint64_t
+MemoryUsedByRawReply(const SBuf &reply)
+{
+    return reply.length();
+}
+
+/// Remembers raw replies to recent helper requests so that identical
+/// requests can be answered without contacting helper processes. Requests
+/// are matched by their exact request line. Replies are stored in a
+/// worker-local map and, if shared_helper_result_cache_size is positive, in
+/// a table shared by all SMP workers.
+class ResultCache
+{
+public:
+    using Ttl = int; ///< seconds; \sa ClpMap::Ttl
+
+    /// \param name distinguishes helpers sharing the SMP table
+    explicit ResultCache(const char * const name): name_(name) {}
+
+    /// applies (re)configured limits; zero TTL disables caching; forgets
+    /// replies produced under the previous configuration
+    /// \param cmdline the helper program and its arguments
+    void configure(time_t ttl, uint64_t memLimit, const wordlist *cmdline);
+
+    /// whether find() and remember() may be used
+    bool enabled() const { return ttl_ > 0; }
+
+    /// \returns a fresh raw reply to the given request line (if any)
+    std::optional<SBuf> find(const SBuf &request);
+
+    /// remembers the raw reply to the given request line
+    void remember(const SBuf &request, const SBuf &reply);
+
+    /// reports cache hit and miss counters to the cache manager
+    void packStatsInto(Packable *) const;
+
+private:
+    using Replies = ClpMap<SBuf, SBuf, MemoryUsedByRawReply>;
+    static_assert(std::is_same<Ttl, Replies::Ttl>::value, "ResultCache::Ttl matches ClpMap::Ttl");
+
+    const char * const name_; ///< admin-visible helper category
+
+    /// the name_ and helper program configuration that produced replies;
+    /// distinguishes shared table entries of different configurations
+    SBuf scope_;
+
+    std::unique_ptr<Replies> local_; ///< this worker's replies
+    time_t ttl_ = 0; ///< how long remembered replies are used
+
+    struct {
+        uint64_t hits = 0; ///< requests answered from local_
+        uint64_t sharedHits = 0; ///< requests answered from the shared table
+        uint64_t misses = 0; ///< requests sent to helper processes
+        uint64_t stores = 0; ///< remember() calls
+    } stats_;
+};
+
+} // namespace Helper
+
+#endif /* SQUID_SRC_HELPER_RESULTCACHE_H */
+
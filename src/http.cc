@@ -54,13 +54,16 @@
 #include "refresh.h"
 #include "RefreshPattern.h"
 #include "rfc1738.h"
+#include "security/NegotiationHistory.h"
 #include "SquidConfig.h"
 #include "SquidMath.h"
 #include "StatCounters.h"
 #include "Store.h"
 #include "StrList.h"
 #include "tools.h"
+#include "TransactionTrace.h"
 #include "util.h"
+#include "VaryNormalizer.h"
 
 #if USE_AUTH
 #include "auth/UserRequest.h"
@@ -111,6 +114,9 @@ HttpStateData::HttpStateData(FwdState *theFwdState) :
     typedef CommCbMemFunT<HttpStateData, CommCloseCbParams> Dialer;
     closeHandler = JobCallback(9, 5, Dialer, this, HttpStateData::httpStateConnClosed);
     comm_add_close_handler(serverConnection->fd, closeHandler);
+
+    if (fwd->multiplexedServerConnection())
+        h2Session = Http::Two::Session::Get(serverConnection);
 }
 
 HttpStateData::~HttpStateData()
@@ -309,7 +315,7 @@ HttpStateData::reusableReply(HttpStateData::ReuseDecision &decision)
      * condition
      */
 #define REFRESH_OVERRIDE(flag) \
-    ((R = (R ? R : refreshLimits(entry->mem_obj->storeId()))) , \
+    ((R = (R ? R : refreshLimits(*entry->mem_obj))) , \
     (R && R->flags.flag))
 #else
 #define REFRESH_OVERRIDE(flag) 0
@@ -551,7 +557,7 @@ HttpStateData::reusableReply(HttpStateData::ReuseDecision &decision)
 
 /// assemble a variant key (vary-mark) from the given Vary header and HTTP request
 static void
-assembleVaryKey(String &vary, SBuf &vstr, const HttpRequest &request)
+assembleVaryKey(String &vary, SBuf &vstr, HttpRequest &request)
 {
     static const SBuf asterisk("*");
     const char *pos = nullptr;
@@ -571,7 +577,13 @@ assembleVaryKey(String &vary, SBuf &vstr, const HttpRequest &request)
         String hdr(request.header.getByName(name));
         const char *value = hdr.termedBuf();
         if (value) {
-            value = rfc1738_escape_part(value);
+            if (Config.varyNormalizer) {
+                SBuf normalized(value);
+                Config.varyNormalizer->normalize(name, request, normalized);
+                value = rfc1738_escape_part(normalized.c_str());
+            } else {
+                value = rfc1738_escape_part(value);
+            }
             vstr.append("=\"", 2);
             vstr.append(value);
             vstr.append("\"", 1);
@@ -1217,8 +1229,8 @@ HttpStateData::readReply(const CommIoCbParams &io)
             return; // wait for Client::noteMoreBodySpaceAvailable()
         }
 
-        if (virginBodyDestination && !virginBodyDestination->buf().hasPotentialSpace()) {
-            debugs(11, 5, "avoid delayRead() to give adaptation a chance to drain body pipe buffer: " << virginBodyDestination->buf().contentSize());
+        if (virginBodyDestination && !virginBodyDestination->spaceSize()) {
+            debugs(11, 5, "avoid delayRead() to give adaptation a chance to drain body pipe buffer: " << virginBodyDestination->buf().length());
             return; // wait for Client::noteMoreBodySpaceAvailable()
         }
 #endif
@@ -1227,10 +1239,11 @@ HttpStateData::readReply(const CommIoCbParams &io)
         return;
     }
 
+    const auto firstRead = !flags.headers_parsed && inBuf.isEmpty();
     CommIoCbParams rd(this); // will be expanded with ReadNow results
     rd.conn = io.conn;
     rd.size = readSizeWanted;
-    switch (Comm::ReadNow(rd, inBuf)) {
+    switch (readFromServer(rd)) {
     case Comm::INPROGRESS:
         if (inBuf.isEmpty())
             debugs(33, 2, io.conn << ": no data to process, " << xstrerr(rd.xerrno));
@@ -1239,6 +1252,10 @@ HttpStateData::readReply(const CommIoCbParams &io)
 
     case Comm::OK:
     {
+        if (firstRead) {
+            TransactionTrace::Note(request->masterXaction, TransactionTrace::Milestone::firstByte);
+            request->masterXaction->phases.stop(TransactionPhases::originTtfb);
+        }
         payloadSeen += rd.size;
 #if USE_DELAY_POOLS
         DelayId delayId = entry->mem_obj->mostBytesAllowed();
@@ -1282,6 +1299,23 @@ HttpStateData::readReply(const CommIoCbParams &io)
     processReply();
 }
 
+/// Comm::ReadNow() or its HTTP/2 stream equivalent
+Comm::Flag
+HttpStateData::readFromServer(CommIoCbParams &rd)
+{
+    if (!h2Session.set())
+        return Comm::ReadNow(rd, inBuf);
+
+    const auto session = h2Session.get();
+    if (!session || !h2Stream) {
+        rd.size = 0;
+        rd.xerrno = ECONNRESET;
+        rd.flag = Comm::COMM_ERROR;
+        return rd.flag;
+    }
+    return session->readNow(h2Stream, rd, inBuf);
+}
+
 /// processes the already read and buffered response data, possibly after
 /// waiting for asynchronous 1xx control message processing
 void
@@ -1425,9 +1459,8 @@ void
 HttpStateData::writeReplyBody()
 {
     truncateVirginBody(); // if needed
-    const char *data = inBuf.rawContent();
-    int len = inBuf.length();
-    addVirginReplyBody(data, len);
+    const auto len = inBuf.length();
+    addVirginReplyBody(inBuf);
     inBuf.consume(len);
 
     // after addVirginReplyBody() wrote (when not adapting) everything we have
@@ -1453,12 +1486,11 @@ HttpStateData::decodeAndWriteReplyBody()
     assert(flags.chunked);
     assert(httpChunkDecoder);
     try {
-        MemBuf decodedData;
-        decodedData.init();
-        httpChunkDecoder->setPayloadBuffer(&decodedData);
+        SBuf decodedData;
+        httpChunkDecoder->setPayloadBuffer(&decodedData, SBuf::maxSize);
         const bool doneParsing = httpChunkDecoder->parse(inBuf);
         inBuf = httpChunkDecoder->remaining(); // sync buffers after parse
-        addVirginReplyBody(decodedData.content(), decodedData.contentSize());
+        addVirginReplyBody(decodedData);
         if (doneParsing) {
             lastChunk = 1;
             markParsedVirginReplyAsWhole("http parsed last-chunk");
@@ -1524,9 +1556,9 @@ HttpStateData::processReplyBody()
             /* Wait for more data or EOF condition */
             AsyncCall::Pointer nil;
             if (flags.keepalive_broken) {
-                commSetConnTimeout(serverConnection, 10, nil);
+                setServerTimeout(10, nil);
             } else {
-                commSetConnTimeout(serverConnection, Config.Timeout.read, nil);
+                setServerTimeout(Config.Timeout.read, nil);
             }
         }
         break;
@@ -1534,6 +1566,12 @@ HttpStateData::processReplyBody()
         case COMPLETE_PERSISTENT_MSG: {
             debugs(11, 5, "processReplyBody: COMPLETE_PERSISTENT_MSG from " << serverConnection);
 
+            if (h2Session.set()) {
+                // the session keeps the connection; we only close our stream
+                serverComplete();
+                return;
+            }
+
             // TODO: Remove serverConnectionSaved but preserve exception safety.
 
             commUnsetConnTimeout(serverConnection);
@@ -1628,12 +1666,20 @@ HttpStateData::maybeReadVirginBody()
         return;
     }
 
-    assert(!Comm::MonitorsRead(serverConnection->fd));
-
     // wait for read(2) to be possible.
     typedef CommCbMemFunT<HttpStateData, CommIoCbParams> Dialer;
     AsyncCall::Pointer call = JobCallback(11, 5, Dialer, this, HttpStateData::readReply);
-    Comm::Read(serverConnection, call);
+    if (h2Session.set()) {
+        const auto session = h2Session.get();
+        if (!session || !h2Stream) {
+            debugs(11, 3, "no, HTTP/2 stream gone");
+            return;
+        }
+        session->read(h2Stream, call);
+    } else {
+        assert(!Comm::MonitorsRead(serverConnection->fd));
+        Comm::Read(serverConnection, call);
+    }
     waitingForCommRead = true;
 }
 
@@ -1764,15 +1810,43 @@ HttpStateData::sendComplete()
     AsyncCall::Pointer timeoutCall =  JobCallback(11, 5,
                                       TimeoutDialer, this, HttpStateData::httpTimeout);
 
-    commSetConnTimeout(serverConnection, Config.Timeout.read, timeoutCall);
+    setServerTimeout(Config.Timeout.read, timeoutCall);
     flags.request_sent = true;
 }
 
+/// commSetConnTimeout() for our connection or HTTP/2 stream
+void
+HttpStateData::setServerTimeout(const time_t timeout, AsyncCall::Pointer &callback)
+{
+    if (!h2Session.set()) {
+        commSetConnTimeout(serverConnection, timeout, callback);
+        return;
+    }
+
+    if (const auto session = h2Session.get())
+        session->setTimeout(h2Stream, timeout, callback);
+}
+
 void
 HttpStateData::closeServer()
 {
     debugs(11,5, "closing HTTP server " << serverConnection << " this " << this);
 
+    if (h2Session.set()) {
+        // other transactions share the connection; close our stream only
+        if (Comm::IsConnOpen(serverConnection)) {
+            if (fwd->serverConnection() == serverConnection)
+                fwd->unregister(serverConnection);
+            comm_remove_close_handler(serverConnection->fd, closeHandler);
+            closeHandler = nullptr;
+        }
+        serverConnection = nullptr;
+        if (const auto session = h2Session.get())
+            session->closeStream(h2Stream);
+        h2Stream = 0;
+        return;
+    }
+
     if (Comm::IsConnOpen(serverConnection)) {
         fwd->unregister(serverConnection);
         comm_remove_close_handler(serverConnection->fd, closeHandler);
@@ -2073,6 +2147,10 @@ HttpStateData::httpBuildRequestHeader(HttpRequest * request,
         hdr_out->putStr(Http::HdrType::TRANSFER_ENCODING, "chunked");
     }
 
+    // the next hop must select its response using the variant key values
+    if (Config.varyNormalizer)
+        Config.varyNormalizer->normalizeForwarded(*request, *hdr_out);
+
     /* Now mangle the headers. */
     httpHdrMangleList(hdr_out, request, al, ROR_REQUEST);
 
@@ -2361,12 +2439,11 @@ HttpStateData::decideIfWeDoRanges (HttpRequest * request)
     return result;
 }
 
-/* build request prefix and append it to a given MemBuf;
- * return the length of the prefix */
-mb_size_t
-HttpStateData::buildRequestPrefix(MemBuf * mb)
+/// appends the request line, the given header fields, and the header
+/// terminator to the given buffer
+static void
+PackRequestPrefix(MemBuf &mb, const HttpRequest &request, const bool toOrigin, const HttpHeader &hdr)
 {
-    const int offset = mb->size;
     /* Uses a local httpver variable to print the HTTP label
      * since the HttpRequest may have an older version label.
      * XXX: This could create protocol bugs as the headers sent and
@@ -2374,37 +2451,79 @@ HttpStateData::buildRequestPrefix(MemBuf * mb)
      * not the one we are sending. Needs checking.
      */
     const AnyP::ProtocolVersion httpver = Http::ProtocolVersion();
-    const SBuf url(flags.toOrigin ? request->url.originForm() : request->effectiveRequestUri());
-    mb->appendf(SQUIDSBUFPH " " SQUIDSBUFPH " %s/%d.%d\r\n",
-                SQUIDSBUFPRINT(request->method.image()),
-                SQUIDSBUFPRINT(url),
-                AnyP::ProtocolType_str[httpver.protocol],
-                httpver.major,httpver.minor);
-    /* build and pack headers */
-    {
-        HttpHeader hdr(hoRequest);
+    const SBuf url(toOrigin ? request.url.originForm() : request.effectiveRequestUri());
+    mb.appendf(SQUIDSBUFPH " " SQUIDSBUFPH " %s/%d.%d\r\n",
+               SQUIDSBUFPRINT(request.method.image()),
+               SQUIDSBUFPRINT(url),
+               AnyP::ProtocolType_str[httpver.protocol],
+               httpver.major,httpver.minor);
+    hdr.packInto(&mb);
+    /* append header terminator */
+    mb.append(crlf, 2);
+}
+
+/* build request prefix and append it to a given MemBuf;
+ * return the length of the prefix */
+mb_size_t
+HttpStateData::buildRequestPrefix(MemBuf * mb)
+{
+    const int offset = mb->size;
+    HttpHeader hdr(hoRequest);
+    buildRequestHeader(hdr);
+    PackRequestPrefix(*mb, *request, flags.toOrigin, hdr);
+    hdr.clean();
+    return mb->size - offset;
+}
+
+SBuf
+HttpStateData::EarlyRequest(HttpRequest * const request, StoreEntry * const entry, const AccessLogEntryPointer &al)
+{
+    // early data may be replayed; limit it to requests that are safe to repeat
+    if (request->method != Http::METHOD_GET && request->method != Http::METHOD_HEAD)
+        return SBuf();
+
+    // avoid cases where sendRequest() has side effects or uses other flags
+    if (request->body_pipe || request->range || request->flags.pinned ||
+            request->header.has(Http::HdrType::UPGRADE))
+        return SBuf();
+
+    // see sendRequest() and HttpStateData constructor for the origin case
+    Http::StateFlags flags;
+    flags.toOrigin = true;
+    flags.keepalive = request->flags.mustKeepalive || Config.onoff.server_pconns;
+
+    HttpHeader hdr(hoRequest);
+    httpBuildRequestHeader(request, entry, al, &hdr, nullptr, flags);
+    if (hdr.has(Http::HdrType::AUTHORIZATION))
+        return SBuf(); // do not expose credentials to replay attacks
+
+    MemBuf mb;
+    mb.init();
+    PackRequestPrefix(mb, *request, flags.toOrigin, hdr);
+    hdr.clean();
+    return SBuf(mb.content(), mb.contentSize());
+}
+
+/// fills the given header with request header fields to send
+void
+HttpStateData::buildRequestHeader(HttpHeader &hdr)
+{
+    if (!h2Session.set()) // HTTP/2 cannot switch protocols
         forwardUpgrade(hdr); // before httpBuildRequestHeader() for CONNECTION
-        const auto peer = cbdataReferenceValid(_peer) ? _peer : nullptr;
-        httpBuildRequestHeader(request.getRaw(), entry, fwd->al, &hdr, peer, flags);
-
-        if (request->flags.pinned && request->flags.connectionAuth)
-            request->flags.authSent = true;
-        else if (hdr.has(Http::HdrType::AUTHORIZATION))
-            request->flags.authSent = true;
-
-        // The late placement of this check supports reply_header_add mangling,
-        // but also complicates optimizing upgradeHeaderOut-like lookups.
-        if (hdr.has(Http::HdrType::UPGRADE)) {
-            assert(!upgradeHeaderOut);
-            upgradeHeaderOut = new String(hdr.getList(Http::HdrType::UPGRADE));
-        }
+    const auto peer = cbdataReferenceValid(_peer) ? _peer : nullptr;
+    httpBuildRequestHeader(request.getRaw(), entry, fwd->al, &hdr, peer, flags);
 
-        hdr.packInto(mb);
-        hdr.clean();
+    if (request->flags.pinned && request->flags.connectionAuth)
+        request->flags.authSent = true;
+    else if (hdr.has(Http::HdrType::AUTHORIZATION))
+        request->flags.authSent = true;
+
+    // The late placement of this check supports reply_header_add mangling,
+    // but also complicates optimizing upgradeHeaderOut-like lookups.
+    if (!h2Session.set() && hdr.has(Http::HdrType::UPGRADE)) {
+        assert(!upgradeHeaderOut);
+        upgradeHeaderOut = new String(hdr.getList(Http::HdrType::UPGRADE));
     }
-    /* append header terminator */
-    mb->append(crlf, 2);
-    return mb->size - offset;
 }
 
 /* This will be called when connect completes. Write request. */
@@ -2421,10 +2540,18 @@ HttpStateData::sendRequest()
         return false;
     }
 
+    if (h2Session.set()) {
+        const auto session = h2Session.get();
+        if (!session || !(h2Stream = session->addStream())) {
+            debugs(11, 3, "cannot open an HTTP/2 stream on " << serverConnection);
+            return false;
+        }
+    }
+
     typedef CommCbMemFunT<HttpStateData, CommTimeoutCbParams> TimeoutDialer;
     AsyncCall::Pointer timeoutCall =  JobCallback(11, 5,
                                       TimeoutDialer, this, HttpStateData::httpTimeout);
-    commSetConnTimeout(serverConnection, Config.Timeout.lifetime, timeoutCall);
+    setServerTimeout(Config.Timeout.lifetime, timeoutCall);
     maybeReadVirginBody();
 
     if (request->body_pipe != nullptr) {
@@ -2436,7 +2563,8 @@ HttpStateData::sendRequest()
 
         Must(!flags.chunked_request);
         // use chunked encoding if we do not know the length
-        if (request->content_length < 0)
+        // (HTTP/2 DATA frames delimit the body on their own)
+        if (request->content_length < 0 && !h2Session.set())
             flags.chunked_request = true;
     } else {
         assert(!requestBodySource);
@@ -2483,13 +2611,66 @@ HttpStateData::sendRequest()
         flags.front_end_https = _peer->front_end_https;
     }
 
+    if (h2Session.set()) {
+        HttpHeader hdr(hoRequest);
+        buildRequestHeader(hdr);
+        debugs(11, 2, "HTTP/2 Server " << serverConnection << " stream " << h2Stream);
+        request->masterXaction->phases.start(TransactionPhases::originTtfb);
+        h2Session->sendHeaders(h2Stream, *request, hdr, !request->body_pipe, requestSender);
+        return true;
+    }
+
     mb.init();
     buildRequestPrefix(&mb);
 
     debugs(11, 2, "HTTP Server " << serverConnection);
     debugs(11, 2, "HTTP Server REQUEST:\n---------\n" << mb.buf << "\n----------");
 
-    Comm::Write(serverConnection, &mb, requestSender);
+    request->masterXaction->phases.start(TransactionPhases::originTtfb);
+    if (!claimEarlyData(mb)) {
+        if (!Comm::IsConnOpen(serverConnection))
+            return false; // claimEarlyData() failed the transaction
+        Comm::Write(serverConnection, &mb, requestSender);
+    }
+    return true;
+}
+
+/// If the TLS handshake has already delivered this request to the server as
+/// accepted early data, simulates a successful write of the given request.
+/// If the server has accepted some other early data, fails the transaction
+/// and closes the connection: The server will answer that other request.
+/// \returns whether the request was sent as early data
+bool
+HttpStateData::claimEarlyData(const MemBuf &mb)
+{
+    if (!serverConnection->hasTlsNegotiations())
+        return false;
+
+    auto &earlyData = serverConnection->tlsNegotiations()->acceptedEarlyData;
+    if (earlyData.isEmpty())
+        return false;
+
+    if (earlyData != SBuf(mb.content(), mb.contentSize())) {
+        debugs(11, DBG_IMPORTANT, "ERROR: Cannot forward a request: The server accepted different TLS early data" <<
+               Debug::Extra << "connection: " << serverConnection);
+        debugs(11, 2, "early data: " << earlyData);
+        earlyData.clear();
+        const auto err = new ErrorState(ERR_WRITE_ERROR, Http::scBadGateway, fwd->request, fwd->al);
+        fwd->fail(err);
+        closeServer();
+        return false;
+    }
+
+    debugs(11, 3, "the server accepted " << earlyData.length() << " bytes of early data");
+    Must(!request->body_pipe); // requestSender is wroteLast()
+    auto &params = GetCommParams<CommIoCbParams>(requestSender);
+    params.conn = serverConnection;
+    params.fd = serverConnection->fd;
+    params.flag = Comm::OK;
+    params.size = earlyData.length();
+    params.xerrno = 0;
+    earlyData.clear();
+    ScheduleCallHere(requestSender);
     return true;
 }
 
@@ -2612,6 +2793,17 @@ HttpStateData::doneSendingRequestBody()
     Client::doneSendingRequestBody();
     debugs(11,5, serverConnection);
 
+    if (h2Session.set()) {
+        // END_STREAM is our last-chunk
+        const auto session = h2Session.get();
+        if (!session || !h2Stream)
+            return; // the connection closure handler will clean up
+        typedef CommCbMemFunT<HttpStateData, CommIoCbParams> Dialer;
+        requestSender = JobCallback(11,5, Dialer, this, HttpStateData::wroteLast);
+        session->write(h2Stream, nullptr, 0, true, requestSender);
+        return;
+    }
+
     // do we need to write something after the last body byte?
     if (flags.chunked_request && finishingChunkedRequest())
         return;
@@ -2641,6 +2833,18 @@ HttpStateData::handleRequestBodyProducerAborted()
     abortTransaction("request body producer aborted");
 }
 
+void
+HttpStateData::writeRequestBody(MemBuf &buf)
+{
+    if (!h2Session.set()) {
+        Client::writeRequestBody(buf);
+        return;
+    }
+
+    if (const auto session = h2Session.get())
+        session->write(h2Stream, buf.content(), buf.contentSize(), false, requestSender);
+}
+
 // called when we wrote request headers(!) or a part of the body
 void
 HttpStateData::sentRequestBody(const CommIoCbParams &io)
@@ -10,6 +10,7 @@
 #define SQUID_SRC_HTTP_H
 
 #include "clients/Client.h"
+#include "clients/Http2Session.h"
 #include "comm.h"
 #include "http/forward.h"
 #include "http/StateFlags.h"
@@ -53,6 +54,10 @@ public:
                                        const CachePeer *peer,
                                        const Http::StateFlags &flags);
 
+    /// \returns the request that sendRequest() would send to the origin
+    /// server if the request is safe to send as TLS early data (or nothing)
+    static SBuf EarlyRequest(HttpRequest *, StoreEntry *, const AccessLogEntryPointer &);
+
     const Comm::ConnectionPointer & dataConnection() const override;
     /* should be private */
     bool sendRequest();
@@ -94,6 +99,10 @@ private:
      */
     Comm::ConnectionPointer serverConnection;
     AsyncCall::Pointer closeHandler;
+
+    /// the HTTP/2 session sharing serverConnection (if any)
+    Http::Two::Session::Pointer h2Session;
+    uint32_t h2Stream = 0; ///< our h2Session stream (or zero)
     enum ConnectionStatus {
         INCOMPLETE_MSG,
         COMPLETE_PERSISTENT_MSG,
@@ -130,13 +139,18 @@ private:
     void doneSendingRequestBody() override;
     void requestBodyHandler(MemBuf &);
     void sentRequestBody(const CommIoCbParams &io) override;
+    void writeRequestBody(MemBuf &) override;
     void wroteLast(const CommIoCbParams &io);
     void sendComplete();
+    void setServerTimeout(time_t, AsyncCall::Pointer &);
+    Comm::Flag readFromServer(CommIoCbParams &);
     void httpStateConnClosed(const CommCloseCbParams &params);
     void httpTimeout(const CommTimeoutCbParams &params);
     void markPrematureReplyBodyEofFailure();
 
     mb_size_t buildRequestPrefix(MemBuf * mb);
+    void buildRequestHeader(HttpHeader &);
+    bool claimEarlyData(const MemBuf &);
     void forwardUpgrade(HttpHeader&);
     static bool decideIfWeDoRanges (HttpRequest * orig_request);
     bool peerSupportsConnectionPinning() const;
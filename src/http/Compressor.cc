@@ -0,0 +1,298 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "base/TextException.h"
+#include "http/Compressor.h"
+#include "http/WeightedList.h"
+#include "sbuf/Stream.h"
+
+#include <algorithm>
+
+#if HAVE_LIBZLIB && HAVE_ZLIB_H
+#include <zlib.h>
+#endif
+#if HAVE_LIBBROTLIENC && HAVE_BROTLI_ENCODE_H
+#include <brotli/encode.h>
+#endif
+
+namespace Http
+{
+
+/// the size of output buffer space we reserve for each compression step
+static const SBuf::size_type OutputStep = 16*1024;
+
+#if HAVE_LIBZLIB && HAVE_ZLIB_H
+/// gzip coding implementation using zlib
+class GzipCompressor: public Compressor
+{
+public:
+    explicit GzipCompressor(int level);
+    ~GzipCompressor() override;
+
+    /* Compressor API */
+    void compress(const char *buf, size_t size, SBuf &out) override;
+    void finish(SBuf &out) override;
+
+private:
+    void deflateSome(int flush, SBuf &out);
+
+    z_stream stream_;
+};
+
+GzipCompressor::GzipCompressor(const int level)
+{
+    stream_.zalloc = Z_NULL;
+    stream_.zfree = Z_NULL;
+    stream_.opaque = Z_NULL;
+    // 16 added to the maximum window bits selects the gzip wrapper
+    if (deflateInit2(&stream_, level, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        throw TextException(ToSBuf("cannot initialize gzip compression: ", (stream_.msg ? stream_.msg : "unknown error")), Here());
+}
+
+GzipCompressor::~GzipCompressor()
+{
+    (void)deflateEnd(&stream_);
+}
+
+void
+GzipCompressor::compress(const char *buf, const size_t size, SBuf &out)
+{
+    stream_.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(buf));
+    stream_.avail_in = size;
+    bytesIn_ += size;
+    deflateSome(Z_NO_FLUSH, out);
+}
+
+void
+GzipCompressor::finish(SBuf &out)
+{
+    stream_.next_in = Z_NULL;
+    stream_.avail_in = 0;
+    deflateSome(Z_FINISH, out);
+}
+
+/// compresses all pending input, appending output to `out`
+void
+GzipCompressor::deflateSome(const int flush, SBuf &out)
+{
+    for (;;) {
+        const auto space = out.rawAppendStart(OutputStep);
+        stream_.next_out = reinterpret_cast<Bytef *>(space);
+        stream_.avail_out = OutputStep;
+        const auto result = deflate(&stream_, flush);
+        if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR)
+            throw TextException(ToSBuf("gzip compression failure: ", (stream_.msg ? stream_.msg : "unknown error")), Here());
+        const auto produced = OutputStep - stream_.avail_out;
+        out.rawAppendFinish(space, produced);
+        bytesOut_ += produced;
+
+        if (result == Z_STREAM_END)
+            return;
+        // without Z_FINISH, deflate() is done when it leaves output space
+        if (flush != Z_FINISH && stream_.avail_out > 0 && !stream_.avail_in)
+            return;
+    }
+}
+#endif /* HAVE_LIBZLIB && HAVE_ZLIB_H */
+
+#if HAVE_LIBBROTLIENC && HAVE_BROTLI_ENCODE_H
+/// br coding implementation using the Brotli encoder library
+class BrotliCompressor: public Compressor
+{
+public:
+    explicit BrotliCompressor(int quality);
+    ~BrotliCompressor() override;
+
+    /* Compressor API */
+    void compress(const char *buf, size_t size, SBuf &out) override;
+    void finish(SBuf &out) override;
+
+private:
+    void encodeSome(BrotliEncoderOperation, const char *buf, size_t size, SBuf &out);
+
+    BrotliEncoderState *state_;
+};
+
+BrotliCompressor::BrotliCompressor(const int quality):
+    state_(BrotliEncoderCreateInstance(nullptr, nullptr, nullptr))
+{
+    if (!state_)
+        throw TextException("cannot initialize brotli compression", Here());
+    (void)BrotliEncoderSetParameter(state_, BROTLI_PARAM_QUALITY, quality);
+}
+
+BrotliCompressor::~BrotliCompressor()
+{
+    BrotliEncoderDestroyInstance(state_);
+}
+
+void
+BrotliCompressor::compress(const char *buf, const size_t size, SBuf &out)
+{
+    bytesIn_ += size;
+    encodeSome(BROTLI_OPERATION_PROCESS, buf, size, out);
+}
+
+void
+BrotliCompressor::finish(SBuf &out)
+{
+    encodeSome(BROTLI_OPERATION_FINISH, nullptr, 0, out);
+}
+
+/// compresses the given input, appending output to `out`
+void
+BrotliCompressor::encodeSome(const BrotliEncoderOperation op, const char *buf, const size_t size, SBuf &out)
+{
+    auto availableIn = size;
+    auto nextIn = reinterpret_cast<const uint8_t *>(buf);
+    for (;;) {
+        const auto space = out.rawAppendStart(OutputStep);
+        size_t availableOut = OutputStep;
+        auto nextOut = reinterpret_cast<uint8_t *>(space);
+        if (!BrotliEncoderCompressStream(state_, op, &availableIn, &nextIn, &availableOut, &nextOut, nullptr))
+            throw TextException("brotli compression failure", Here());
+        const auto produced = OutputStep - availableOut;
+        out.rawAppendFinish(space, produced);
+        bytesOut_ += produced;
+
+        if (availableIn || BrotliEncoderHasMoreOutput(state_))
+            continue;
+        if (op != BROTLI_OPERATION_FINISH || BrotliEncoderIsFinished(state_))
+            return;
+    }
+}
+#endif /* HAVE_LIBBROTLIENC && HAVE_BROTLI_ENCODE_H */
+
+bool
+Compressor::Supported(const Coding coding)
+{
+    switch (coding) {
+    case Coding::identity:
+        return true;
+    case Coding::gzip:
+#if HAVE_LIBZLIB && HAVE_ZLIB_H
+        return true;
+#else
+        return false;
+#endif
+    case Coding::br:
+#if HAVE_LIBBROTLIENC && HAVE_BROTLI_ENCODE_H
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false; // not reached
+}
+
+const char *
+Compressor::Name(const Coding coding)
+{
+    switch (coding) {
+    case Coding::identity:
+        return "identity";
+    case Coding::gzip:
+        return "gzip";
+    case Coding::br:
+        return "br";
+    }
+    return "identity"; // not reached
+}
+
+Compressor::Coding
+Compressor::Negotiate(const SBuf &acceptEncoding, const int gzipLevel, const int brLevel)
+{
+    // -1 stands for codings not mentioned by the client
+    int gzipQ = -1;
+    int brQ = -1;
+    int anyQ = -1;
+
+    for (const auto &item: ParseWeightedList(acceptEncoding)) {
+        if (item.value.caseCmp("gzip") == 0 || item.value.caseCmp("x-gzip") == 0)
+            gzipQ = item.quality;
+        else if (item.value.caseCmp("br") == 0)
+            brQ = item.quality;
+        else if (item.value.cmp("*") == 0)
+            anyQ = item.quality;
+    }
+
+    if (gzipQ < 0)
+        gzipQ = std::max(anyQ, 0);
+    if (brQ < 0)
+        brQ = std::max(anyQ, 0);
+
+    if (brLevel <= 0 || !Supported(Coding::br))
+        brQ = 0;
+    if (gzipLevel <= 0 || !Supported(Coding::gzip))
+        gzipQ = 0;
+
+    if (brQ > 0 && brQ >= gzipQ)
+        return Coding::br;
+    if (gzipQ > 0)
+        return Coding::gzip;
+    return Coding::identity;
+}
+
+bool
+Compressor::AddETagCoding(SBuf &etag, const Coding coding)
+{
+    const auto quoted = etag.startsWith(SBuf("W/")) ? 2 : 0;
+    if (etag.length() < quoted + 2U || etag[quoted] != '"' || etag[etag.length() - 1] != '"')
+        return false;
+
+    etag.chop(0, etag.length() - 1);
+    etag.append('-').append(Name(coding)).append('"');
+    return true;
+}
+
+bool
+Compressor::RemoveETagCoding(SBuf &etag, const SBuf &contentEncoding)
+{
+    for (const auto coding: {Coding::gzip, Coding::br}) {
+        const SBuf name(Name(coding));
+        if (contentEncoding.caseCmp(name) != 0)
+            continue;
+
+        SBuf suffix("-");
+        suffix.append(name).append('"');
+        if (etag.length() < suffix.length() + 1 || etag.substr(etag.length() - suffix.length()) != suffix)
+            return false;
+
+        etag.chop(0, etag.length() - suffix.length());
+        etag.append('"');
+        return true;
+    }
+    return false;
+}
+
+std::unique_ptr<Compressor>
+Compressor::Make(const Coding coding, [[maybe_unused]] const int level)
+{
+    Assure(Supported(coding));
+    switch (coding) {
+    case Coding::gzip:
+#if HAVE_LIBZLIB && HAVE_ZLIB_H
+        return std::make_unique<GzipCompressor>(level);
+#else
+        break;
+#endif
+    case Coding::br:
+#if HAVE_LIBBROTLIENC && HAVE_BROTLI_ENCODE_H
+        return std::make_unique<BrotliCompressor>(level);
+#else
+        break;
+#endif
+    case Coding::identity:
+        break;
+    }
+    throw TextException(ToSBuf("cannot compress using ", Name(coding)), Here());
+}
+
+} // namespace Http
+
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_HTTP_COMPRESSOR_H
+#define SQUID_SRC_HTTP_COMPRESSOR_H
+
+#include "sbuf/SBuf.h"
+
+#include <memory>
+
+namespace Http
+{
+
+/// Applies a content coding (RFC 9110 Section 8.4.1) to a message body
+/// received in pieces.
+class Compressor
+{
+public:
+    /// content codings Squid may apply to response bodies
+    enum class Coding { identity, gzip, br };
+
+    /// whether this Squid build can apply the given coding
+    static bool Supported(Coding);
+
+    /// the Content-Encoding name of the given coding
+    static const char *Name(Coding);
+
+    /// the coding the client prefers among the ones we may apply, honoring
+    /// Accept-Encoding qvalues and preferring br over gzip on ties
+    /// \param acceptEncoding the request Accept-Encoding field value
+    /// \param gzipLevel gzip compression level; zero disables gzip
+    /// \param brLevel brotli compression quality; zero disables br
+    /// \returns Coding::identity if no usable coding is acceptable
+    static Coding Negotiate(const SBuf &acceptEncoding, int gzipLevel, int brLevel);
+
+    /// Gives a representation encoded with the given coding its own entity
+    /// tag by appending the coding name to the given ETag field value
+    /// (e.g., "v1" becomes "v1-gzip").
+    /// \returns false (leaving etag intact) for malformed entity tags
+    static bool AddETagCoding(SBuf &etag, Coding);
+
+    /// Undoes AddETagCoding() for the given ETag field value of a response
+    /// with the given Content-Encoding field value. Conditional requests
+    /// must use the validator that the origin server sent.
+    /// \returns false (leaving etag intact) if the tag lacks a suffix
+    /// matching the response coding
+    static bool RemoveETagCoding(SBuf &etag, const SBuf &contentEncoding);
+
+    /// a compressor for a Supported() coding
+    static std::unique_ptr<Compressor> Make(Coding, int level);
+
+    virtual ~Compressor() {}
+
+    /// compresses the given body bytes, appending output (if any) to `out`
+    virtual void compress(const char *buf, size_t size, SBuf &out) = 0;
+
+    /// appends the remaining output, including any coding trailer, to `out`;
+    /// compress() must not be called after finish()
+    virtual void finish(SBuf &out) = 0;
+
+    /// the number of body bytes given to compress() so far
+    uint64_t bytesIn() const { return bytesIn_; }
+
+    /// the number of bytes appended to compress() and finish() outputs so far
+    uint64_t bytesOut() const { return bytesOut_; }
+
+protected:
+    uint64_t bytesIn_ = 0;
+    uint64_t bytesOut_ = 0;
+};
+
+} // namespace Http
+
+#endif /* SQUID_SRC_HTTP_COMPRESSOR_H */
+
@@ -72,6 +72,9 @@ Http::Stream::writeComplete(size_t size)
            ", off " << (http->out.size + size) << ", len " <<
            (entry ? entry->objectLen() : 0));
 
+    if (http->request)
+        http->request->masterXaction->phases.stop(TransactionPhases::clientWriteDrain);
+
     http->out.size += size;
 
     switch (socketState()) {
@@ -106,6 +109,13 @@ Http::Stream::writeComplete(size_t size)
     }
 }
 
+void
+Http::Stream::noteWriting()
+{
+    if (http->request)
+        http->request->masterXaction->phases.start(TransactionPhases::clientWriteDrain);
+}
+
 void
 Http::Stream::pullData()
 {
@@ -307,6 +317,7 @@ Http::Stream::sendStartOfMessage(HttpReply *rep, StoreIOBuffer bodyData)
     }
 #endif
 
+    noteWriting();
     getConn()->write(mb);
     delete mb;
 }
@@ -317,6 +328,7 @@ Http::Stream::sendBody(StoreIOBuffer bodyData)
     if (!multipartRangeRequest() && !http->request->flags.chunkedReply) {
         size_t length = lengthToSend(bodyData.range());
         noteSentBodyBytes(length);
+        noteWriting();
         getConn()->write(bodyData.data, length);
         return;
     }
@@ -328,9 +340,10 @@ Http::Stream::sendBody(StoreIOBuffer bodyData)
     else
         packChunk(bodyData, mb);
 
-    if (mb.contentSize())
+    if (mb.contentSize()) {
+        noteWriting();
         getConn()->write(&mb);
-    else
+    } else
         writeComplete(0);
 }
 
@@ -571,6 +584,19 @@ Http::Stream::prepareReply(HttpReply *rep)
         buildRangeHeader(rep);
 }
 
+void
+Http::Stream::packBody(const StoreIOBuffer &bodyData, MemBuf &mb)
+{
+    if (multipartRangeRequest()) {
+        packRange(bodyData, &mb);
+        return;
+    }
+
+    const auto length = lengthToSend(bodyData.range());
+    noteSentBodyBytes(length);
+    mb.append(bodyData.data, length);
+}
+
 /**
  * Packs bodyData into mb using chunked encoding.
  * Packs the last-chunk if bodyData is empty.
@@ -113,6 +113,12 @@ public:
     /// add Range headers (if any) to the given HTTP reply message
     void buildRangeHeader(HttpReply *);
 
+    /// remember the reply being sent and adjust it for Range requests
+    void prepareReply(HttpReply *);
+    /// appends some reply message payload without any transfer coding,
+    /// for protocols that frame message payload themselves
+    void packBody(const StoreIOBuffer &bodyData, MemBuf &);
+
     clientStreamNode * getTail() const;
     clientStreamNode * getClientReplyContext() const;
 
@@ -160,10 +166,11 @@ public: // HTTP/1.x state data
     int64_t writtenToSocket;
 
 private:
-    void prepareReply(HttpReply *);
     void packChunk(const StoreIOBuffer &bodyData, MemBuf &);
     void packRange(StoreIOBuffer const &, MemBuf *);
     void doClose();
+    /// starts waiting for the client to accept the response bytes being written
+    void noteWriting();
 
     bool mayUseConnection_; /* This request may use the connection. Don't read anymore requests for now */
     bool connRegistered_;
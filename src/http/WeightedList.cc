@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "base/CharacterSet.h"
+#include "http/WeightedList.h"
+#include "parser/Tokenizer.h"
+
+#include <algorithm>
+#include <set>
+
+/// parses optional list member parameters, extracting the qvalue
+/// \returns the qvalue in thousandths
+static int
+ParseQvalue(Parser::Tokenizer &tok)
+{
+    static const CharacterSet ows = CharacterSet::WSP;
+    static const CharacterSet qChars = CharacterSet("qvalue", "qQ");
+    static const CharacterSet paramChars = CharacterSet("parameter", ";,").complement();
+
+    for (;;) {
+        tok.skipAll(ows);
+        if (!tok.skip(';'))
+            return 1000;
+        tok.skipAll(ows);
+        if (!tok.skipOne(qChars) || !tok.skip('=')) {
+            SBuf ignored;
+            (void)tok.prefix(ignored, paramChars); // an unknown parameter
+            continue;
+        }
+
+        // qvalue = ( "0" [ "." 0*3DIGIT ] ) / ( "1" [ "." 0*3("0") ] )
+        int64_t whole = 0;
+        if (!tok.int64(whole, 10, false, 1) || whole > 1)
+            return 0; // treat malformed qvalues as "not acceptable"
+        int thousandths = whole * 1000;
+        if (tok.skip('.')) {
+            int scale = 100;
+            SBuf digits;
+            (void)tok.prefix(digits, CharacterSet::DIGIT, 3);
+            for (const auto c: digits) {
+                thousandths += (c - '0') * scale;
+                scale /= 10;
+            }
+        }
+        return std::min(thousandths, 1000);
+    }
+}
+
+Http::WeightedList
+Http::ParseWeightedList(const SBuf &raw)
+{
+    static const CharacterSet listDelimiters = CharacterSet("list", ",") + CharacterSet::WSP;
+    static const CharacterSet afterMember = CharacterSet("list", ",").complement();
+
+    WeightedList items;
+    Parser::Tokenizer tok(raw);
+    while (!tok.atEnd()) {
+        tok.skipAll(listDelimiters);
+        WeightedListItem item;
+        if (tok.prefix(item.value, CharacterSet::TCHAR)) {
+            item.quality = ParseQvalue(tok);
+            items.push_back(item);
+        }
+        SBuf ignored;
+        (void)tok.prefix(ignored, afterMember); // garbage after the member (if any)
+    }
+    return items;
+}
+
+SBuf
+Http::CanonicalTokens(const SBuf &value, const SBufList &only)
+{
+    static const SBuf wildcard("*");
+    std::set<SBuf> accepted;
+    std::set<SBuf> rejected;
+    for (auto &item: ParseWeightedList(value)) {
+        item.value.toLower();
+        if (!only.empty() && item.value != wildcard &&
+                std::find(only.begin(), only.end(), item.value) == only.end())
+            continue;
+        if (item.quality > 0)
+            accepted.insert(item.value);
+        else
+            rejected.insert(item.value);
+    }
+
+    SBuf result;
+    for (const auto &token: accepted) {
+        if (!result.isEmpty())
+            result.append(',');
+        result.append(token);
+    }
+    if (accepted.count(wildcard)) {
+        for (const auto &token: rejected) {
+            if (accepted.count(token))
+                continue;
+            result.append(',');
+            result.append(token);
+            result.append(";q=0");
+        }
+    }
+    return result;
+}
+
+SBuf
+Http::LookupLanguage(const SBuf &value, const SBufList &languages, const SBuf &defaultLanguage)
+{
+    auto ranges = ParseWeightedList(value);
+    std::stable_sort(ranges.begin(), ranges.end(), [](const WeightedListItem &a, const WeightedListItem &b) {
+        return a.quality > b.quality;
+    });
+
+    for (auto &range: ranges) {
+        if (!range.quality)
+            break; // the remaining ranges are not acceptable
+
+        if (range.value.cmp("*") == 0)
+            return (defaultLanguage.isEmpty() && !languages.empty()) ? languages.front() : defaultLanguage;
+
+        range.value.toLower();
+        auto tag = range.value;
+        for (;;) {
+            const auto found = std::find(languages.begin(), languages.end(), tag);
+            if (found != languages.end())
+                return *found;
+            const auto dash = tag.rfind('-');
+            if (dash == SBuf::npos)
+                break;
+            tag.chop(0, dash);
+        }
+    }
+    return defaultLanguage;
+}
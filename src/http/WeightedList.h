@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_HTTP_WEIGHTEDLIST_H
+#define SQUID_SRC_HTTP_WEIGHTEDLIST_H
+
+#include "sbuf/List.h"
+#include "sbuf/SBuf.h"
+
+#include <vector>
+
+namespace Http
+{
+
+/// a member of Accept-Encoding, Accept-Language, and similar lists of
+/// values with optional qvalue weights (RFC 9110 Section 12.4.2)
+class WeightedListItem
+{
+public:
+    SBuf value; ///< a content coding, a language range, or a similar token
+    int quality = 1000; ///< the qvalue in thousandths
+};
+
+typedef std::vector<WeightedListItem> WeightedList;
+
+/// parses a comma-separated list of tokens with optional parameters,
+/// skipping malformed list members; a malformed qvalue yields zero quality
+WeightedList ParseWeightedList(const SBuf &);
+
+/// A sorted, duplicate-free list of lowercase list members with non-zero
+/// weights, optionally restricted to the given lowercase members. Rejected
+/// members remain (with q=0) only when a wildcard member would otherwise
+/// accept them.
+/// \param only the members to keep (or empty to keep all)
+SBuf CanonicalTokens(const SBuf &value, const SBufList &only);
+
+/// The supported language best matching the given language ranges, using the
+/// RFC 4647 Section 3.4 Lookup scheme, or the default language.
+/// \param languages lowercase supported language tags
+/// \param defaultLanguage the tag for unsupported languages (may be empty)
+SBuf LookupLanguage(const SBuf &value, const SBufList &languages, const SBuf &defaultLanguage);
+
+} // namespace Http
+
+#endif /* SQUID_SRC_HTTP_WEIGHTEDLIST_H */
@@ -16,6 +16,7 @@
 namespace Http
 {
 
+class Compressor;
 class ContentLengthInterpreter;
 
 class Message;
@@ -12,7 +12,6 @@
 #include "http/one/TeChunkedParser.h"
 #include "http/one/Tokenizer.h"
 #include "http/ProtocolVersion.h"
-#include "MemBuf.h"
 #include "parser/Tokenizer.h"
 #include "Parsing.h"
 #include "sbuf/Stream.h"
@@ -34,6 +33,7 @@ Http::One::TeChunkedParser::clear()
     buf_.clear();
     theChunkSize = theLeftBodySize = 0;
     theOut = nullptr;
+    theOutLimit = 0;
     // XXX: We do not reset customExtensionValueParser here. Based on the
     // clear() API description, we must, but it makes little sense and could
     // break method callers if they appear because some of them may forget to
@@ -82,7 +82,7 @@ bool
 Http::One::TeChunkedParser::needsMoreSpace() const
 {
     assert(theOut);
-    return parsingStage_ == Http1::HTTP_PARSE_CHUNK && !theOut->hasPotentialSpace();
+    return parsingStage_ == Http1::HTTP_PARSE_CHUNK && theOut->length() >= theOutLimit;
 }
 
 /// RFC 7230 section 4.1 chunk-size
@@ -203,9 +203,13 @@ Http::One::TeChunkedParser::parseChunkBody(Tokenizer &tok)
 
         // TODO fix type mismatches and casting for these
         const size_t availSize = min(theLeftBodySize, (uint64_t)buf_.length());
-        const size_t safeSize = min(availSize, (size_t)theOut->potentialSpaceSize());
+        const size_t spaceSize = theOut->length() < theOutLimit ? theOutLimit - theOut->length() : 0;
+        const size_t safeSize = min(availSize, spaceSize);
 
-        theOut->append(buf_.rawContent(), safeSize);
+        if (theOut->isEmpty())
+            *theOut = buf_.substr(0, safeSize); // share input storage
+        else
+            theOut->append(buf_.substr(0, safeSize));
         buf_.consume(safeSize);
         theLeftBodySize -= safeSize;
 
@@ -11,8 +11,6 @@
 
 #include "http/one/Parser.h"
 
-class MemBuf;
-
 namespace Http
 {
 namespace One
@@ -54,8 +52,10 @@ public:
     TeChunkedParser();
     ~TeChunkedParser() override { theOut=nullptr; /* we do not own this object */ }
 
-    /// set the buffer to be used to store decoded chunk data
-    void setPayloadBuffer(MemBuf *parsedContent) {theOut = parsedContent;}
+    /// Set the buffer to be used to store decoded chunk data. The buffer may
+    /// grow up to maxSize bytes. Decoded data added to an empty buffer shares
+    /// storage with the parsed input.
+    void setPayloadBuffer(SBuf *parsedContent, SBuf::size_type maxSize) { theOut = parsedContent; theOutLimit = maxSize; }
 
     /// Instead of ignoring all chunk extension values, give the supplied
     /// parser a chance to handle them. Only applied to last-chunk (for now).
@@ -76,7 +76,8 @@ private:
     bool parseChunkBody(Tokenizer &tok);
     bool parseChunkEnd(Tokenizer &tok);
 
-    MemBuf *theOut;
+    SBuf *theOut;
+    SBuf::size_type theOutLimit; ///< the maximum theOut length
     uint64_t theChunkSize;
     uint64_t theLeftBodySize;
 
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "http/two/Frame.h"
+
+#include <algorithm>
+#include <ostream>
+
+const SBuf &
+Http::Two::ClientPreface()
+{
+    static const SBuf preface("PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n");
+    return preface;
+}
+
+Http::Two::FrameHeader
+Http::Two::FrameHeader::Parse(const char *raw)
+{
+    const auto *p = reinterpret_cast<const unsigned char *>(raw);
+    FrameHeader header;
+    header.length = (uint32_t(p[0]) << 16) | (uint32_t(p[1]) << 8) | uint32_t(p[2]);
+    header.type = p[3];
+    header.flags = p[4];
+    header.streamId = GetUint32(raw + 5) & 0x7fffffff; // ignore the reserved bit
+    return header;
+}
+
+std::ostream &
+Http::Two::operator <<(std::ostream &os, const FrameHeader &header)
+{
+    return os << "frame type " << int(header.type) <<
+           " flags 0x" << std::hex << int(header.flags) << std::dec <<
+           " stream " << header.streamId <<
+           " length " << header.length;
+}
+
+void
+Http::Two::PutUint32(SBuf &buf, const uint32_t value)
+{
+    const char raw[4] = {
+        static_cast<char>(value >> 24),
+        static_cast<char>(value >> 16),
+        static_cast<char>(value >> 8),
+        static_cast<char>(value)
+    };
+    buf.append(raw, sizeof(raw));
+}
+
+void
+Http::Two::PutUint16(SBuf &buf, const uint16_t value)
+{
+    const char raw[2] = {
+        static_cast<char>(value >> 8),
+        static_cast<char>(value)
+    };
+    buf.append(raw, sizeof(raw));
+}
+
+void
+Http::Two::PackFrameHeader(SBuf &buf, const FrameType type, const uint8_t flags, const uint32_t streamId, const size_t length)
+{
+    const char raw[5] = {
+        static_cast<char>(length >> 16),
+        static_cast<char>(length >> 8),
+        static_cast<char>(length),
+        static_cast<char>(type),
+        static_cast<char>(flags)
+    };
+    buf.append(raw, sizeof(raw));
+    PutUint32(buf, streamId & 0x7fffffff);
+}
+
+void
+Http::Two::PackFrame(SBuf &buf, const FrameType type, const uint8_t flags, const uint32_t streamId, const SBuf &payload)
+{
+    PackFrameHeader(buf, type, flags, streamId, payload.length());
+    buf.append(payload);
+}
+
+void
+Http::Two::PackRstStream(SBuf &buf, const uint32_t streamId, const ErrorCode error)
+{
+    PackFrameHeader(buf, ftRstStream, 0, streamId, 4);
+    PutUint32(buf, error);
+}
+
+void
+Http::Two::PackWindowUpdate(SBuf &buf, const uint32_t streamId, const uint32_t increment)
+{
+    PackFrameHeader(buf, ftWindowUpdate, 0, streamId, 4);
+    PutUint32(buf, increment & 0x7fffffff);
+}
+
+void
+Http::Two::PackGoAway(SBuf &buf, const uint32_t lastStreamId, const ErrorCode error)
+{
+    PackFrameHeader(buf, ftGoAway, 0, 0, 8);
+    PutUint32(buf, lastStreamId & 0x7fffffff);
+    PutUint32(buf, error);
+}
+
+void
+Http::Two::PackHeaderBlock(SBuf &buf, const uint32_t streamId, const SBuf &block, const bool endStream, const uint32_t maxFrameSize)
+{
+    auto type = ftHeaders;
+    SBuf::size_type offset = 0;
+    do {
+        const auto size = std::min<SBuf::size_type>(block.length() - offset, maxFrameSize);
+        const auto last = offset + size == block.length();
+        uint8_t flags = last ? ffEndHeaders : 0;
+        if (endStream && type == ftHeaders)
+            flags |= ffEndStream;
+        PackFrameHeader(buf, type, flags, streamId, size);
+        buf.append(block.rawContent() + offset, size);
+        offset += size;
+        type = ftContinuation;
+    } while (offset < block.length());
+}
+
+const char *
+Http::Two::ErrorCodeName(const uint32_t code)
+{
+    static const char *names[] = {
+        "NO_ERROR",
+        "PROTOCOL_ERROR",
+        "INTERNAL_ERROR",
+        "FLOW_CONTROL_ERROR",
+        "SETTINGS_TIMEOUT",
+        "STREAM_CLOSED",
+        "FRAME_SIZE_ERROR",
+        "REFUSED_STREAM",
+        "CANCEL",
+        "COMPRESSION_ERROR",
+        "CONNECT_ERROR",
+        "ENHANCE_YOUR_CALM",
+        "INADEQUATE_SECURITY",
+        "HTTP_1_1_REQUIRED"
+    };
+    return code < sizeof(names)/sizeof(names[0]) ? names[code] : "UNKNOWN_ERROR";
+}
+
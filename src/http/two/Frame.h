@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_HTTP_TWO_FRAME_H
+#define SQUID_SRC_HTTP_TWO_FRAME_H
+
+#include "http/two/forward.h"
+#include "sbuf/SBuf.h"
+
+#include <iosfwd>
+
+namespace Http {
+namespace Two {
+
+/// frame types (RFC 9113 Section 6)
+typedef enum {
+    ftData = 0x0,
+    ftHeaders = 0x1,
+    ftPriority = 0x2,
+    ftRstStream = 0x3,
+    ftSettings = 0x4,
+    ftPushPromise = 0x5,
+    ftPing = 0x6,
+    ftGoAway = 0x7,
+    ftWindowUpdate = 0x8,
+    ftContinuation = 0x9
+} FrameType;
+
+/// frame flags; their meaning depends on the frame type
+typedef enum {
+    ffEndStream = 0x1, ///< DATA and HEADERS
+    ffAck = 0x1, ///< SETTINGS and PING
+    ffEndHeaders = 0x4, ///< HEADERS and CONTINUATION
+    ffPadded = 0x8, ///< DATA and HEADERS
+    ffPriority = 0x20 ///< HEADERS
+} FrameFlag;
+
+/// RST_STREAM and GOAWAY error codes (RFC 9113 Section 7)
+typedef enum {
+    ecNoError = 0x0,
+    ecProtocolError = 0x1,
+    ecInternalError = 0x2,
+    ecFlowControlError = 0x3,
+    ecSettingsTimeout = 0x4,
+    ecStreamClosed = 0x5,
+    ecFrameSizeError = 0x6,
+    ecRefusedStream = 0x7,
+    ecCancel = 0x8,
+    ecCompressionError = 0x9,
+    ecConnectError = 0xa,
+    ecEnhanceYourCalm = 0xb,
+    ecInadequateSecurity = 0xc,
+    ecHttp11Required = 0xd
+} ErrorCode;
+
+/// SETTINGS parameter identifiers (RFC 9113 Section 6.5.2)
+typedef enum {
+    sHeaderTableSize = 0x1,
+    sEnablePush = 0x2,
+    sMaxConcurrentStreams = 0x3,
+    sInitialWindowSize = 0x4,
+    sMaxFrameSize = 0x5,
+    sMaxHeaderListSize = 0x6
+} SettingId;
+
+/// the size of the fixed frame header preceding every frame payload
+const size_t FrameHeaderSize = 9;
+
+/// the maximum frame payload size a peer may send before SETTINGS say otherwise
+const uint32_t DefaultMaxFrameSize = 16384;
+
+/// the largest SETTINGS_MAX_FRAME_SIZE value
+const uint32_t MaxFrameSizeLimit = 16777215;
+
+/// the initial flow control window size for new streams and connections
+const int64_t DefaultWindowSize = 65535;
+
+/// the largest flow control window size
+const int64_t MaxWindowSize = 2147483647;
+
+/// the default SETTINGS_HEADER_TABLE_SIZE
+const size_t DefaultHeaderTableSize = 4096;
+
+/// the client connection preface (RFC 9113 Section 3.4)
+const SBuf &ClientPreface();
+
+/// a parsed frame header
+class FrameHeader
+{
+public:
+    /// parses the frame header at the start of the given buffer
+    /// \param raw must contain at least FrameHeaderSize bytes
+    static FrameHeader Parse(const char *raw);
+
+    bool hasFlag(const uint8_t flag) const { return (flags & flag) != 0; }
+
+    uint32_t length = 0; ///< payload size
+    uint8_t type = 0; ///< FrameType (or an unknown extension type)
+    uint8_t flags = 0; ///< FrameFlag bits
+    uint32_t streamId = 0; ///< zero for connection-level frames
+};
+
+std::ostream &operator <<(std::ostream &, const FrameHeader &);
+
+/// reads a big-endian 32-bit integer
+inline uint32_t
+GetUint32(const char *raw)
+{
+    const auto *p = reinterpret_cast<const unsigned char *>(raw);
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+/// reads a big-endian 16-bit integer
+inline uint16_t
+GetUint16(const char *raw)
+{
+    const auto *p = reinterpret_cast<const unsigned char *>(raw);
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+/// appends a big-endian 32-bit integer
+void PutUint32(SBuf &, uint32_t);
+
+/// appends a big-endian 16-bit integer
+void PutUint16(SBuf &, uint16_t);
+
+/// appends a frame header
+void PackFrameHeader(SBuf &, FrameType, uint8_t flags, uint32_t streamId, size_t length);
+
+/// appends a complete frame
+void PackFrame(SBuf &, FrameType, uint8_t flags, uint32_t streamId, const SBuf &payload);
+
+/// appends an RST_STREAM frame
+void PackRstStream(SBuf &, uint32_t streamId, ErrorCode);
+
+/// appends a WINDOW_UPDATE frame
+void PackWindowUpdate(SBuf &, uint32_t streamId, uint32_t increment);
+
+/// appends a GOAWAY frame
+void PackGoAway(SBuf &, uint32_t lastStreamId, ErrorCode);
+
+/// appends a HEADERS frame carrying the given header block, followed by
+/// CONTINUATION frames if the block does not fit into maxFrameSize
+void PackHeaderBlock(SBuf &, uint32_t streamId, const SBuf &block, bool endStream, uint32_t maxFrameSize);
+
+/// the error code name, for debugging
+const char *ErrorCodeName(uint32_t);
+
+} // namespace Two
+} // namespace Http
+
+#endif /* SQUID_SRC_HTTP_TWO_FRAME_H */
+
@@ -0,0 +1,574 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "base/CharacterSet.h"
+#include "http/two/Hpack.h"
+
+#include <algorithm>
+
+namespace Http {
+namespace Two {
+
+/// a Huffman code for one symbol
+class HuffmanCode
+{
+public:
+    uint32_t code; ///< right-aligned code bits
+    uint8_t bits; ///< code length
+};
+
+/// HPACK Huffman codes indexed by symbol; the last one is EOS
+/// (RFC 7541 Appendix B)
+static const HuffmanCode HuffmanCodes[257] = {
+    {0x1ff8, 13}, {0x7fffd8, 23}, {0xfffffe2, 28}, {0xfffffe3, 28},
+    {0xfffffe4, 28}, {0xfffffe5, 28}, {0xfffffe6, 28}, {0xfffffe7, 28},
+    {0xfffffe8, 28}, {0xffffea, 24}, {0x3ffffffc, 30}, {0xfffffe9, 28},
+    {0xfffffea, 28}, {0x3ffffffd, 30}, {0xfffffeb, 28}, {0xfffffec, 28},
+    {0xfffffed, 28}, {0xfffffee, 28}, {0xfffffef, 28}, {0xffffff0, 28},
+    {0xffffff1, 28}, {0xffffff2, 28}, {0x3ffffffe, 30}, {0xffffff3, 28},
+    {0xffffff4, 28}, {0xffffff5, 28}, {0xffffff6, 28}, {0xffffff7, 28},
+    {0xffffff8, 28}, {0xffffff9, 28}, {0xffffffa, 28}, {0xffffffb, 28},
+    {0x14, 6}, {0x3f8, 10}, {0x3f9, 10}, {0xffa, 12},
+    {0x1ff9, 13}, {0x15, 6}, {0xf8, 8}, {0x7fa, 11},
+    {0x3fa, 10}, {0x3fb, 10}, {0xf9, 8}, {0x7fb, 11},
+    {0xfa, 8}, {0x16, 6}, {0x17, 6}, {0x18, 6},
+    {0x0, 5}, {0x1, 5}, {0x2, 5}, {0x19, 6},
+    {0x1a, 6}, {0x1b, 6}, {0x1c, 6}, {0x1d, 6},
+    {0x1e, 6}, {0x1f, 6}, {0x5c, 7}, {0xfb, 8},
+    {0x7ffc, 15}, {0x20, 6}, {0xffb, 12}, {0x3fc, 10},
+    {0x1ffa, 13}, {0x21, 6}, {0x5d, 7}, {0x5e, 7},
+    {0x5f, 7}, {0x60, 7}, {0x61, 7}, {0x62, 7},
+    {0x63, 7}, {0x64, 7}, {0x65, 7}, {0x66, 7},
+    {0x67, 7}, {0x68, 7}, {0x69, 7}, {0x6a, 7},
+    {0x6b, 7}, {0x6c, 7}, {0x6d, 7}, {0x6e, 7},
+    {0x6f, 7}, {0x70, 7}, {0x71, 7}, {0x72, 7},
+    {0xfc, 8}, {0x73, 7}, {0xfd, 8}, {0x1ffb, 13},
+    {0x7fff0, 19}, {0x1ffc, 13}, {0x3ffc, 14}, {0x22, 6},
+    {0x7ffd, 15}, {0x3, 5}, {0x23, 6}, {0x4, 5},
+    {0x24, 6}, {0x5, 5}, {0x25, 6}, {0x26, 6},
+    {0x27, 6}, {0x6, 5}, {0x74, 7}, {0x75, 7},
+    {0x28, 6}, {0x29, 6}, {0x2a, 6}, {0x7, 5},
+    {0x2b, 6}, {0x76, 7}, {0x2c, 6}, {0x8, 5},
+    {0x9, 5}, {0x2d, 6}, {0x77, 7}, {0x78, 7},
+    {0x79, 7}, {0x7a, 7}, {0x7b, 7}, {0x7ffe, 15},
+    {0x7fc, 11}, {0x3ffd, 14}, {0x1ffd, 13}, {0xffffffc, 28},
+    {0xfffe6, 20}, {0x3fffd2, 22}, {0xfffe7, 20}, {0xfffe8, 20},
+    {0x3fffd3, 22}, {0x3fffd4, 22}, {0x3fffd5, 22}, {0x7fffd9, 23},
+    {0x3fffd6, 22}, {0x7fffda, 23}, {0x7fffdb, 23}, {0x7fffdc, 23},
+    {0x7fffdd, 23}, {0x7fffde, 23}, {0xffffeb, 24}, {0x7fffdf, 23},
+    {0xffffec, 24}, {0xffffed, 24}, {0x3fffd7, 22}, {0x7fffe0, 23},
+    {0xffffee, 24}, {0x7fffe1, 23}, {0x7fffe2, 23}, {0x7fffe3, 23},
+    {0x7fffe4, 23}, {0x1fffdc, 21}, {0x3fffd8, 22}, {0x7fffe5, 23},
+    {0x3fffd9, 22}, {0x7fffe6, 23}, {0x7fffe7, 23}, {0xffffef, 24},
+    {0x3fffda, 22}, {0x1fffdd, 21}, {0xfffe9, 20}, {0x3fffdb, 22},
+    {0x3fffdc, 22}, {0x7fffe8, 23}, {0x7fffe9, 23}, {0x1fffde, 21},
+    {0x7fffea, 23}, {0x3fffdd, 22}, {0x3fffde, 22}, {0xfffff0, 24},
+    {0x1fffdf, 21}, {0x3fffdf, 22}, {0x7fffeb, 23}, {0x7fffec, 23},
+    {0x1fffe0, 21}, {0x1fffe1, 21}, {0x3fffe0, 22}, {0x1fffe2, 21},
+    {0x7fffed, 23}, {0x3fffe1, 22}, {0x7fffee, 23}, {0x7fffef, 23},
+    {0xfffea, 20}, {0x3fffe2, 22}, {0x3fffe3, 22}, {0x3fffe4, 22},
+    {0x7ffff0, 23}, {0x3fffe5, 22}, {0x3fffe6, 22}, {0x7ffff1, 23},
+    {0x3ffffe0, 26}, {0x3ffffe1, 26}, {0xfffeb, 20}, {0x7fff1, 19},
+    {0x3fffe7, 22}, {0x7ffff2, 23}, {0x3fffe8, 22}, {0x1ffffec, 25},
+    {0x3ffffe2, 26}, {0x3ffffe3, 26}, {0x3ffffe4, 26}, {0x7ffffde, 27},
+    {0x7ffffdf, 27}, {0x3ffffe5, 26}, {0xfffff1, 24}, {0x1ffffed, 25},
+    {0x7fff2, 19}, {0x1fffe3, 21}, {0x3ffffe6, 26}, {0x7ffffe0, 27},
+    {0x7ffffe1, 27}, {0x3ffffe7, 26}, {0x7ffffe2, 27}, {0xfffff2, 24},
+    {0x1fffe4, 21}, {0x1fffe5, 21}, {0x3ffffe8, 26}, {0x3ffffe9, 26},
+    {0xffffffd, 28}, {0x7ffffe3, 27}, {0x7ffffe4, 27}, {0x7ffffe5, 27},
+    {0xfffec, 20}, {0xfffff3, 24}, {0xfffed, 20}, {0x1fffe6, 21},
+    {0x3fffe9, 22}, {0x1fffe7, 21}, {0x1fffe8, 21}, {0x7ffff3, 23},
+    {0x3fffea, 22}, {0x3fffeb, 22}, {0x1ffffee, 25}, {0x1ffffef, 25},
+    {0xfffff4, 24}, {0xfffff5, 24}, {0x3ffffea, 26}, {0x7ffff4, 23},
+    {0x3ffffeb, 26}, {0x7ffffe6, 27}, {0x3ffffec, 26}, {0x3ffffed, 26},
+    {0x7ffffe7, 27}, {0x7ffffe8, 27}, {0x7ffffe9, 27}, {0x7ffffea, 27},
+    {0x7ffffeb, 27}, {0xffffffe, 28}, {0x7ffffec, 27}, {0x7ffffed, 27},
+    {0x7ffffee, 27}, {0x7ffffef, 27}, {0x7fffff0, 27}, {0x3ffffee, 26},
+    {0x3fffffff, 30}
+};
+
+/// the End Of String symbol
+static const uint16_t HuffmanEos = 256;
+
+/// the longest Huffman code length
+static const int HuffmanMaxBits = 30;
+
+/// Tables for decoding canonical Huffman codes. HPACK codes are canonical:
+/// Same-length codes are consecutive numbers assigned in symbol order, and
+/// shorter codes precede longer ones.
+class HuffmanDecodingTables
+{
+public:
+    HuffmanDecodingTables();
+
+    uint32_t firstCode[HuffmanMaxBits + 1]; ///< the first code of each length
+    uint16_t count[HuffmanMaxBits + 1]; ///< the number of codes of each length
+    uint16_t offset[HuffmanMaxBits + 1]; ///< symbols[] index of each length first code
+    uint16_t symbols[257]; ///< all symbols ordered by their codes
+};
+
+/// HPACK static table entries (RFC 7541 Appendix A)
+static const char *StaticTableEntries[HpackTable::StaticEntries][2] = {
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""}
+};
+
+} // namespace Two
+} // namespace Http
+
+Http::Two::HuffmanDecodingTables::HuffmanDecodingTables()
+{
+    std::fill(std::begin(count), std::end(count), 0);
+    for (const auto &code: HuffmanCodes)
+        ++count[code.bits];
+
+    uint16_t next = 0;
+    for (int bits = 0; bits <= HuffmanMaxBits; ++bits) {
+        offset[bits] = next;
+        next += count[bits];
+    }
+
+    uint16_t filled[HuffmanMaxBits + 1] = {};
+    for (uint16_t symbol = 0; symbol <= HuffmanEos; ++symbol) {
+        const auto bits = HuffmanCodes[symbol].bits;
+        symbols[offset[bits] + filled[bits]++] = symbol;
+    }
+
+    for (int bits = 0; bits <= HuffmanMaxBits; ++bits)
+        firstCode[bits] = count[bits] ? HuffmanCodes[symbols[offset[bits]]].code : 0;
+}
+
+bool
+Http::Two::HuffmanDecode(const char *raw, const size_t size, SBuf &out)
+{
+    static const HuffmanDecodingTables tables;
+
+    out.clear();
+    out.reserveSpace(size + size/2); // decoded strings are usually ~1.25x longer
+
+    uint32_t code = 0;
+    int bits = 0;
+    for (size_t i = 0; i < size; ++i) {
+        const auto byte = static_cast<unsigned char>(raw[i]);
+        for (int bit = 7; bit >= 0; --bit) {
+            code = (code << 1) | ((byte >> bit) & 1);
+            ++bits;
+            if (bits > HuffmanMaxBits)
+                return false;
+            if (code >= tables.firstCode[bits] && code - tables.firstCode[bits] < tables.count[bits]) {
+                const auto symbol = tables.symbols[tables.offset[bits] + code - tables.firstCode[bits]];
+                if (symbol == HuffmanEos)
+                    return false; // RFC 7541 Section 5.2: EOS is a decoding error
+                out.append(static_cast<char>(symbol));
+                code = 0;
+                bits = 0;
+            }
+        }
+    }
+
+    // padding must be a short EOS prefix (i.e. all ones)
+    return bits <= 7 && code == (uint32_t(1) << bits) - 1;
+}
+
+size_t
+Http::Two::HuffmanEncodedSize(const SBuf &str)
+{
+    size_t bits = 0;
+    for (const auto c: str)
+        bits += HuffmanCodes[static_cast<unsigned char>(c)].bits;
+    return (bits + 7) / 8;
+}
+
+void
+Http::Two::HuffmanEncode(const SBuf &str, SBuf &out)
+{
+    uint64_t pending = 0; // right-aligned bits not yet appended
+    int bits = 0;
+    for (const auto c: str) {
+        const auto &code = HuffmanCodes[static_cast<unsigned char>(c)];
+        pending = (pending << code.bits) | code.code;
+        bits += code.bits;
+        while (bits >= 8) {
+            bits -= 8;
+            out.append(static_cast<char>(pending >> bits));
+        }
+        pending &= (uint64_t(1) << bits) - 1;
+    }
+    if (bits)
+        out.append(static_cast<char>((pending << (8 - bits)) | (0xff >> bits))); // EOS-prefix padding
+}
+
+/* integer and string primitives (RFC 7541 Section 5) */
+
+/// the largest integer we decode; large enough for any field or table size
+static const uint64_t MaxHpackInteger = 0xffffffff;
+
+/// decodes an integer with the given prefix size, advancing p
+static bool
+DecodeInteger(const char *&p, const char * const end, const int prefixBits, uint64_t &value)
+{
+    if (p >= end)
+        return false;
+
+    const unsigned int prefixMax = (1u << prefixBits) - 1;
+    value = static_cast<unsigned char>(*p++) & prefixMax;
+    if (value < prefixMax)
+        return true;
+
+    for (int shift = 0; p < end && shift <= 28; shift += 7) {
+        const auto byte = static_cast<unsigned char>(*p++);
+        value += uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return value <= MaxHpackInteger;
+    }
+    return false; // truncated or too large
+}
+
+/// decodes a string literal, advancing p
+static bool
+DecodeString(const char *&p, const char * const end, SBuf &out)
+{
+    if (p >= end)
+        return false;
+
+    const auto huffman = (static_cast<unsigned char>(*p) & 0x80) != 0;
+    uint64_t length = 0;
+    if (!DecodeInteger(p, end, 7, length) || length > static_cast<uint64_t>(end - p))
+        return false;
+
+    if (huffman) {
+        if (!Http::Two::HuffmanDecode(p, length, out))
+            return false;
+    } else {
+        out.assign(p, length);
+    }
+    p += length;
+    return true;
+}
+
+/// appends an integer with the given prefix size and first byte flags
+static void
+EncodeInteger(SBuf &out, const unsigned char flags, const int prefixBits, uint64_t value)
+{
+    const unsigned int prefixMax = (1u << prefixBits) - 1;
+    if (value < prefixMax) {
+        out.append(static_cast<char>(flags | value));
+        return;
+    }
+
+    out.append(static_cast<char>(flags | prefixMax));
+    value -= prefixMax;
+    while (value >= 0x80) {
+        out.append(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.append(static_cast<char>(value));
+}
+
+/// appends a string literal, Huffman-encoded if that makes it shorter
+static void
+EncodeString(SBuf &out, const SBuf &str)
+{
+    const auto huffmanSize = Http::Two::HuffmanEncodedSize(str);
+    if (huffmanSize < str.length()) {
+        EncodeInteger(out, 0x80, 7, huffmanSize);
+        Http::Two::HuffmanEncode(str, out);
+    } else {
+        EncodeInteger(out, 0, 7, str.length());
+        out.append(str);
+    }
+}
+
+/// the static table entries as HeaderField objects
+static const std::vector<Http::Two::HeaderField> &
+StaticTable()
+{
+    static const auto table = [] {
+        std::vector<Http::Two::HeaderField> fields;
+        fields.reserve(Http::Two::HpackTable::StaticEntries);
+        for (const auto &entry: Http::Two::StaticTableEntries)
+            fields.emplace_back(SBuf(entry[0]), SBuf(entry[1]));
+        return fields;
+    }();
+    return table;
+}
+
+bool
+Http::Two::ValidFieldName(const SBuf &name)
+{
+    static const auto nameChars = (CharacterSet::TCHAR - CharacterSet("upper", 'A', 'Z')).rename("h2-field-name");
+    return !name.isEmpty() && name.findFirstNotOf(nameChars) == SBuf::npos;
+}
+
+bool
+Http::Two::ValidFieldValue(const SBuf &value)
+{
+    static const auto badChars = CharacterSet("h2-bad-value", "\r\n").add('\0');
+    return value.findFirstOf(badChars) == SBuf::npos;
+}
+
+/* Http::Two::HpackTable */
+
+const Http::Two::HeaderField *
+Http::Two::HpackTable::at(const uint64_t index) const
+{
+    if (!index)
+        return nullptr;
+    if (index <= StaticEntries)
+        return &StaticTable()[index - 1];
+    const auto dynamicIndex = index - StaticEntries - 1;
+    if (dynamicIndex < dynamic_.size())
+        return &dynamic_[dynamicIndex];
+    return nullptr;
+}
+
+void
+Http::Two::HpackTable::add(const HeaderField &field)
+{
+    const auto fieldSize = field.size();
+    if (fieldSize > maxSize_) {
+        // RFC 7541 Section 4.4: an oversized entry empties the table
+        evictDownTo(0);
+        return;
+    }
+    evictDownTo(maxSize_ - fieldSize);
+    dynamic_.push_front(field);
+    size_ += fieldSize;
+}
+
+void
+Http::Two::HpackTable::setMaxSize(const size_t newMaxSize)
+{
+    maxSize_ = newMaxSize;
+    evictDownTo(maxSize_);
+}
+
+void
+Http::Two::HpackTable::evictDownTo(const size_t limit)
+{
+    while (size_ > limit) {
+        size_ -= dynamic_.back().size();
+        dynamic_.pop_back();
+    }
+}
+
+uint64_t
+Http::Two::HpackTable::find(const SBuf &name, const SBuf &value, uint64_t &nameIndex) const
+{
+    nameIndex = 0;
+
+    const auto &staticTable = StaticTable();
+    for (uint64_t i = 0; i < staticTable.size(); ++i) {
+        if (staticTable[i].name != name)
+            continue;
+        if (staticTable[i].value == value)
+            return i + 1;
+        if (!nameIndex)
+            nameIndex = i + 1;
+    }
+
+    for (uint64_t i = 0; i < dynamic_.size(); ++i) {
+        if (dynamic_[i].name != name)
+            continue;
+        if (dynamic_[i].value == value)
+            return StaticEntries + i + 1;
+        if (!nameIndex)
+            nameIndex = StaticEntries + i + 1;
+    }
+
+    return 0;
+}
+
+/* Http::Two::HpackDecoder */
+
+Http::Two::HpackDecoder::HpackDecoder(const size_t maxTableSize, const size_t maxListSize):
+    table_(maxTableSize),
+    maxTableSize_(maxTableSize),
+    maxListSize_(maxListSize)
+{
+}
+
+bool
+Http::Two::HpackDecoder::decode(const SBuf &block, HeaderFields &fields)
+{
+    const char *p = block.rawContent();
+    const char * const end = p + block.length();
+    size_t listSize = 0;
+    auto sawField = false;
+
+    while (p < end) {
+        const auto first = static_cast<unsigned char>(*p);
+        HeaderField field;
+
+        if (first & 0x80) { // indexed field
+            uint64_t index = 0;
+            if (!DecodeInteger(p, end, 7, index))
+                return false;
+            const auto indexed = table_.at(index);
+            if (!indexed)
+                return false;
+            field = *indexed;
+        } else if ((first & 0xc0) == 0x40) { // literal with incremental indexing
+            if (!decodeLiteral(p, end, 6, field))
+                return false;
+            table_.add(field);
+        } else if ((first & 0xe0) == 0x20) { // dynamic table size update
+            uint64_t newSize = 0;
+            // RFC 7541 Section 4.2: updates must precede the first field
+            if (sawField || !DecodeInteger(p, end, 5, newSize) || newSize > maxTableSize_)
+                return false;
+            table_.setMaxSize(newSize);
+            continue;
+        } else { // literal without indexing or never indexed
+            if (!decodeLiteral(p, end, 4, field))
+                return false;
+        }
+
+        sawField = true;
+        listSize += field.size();
+        if (listSize > maxListSize_)
+            return false;
+        fields.push_back(field);
+    }
+
+    return true;
+}
+
+/// decodes a literal field representation with the given index prefix size
+bool
+Http::Two::HpackDecoder::decodeLiteral(const char *&p, const char * const end, const int prefixBits, HeaderField &field) const
+{
+    uint64_t nameIndex = 0;
+    if (!DecodeInteger(p, end, prefixBits, nameIndex))
+        return false;
+
+    if (nameIndex) {
+        const auto indexed = table_.at(nameIndex);
+        if (!indexed)
+            return false;
+        field.name = indexed->name;
+    } else if (!DecodeString(p, end, field.name)) {
+        return false;
+    }
+
+    return DecodeString(p, end, field.value);
+}
+
+/* Http::Two::HpackEncoder */
+
+void
+Http::Two::HpackEncoder::setMaxTableSize(const size_t peerLimit)
+{
+    // we never need more than the default table size
+    const auto newSize = std::min(peerLimit, DefaultHeaderTableSize);
+    if (newSize == table_.maxSize())
+        return;
+
+    minPendingSize_ = sizeChanged_ ? std::min(minPendingSize_, newSize) : std::min(table_.maxSize(), newSize);
+    sizeChanged_ = true;
+    table_.setMaxSize(newSize);
+}
+
+void
+Http::Two::HpackEncoder::startBlock(SBuf &block)
+{
+    if (!sizeChanged_)
+        return;
+
+    // RFC 7541 Section 4.2: signal the smallest size and then the final one
+    if (minPendingSize_ < table_.maxSize())
+        EncodeInteger(block, 0x20, 5, minPendingSize_);
+    EncodeInteger(block, 0x20, 5, table_.maxSize());
+    sizeChanged_ = false;
+    minPendingSize_ = 0;
+}
+
+void
+Http::Two::HpackEncoder::encode(SBuf &block, const SBuf &name, const SBuf &value, const Indexing indexing)
+{
+    uint64_t nameIndex = 0;
+    if (const auto index = table_.find(name, value, nameIndex)) {
+        EncodeInteger(block, 0x80, 7, index);
+        return;
+    }
+
+    if (indexing == idxIncremental && HeaderField(name, value).size() <= table_.maxSize()) {
+        EncodeInteger(block, 0x40, 6, nameIndex);
+        if (!nameIndex)
+            EncodeString(block, name);
+        EncodeString(block, value);
+        table_.add(HeaderField(name, value));
+        return;
+    }
+
+    EncodeInteger(block, indexing == idxNever ? 0x10 : 0x00, 4, nameIndex);
+    if (!nameIndex)
+        EncodeString(block, name);
+    EncodeString(block, value);
+}
+
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_HTTP_TWO_HPACK_H
+#define SQUID_SRC_HTTP_TWO_HPACK_H
+
+#include "http/two/forward.h"
+#include "http/two/Frame.h"
+#include "sbuf/SBuf.h"
+
+#include <deque>
+#include <vector>
+
+namespace Http {
+namespace Two {
+
+/// a header field name and value
+class HeaderField
+{
+public:
+    HeaderField() = default;
+    HeaderField(const SBuf &aName, const SBuf &aValue): name(aName), value(aValue) {}
+
+    /// the field size for HPACK table accounting (RFC 7541 Section 4.1)
+    size_t size() const { return name.length() + value.length() + 32; }
+
+    SBuf name;
+    SBuf value;
+};
+
+typedef std::vector<HeaderField> HeaderFields;
+
+/// whether the given field name is acceptable (RFC 9113 Section 8.2.1)
+bool ValidFieldName(const SBuf &);
+
+/// whether the given field value is acceptable (RFC 9113 Section 8.2.1)
+bool ValidFieldValue(const SBuf &);
+
+/// The HPACK static and dynamic tables (RFC 7541 Section 2.3) sharing one
+/// index address space: Indexes 1-61 refer to static table entries, and
+/// the following indexes refer to dynamic entries, newest first.
+class HpackTable
+{
+public:
+    /// the number of static table entries
+    static const uint64_t StaticEntries = 61;
+
+    explicit HpackTable(const size_t aMaxSize): maxSize_(aMaxSize) {}
+
+    /// \returns the field at the given index or nil for invalid indexes
+    const HeaderField *at(uint64_t index) const;
+
+    /// inserts a field into the dynamic table, evicting old entries as needed
+    void add(const HeaderField &);
+
+    /// changes the dynamic table size limit, evicting old entries as needed
+    void setMaxSize(size_t);
+
+    /// dynamic table size limit
+    size_t maxSize() const { return maxSize_; }
+
+    /// dynamic table size
+    size_t size() const { return size_; }
+
+    /// \returns the index of a field with the given name and value or zero
+    /// \param nameIndex is set to the index of a same-name field or zero
+    uint64_t find(const SBuf &name, const SBuf &value, uint64_t &nameIndex) const;
+
+private:
+    void evictDownTo(size_t);
+
+    std::deque<HeaderField> dynamic_; ///< dynamic entries, newest first
+    size_t size_ = 0; ///< dynamic_ size according to HeaderField::size()
+    size_t maxSize_; ///< dynamic_ size limit
+};
+
+/// decodes HPACK header blocks received from the peer
+class HpackDecoder
+{
+public:
+    /// \param maxTableSize our SETTINGS_HEADER_TABLE_SIZE
+    /// \param maxListSize the maximum decoded header list size
+    HpackDecoder(size_t maxTableSize, size_t maxListSize);
+
+    /// decodes a complete header block, appending fields in received order
+    /// \returns false for malformed blocks and oversized header lists;
+    /// the decoding context is unusable after a failure
+    bool decode(const SBuf &block, HeaderFields &fields);
+
+private:
+    bool decodeLiteral(const char *&, const char *, int prefixBits, HeaderField &) const;
+
+    HpackTable table_;
+    const size_t maxTableSize_; ///< dynamic table size updates limit
+    const size_t maxListSize_; ///< decoded header list size limit
+};
+
+/// encodes HPACK header blocks sent to the peer
+class HpackEncoder
+{
+public:
+    /// how a literal field may affect the dynamic table
+    typedef enum {
+        idxIncremental, ///< added to the dynamic table
+        idxNone, ///< not added to the dynamic table
+        idxNever ///< not added by any intermediary (sensitive values)
+    } Indexing;
+
+    HpackEncoder(): table_(DefaultHeaderTableSize) {}
+
+    /// applies the peer's SETTINGS_HEADER_TABLE_SIZE
+    void setMaxTableSize(size_t);
+
+    /// starts a new header block, signaling pending table size changes
+    void startBlock(SBuf &block);
+
+    /// appends the given field representation to the header block
+    void encode(SBuf &block, const SBuf &name, const SBuf &value, Indexing);
+
+private:
+    HpackTable table_;
+
+    /// the smallest table size limit since the last startBlock(), if it
+    /// has changed since then (and zero otherwise)
+    size_t minPendingSize_ = 0;
+    bool sizeChanged_ = false; ///< whether startBlock() must signal the table size
+};
+
+/// decodes a Huffman-encoded string (RFC 7541 Section 5.2)
+/// \returns false for malformed strings
+bool HuffmanDecode(const char *raw, size_t size, SBuf &out);
+
+/// \returns the size of the Huffman-encoded string
+size_t HuffmanEncodedSize(const SBuf &);
+
+/// appends the Huffman-encoded string
+void HuffmanEncode(const SBuf &, SBuf &out);
+
+} // namespace Two
+} // namespace Http
+
+#endif /* SQUID_SRC_HTTP_TWO_HPACK_H */
+
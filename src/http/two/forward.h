@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_HTTP_TWO_FORWARD_H
+#define SQUID_SRC_HTTP_TWO_FORWARD_H
+
+namespace Http {
+namespace Two {
+
+class FrameHeader;
+class HeaderField;
+class HpackDecoder;
+class HpackEncoder;
+class HpackTable;
+class Server;
+
+} // namespace Two
+} // namespace Http
+
+namespace Http2 = Http::Two;
+
+#endif /* SQUID_SRC_HTTP_TWO_FORWARD_H */
+
@@ -148,3 +148,10 @@ size_t Kids::count() const
     return storage.size();
 }
 
+int
+Ipc::KidSlots()
+{
+    // KidIdentifier is zero in no-daemon mode and starts with one otherwise
+    return NumberOfKids() + 1;
+}
+
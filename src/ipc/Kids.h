@@ -66,5 +66,13 @@ extern Kids TheKids; ///< All kids being maintained
 
 extern SBuf TheKidName; ///< current Squid process name (e.g., "squid-coord")
 
+namespace Ipc
+{
+
+/// the number of entries in a shared memory table indexed by KidIdentifier
+int KidSlots();
+
+} // namespace Ipc
+
 #endif /* SQUID_SRC_IPC_KIDS_H */
 
@@ -10,6 +10,7 @@
 
 #include "squid.h"
 #include "base/IoManip.h"
+#include "base/Packable.h"
 #include "ipc/StoreMap.h"
 #include "sbuf/SBuf.h"
 #include "SquidConfig.h"
@@ -39,8 +40,14 @@ StoreMapFileNosId(const SBuf &path)
     return Ipc::Mem::Segment::Name(path, "filenos");
 }
 
+static SBuf
+StoreMapEvictionId(const SBuf &path)
+{
+    return Ipc::Mem::Segment::Name(path, "eviction");
+}
+
 Ipc::StoreMap::Owner *
-Ipc::StoreMap::Init(const SBuf &path, const int sliceLimit)
+Ipc::StoreMap::Init(const SBuf &path, const int sliceLimit, const EvictionPolicy policy)
 {
     assert(sliceLimit > 0); // we should not be created otherwise
     const int anchorLimit = min(sliceLimit, static_cast<int>(SwapFilenMax));
@@ -48,16 +55,24 @@ Ipc::StoreMap::Init(const SBuf &path, const int sliceLimit)
     owner->fileNos = shm_new(FileNos)(StoreMapFileNosId(path).c_str(), anchorLimit);
     owner->anchors = shm_new(Anchors)(StoreMapAnchorsId(path).c_str(), anchorLimit);
     owner->slices = shm_new(Slices)(StoreMapSlicesId(path).c_str(), sliceLimit);
-    debugs(54, 5, "created " << path << " with " << anchorLimit << '+' << sliceLimit);
+    if (policy != EvictionPolicy::hashOrder)
+        owner->eviction = shm_new(StoreMapEviction)(StoreMapEvictionId(path).c_str(), anchorLimit, policy);
+    debugs(54, 5, "created " << path << " with " << anchorLimit << '+' << sliceLimit <<
+           " and " << EvictionPolicyName(policy) << " eviction");
     return owner;
 }
 
-Ipc::StoreMap::StoreMap(const SBuf &aPath): cleaner(nullptr), path(aPath),
+Ipc::StoreMap::StoreMap(const SBuf &aPath, const EvictionPolicy policy): cleaner(nullptr), path(aPath),
     fileNos(shm_old(FileNos)(StoreMapFileNosId(path).c_str())),
     anchors(shm_old(Anchors)(StoreMapAnchorsId(path).c_str())),
     slices(shm_old(Slices)(StoreMapSlicesId(path).c_str())),
     hitValidation(true)
 {
+    if (policy != EvictionPolicy::hashOrder) {
+        eviction = shm_old(StoreMapEviction)(StoreMapEvictionId(path).c_str());
+        assert(eviction->capacity == entryLimit());
+    }
+
     debugs(54, 5, "attached " << path << " with " <<
            fileNos->capacity << '+' <<
            anchors->capacity << '+' << slices->capacity);
@@ -146,6 +161,8 @@ Ipc::StoreMap::openForWriting(const cache_key *const key, sfileno &fileno)
 
     if (Anchor *anchor = openForWritingAt(idx)) {
         fileno = idx;
+        if (eviction)
+            eviction->noteInsertion(idx, key);
         return anchor;
     }
 
@@ -489,6 +506,9 @@ Ipc::StoreMap::openForReadingAt(const sfileno fileno, const cache_key *const key
         return nullptr;
     }
 
+    if (eviction)
+        eviction->noteAccess(fileno);
+
     debugs(54, 5, "opened entry " << fileno << " for reading " << path);
     return &s;
 }
@@ -701,21 +721,73 @@ Ipc::StoreMap::visitVictims(const NameFilter visitor)
 bool
 Ipc::StoreMap::purgeOne()
 {
+    if (eviction) {
+        // Hopefully, we find a usable entry much sooner (TODO: use time?).
+        const int searchLimit = min(10000, entryLimit());
+        const auto evictor = [&](const sfileno fileno, const uint32_t tag) {
+            return purgeAt(fileno, tag);
+        };
+        if (eviction->evictOne(evictor, searchLimit))
+            return true;
+        debugs(54, 5, "no victims found in " << path);
+        return false;
+    }
+
     return visitVictims([&](const sfileno name) {
-        const sfileno fileno = fileNoByName(name);
-        Anchor &s = anchorAt(fileno);
-        if (s.lock.lockExclusive()) {
-            // the caller wants a free slice; empty anchor is not enough
-            if (!s.empty() && s.start >= 0) {
-                // this entry may be marked for deletion, and that is OK
-                freeChain(fileno, s, false);
-                debugs(54, 5, "purged entry " << fileno << " from " << path);
-                return true;
-            }
-            s.lock.unlockExclusive();
+        return purgeAt(fileNoByName(name), 0);
+    });
+}
+
+bool
+Ipc::StoreMap::purgeAt(const sfileno fileno, const uint32_t tag)
+{
+    Anchor &s = anchorAt(fileno);
+    if (s.lock.lockExclusive()) {
+        // the caller wants a free slice; empty anchor is not enough
+        if (!s.empty() && s.start >= 0 &&
+                (!tag || StoreMapEviction::Tag(reinterpret_cast<const cache_key *>(s.key)) == tag)) {
+            // this entry may be marked for deletion, and that is OK
+            freeChain(fileno, s, false);
+            debugs(54, 5, "purged entry " << fileno << " from " << path);
+            return true;
         }
+        s.lock.unlockExclusive();
+    }
+    return false;
+}
+
+bool
+Ipc::StoreMap::peekVictim(const cache_key *const key, const bool full, cache_key *victimKey) const
+{
+    // openForWriting() overwrites the entry at the key position (if any)
+    if (copyReadableKey(fileNoByKey(key), victimKey))
+        return true;
+
+    if (!full || entryLimit() <= 0)
         return false;
-    });
+
+    if (eviction) {
+        const auto fileno = eviction->nextVictim();
+        return fileno >= 0 && copyReadableKey(fileno, victimKey);
+    }
+
+    // the first victims candidate visited by the next purgeOne() call
+    const auto name = static_cast<sfileno>((anchors->victim + 1) % entryLimit());
+    return copyReadableKey(fileNoByName(name), victimKey);
+}
+
+bool
+Ipc::StoreMap::copyReadableKey(const sfileno fileno, cache_key *keyCopy) const
+{
+    const Anchor &s = anchorAt(fileno);
+    if (!s.lock.lockShared())
+        return false;
+
+    const auto readable = s.complete() && !s.waitingToBeFreed;
+    if (readable)
+        memcpy(keyCopy, s.key, sizeof(s.key));
+    s.lock.unlockShared();
+    return readable;
 }
 
 void
@@ -754,6 +826,15 @@ Ipc::StoreMap::updateStats(ReadWriteLockStats &stats) const
         anchorAt(i).lock.updateStats(stats);
 }
 
+void
+Ipc::StoreMap::packEvictionStatsInto(Packable &p) const
+{
+    if (eviction)
+        eviction->packStatsInto(p);
+    else
+        p.appendf("Replacement policy: %s\n", EvictionPolicyName(EvictionPolicy::hashOrder));
+}
+
 bool
 Ipc::StoreMap::validEntry(const int pos) const
 {
@@ -1038,7 +1119,8 @@ Ipc::StoreMapUpdate::~StoreMapUpdate()
 Ipc::StoreMap::Owner::Owner():
     fileNos(nullptr),
     anchors(nullptr),
-    slices(nullptr)
+    slices(nullptr),
+    eviction(nullptr)
 {
 }
 
@@ -1047,6 +1129,7 @@ Ipc::StoreMap::Owner::~Owner()
     delete fileNos;
     delete anchors;
     delete slices;
+    delete eviction;
 }
 
 /* Ipc::StoreMapAnchors */
@@ -12,6 +12,7 @@
 #include "ipc/mem/FlexibleArray.h"
 #include "ipc/mem/Pointer.h"
 #include "ipc/ReadWriteLock.h"
+#include "ipc/StoreMapEviction.h"
 #include "sbuf/SBuf.h"
 #include "store/forward.h"
 #include "store_key_md5.h"
@@ -237,15 +238,17 @@ public:
         FileNos::Owner *fileNos;
         Anchors::Owner *anchors;
         Slices::Owner *slices;
+        StoreMapEviction::Owner *eviction; ///< nil for EvictionPolicy::hashOrder
     private:
         Owner(const Owner &); // not implemented
         Owner &operator =(const Owner &); // not implemented
     };
 
     /// initialize shared memory
-    static Owner *Init(const SBuf &path, const int slotLimit);
+    static Owner *Init(const SBuf &path, const int slotLimit, EvictionPolicy = EvictionPolicy::hashOrder);
 
-    StoreMap(const SBuf &aPath);
+    /// attaches to the shared memory created by Init() with the same policy
+    StoreMap(const SBuf &aPath, EvictionPolicy = EvictionPolicy::hashOrder);
 
     /// computes map entry anchor position for a given entry key
     sfileno fileNoByKey(const cache_key *const key) const;
@@ -339,6 +342,13 @@ public:
     /// either finds and frees an entry with at least 1 slice or returns false
     bool purgeOne();
 
+    /// Copies the key of the readable entry that storing an entry with the
+    /// given key would displace into victimKey. That is either the entry
+    /// occupying the given key position or, if the map is full, the entry
+    /// purgeOne() would try first.
+    /// \returns whether victimKey has been set
+    bool peekVictim(const cache_key *const key, const bool full, cache_key *victimKey) const;
+
     /// validates locked hit metadata and calls freeEntry() for invalid entries
     /// \returns whether hit metadata is correct
     bool validateHit(const sfileno);
@@ -358,6 +368,9 @@ public:
     /// adds approximate current stats to the supplied ones
     void updateStats(ReadWriteLockStats &stats) const;
 
+    /// reports the replacement policy and its statistics
+    void packEvictionStatsInto(Packable &) const;
+
     StoreMapCleaner *cleaner; ///< notified before a readable entry is freed
 
 protected:
@@ -365,6 +378,7 @@ protected:
     Mem::Pointer<StoreMapFileNos> fileNos; ///< entry inodes (starting blocks)
     Mem::Pointer<StoreMapAnchors> anchors; ///< entry inodes (starting blocks)
     Mem::Pointer<StoreMapSlices> slices; ///< chained entry pieces positions
+    Mem::Pointer<StoreMapEviction> eviction; ///< entry eviction order (if not hashOrder)
 
 private:
     /// computes entry name (i.e., key hash) for a given entry key
@@ -376,6 +390,8 @@ private:
     Anchor &anchorAt(const sfileno fileno);
     const Anchor &anchorAt(const sfileno fileno) const;
     Anchor &anchorByKey(const cache_key *const key);
+    /// copies the key of the readable entry at the given position (if any)
+    bool copyReadableKey(const sfileno fileno, cache_key *keyCopy) const;
 
     Slice &sliceAt(const SliceId sliceId);
     const Slice &sliceAt(const SliceId sliceId) const;
@@ -386,6 +402,10 @@ private:
     typedef std::function<bool (const sfileno name)> NameFilter; // a "name"-based test
     bool visitVictims(const NameFilter filter);
 
+    /// purgeOne() helper: frees the entry at the given position if it is
+    /// not busy and, unless the tag is zero, still has the given key tag
+    bool purgeAt(const sfileno fileno, const uint32_t tag);
+
     void freeChain(const sfileno fileno, Anchor &inode, const bool keepLock);
     void freeChainAt(SliceId sliceId, const SliceId splicingPoint);
 
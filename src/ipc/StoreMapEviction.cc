@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 54    Interprocess Communication */
+
+#include "squid.h"
+#include "base/Packable.h"
+#include "debug/Stream.h"
+#include "ipc/StoreMapEviction.h"
+
+#include <algorithm>
+#include <cstring>
+
+bool
+Ipc::ParseEvictionPolicy(const char * const name, EvictionPolicy &policy)
+{
+    if (strcmp(name, "hash") == 0)
+        policy = EvictionPolicy::hashOrder;
+    else if (strcmp(name, "clock") == 0)
+        policy = EvictionPolicy::clock;
+    else if (strcmp(name, "s3fifo") == 0)
+        policy = EvictionPolicy::s3fifo;
+    else
+        return false;
+    return true;
+}
+
+const char *
+Ipc::EvictionPolicyName(const EvictionPolicy policy)
+{
+    switch (policy) {
+    case EvictionPolicy::hashOrder:
+        return "hash";
+    case EvictionPolicy::clock:
+        return "clock";
+    case EvictionPolicy::s3fifo:
+        return "s3fifo";
+    }
+    return "unknown"; // not reached
+}
+
+/// packs an entry position and key tag into a small queue ring slot value
+static uint64_t
+QueuedValue(const sfileno fileno, const uint32_t tag)
+{
+    return (static_cast<uint64_t>(fileno + 1) << 32) | tag;
+}
+
+/* Ipc::StoreMapEviction */
+
+Ipc::StoreMapEviction::StoreMapEviction(const int aCapacity, const EvictionPolicy aPolicy):
+    policy(aPolicy),
+    capacity(aCapacity),
+    // S3-FIFO gives 10% of the cache to the small queue; the ring has room
+    // for overflows while evictions catch up with insertions
+    smallTarget(std::max(1, aCapacity/10)),
+    smallRing(std::min(aCapacity, 2*std::max(1, aCapacity/10))),
+    hand(0),
+    smallHead(0),
+    smallTail(0),
+    evictions(0),
+    smallEvictions(0),
+    secondChances(0),
+    promotions(0),
+    ghostHits(0),
+    items(aCapacity)
+{
+}
+
+uint32_t
+Ipc::StoreMapEviction::Tag(const cache_key * const key)
+{
+    // cache keys are MD5 digests, so any of their bits will do
+    uint32_t tag;
+    memcpy(&tag, key + sizeof(uint64_t), sizeof(tag));
+    return tag ? tag : 1; // zero marks empty ghost and queue slots
+}
+
+void
+Ipc::StoreMapEviction::noteInsertion(const sfileno fileno, const cache_key * const key)
+{
+    auto &item = items[fileno];
+    item.frequency.store(0, std::memory_order_relaxed);
+
+    if (policy != EvictionPolicy::s3fifo)
+        return;
+
+    // a recently evicted entry returns directly to the main queue
+    const auto tag = Tag(key);
+    auto &ghost = items[tag % capacity].ghost;
+    auto expected = tag;
+    if (ghost.compare_exchange_strong(expected, 0, std::memory_order_relaxed)) {
+        item.probationary.store(0, std::memory_order_relaxed);
+        ++ghostHits;
+        return;
+    }
+
+    item.probationary.store(1, std::memory_order_relaxed);
+    const auto position = smallTail.fetch_add(1);
+    items[position % smallRing].queued.store(QueuedValue(fileno, tag));
+}
+
+void
+Ipc::StoreMapEviction::noteAccess(const sfileno fileno)
+{
+    auto &frequency = items[fileno].frequency;
+    auto current = frequency.load(std::memory_order_relaxed);
+    while (current < MaxFrequency && !frequency.compare_exchange_weak(current, current + 1, std::memory_order_relaxed)) {}
+}
+
+bool
+Ipc::StoreMapEviction::smallOverflows() const
+{
+    const auto tail = smallTail.load();
+    const auto head = smallHead.load();
+    return tail > head && tail - head > static_cast<uint64_t>(smallTarget);
+}
+
+bool
+Ipc::StoreMapEviction::evictOne(const Evictor &evict, const int searchLimit)
+{
+    if (policy == EvictionPolicy::s3fifo && smallOverflows())
+        return evictFromSmall(evict, searchLimit) || evictFromMain(evict, searchLimit);
+
+    if (evictFromMain(evict, searchLimit))
+        return true;
+
+    // the main CLOCK may be busy or full of popular entries
+    return policy == EvictionPolicy::s3fifo && evictFromSmall(evict, searchLimit);
+}
+
+bool
+Ipc::StoreMapEviction::evictFromSmall(const Evictor &evict, const int searchLimit)
+{
+    for (int tries = 0; tries < searchLimit; ++tries) {
+        auto head = smallHead.load();
+        const auto tail = smallTail.load();
+        if (head >= tail)
+            return false; // empty
+
+        // skip positions overwritten by enqueuing faster than we dequeue
+        if (tail - head > static_cast<uint64_t>(smallRing)) {
+            (void)smallHead.compare_exchange_weak(head, tail - smallRing);
+            continue;
+        }
+
+        if (!smallHead.compare_exchange_weak(head, head + 1))
+            continue; // another kid has dequeued that position
+
+        const auto queued = items[head % smallRing].queued.load();
+        if (!queued)
+            continue;
+        const auto fileno = static_cast<sfileno>((queued >> 32) - 1);
+        const auto tag = static_cast<uint32_t>(queued);
+        auto &item = items[fileno];
+
+        if (!item.probationary.load(std::memory_order_relaxed))
+            continue; // already promoted or evicted
+
+        // hit while probationary: keep the entry in the main queue
+        if (item.frequency.load(std::memory_order_relaxed)) {
+            item.probationary.store(0, std::memory_order_relaxed);
+            ++promotions;
+            continue;
+        }
+
+        if (evict(fileno, tag)) {
+            item.probationary.store(0, std::memory_order_relaxed);
+            items[tag % capacity].ghost.store(tag, std::memory_order_relaxed);
+            ++smallEvictions;
+            debugs(54, 7, "evicted probationary entry " << fileno);
+            return true;
+        }
+        // busy entries are left to the main CLOCK
+    }
+    return false;
+}
+
+bool
+Ipc::StoreMapEviction::evictFromMain(const Evictor &evict, const int searchLimit)
+{
+    for (int tries = 0; tries < searchLimit; ++tries) {
+        const auto fileno = static_cast<sfileno>(hand.fetch_add(1) % capacity);
+        auto &frequency = items[fileno].frequency;
+        auto current = frequency.load(std::memory_order_relaxed);
+        if (current) {
+            // a recently used entry gets another trip around the clock
+            if (frequency.compare_exchange_strong(current, current - 1, std::memory_order_relaxed))
+                ++secondChances;
+            continue;
+        }
+
+        if (evict(fileno, 0)) {
+            ++evictions;
+            debugs(54, 7, "evicted entry " << fileno);
+            return true;
+        }
+    }
+    return false;
+}
+
+sfileno
+Ipc::StoreMapEviction::nextVictim()
+{
+    if (policy == EvictionPolicy::s3fifo && smallOverflows()) {
+        const auto head = smallHead.load();
+        if (const auto queued = items[head % smallRing].queued.load()) {
+            const auto fileno = static_cast<sfileno>((queued >> 32) - 1);
+            const auto &item = items[fileno];
+            if (item.probationary.load(std::memory_order_relaxed) && !item.frequency.load(std::memory_order_relaxed))
+                return fileno;
+        }
+    }
+
+    // the first entry the main CLOCK would not give a second chance to
+    const auto start = hand.load();
+    const auto searchLimit = std::min(capacity, 64);
+    for (int offset = 0; offset < searchLimit; ++offset) {
+        const auto fileno = static_cast<sfileno>((start + offset) % capacity);
+        if (!items[fileno].frequency.load(std::memory_order_relaxed))
+            return fileno;
+    }
+    return -1;
+}
+
+void
+Ipc::StoreMapEviction::packStatsInto(Packable &p) const
+{
+    p.appendf("Replacement policy: %s\n", EvictionPolicyName(policy));
+    p.appendf("Evicted entries: %" PRIu64 "\n", evictions.load() + smallEvictions.load());
+    p.appendf("CLOCK second chances: %" PRIu64 "\n", secondChances.load());
+    if (policy == EvictionPolicy::s3fifo) {
+        const auto tail = smallTail.load();
+        const auto head = smallHead.load();
+        // the ring forgets the oldest entries when insertions outpace evictions
+        const auto queued = tail > head ? std::min(tail - head, static_cast<uint64_t>(smallRing)) : 0;
+        p.appendf("Small queue entries: %" PRIu64 " of %d\n", queued, smallTarget);
+        p.appendf("Small queue evictions: %" PRIu64 "\n", smallEvictions.load());
+        p.appendf("Small queue promotions: %" PRIu64 "\n", promotions.load());
+        p.appendf("Ghost hits: %" PRIu64 "\n", ghostHits.load());
+    }
+}
+
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_IPC_STOREMAPEVICTION_H
+#define SQUID_SRC_IPC_STOREMAPEVICTION_H
+
+#include "ipc/forward.h"
+#include "ipc/mem/FlexibleArray.h"
+#include "ipc/mem/Pointer.h"
+#include "store/forward.h"
+
+#include <atomic>
+#include <functional>
+
+class Packable;
+
+namespace Ipc
+{
+
+/// the order in which a StoreMap-based cache evicts its entries
+enum class EvictionPolicy : uint8_t {
+    hashOrder = 0, ///< the next entry in the key hash order (nearly random)
+    clock, ///< CLOCK with 2-bit access frequencies
+    s3fifo ///< S3-FIFO: small probationary FIFO, main CLOCK, and ghost keys
+};
+
+/// converts eviction policy configuration name to EvictionPolicy
+/// \returns false for unknown names
+bool ParseEvictionPolicy(const char *name, EvictionPolicy &);
+
+/// the configuration name of the given eviction policy
+const char *EvictionPolicyName(EvictionPolicy);
+
+/// eviction metadata for a single StoreMap entry position; some members
+/// serve as the storage for policy-wide structures indexed the same way
+class StoreMapEvictionItem
+{
+public:
+    StoreMapEvictionItem(): frequency(0), probationary(0), ghost(0), queued(0) {}
+
+    /// entry hits since insertion or since the last CLOCK second chance
+    std::atomic<uint8_t> frequency;
+
+    /// whether the entry was inserted into the S3-FIFO small queue and has
+    /// not been promoted or evicted since
+    std::atomic<uint8_t> probationary;
+
+    /// a key tag of a recently evicted probationary entry (or zero);
+    /// a slot of the S3-FIFO ghost table
+    std::atomic<uint32_t> ghost;
+
+    /// a queued entry position and key tag (or zero);
+    /// a slot of the S3-FIFO small queue ring
+    std::atomic<uint64_t> queued;
+};
+
+/// Shared eviction state of a StoreMap: Per-entry access frequencies plus
+/// the policy-specific structures. All methods are safe to call from
+/// multiple kids concurrently without locking; the eviction callback is
+/// responsible for locking and validating the entry being evicted.
+class StoreMapEviction
+{
+public:
+    typedef Ipc::Mem::Owner<StoreMapEviction> Owner;
+
+    /// Frees the entry at the given position if it is not busy and, unless
+    /// the tag is zero, still has the given key tag.
+    /// \returns whether the entry was freed
+    using Evictor = std::function<bool (sfileno, uint32_t tag)>;
+
+    StoreMapEviction(int aCapacity, EvictionPolicy);
+
+    size_t sharedMemorySize() const { return SharedMemorySize(capacity); }
+    static size_t SharedMemorySize(const int aCapacity, EvictionPolicy = EvictionPolicy::hashOrder) { return sizeof(StoreMapEviction) + aCapacity*sizeof(StoreMapEvictionItem); }
+
+    /// the nonzero key tag used to validate queued and ghost entries
+    static uint32_t Tag(const cache_key *);
+
+    /// an entry with the given key is being stored at the given position
+    void noteInsertion(sfileno, const cache_key *);
+
+    /// the entry at the given position has been read
+    void noteAccess(sfileno);
+
+    /// frees one entry, trying at most searchLimit candidates
+    /// \returns whether an entry was freed
+    bool evictOne(const Evictor &, int searchLimit);
+
+    /// the position of the entry evictOne() is likely to free next
+    /// \returns -1 if no likely victim has been found
+    sfileno nextVictim();
+
+    /// reports policy statistics
+    void packStatsInto(Packable &) const;
+
+    const EvictionPolicy policy; ///< the eviction algorithm
+    const int capacity; ///< the number of StoreMap entry positions
+    const int smallTarget; ///< the desired maximum S3-FIFO small queue size
+    const int smallRing; ///< the number of S3-FIFO small queue ring slots
+
+    std::atomic<uint64_t> hand; ///< the next CLOCK position (modulo capacity)
+    std::atomic<uint64_t> smallHead; ///< the next small queue position to dequeue
+    std::atomic<uint64_t> smallTail; ///< the next small queue position to enqueue
+
+    /* statistics */
+    std::atomic<uint64_t> evictions; ///< entries freed by the main CLOCK
+    std::atomic<uint64_t> smallEvictions; ///< entries freed from the small queue
+    std::atomic<uint64_t> secondChances; ///< CLOCK frequency decrements
+    std::atomic<uint64_t> promotions; ///< small queue entries moved to main
+    std::atomic<uint64_t> ghostHits; ///< insertions of recently evicted keys
+
+    Ipc::Mem::FlexibleArray<StoreMapEvictionItem> items; ///< per-position metadata
+
+private:
+    /// the saturation limit for StoreMapEvictionItem::frequency
+    static const uint8_t MaxFrequency = 3;
+
+    bool evictFromSmall(const Evictor &, int searchLimit);
+    bool evictFromMain(const Evictor &, int searchLimit);
+
+    /// whether the small queue has grown beyond its target size
+    bool smallOverflows() const;
+};
+
+} // namespace Ipc
+
+#endif /* SQUID_SRC_IPC_STOREMAPEVICTION_H */
+
@@ -11,9 +11,12 @@
 #ifndef SQUID_SRC_IPC_FORWARD_H
 #define SQUID_SRC_IPC_FORWARD_H
 
+#include <cstdint>
+
 namespace Ipc
 {
 
+enum class EvictionPolicy : uint8_t;
 class Forwarder;
 class Inquirer;
 class QuestionerId;
@@ -1371,14 +1371,23 @@ RegisterModules()
     // RegisteredRunner event handlers should not depend on handler call order
     // and, hence, should not depend on the registration call order below.
 
+    CallRunnerRegistrator(AdmissionRr);
     CallRunnerRegistrator(CarpRr);
     CallRunnerRegistrator(ClientDbRr);
     CallRunnerRegistrator(CollapsedForwardingRr);
     CallRunnerRegistrator(MemStoreRr);
+    CallRunnerRegistrator(PeerHashRingRr);
     CallRunnerRegistrator(PeerPoolMgrsRr);
     CallRunnerRegistrator(PeerSourceHashRr);
+    CallRunnerRegistrator(RangeCacheRr);
+    CallRunnerRegistrator(RefreshRulesRr);
+    CallRunnerRegistrator(SessionResumptionRr);
+    CallRunnerRegistrator(SharedClientDbRr);
+    CallRunnerRegistrator(SharedHelperResultsRr);
     CallRunnerRegistrator(SharedMemPagesRr);
     CallRunnerRegistrator(SharedSessionCacheRr);
+    CallRunnerRegistrator(SharedStatCountersRr);
+    CallRunnerRegistrator(TransactionTraceRr);
     CallRunnerRegistrator(TransientsRr);
     CallRunnerRegistratorIn(Dns, ConfigRr);
 
@@ -1393,6 +1402,9 @@ RegisterModules()
 #if USE_AUTH
     CallRunnerRegistrator(PeerUserHashRr);
 #endif
+#if ICAP_CLIENT
+    CallRunnerRegistrator(IcapSharedServicesRr);
+#endif
 #if USE_HTCP
     CallRunnerRegistrator(HtcpRr);
 #endif
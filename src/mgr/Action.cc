@@ -66,6 +66,8 @@ Mgr::Action::contentType() const
         return "application/yaml;charset=utf-8";
     case Format::informal:
         return "text/plain;charset=utf-8";
+    case Format::openMetrics:
+        return "application/openmetrics-text;version=1.0.0;charset=utf-8";
     }
     assert(!"unreachable code");
     return "";
@@ -148,6 +150,8 @@ Mgr::OpenKidSection(StoreEntry * const entry, const Format format)
         return storeAppendPrintf(entry, "---\nkid: %d\n", KidIdentifier);
     case Format::informal:
         return storeAppendPrintf(entry, "by kid%d {\n", KidIdentifier);
+    case Format::openMetrics:
+        return; // samples carry kid labels instead
     }
     // unreachable code
 }
@@ -160,6 +164,8 @@ Mgr::CloseKidSection(StoreEntry * const entry, const Format format)
         return storeAppendPrintf(entry, "...\n");
     case Format::informal:
         return storeAppendPrintf(entry, "} by kid%d\n\n", KidIdentifier);
+    case Format::openMetrics:
+        return;
     }
     // unreachable code
 }
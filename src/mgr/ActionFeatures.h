@@ -27,7 +27,12 @@ enum class Protected { no, yes };
 enum class Atomic { no, yes };
 
 /// whether Action report uses valid YAML or unspecified/legacy formatting
-enum class Format { informal, yaml };
+/// or OpenMetrics text exposition format
+enum class Format { informal, yaml, openMetrics };
+
+/// whether Action report covers just the kid producing it or, when built
+/// from shared memory, all kids (without asking other kids to contribute)
+enum class Scope { kid, allKids };
 
 } // namespace Mgr
 
@@ -29,11 +29,13 @@ public:
                   ActionCreatorPointer aCreator,
                   const Protected aProtected,
                   const Atomic anAtomic,
-                  const Format aFormat):
+                  const Format aFormat,
+                  const Scope aScope):
         name(aName), desc(aDesc),
         isPwReq(aProtected == Protected::yes),
         isAtomic(anAtomic == Atomic::yes),
         format(aFormat),
+        coversAllKids(aScope == Scope::allKids),
         creator(aCreator) {
     }
 
@@ -43,6 +45,7 @@ public:
     bool isPwReq; ///< whether password is required to perform the action
     bool isAtomic; ///< whether action dumps everything in one dump() call
     Format format; ///< action report syntax
+    bool coversAllKids; ///< whether any kid reports on all kids without SMP fan-out
     ActionCreatorPointer creator; ///< creates Action objects with this profile
 };
 
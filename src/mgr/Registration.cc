@@ -55,12 +55,13 @@ Mgr::RegisterAction(char const * action, char const * desc,
                     OBJH * handler,
                     const Protected protection,
                     const Atomic atomicity,
-                    const Format format)
+                    const Format format,
+                    const Scope scope)
 {
     debugs(16, 3, "function-based " << action);
     const auto profile = ActionProfile::Pointer::Make(action,
                          desc, new FunActionCreator(handler),
-                         protection, atomicity, format);
+                         protection, atomicity, format, scope);
     CacheManager::GetInstance()->registerProfile(profile);
 }
 
@@ -69,12 +70,13 @@ Mgr::RegisterAction(char const * action, char const * desc,
                     ClassActionCreationHandler *handler,
                     const Protected protection,
                     const Atomic atomicity,
-                    const Format format)
+                    const Format format,
+                    const Scope scope)
 {
     debugs(16, 3, "class-based " << action);
     const auto profile = ActionProfile::Pointer::Make(action,
                          desc, new ClassActionCreator(handler),
-                         protection, atomicity, format);
+                         protection, atomicity, format, scope);
     CacheManager::GetInstance()->registerProfile(profile);
 }
 
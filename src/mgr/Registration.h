@@ -21,7 +21,7 @@ namespace Mgr
 /// collection (once across all calls with the same action name).
 void RegisterAction(char const * action, char const * desc,
                     OBJH * handler,
-                    Protected, Atomic, Format);
+                    Protected, Atomic, Format, Scope = Scope::kid);
 
 /// wrapper for legacy Format-unaware function-based action registration code
 inline void
@@ -39,7 +39,7 @@ RegisterAction(const char * const action, const char * const desc,
 /// collection (once across all calls with the same action name).
 void RegisterAction(char const * action, char const * desc,
                     ClassActionCreationHandler *handler,
-                    Protected, Atomic, Format);
+                    Protected, Atomic, Format, Scope = Scope::kid);
 
 /// wrapper for legacy Format-unaware class-based action registration code
 inline void
@@ -241,7 +241,7 @@ peerHasConnAvailable(const CachePeer *p)
 void
 peerConnClosed(CachePeer *p)
 {
-    --p->stats.conn_open;
+    p->noteConnectionClosed();
     if (p->standby.waitingForClose && peerCanOpenMore(p)) {
         p->standby.waitingForClose = false;
         PeerPoolMgr::Checkpoint(p->standby.mgr, "conn closed");
@@ -1487,6 +1487,9 @@ dump_peer_options(StoreEntry * sentry, CachePeer * p)
     if (p->options.originserver)
         os << " originserver";
 
+    if (p->options.http2)
+        os << " http2";
+
     if (p->domain)
         os << " forceddomain=" << p->domain;
 
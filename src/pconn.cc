@@ -12,6 +12,7 @@
 #include "base/IoManip.h"
 #include "base/PackableStream.h"
 #include "CachePeer.h"
+#include "clients/Http2Session.h"
 #include "comm.h"
 #include "comm/Connection.h"
 #include "comm/Read.h"
@@ -304,9 +305,12 @@ IdleConnList::findAndClose(const Comm::ConnectionPointer &conn)
         if (parent_)
             parent_->notifyManager("idle conn closure");
         clearHandlers(conn);
+        const auto callback = idleClosureCallback_; // removeAt() may delete us
         /* might delete this */
         removeAt(index);
         conn->close();
+        if (callback)
+            callback();
     }
 }
 
@@ -519,6 +523,13 @@ PconnPool::popStored(const Comm::ConnectionPointer &dest, const char *domain, co
     return Comm::ConnectionPointer();
 }
 
+int
+PconnPool::count(const Comm::ConnectionPointer &dest, const char *domain) const
+{
+    const auto list = static_cast<const IdleConnList *>(hash_lookup(table, key(dest, domain)));
+    return list ? list->count() : 0;
+}
+
 void
 PconnPool::notifyManager(const char *reason)
 {
@@ -610,6 +621,7 @@ PconnModule::dump(std::ostream &yaml)
 {
     for (const auto &p: pools)
         p->dump(yaml);
+    Http::Two::Session::Dump(yaml);
 }
 
 void
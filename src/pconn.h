@@ -13,6 +13,7 @@
 #include "base/RunnersRegistry.h"
 #include "mgr/forward.h"
 
+#include <functional>
 #include <set>
 #include <iosfwd>
 
@@ -64,6 +65,11 @@ public:
 
     void closeN(size_t count);
 
+    /// Sets a function to call after an idle connection times out or is
+    /// closed by the peer. Lists without a parent pool may use it to keep
+    /// their connection accounting current.
+    void onIdleClosure(const std::function<void()> &callback) { idleClosureCallback_ = callback; }
+
     // IndependentRunner API
     void endingShutdown() override;
 private:
@@ -94,6 +100,9 @@ private:
      */
     PconnPool *parent_;
 
+    /// the onIdleClosure() callback (if any)
+    std::function<void()> idleClosureCallback_;
+
     char fakeReadBuf_[4096]; // TODO: kill magic number.
 };
 
@@ -142,6 +151,8 @@ public:
     /// closes any n connections, regardless of their destination
     void closeN(int n);
     int count() const { return theCount; }
+    /// the number of idle connections to the given destination
+    int count(const Comm::ConnectionPointer &dest, const char *domain) const;
     void noteConnectionAdded() { ++theCount; }
     void noteConnectionRemoved() { assert(theCount > 0); --theCount; }
 
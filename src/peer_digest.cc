@@ -41,14 +41,16 @@ static STCB peerDigestHandleReply;
 static int peerDigestFetchReply(void *, char *, ssize_t);
 int peerDigestSwapInCBlock(void *, char *, ssize_t);
 int peerDigestSwapInMask(void *, char *, ssize_t);
+static int peerDigestSwapInDelta(void *, char *, ssize_t);
 static int peerDigestFetchedEnough(DigestFetchState * fetch, char *buf, ssize_t size, const char *step_name);
 static void finishAndDeleteFetch(DigestFetchState *, const char *reason, bool sawError);
 static void peerDigestFetchSetStats(DigestFetchState * fetch);
 static int peerDigestSetCBlock(PeerDigest * pd, const char *buf);
+static const char *peerDigestSetDeltaCBlock(DigestFetchState *, const char *buf);
 static int peerDigestUseful(const PeerDigest * pd);
 
 /* local constants */
-Version const CacheDigestVer = { 5, 3 };
+Version const CacheDigestVer = { 6, 3 };
 
 #define StoreDigestCBlockSize sizeof(StoreDigestCBlock)
 
@@ -81,6 +83,10 @@ DigestFetchState::DigestFetchState(PeerDigest *aPd, HttpRequest *req) :
     request(req),
     offset(0),
     mask_offset(0),
+    delta(false),
+    deltaSize(0),
+    deltaOffset(0),
+    deltaGeneration(0),
     start_time(squid_curtime),
     resp_time(0),
     expires(0),
@@ -234,12 +240,17 @@ peerDigestRequest(PeerDigest * pd)
     pd->req_result = nullptr;
     pd->flags.requested = true;
 
+    // Fetch changes to our digest copy if the peer supports deltas. We do not
+    // know where to get deltas of digests with custom URLs.
+    const auto delta = pd->cd && pd->generation && !pd->flags.needsFull && !p->digest_url;
+    pd->flags.needsFull = false;
+
     /* compute future request components */
 
     if (p->digest_url)
         url = xstrdup(p->digest_url);
     else
-        url = xstrdup(internalRemoteUri(p->secure.encryptTransport, p->host, p->http_port, "/squid-internal-periodic/", SBuf(StoreDigestFileName)));
+        url = xstrdup(internalRemoteUri(p->secure.encryptTransport, p->host, p->http_port, "/squid-internal-periodic/", SBuf(delta ? StoreDigestDeltaFileName : StoreDigestFileName)));
     debugs(72, 2, url);
 
     const auto mx = MasterXaction::MakePortless<XactionInitiator::initCacheDigest>();
@@ -264,6 +275,7 @@ peerDigestRequest(PeerDigest * pd)
     }
     /* create fetch state structure */
     DigestFetchState *fetch = new DigestFetchState(pd, req);
+    fetch->delta = delta;
 
     /* update timestamps */
     pd->times.requested = squid_curtime;
@@ -381,6 +393,10 @@ peerDigestHandleReply(void *data, StoreIOBuffer receivedData)
             retsize = peerDigestSwapInMask(fetch, fetch->buf, fetch->bufofs);
             break;
 
+        case DIGEST_READ_DELTA:
+            retsize = peerDigestSwapInDelta(fetch, fetch->buf, fetch->bufofs);
+            break;
+
         case DIGEST_READ_NONE:
             break;
 
@@ -498,6 +514,11 @@ peerDigestFetchReply(void *data, char *buf, ssize_t size)
             }
 
             fetch->state = DIGEST_READ_CBLOCK;
+        } else if (fetch->delta) {
+            // the peer has no delta for us; keep using our old digest copy
+            pd->flags.needsFull = true;
+            finishAndDeleteFetch(fetch, "no digest delta", false);
+            return -1;
         } else {
             /* some kind of a bug */
             finishAndDeleteFetch(fetch, reply.sline.reason(), true);
@@ -524,6 +545,23 @@ peerDigestSwapInCBlock(void *data, char *buf, ssize_t size)
         assert(pd);
         assert(fetch->entry->mem_obj);
 
+        if (fetch->delta) {
+            if (const auto problem = peerDigestSetDeltaCBlock(fetch, buf)) {
+                // our old digest copy is still intact and usable
+                pd->flags.needsFull = true;
+                finishAndDeleteFetch(fetch, problem, false);
+                return -1;
+            }
+
+            fetch->state = DIGEST_READ_DELTA;
+            if (!fetch->deltaSize) {
+                pd->generation = fetch->deltaGeneration;
+                assert(peerDigestFetchedEnough(fetch, nullptr, 0, "peerDigestSwapInCBlock"));
+                return -1;
+            }
+            return StoreDigestCBlockSize;
+        }
+
         if (peerDigestSetCBlock(pd, buf)) {
             /* XXX: soon we will have variable header size */
             /* switch to CD buffer and fetch digest guts */
@@ -585,6 +623,44 @@ peerDigestSwapInMask(void *data, char *buf, ssize_t size)
     return size;
 }
 
+/// applies toggled bit positions of a digest delta to our digest copy
+static int
+peerDigestSwapInDelta(void *data, char *buf, ssize_t size)
+{
+    DigestFetchState *fetch = (DigestFetchState *)data;
+    const auto pd = fetch->pd.get();
+    assert(pd);
+    assert(pd->cd && pd->cd->mask);
+    assert(fetch->delta);
+
+    if (peerDigestFetchedEnough(fetch, buf, size, "peerDigestSwapInDelta"))
+        return -1;
+
+    const uint64_t bitCount = static_cast<uint64_t>(pd->cd->mask_size) * 8;
+    ssize_t consumed = 0;
+    while (size - consumed >= static_cast<ssize_t>(sizeof(uint32_t)) && fetch->deltaOffset < fetch->deltaSize) {
+        uint32_t position = 0;
+        memcpy(&position, buf + consumed, sizeof(position));
+        position = ntohl(position);
+        if (position >= bitCount) {
+            finishAndDeleteFetch(fetch, "digest delta bit position out of range", true);
+            return -1;
+        }
+        pd->cd->mask[position >> 3] ^= (1 << (position & 7));
+        consumed += sizeof(position);
+        ++fetch->deltaOffset;
+    }
+
+    if (fetch->deltaOffset >= fetch->deltaSize) {
+        debugs(72, 2, "applied " << fetch->deltaSize << " changes to " << pd->host << " digest");
+        pd->generation = fetch->deltaGeneration;
+        assert(peerDigestFetchedEnough(fetch, nullptr, 0, "peerDigestSwapInDelta"));
+        return -1;
+    }
+
+    return consumed;
+}
+
 static int
 peerDigestFetchedEnough(DigestFetchState * fetch, char *, ssize_t size, const char *step_name)
 {
@@ -621,7 +697,7 @@ peerDigestFetchedEnough(DigestFetchState * fetch, char *, ssize_t size, const ch
     if (!reason && !size && fetch->state != DIGEST_READ_REPLY) {
         if (!pd->cd)
             reason = "null digest?!";
-        else if (fetch->mask_offset != pd->cd->mask_size)
+        else if (fetch->delta ? fetch->deltaOffset != fetch->deltaSize : fetch->mask_offset != pd->cd->mask_size)
             reason = "premature end of digest?!";
         else if (!peerDigestUseful(pd))
             reason = "useless digest";
@@ -678,6 +754,7 @@ PeerDigest::noteFetchFinished(const DigestFetchState &finishedFetch, const char
         peerDigestSetCheck(pd, pd->times.retry_delay);
         delete pd->cd;
         pd->cd = nullptr;
+        pd->generation = 0;
 
         pd->flags.usable = false;
     } else {
@@ -687,6 +764,9 @@ PeerDigest::noteFetchFinished(const DigestFetchState &finishedFetch, const char
 
         /* XXX: ugly condition, but how? */
 
+        if (fetch->delta && fetch->deltaOffset == fetch->deltaSize && fetch->deltaGeneration)
+            ++pd->stats.deltas;
+
         if (fetch->entry->store_status == STORE_OK)
             debugs(72, 2, "reused old digest from " << host);
         else
@@ -746,6 +826,7 @@ peerDigestSetCBlock(PeerDigest * pd, const char *buf)
     cblock.count = ntohl(cblock.count);
     cblock.del_count = ntohl(cblock.del_count);
     cblock.mask_size = ntohl(cblock.mask_size);
+    cblock.generation = ntohl(cblock.generation);
     debugs(72, 2, "got digest cblock from " << host << "; ver: " <<
            (int) cblock.ver.current << " (req: " << (int) cblock.ver.required <<
            ")");
@@ -820,9 +901,59 @@ peerDigestSetCBlock(PeerDigest * pd, const char *buf)
     /* these assignments leave us in an inconsistent state until we finish reading the digest */
     pd->cd->count = cblock.count;
     pd->cd->del_count = cblock.del_count;
+    // older peers do not send generations and, hence, deltas
+    pd->generation = cblock.ver.current >= 6 ? cblock.generation : 0;
     return 1;
 }
 
+/// validates a digest delta control block against our digest copy
+/// \returns nil if the delta applies to our digest copy or the problem description
+static const char *
+peerDigestSetDeltaCBlock(DigestFetchState *fetch, const char *buf)
+{
+    const auto pd = fetch->pd.get();
+    assert(pd && pd->cd);
+
+    StoreDigestCBlock cblock;
+    memcpy(&cblock, buf, sizeof(cblock));
+    cblock.ver.current = ntohs(cblock.ver.current);
+    cblock.ver.required = ntohs(cblock.ver.required);
+    cblock.capacity = ntohl(cblock.capacity);
+    cblock.count = ntohl(cblock.count);
+    cblock.del_count = ntohl(cblock.del_count);
+    cblock.mask_size = ntohl(cblock.mask_size);
+    cblock.generation = ntohl(cblock.generation);
+    cblock.delta_base = ntohl(cblock.delta_base);
+    cblock.delta_size = ntohl(cblock.delta_size);
+
+    debugs(72, 2, "got digest delta cblock from " << pd->host << "; generations: " <<
+           cblock.delta_base << " -> " << cblock.generation << "; changes: " << cblock.delta_size);
+
+    if (cblock.ver.required > CacheDigestVer.current)
+        return "unsupported digest delta version";
+
+    if (cblock.ver.current < 6 || !cblock.delta_base || !cblock.generation)
+        return "not a digest delta";
+
+    if (cblock.delta_base != pd->generation)
+        return "digest delta for another digest generation";
+
+    if (cblock.mask_size != static_cast<int>(pd->cd->mask_size) ||
+            cblock.bits_per_entry != pd->cd->bits_per_entry ||
+            cblock.capacity != static_cast<int>(pd->cd->capacity))
+        return "digest delta for another digest size";
+
+    if (cblock.delta_size < 0)
+        return "corrupted digest delta cblock";
+
+    fetch->deltaSize = cblock.delta_size;
+    fetch->deltaOffset = 0;
+    fetch->deltaGeneration = cblock.generation;
+    pd->cd->count = cblock.count;
+    pd->cd->del_count = cblock.del_count;
+    return nullptr;
+}
+
 static int
 peerDigestUseful(const PeerDigest * pd)
 {
@@ -876,12 +1007,14 @@ peerDigestStatsReport(const PeerDigest * pd, StoreEntry * e)
                       (int) pd->times.req_delay);
     storeAppendPrintf(e, "\tlast request result: %s\n",
                       pd->req_result ? pd->req_result : "(none)");
+    storeAppendPrintf(e, "\tdigest generation: %d\n", pd->generation);
 
     storeAppendPrintf(e, "\npeer digest traffic:\n");
     storeAppendPrintf(e, "\trequests sent: %d, volume: %d KB\n",
                       pd->stats.sent.msgs, (int) pd->stats.sent.kbytes.kb);
     storeAppendPrintf(e, "\treplies recv:  %d, volume: %d KB\n",
                       pd->stats.recv.msgs, (int) pd->stats.recv.kbytes.kb);
+    storeAppendPrintf(e, "\tdeltas applied: %d\n", pd->stats.deltas);
 
     storeAppendPrintf(e, "\npeer digest structure:\n");
 
@@ -37,6 +37,7 @@
 #include "SquidConfig.h"
 #include "Store.h"
 #include "time/gadgets.h"
+#include "TransactionTrace.h"
 
 /**
  * A CachePeer which has been selected as a possible destination.
@@ -314,6 +315,8 @@ peerSelect(PeerSelectionInitiator *initiator,
 
     selector->entry = entry;
 
+    request->masterXaction->phases.start(TransactionPhases::peerSelection);
+
 #if USE_CACHE_DIGESTS
 
     request->hier.peer_select_start = current_time;
@@ -408,6 +411,8 @@ PeerSelector::resolveSelected()
     if (selectionAborted())
         return;
 
+    request->masterXaction->phases.stop(TransactionPhases::peerSelection);
+
     FwdServer *fs = servers;
 
     // Bug 3243: CVE 2009-0801
@@ -452,6 +457,7 @@ PeerSelector::resolveSelected()
         // send the next one off for DNS lookup.
         const char *host = fs->_peer.valid() ? fs->_peer->host : request->url.host();
         debugs(44, 2, "Find IP destination for: " << url() << "' via " << host);
+        request->masterXaction->phases.start(TransactionPhases::dns);
         Dns::nbgethostbyname(host, this);
         return;
     }
@@ -499,6 +505,8 @@ PeerSelector::noteLookup(const Dns::LookupDetails &details)
     if (selectionAborted())
         return;
 
+    TransactionTrace::Note(request->masterXaction, TransactionTrace::Milestone::resolved);
+
     if (!wantsMoreDestinations())
         return;
 
@@ -537,6 +545,8 @@ PeerSelector::noteIps(const Dns::CachedIps *ia, const Dns::LookupDetails &detail
     if (selectionAborted())
         return;
 
+    request->masterXaction->phases.stop(TransactionPhases::dns);
+
     FwdServer *fs = servers;
     if (!ia) {
         debugs(44, 3, "Unknown host: " << (fs->_peer.valid() ? fs->_peer->host : request->url.host()));
@@ -16,6 +16,7 @@
 #include "mgr/Registration.h"
 #include "neighbors.h"
 #include "peer_sourcehash.h"
+#include "PeerHashRing.h"
 #include "PeerSelectState.h"
 #include "SquidConfig.h"
 #include "Store.h"
@@ -32,6 +33,14 @@ SourceHashPeers()
     return *hashPeers;
 }
 
+/// sourcehash peers placed on a consistent hashing ring (if enabled)
+static auto &
+SourceHashRing()
+{
+    static const auto hashRing = new PeerHashRing();
+    return *hashRing;
+}
+
 static OBJH peerSourceHashCachemgr;
 static void peerSourceHashRegisterWithCacheManager(void);
 
@@ -52,6 +61,7 @@ peerSourceHashInit(void)
     /* Clean up */
 
     SourceHashPeers().clear();
+    SourceHashRing().clear();
     /* find out which peers we have */
 
     RawCachePeers rawSourceHashPeers;
@@ -76,6 +86,9 @@ peerSourceHashInit(void)
     if (rawSourceHashPeers.empty())
         return;
 
+    if (PeerHashRing::Enabled("sourcehash"))
+        SourceHashRing().reset(rawSourceHashPeers);
+
     /* calculate hashes and load factors */
     for (const auto &p: rawSourceHashPeers) {
         /* calculate this peers hash */
@@ -166,6 +179,9 @@ peerSourceHashSelectParent(PeerSelector *ps)
 
     key = request->client_addr.toStr(ntoabuf, sizeof(ntoabuf));
 
+    if (!SourceHashRing().empty())
+        return SourceHashRing().select(SBuf(key), ps);
+
     /* calculate hash key */
     debugs(39, 2, "peerSourceHashSelectParent: Calculating hash for " << key);
 
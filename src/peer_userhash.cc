@@ -21,6 +21,7 @@
 #include "mgr/Registration.h"
 #include "neighbors.h"
 #include "peer_userhash.h"
+#include "PeerHashRing.h"
 #include "PeerSelectState.h"
 #include "SquidConfig.h"
 #include "Store.h"
@@ -37,6 +38,14 @@ UserHashPeers()
     return *hashPeers;
 }
 
+/// userhash peers placed on a consistent hashing ring (if enabled)
+static auto &
+UserHashRing()
+{
+    static const auto hashRing = new PeerHashRing();
+    return *hashRing;
+}
+
 static OBJH peerUserHashCachemgr;
 static void peerUserHashRegisterWithCacheManager(void);
 
@@ -57,6 +66,7 @@ peerUserHashInit(void)
     /* Clean up */
 
     UserHashPeers().clear();
+    UserHashRing().clear();
     /* find out which peers we have */
 
     peerUserHashRegisterWithCacheManager();
@@ -81,6 +91,9 @@ peerUserHashInit(void)
     if (rawUserHashPeers.empty())
         return;
 
+    if (PeerHashRing::Enabled("userhash"))
+        UserHashRing().reset(rawUserHashPeers);
+
     /* calculate hashes and load factors */
     for (const auto &p: rawUserHashPeers) {
         /* calculate this peers hash */
@@ -174,6 +187,9 @@ peerUserHashSelectParent(PeerSelector *ps)
     if (!key)
         return nullptr;
 
+    if (!UserHashRing().empty())
+        return UserHashRing().select(SBuf(key), ps);
+
     /* calculate hash key */
     debugs(39, 2, "peerUserHashSelectParent: Calculating hash for " << key);
 
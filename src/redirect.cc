@@ -365,6 +365,8 @@ redirectInit(void)
         if (Config.onUrlRewriteTimeout.action == toutActUseConfiguredResponse)
             redirectors->onTimedOutResponse.assign(Config.onUrlRewriteTimeout.response);
 
+        redirectors->resultCache.configure(Config.urlRewriteCache.ttl, Config.urlRewriteCache.size, Config.Program.redirect);
+
         redirectors->openSessions();
     }
 
@@ -386,6 +388,8 @@ redirectInit(void)
 
         storeIds->retryBrokenHelper = true; // XXX: make this configurable ?
 
+        storeIds->resultCache.configure(Config.storeIdCache.ttl, Config.storeIdCache.size, Config.Program.store_id);
+
         storeIds->openSessions();
     }
 
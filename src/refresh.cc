@@ -14,6 +14,8 @@
 
 #include "squid.h"
 #include "base/PackableStream.h"
+#include "base/RunnersRegistry.h"
+#include "base/TextException.h"
 #include "HttpHdrCc.h"
 #include "HttpReply.h"
 #include "HttpRequest.h"
@@ -25,6 +27,9 @@
 #include "Store.h"
 #include "util.h"
 
+#include <memory>
+#include <vector>
+
 typedef enum {
     rcHTTP,
     rcICP,
@@ -62,6 +67,7 @@ enum {
     FRESH_MIN_RULE,
     FRESH_OVERRIDE_EXPIRES,
     FRESH_OVERRIDE_LASTMOD,
+    FRESH_STALE_WHILE_REVALIDATE,
     STALE_MUST_REVALIDATE = 200,
     STALE_RELOAD_INTO_IMS,
     STALE_FORCED_RELOAD,
@@ -70,6 +76,7 @@ enum {
     STALE_MAX_RULE,
     STALE_LMFACTOR_RULE,
     STALE_MAX_STALE,
+    STALE_BACKGROUND_REFRESH,
     STALE_DEFAULT = 299
 };
 
@@ -84,6 +91,150 @@ static int refreshStaleness(const StoreEntry * entry, time_t check_time, const t
 
 static RefreshPattern DefaultRefresh(nullptr);
 
+/// Finds the first refresh_pattern rule matching a URL. Consecutive rules
+/// are combined into large regular expressions, one per group of rules, so
+/// that a URL is only tested against individual rules of the first group
+/// with a match. The idea is borrowed from ACLRegexData.
+class RefreshRulesMatcher
+{
+public:
+    explicit RefreshRulesMatcher(const RefreshPattern *rules);
+
+    /// the first rule matching the given URL or nil
+    const RefreshPattern *match(const char *url) const;
+
+    /// distinguishes matchers built for different refresh_pattern configurations
+    const uint64_t generation;
+
+private:
+    /// consecutive rules and, unless it is not needed or could not be
+    /// built, their combined regular expression
+    class Group
+    {
+    public:
+        std::unique_ptr<RegexPattern> combined;
+        std::vector<const RefreshPattern *> rules;
+    };
+
+    void addGroup(std::vector<const RefreshPattern *> &rules, bool caseSensitive);
+
+    static uint64_t LastGeneration;
+
+    std::vector<Group> groups_;
+};
+
+uint64_t RefreshRulesMatcher::LastGeneration = 0;
+
+/// whether the regex cannot be combined with others without changing its meaning
+static bool
+refreshRegexHasBackReferences(const SBuf &regex)
+{
+    for (SBuf::size_type pos = 0; (pos = regex.find('\\', pos)) != SBuf::npos; pos += 2) {
+        if (pos + 1 < regex.length() && xisdigit(regex[pos + 1]))
+            return true;
+    }
+    return false;
+}
+
+RefreshRulesMatcher::RefreshRulesMatcher(const RefreshPattern *rules):
+    generation(++LastGeneration)
+{
+    std::vector<const RefreshPattern *> accumulated;
+    size_t accumulatedSize = 0;
+    auto caseSensitive = true;
+    for (auto R = rules; R; R = R->next) {
+        const auto &regex = R->regex();
+        if (refreshRegexHasBackReferences(regex.text())) {
+            addGroup(accumulated, caseSensitive);
+            accumulatedSize = 0;
+            std::vector<const RefreshPattern *> single(1, R);
+            addGroup(single, regex.caseSensitive());
+            continue;
+        }
+
+        if (regex.caseSensitive() != caseSensitive || accumulatedSize > 1024) {
+            addGroup(accumulated, caseSensitive);
+            accumulatedSize = 0;
+        }
+        caseSensitive = regex.caseSensitive();
+        accumulated.push_back(R);
+        accumulatedSize += regex.text().length();
+    }
+    addGroup(accumulated, caseSensitive);
+
+    debugs(22, 2, "grouped refresh_pattern rules into " << groups_.size() << " regular expressions");
+}
+
+/// moves the given rules into a new group
+void
+RefreshRulesMatcher::addGroup(std::vector<const RefreshPattern *> &rules, const bool caseSensitive)
+{
+    if (rules.empty())
+        return;
+
+    Group group;
+    if (rules.size() > 1) {
+        SBuf combined;
+        for (const auto R: rules) {
+            if (!combined.isEmpty())
+                combined.append('|');
+            combined.append('(');
+            combined.append(R->regex().text());
+            combined.append(')');
+        }
+
+        try {
+            group.combined.reset(new RegexPattern(combined, REG_EXTENDED | REG_NOSUB | (caseSensitive ? 0 : REG_ICASE)));
+        } catch (...) {
+            // fall back to testing each rule of the group
+            debugs(22, DBG_IMPORTANT, "WARNING: Cannot combine " << rules.size() << " refresh_pattern rules into one regular expression" <<
+                   Debug::Extra << "problem: " << CurrentException);
+        }
+    }
+    group.rules.swap(rules);
+    groups_.push_back(std::move(group));
+}
+
+const RefreshPattern *
+RefreshRulesMatcher::match(const char * const url) const
+{
+    for (const auto &group: groups_) {
+        if (group.combined && !group.combined->match(url))
+            continue;
+
+        for (const auto R: group.rules) {
+            ++(R->stats.matchTests);
+            if (R->regex().match(url)) {
+                ++(R->stats.matchCount);
+                return R;
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+/// matches URLs against the current refresh_pattern configuration
+static std::unique_ptr<RefreshRulesMatcher> TheRulesMatcher;
+
+/// (re)builds TheRulesMatcher to reflect the current refresh_pattern configuration
+static void
+refreshRulesConfigure()
+{
+    TheRulesMatcher.reset(new RefreshRulesMatcher(Config.Refresh));
+}
+
+/// keeps TheRulesMatcher in sync with refresh_pattern configuration
+class RefreshRulesRr: public RegisteredRunner
+{
+public:
+    /* RegisteredRunner API */
+    void useConfig() override { refreshRulesConfigure(); }
+    void startReconfigure() override { TheRulesMatcher.reset(); }
+    void syncConfig() override { refreshRulesConfigure(); }
+};
+DefineRunnerRegistrator(RefreshRulesRr);
+
 /** Locate the first refresh_pattern rule that matches the given URL by regex.
  *
  * \return A pointer to the refresh_pattern parameters to use, or nullptr if there is no match.
@@ -91,15 +242,27 @@ static RefreshPattern DefaultRefresh(nullptr);
 const RefreshPattern *
 refreshLimits(const char *url)
 {
-    for (auto R = Config.Refresh; R; R = R->next) {
-        ++(R->stats.matchTests);
-        if (R->regex().match(url)) {
-            ++(R->stats.matchCount);
-            return R;
-        }
+    if (!TheRulesMatcher)
+        refreshRulesConfigure();
+    return TheRulesMatcher->match(url);
+}
+
+const RefreshPattern *
+refreshLimits(const MemObject &mem)
+{
+    if (!TheRulesMatcher)
+        refreshRulesConfigure();
+
+    auto &cached = mem.refreshRule;
+    if (cached.generation == TheRulesMatcher->generation) {
+        if (cached.rule)
+            ++(cached.rule->stats.reuseCount);
+        return cached.rule;
     }
 
-    return nullptr;
+    cached.rule = TheRulesMatcher->match(mem.storeId());
+    cached.generation = TheRulesMatcher->generation;
+    return cached.rule;
 }
 
 /// the first explicit refresh_pattern rule that uses a "." regex (or nil)
@@ -234,6 +397,7 @@ refreshStaleness(const StoreEntry * entry, time_t check_time, const time_t age,
  *  - FRESH_MIN_RULE
  *  - FRESH_OVERRIDE_EXPIRES
  *  - FRESH_OVERRIDE_LASTMOD
+ *  - FRESH_STALE_WHILE_REVALIDATE
  *  - STALE_MUST_REVALIDATE
  *  - STALE_RELOAD_INTO_IMS
  *  - STALE_FORCED_RELOAD
@@ -242,15 +406,19 @@ refreshStaleness(const StoreEntry * entry, time_t check_time, const time_t age,
  *  - STALE_MAX_RULE
  *  - STALE_LMFACTOR_RULE
  *  - STALE_MAX_STALE
+ *  - STALE_BACKGROUND_REFRESH
  *  - STALE_DEFAULT
  *
+ * \param allowBackgroundRefresh whether a hit may be refreshed in the
+ *        background (sets request->flags.refreshAfterHit)
+ *
  * \note request may be NULL (e.g. for cache digests build)
  *
  * \note the store entry being examined is not necessarily cached (e.g. if
  *       this response is being evaluated for the first time)
  */
 static int
-refreshCheck(const StoreEntry * entry, HttpRequest * request, time_t delta)
+refreshCheck(const StoreEntry * entry, HttpRequest * request, time_t delta, const bool allowBackgroundRefresh = false)
 {
     time_t age = 0;
     time_t check_time = squid_curtime + delta;
@@ -260,10 +428,17 @@ refreshCheck(const StoreEntry * entry, HttpRequest * request, time_t delta)
     // get the URL of this entry, if there is one
     static const SBuf nilUri("<none>");
     SBuf uri = nilUri;
-    if (entry->mem_obj)
+    const RefreshPattern *R = nullptr;
+    if (entry->mem_obj) {
         uri = entry->mem_obj->storeId();
-    else if (request)
+        R = refreshLimits(*entry->mem_obj);
+    } else if (request) {
         uri = request->effectiveRequestUri();
+        // XXX: performance regression. c_str() reallocates
+        R = refreshLimits(uri.c_str());
+    } else {
+        R = refreshFirstDotRule();
+    }
 
     debugs(22, 3, "checking freshness of " << *entry << " with URI: " << uri);
 
@@ -280,8 +455,6 @@ refreshCheck(const StoreEntry * entry, HttpRequest * request, time_t delta)
      *   2. the "." rule from the config file
      *   3. the default "." rule
      */
-    // XXX: performance regression. c_str() reallocates
-    const RefreshPattern *R = (uri != nilUri) ? refreshLimits(uri.c_str()) : refreshFirstDotRule();
     if (nullptr == R)
         R = &DefaultRefresh;
 
@@ -341,6 +514,11 @@ refreshCheck(const StoreEntry * entry, HttpRequest * request, time_t delta)
         return STALE_MUST_REVALIDATE;
     }
 
+    if (request && request->flags.backgroundRefresh) {
+        debugs(22, 3, "YES: Refreshing the cached response in the background");
+        return STALE_BACKGROUND_REFRESH;
+    }
+
     /* request-specific checks */
     if (request && !request->flags.ignoreCc) {
         HttpHdrCc *cc = request->cache_control;
@@ -440,6 +618,17 @@ refreshCheck(const StoreEntry * entry, HttpRequest * request, time_t delta)
     // If the object is fresh, return the right FRESH_ code
     if (-1 == staleness) {
         debugs(22, 3, "Object isn't stale..");
+
+        // refresh popular responses shortly before they become stale
+        if (allowBackgroundRefresh && request && R->prefetch > 0 && entry->refcount >= R->prefetch_min_hits) {
+            stale_flags prefetchFlags;
+            memset(&prefetchFlags, '\0', sizeof(prefetchFlags));
+            if (refreshStaleness(entry, check_time + R->prefetch, age + R->prefetch, R, &prefetchFlags) > -1) {
+                debugs(22, 3, "MAYBE: Refreshing a popular object that becomes stale within " << R->prefetch << " sec (prefetch option)");
+                request->flags.refreshAfterHit = true;
+            }
+        }
+
         if (sf.expires) {
             debugs(22, 3, "returning FRESH_EXPIRES");
             return FRESH_EXPIRES;
@@ -471,6 +660,18 @@ refreshCheck(const StoreEntry * entry, HttpRequest * request, time_t delta)
         return STALE_MAX_STALE;
     }
 
+    // RFC 5861: serve a stale response while refreshing it in the background
+    if (allowBackgroundRefresh && request) {
+        int staleWhileRevalidate = R->stale_while_revalidate;
+        if (reply && reply->cache_control)
+            reply->cache_control->hasStaleWhileRevalidate(&staleWhileRevalidate);
+        if (staleness < staleWhileRevalidate) {
+            debugs(22, 3, "NO: Serving a stale object while refreshing it (stale-while-revalidate=" << staleWhileRevalidate << ")");
+            request->flags.refreshAfterHit = true;
+            return FRESH_STALE_WHILE_REVALIDATE;
+        }
+    }
+
     if (sf.expires) {
 #if USE_HTTP_VIOLATIONS
 
@@ -581,7 +782,8 @@ refreshIsStaleIfHit(const int reason)
 int
 refreshCheckHTTP(const StoreEntry * entry, HttpRequest * request)
 {
-    int reason = refreshCheck(entry, request, 0);
+    request->flags.refreshAfterHit = false;
+    int reason = refreshCheck(entry, request, 0, true);
     ++ refreshCounts[rcHTTP].total;
     ++ refreshCounts[rcHTTP].status[reason];
     request->flags.staleIfHit = refreshIsStaleIfHit(reason);
@@ -670,6 +872,7 @@ refreshCountsStats(StoreEntry * sentry, struct RefreshCounts &rc)
     refreshCountsStatsEntry(sentry, rc, FRESH_MIN_RULE, "Fresh: refresh_pattern min value");
     refreshCountsStatsEntry(sentry, rc, FRESH_OVERRIDE_EXPIRES, "Fresh: refresh_pattern override-expires");
     refreshCountsStatsEntry(sentry, rc, FRESH_OVERRIDE_LASTMOD, "Fresh: refresh_pattern override-lastmod");
+    refreshCountsStatsEntry(sentry, rc, FRESH_STALE_WHILE_REVALIDATE, "Fresh: stale-while-revalidate");
     refreshCountsStatsEntry(sentry, rc, STALE_MUST_REVALIDATE, "Stale: response has must-revalidate");
     refreshCountsStatsEntry(sentry, rc, STALE_RELOAD_INTO_IMS, "Stale: changed reload into IMS");
     refreshCountsStatsEntry(sentry, rc, STALE_FORCED_RELOAD, "Stale: request has no-cache directive");
@@ -677,6 +880,7 @@ refreshCountsStats(StoreEntry * sentry, struct RefreshCounts &rc)
     refreshCountsStatsEntry(sentry, rc, STALE_EXPIRES, "Stale: expires time reached");
     refreshCountsStatsEntry(sentry, rc, STALE_MAX_RULE, "Stale: refresh_pattern max age rule");
     refreshCountsStatsEntry(sentry, rc, STALE_LMFACTOR_RULE, "Stale: refresh_pattern last-mod factor percentage");
+    refreshCountsStatsEntry(sentry, rc, STALE_BACKGROUND_REFRESH, "Stale: background refresh");
     refreshCountsStatsEntry(sentry, rc, STALE_DEFAULT, "Stale: by default");
     storeAppendPrintf(sentry, "\n");
 }
@@ -686,12 +890,13 @@ refreshStats(StoreEntry * sentry)
 {
     // display per-rule counts of usage and tests
     storeAppendPrintf(sentry, "\nRefresh pattern usage:\n\n");
-    storeAppendPrintf(sentry, "  Used      \tChecks    \t%% Matches\tPattern\n");
+    storeAppendPrintf(sentry, "  Used      \tChecks    \t%% Matches\tReused    \tPattern\n");
     for (const RefreshPattern *R = Config.Refresh; R; R = R->next) {
-        storeAppendPrintf(sentry, "  %10" PRIu64 "\t%10" PRIu64 "\t%6.2f\t",
+        storeAppendPrintf(sentry, "  %10" PRIu64 "\t%10" PRIu64 "\t%6.2f\t%10" PRIu64 "\t",
                           R->stats.matchCount,
                           R->stats.matchTests,
-                          xpercent(R->stats.matchCount, R->stats.matchTests));
+                          xpercent(R->stats.matchCount, R->stats.matchTests),
+                          R->stats.reuseCount);
         PackableStream os(*sentry);
         R->printPattern(os);
         os << "\n";
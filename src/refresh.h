@@ -23,8 +23,11 @@ int refreshCheckDigest(const StoreEntry *, time_t delta);
 time_t getMaxAge(const char *url);
 void refreshInit(void);
 
+class MemObject;
 class RefreshPattern;
 const RefreshPattern *refreshLimits(const char *url);
+/// refreshLimits() for the entry Store ID, remembered in the given MemObject
+const RefreshPattern *refreshLimits(const MemObject &);
 
 #endif /* SQUID_SRC_REFRESH_H */
 
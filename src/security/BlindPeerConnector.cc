@@ -14,8 +14,10 @@
 #include "fde.h"
 #include "HttpRequest.h"
 #include "neighbors.h"
+#include "sbuf/Stream.h"
 #include "security/BlindPeerConnector.h"
 #include "security/NegotiationHistory.h"
+#include "security/SessionResumption.h"
 #include "SquidConfig.h"
 
 CBDATA_NAMESPACED_CLASS_INIT(Security, BlindPeerConnector);
@@ -52,11 +54,21 @@ Security::BlindPeerConnector::initialize(Security::SessionPointer &serverSession
         Ssl::setClientSNI(serverSession.get(), host->c_str());
 
         Security::SetSessionResumeData(serverSession, peer->sslSession);
+#endif
     } else {
+#if USE_OPENSSL
         SBuf *hostName = new SBuf(request->url.host());
         SSL_set_ex_data(serverSession.get(), ssl_ex_index_server, (void*)hostName);
         Ssl::setClientSNI(serverSession.get(), hostName->c_str());
 #endif
+        if (!peer) {
+            Security::ResumeOriginSession(originSessionKey(), serverSession);
+            const auto limit = Security::EarlyDataLimit(serverSession);
+            if (earlyData.length() > limit) {
+                debugs(83, 5, "cannot send " << earlyData.length() << " bytes of early data; limit: " << limit);
+                earlyData.clear();
+            }
+        }
     }
 
     debugs(83, 5, "success");
@@ -80,12 +92,42 @@ Security::BlindPeerConnector::noteNegotiationDone(ErrorState *error)
         return;
     }
 
+    const auto &session = fd_table[serverConnection()->fd].ssl;
     if (peer && peer->secure.encryptTransport) {
-        const int fd = serverConnection()->fd;
-        Security::MaybeGetSessionResumeData(fd_table[fd].ssl, peer->sslSession);
+        Security::MaybeGetSessionResumeData(session, peer->sslSession);
+        peer->tlsHandshakes.noteSession(session);
+    } else if (!peer) {
+        Security::RememberOriginSession(originSessionKey(), session);
+        Security::OriginHandshakes().noteSession(session);
+        noteEarlyDataOutcome(session);
     }
 }
 
+/// checks whether the server accepted our early data (if any) and, if it
+/// did, leaves that data for the HTTP transaction using the connection
+void
+Security::BlindPeerConnector::noteEarlyDataOutcome(const Security::SessionPointer &session)
+{
+    if (!earlyDataWritten)
+        return;
+
+#if USE_OPENSSL
+    const auto accepted = SSL_get_early_data_status(session.get()) == SSL_EARLY_DATA_ACCEPTED;
+    debugs(83, 5, "accepted: " << accepted << " bytes: " << earlyData.length());
+    Security::OriginHandshakes().noteEarlyData(accepted);
+    if (accepted)
+        serverConnection()->tlsNegotiations()->acceptedEarlyData = earlyData;
+#else
+    (void)session;
+#endif
+}
+
+SBuf
+Security::BlindPeerConnector::originSessionKey() const
+{
+    return ToSBuf(request->url.host(), ':', serverConnection()->remote.port());
+}
+
 Security::BlindPeerConnector::BlindPeerConnector(HttpRequestPointer &aRequest,
         const Comm::ConnectionPointer &aServerConn,
         const AsyncCallback<EncryptorAnswer> &aCallback,
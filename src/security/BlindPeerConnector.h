@@ -40,6 +40,18 @@ public:
     /// On success, stores the used TLS session for later use.
     /// On error, informs the peer.
     void noteNegotiationDone(ErrorState *) override;
+
+    /// Sends the given request as TLS 1.3 early data if we resume an origin
+    /// server session that allows it. If the server accepts that data,
+    /// NegotiationHistory::acceptedEarlyData of the established connection
+    /// keeps the request.
+    void offerEarlyData(const SBuf &data) { earlyData = data; }
+
+private:
+    void noteEarlyDataOutcome(const Security::SessionPointer &);
+
+    /// identifies the origin server for session resumption purposes
+    SBuf originSessionKey() const;
 };
 
 } // namespace Security
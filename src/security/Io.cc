@@ -11,6 +11,7 @@
 #include "squid.h"
 #include "base/IoManip.h"
 #include "fde.h"
+#include "sbuf/SBuf.h"
 #include "security/Io.h"
 #include "ssl/gadgets.h"
 
@@ -233,3 +234,17 @@ Security::Connect(Comm::Connection &transport)
     });
 }
 
+#if USE_OPENSSL
+Security::IoResult
+Security::WriteEarlyData(Comm::Connection &transport, const SBuf &data)
+{
+    return Handshake(transport, SQUID_TLS_ERR_CONNECT, [&data] (ConnectionPointer tlsConn) {
+        size_t written = 0;
+        const auto result = SSL_write_early_data(tlsConn, data.rawContent(), data.length(), &written);
+        // SSL_write_early_data() does not write a part of the given data
+        assert(result <= 0 || written == data.length());
+        return result;
+    });
+}
+#endif
+
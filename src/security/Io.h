@@ -10,6 +10,7 @@
 #define SQUID_SRC_SECURITY_IO_H
 
 #include "comm/forward.h"
+#include "sbuf/forward.h"
 #include "security/ErrorDetail.h"
 #include "security/forward.h"
 
@@ -65,6 +66,12 @@ IoResult Accept(Comm::Connection &transport);
 /// establish a TLS connection over the specified from-Squid transport connection
 IoResult Connect(Comm::Connection &transport);
 
+#if USE_OPENSSL
+/// start establishing a TLS connection over the specified from-Squid transport
+/// connection by sending the given TLS 1.3 early data; Connect() completes it
+IoResult WriteEarlyData(Comm::Connection &transport, const SBuf &data);
+#endif
+
 /// clear any errors that a TLS library has accumulated in its global storage
 void ForgetErrors();
 
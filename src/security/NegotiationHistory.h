@@ -10,6 +10,7 @@
 #define SQUID_SRC_SECURITY_NEGOTIATIONHISTORY_H
 
 #include "anyp/ProtocolVersion.h"
+#include "sbuf/SBuf.h"
 #include "security/Handshake.h"
 #include "security/Session.h"
 
@@ -34,6 +35,11 @@ public:
     /// String representation of the maximum supported TLS version
     /// by remote peer
     const char *supportedVersion() const {return printTlsVersion(supportedVersion_);}
+
+    /// A request sent as TLS 1.3 early data and accepted by the server but
+    /// not yet claimed by the HTTP transaction using this connection.
+    SBuf acceptedEarlyData;
+
 private:
     /// String representation of the TLS version 'v'
     const char *printTlsVersion(AnyP::ProtocolVersion const &v) const;
@@ -218,6 +218,16 @@ Security::PeerConnector::negotiate()
     if (fd_table[fd].closing())
         return;
 
+#if USE_OPENSSL
+    if (!earlyData.isEmpty() && !earlyDataWritten) {
+        const auto earlyResult = Security::WriteEarlyData(*serverConnection(), earlyData);
+        if (earlyResult.category != Security::IoResult::ioSuccess)
+            return handleNegotiationResult(earlyResult);
+        debugs(83, 5, "wrote " << earlyData.length() << " bytes of early data to " << serverConnection());
+        earlyDataWritten = true;
+    }
+#endif
+
     const auto result = Security::Connect(*serverConnection());
 
 #if USE_OPENSSL
@@ -169,6 +169,12 @@ protected:
     /// answer destination
     AsyncCallback<EncryptorAnswer> callback;
 
+    /// a request to send as TLS 1.3 early data during the handshake (or empty)
+    SBuf earlyData;
+
+    /// whether we have sent earlyData (the server may still reject it)
+    bool earlyDataWritten = false;
+
 private:
     PeerConnector(const PeerConnector &); // not implemented
     PeerConnector &operator =(const PeerConnector &); // not implemented
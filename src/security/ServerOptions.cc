@@ -210,8 +210,23 @@ Security::ServerOptions::initServerContexts(AnyP::PortCfg &port)
     // features depending on contexts do their own checks and error messages later.
 }
 
+#if USE_OPENSSL
+/// TLS ALPN callback for ports with the http2 option: prefers HTTP/2 and
+/// otherwise falls back to HTTP/1.1 or no ALPN at all
+static int
+SelectAlpnProtocol(SSL *, const unsigned char **out, unsigned char *outlen, const unsigned char *in, unsigned int inlen, void *)
+{
+    static const unsigned char supported[] = "\x02h2\x08http/1.1";
+    unsigned char *selected = nullptr;
+    if (SSL_select_next_proto(&selected, outlen, supported, sizeof(supported) - 1, in, inlen) != OPENSSL_NPN_NEGOTIATED)
+        return SSL_TLSEXT_ERR_NOACK;
+    *out = selected;
+    return SSL_TLSEXT_ERR_OK;
+}
+#endif
+
 bool
-Security::ServerOptions::createStaticServerContext(AnyP::PortCfg &)
+Security::ServerOptions::createStaticServerContext(AnyP::PortCfg &port)
 {
     updateTlsVersionLimits();
 
@@ -249,6 +264,9 @@ Security::ServerOptions::createStaticServerContext(AnyP::PortCfg &)
             }
         }
 
+        if (port.http2)
+            SSL_CTX_set_alpn_select_cb(t.get(), &SelectAlpnProtocol, nullptr);
+
 #elif HAVE_LIBGNUTLS
         for (auto &keys : certs) {
             gnutls_x509_crt_t crt = keys.cert.get();
@@ -265,6 +283,9 @@ Security::ServerOptions::createStaticServerContext(AnyP::PortCfg &)
             }
             // XXX: add cert chain to the context
         }
+        (void)port; // TODO: Support ALPN with GnuTLS
+#else
+        (void)port;
 #endif
 
         if (!loadClientCaFile())
@@ -0,0 +1,383 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 83    TLS session management */
+
+#include "squid.h"
+#include "base/IoManip.h"
+#include "base/PackableStream.h"
+#include "base/RunnersRegistry.h"
+#include "CachePeer.h"
+#include "CachePeers.h"
+#include "debug/Stream.h"
+#include "fde.h"
+#include "ipc/MemMap.h"
+#include "md5.h"
+#include "mgr/Registration.h"
+#include "security/SessionResumption.h"
+#include "SquidConfig.h"
+#include "Store.h"
+#include "time/gadgets.h"
+
+#include <cstring>
+#include <ostream>
+
+/// shared memory map label
+static const char * const OriginSessionsName = "tls_origin_sessions";
+
+/// serialized session resumption data for each origin server, shared by all
+/// workers, or nil (when caching is disabled)
+static Ipc::MemMap *TheOriginSessions = nullptr;
+
+/// The default lifetime of a remembered session, in seconds, when the TLS
+/// library does not tell us how long the server is willing to resume it.
+static const time_t DefaultSessionTtl = 300;
+
+/// the shared map key for the given origin server
+static void
+OriginSessionKey(const SBuf &origin, unsigned char key[MEMMAP_SLOT_KEY_SIZE])
+{
+    static_assert(SQUID_MD5_DIGEST_LENGTH <= MEMMAP_SLOT_KEY_SIZE, "origin digest fits MemMap key");
+    memset(key, 0, MEMMAP_SLOT_KEY_SIZE);
+    SquidMD5_CTX ctx;
+    SquidMD5Init(&ctx);
+    SquidMD5Update(&ctx, origin.rawContent(), origin.length());
+    SquidMD5Final(key, &ctx);
+}
+
+#if USE_OPENSSL || HAVE_LIBGNUTLS
+/// shares the given session resumption data with other workers
+static void
+StoreOriginSession(const SBuf &origin, const SBuf &data, const time_t ttl)
+{
+    if (!TheOriginSessions)
+        return;
+
+    if (data.isEmpty() || data.length() > MEMMAP_SLOT_DATA_SIZE) {
+        debugs(83, 5, "cannot remember " << data.length() << " bytes for " << origin);
+        return;
+    }
+
+    unsigned char key[MEMMAP_SLOT_KEY_SIZE];
+    OriginSessionKey(origin, key);
+    sfileno pos;
+    if (const auto slot = TheOriginSessions->openForWriting(key, pos)) {
+        slot->set(key, data.rawContent(), data.length(), squid_curtime + ttl);
+        TheOriginSessions->closeForWriting(pos);
+        debugs(83, 5, "remembered " << origin << " session for " << ttl << "s at " << pos);
+    }
+}
+#endif
+
+/// \returns session resumption data remembered for the given origin (if any)
+static SBuf
+FindOriginSession(const SBuf &origin)
+{
+    SBuf data;
+    if (!TheOriginSessions)
+        return data;
+
+    unsigned char key[MEMMAP_SLOT_KEY_SIZE];
+    OriginSessionKey(origin, key);
+    sfileno pos;
+    if (const auto slot = TheOriginSessions->openForReading(key, pos)) {
+        if (slot->expire > squid_curtime)
+            data.assign(reinterpret_cast<const char *>(slot->p), slot->pSize);
+        TheOriginSessions->closeForReading(pos);
+    }
+    return data;
+}
+
+#if USE_OPENSSL
+/// exports resumption data of the given session (or returns an empty buffer)
+static SBuf
+ExportSessionState(SSL_SESSION *session, time_t &ttl)
+{
+    SBuf data;
+    ttl = DefaultSessionTtl;
+    if (!session)
+        return data;
+#if defined(TLS1_3_VERSION)
+    if (!SSL_SESSION_is_resumable(session))
+        return data;
+#endif
+
+    const auto size = i2d_SSL_SESSION(session, nullptr);
+    if (size <= 0)
+        return data;
+
+    const auto start = data.rawAppendStart(size);
+    auto end = reinterpret_cast<unsigned char *>(start);
+    if (i2d_SSL_SESSION(session, &end) != size)
+        return SBuf();
+    data.rawAppendFinish(start, size);
+
+    if (const auto timeout = SSL_SESSION_get_timeout(session))
+        ttl = timeout;
+    return data;
+}
+
+/// SSL ex_data index for the origin server name and port of a to-origin
+/// connection that remembers sessions issued by the server
+static int
+OriginExDataIndex()
+{
+    static const auto index = SSL_get_ex_new_index(0, const_cast<char *>("origin"), nullptr, nullptr,
+    [](void *, void *ptr, CRYPTO_EX_DATA *, int, long, void *) {
+        delete static_cast<SBuf *>(ptr);
+    });
+    return index;
+}
+
+/// SSL_CTX_sess_set_new_cb() callback: remembers a session issued by an
+/// origin server, including TLS 1.3 tickets that arrive after the handshake
+static int
+RememberIssuedSession(SSL *ssl, SSL_SESSION *session)
+{
+    if (const auto origin = static_cast<const SBuf *>(SSL_get_ex_data(ssl, OriginExDataIndex()))) {
+        time_t ttl = DefaultSessionTtl;
+        const auto data = ExportSessionState(session, ttl);
+        StoreOriginSession(*origin, data, ttl);
+    }
+    return 0; // we did not keep a session reference
+}
+#endif
+
+/// configures the given session to resume a session exported earlier
+static void
+ImportSessionResumeData(const Security::SessionPointer &s, const SBuf &data)
+{
+#if USE_OPENSSL
+    auto start = reinterpret_cast<const unsigned char *>(data.rawContent());
+    const Security::SessionStatePointer state(d2i_SSL_SESSION(nullptr, &start, data.length()));
+    if (!state) {
+        debugs(83, 3, "session=" << (void*)s.get() << " cannot import " << data.length() << " bytes");
+        return;
+    }
+    Security::SetSessionResumeData(s, state);
+#elif HAVE_LIBGNUTLS
+    const auto x = gnutls_session_set_data(s.get(), data.rawContent(), data.length());
+    if (x != GNUTLS_E_SUCCESS)
+        debugs(83, 3, "session=" << (void*)s.get() << " resume error: " << Security::ErrorString(x));
+#else
+    (void)s;
+    (void)data;
+#endif
+}
+
+/// whether the session may be resumed with TLS 1.3 early data
+static bool
+AllowsEarlyData(const Security::SessionPointer &s)
+{
+#if USE_OPENSSL && defined(TLS1_3_VERSION)
+    const auto session = SSL_get_session(s.get());
+    return session && SSL_SESSION_get_max_early_data(session) > 0;
+#elif HAVE_LIBGNUTLS && defined(GNUTLS_SFLAGS_EARLY_DATA)
+    return (gnutls_session_get_flags(s.get()) & GNUTLS_SFLAGS_EARLY_DATA) != 0;
+#else
+    (void)s;
+    return false;
+#endif
+}
+
+/* Security::HandshakeCounters */
+
+void
+Security::HandshakeCounters::noteSession(const SessionPointer &s)
+{
+    if (SessionIsResumed(s))
+        ++resumed;
+    else
+        ++full;
+
+    if (AllowsEarlyData(s))
+        ++earlyDataCapable;
+}
+
+void
+Security::HandshakeCounters::noteEarlyData(const bool accepted)
+{
+    ++earlyDataSent;
+    if (accepted)
+        ++earlyDataAccepted;
+}
+
+void
+Security::HandshakeCounters::dump(std::ostream &yaml, const char *indent) const
+{
+    yaml <<
+         indent << "full handshakes: " << full << "\n" <<
+         indent << "resumed sessions: " << resumed << "\n" <<
+         indent << "early data capable sessions: " << earlyDataCapable << "\n" <<
+         indent << "early data requests sent: " << earlyDataSent << "\n" <<
+         indent << "early data requests accepted: " << earlyDataAccepted << "\n";
+}
+
+/* origin server sessions */
+
+void
+Security::ResumeOriginSession(const SBuf &origin, const SessionPointer &s)
+{
+    if (!TheOriginSessions)
+        return;
+
+#if USE_OPENSSL
+    SSL_set_ex_data(s.get(), OriginExDataIndex(), new SBuf(origin));
+#endif
+
+    const auto data = FindOriginSession(origin);
+    if (!data.isEmpty()) {
+        debugs(83, 5, "resuming " << origin << " session=" << (void*)s.get());
+        ImportSessionResumeData(s, data);
+    }
+}
+
+void
+Security::RememberOriginSession(const SBuf &origin, const SessionPointer &s)
+{
+#if USE_OPENSSL
+    // RememberIssuedSession() does this job
+    (void)origin;
+    (void)s;
+#elif HAVE_LIBGNUTLS
+    // keep using the already remembered data for resumed sessions
+    if (!TheOriginSessions || SessionIsResumed(s))
+        return;
+
+    gnutls_datum_t exported = {nullptr, 0};
+    const auto x = gnutls_session_get_data2(s.get(), &exported);
+    if (x != GNUTLS_E_SUCCESS) {
+        debugs(83, 3, "session=" << (void*)s.get() << " error: " << Security::ErrorString(x));
+        return;
+    }
+    const SBuf data(reinterpret_cast<const char *>(exported.data), exported.size);
+    gnutls_free(exported.data);
+    StoreOriginSession(origin, data, DefaultSessionTtl);
+#else
+    (void)origin;
+    (void)s;
+#endif
+}
+
+void
+Security::SetOriginSessionCallbacks(ContextPointer &ctx)
+{
+#if USE_OPENSSL
+    if (!::Config.ssl_client.originSessionCacheSize)
+        return;
+    SSL_CTX_set_session_cache_mode(ctx.get(), SSL_SESS_CACHE_CLIENT|SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx.get(), &RememberIssuedSession);
+#else
+    (void)ctx;
+#endif
+}
+
+size_t
+Security::EarlyDataLimit(const SessionPointer &s)
+{
+#if USE_OPENSSL && defined(TLS1_3_VERSION)
+    if (const auto session = SSL_get_session(s.get()))
+        return SSL_SESSION_get_max_early_data(session);
+#else
+    (void)s;
+#endif
+    return 0;
+}
+
+Security::HandshakeCounters &
+Security::OriginHandshakes()
+{
+    static HandshakeCounters counters;
+    return counters;
+}
+
+/// reports to-server TLS session resumption statistics
+static void
+DumpSessionStats(StoreEntry *e)
+{
+    PackableStream yaml(*e);
+
+    yaml << "origin servers:\n";
+    Security::OriginHandshakes().dump(yaml, "  ");
+    if (const auto cache = TheOriginSessions) {
+        yaml <<
+             "  remembered sessions: " << cache->entryCount() << "\n" <<
+             "  remembered sessions limit: " << cache->entryLimit() << "\n";
+    }
+
+    AtMostOnce heading("cache_peers:\n");
+    for (const auto &peer: CurrentCachePeers()) {
+        if (!peer->secure.encryptTransport)
+            continue;
+        yaml << heading << "  " << peer->name << ":\n";
+        peer->tlsHandshakes.dump(yaml, "    ");
+    }
+}
+
+/// creates and opens the shared origin session map and registers TLS
+/// session resumption cache manager report
+class SessionResumptionRr: public Ipc::Mem::RegisteredRunner
+{
+public:
+    /* RegisteredRunner API */
+    void useConfig() override;
+    ~SessionResumptionRr() override;
+
+protected:
+    /* Ipc::Mem::RegisteredRunner API */
+    void create() override;
+    void open() override;
+
+private:
+    Ipc::MemMap::Owner *owner = nullptr;
+};
+
+DefineRunnerRegistrator(SessionResumptionRr);
+
+/// the number of shared map slots configured by tls_origin_session_cache_size
+static int
+OriginSessionsLimit()
+{
+    return ::Config.ssl_client.originSessionCacheSize / sizeof(Ipc::MemMap::Slot);
+}
+
+void
+SessionResumptionRr::useConfig()
+{
+    Mgr::RegisterAction("tls_sessions",
+                        "TLS Session Resumption Statistics",
+                        DumpSessionStats, Mgr::Protected::no, Mgr::Atomic::yes,
+                        Mgr::Format::yaml);
+
+#if USE_OPENSSL || HAVE_LIBGNUTLS
+    if (OriginSessionsLimit() > 0)
+        Ipc::Mem::RegisteredRunner::useConfig();
+#endif
+}
+
+void
+SessionResumptionRr::create()
+{
+    Must(!owner);
+    owner = Ipc::MemMap::Init(OriginSessionsName, OriginSessionsLimit());
+}
+
+void
+SessionResumptionRr::open()
+{
+    Must(!TheOriginSessions);
+    TheOriginSessions = new Ipc::MemMap(OriginSessionsName);
+}
+
+SessionResumptionRr::~SessionResumptionRr()
+{
+    delete TheOriginSessions;
+    TheOriginSessions = nullptr;
+    delete owner;
+}
+
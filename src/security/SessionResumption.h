@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_SECURITY_SESSIONRESUMPTION_H
+#define SQUID_SRC_SECURITY_SESSIONRESUMPTION_H
+
+#include "sbuf/forward.h"
+#include "security/Session.h"
+
+#include <cstdint>
+#include <iosfwd>
+
+namespace Security {
+
+/// TLS handshake outcomes for a group of to-server connections
+class HandshakeCounters
+{
+public:
+    /// accounts for a successfully negotiated to-server TLS session
+    void noteSession(const SessionPointer &);
+
+    /// accounts for a request sent as TLS 1.3 early data
+    /// \param accepted whether the server agreed to process that request
+    void noteEarlyData(bool accepted);
+
+    /// reports our counters using YAML-like cache manager format
+    void dump(std::ostream &, const char *indent) const;
+
+    uint64_t full = 0; ///< handshakes that established a new session
+    uint64_t resumed = 0; ///< abbreviated handshakes that resumed an earlier session
+
+    /// negotiated sessions that the server allows to resume with TLS 1.3
+    /// early data (i.e. sessions usable for 0-RTT requests)
+    uint64_t earlyDataCapable = 0;
+
+    uint64_t earlyDataSent = 0; ///< handshakes that carried a request as early data
+    uint64_t earlyDataAccepted = 0; ///< early data requests accepted by the server
+};
+
+/// Configures a new session to resume an earlier session with the given
+/// origin server (if we remember one) and to remember sessions that the
+/// server issues on it. The origin is identified by its server name and port.
+void ResumeOriginSession(const SBuf &origin, const SessionPointer &);
+
+/// Remembers resumption data of a freshly negotiated session with the given
+/// origin server, subject to tls_origin_session_cache_size limit. With
+/// OpenSSL, sessions are remembered when the server issues them instead
+/// because TLS 1.3 servers issue session tickets after the handshake.
+void RememberOriginSession(const SBuf &origin, const SessionPointer &);
+
+/// prepares the given to-origin TLS context for remembering issued sessions
+void SetOriginSessionCallbacks(ContextPointer &);
+
+/// \returns the maximum number of bytes the session may send as TLS 1.3
+/// early data (zero unless it resumes a session that allows early data)
+size_t EarlyDataLimit(const SessionPointer &);
+
+/// handshake counters for all connections to origin servers
+HandshakeCounters &OriginHandshakes();
+
+} // namespace Security
+
+#endif /* SQUID_SRC_SECURITY_SESSIONRESUMPTION_H */
+
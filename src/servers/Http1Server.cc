@@ -19,11 +19,13 @@
 #include "http/one/RequestParser.h"
 #include "http/Stream.h"
 #include "servers/Http1Server.h"
+#include "servers/Http2Server.h"
 #include "SquidConfig.h"
 #include "Store.h"
+#include "TransactionTrace.h"
 #include "tunnel.h"
 
-CBDATA_NAMESPACED_CLASS_INIT(Http1, Server);
+CBDATA_NAMESPACED_CLASS_INIT(Http1, PlainServer);
 
 Http::One::Server::Server(const MasterXaction::Pointer &xact, bool beHttpsServer):
     AsyncJob("Http1::Server"),
@@ -135,6 +137,9 @@ Http::One::Server::buildHttpRequest(Http::StreamPointer &context)
     // TODO: move URL parse into Http Parser and INVALID_URL into the above parse error handling
     const auto mx = MasterXaction::MakePortful(port);
     mx->tcpClient = clientConnection;
+    mx->phases.adopt(TransactionPhases::clientRead, requestReadingTime_);
+    mx->phases.adopt(TransactionPhases::requestParse, requestParsingTime_);
+    mx->phases.start(TransactionPhases::requestParse); // until headers are compiled
     request = HttpRequest::FromUrlXXX(http->uri, mx, parser_->method());
     if (!request) {
         debugs(33, 5, "Invalid URL: " << http->uri);
@@ -150,11 +155,15 @@ Http::One::Server::buildHttpRequest(Http::StreamPointer &context)
         return false;
     }
 
+    TransactionTrace::Note(*mx, TransactionTrace::Milestone::accepted, http->al->cache.start_time);
+    TransactionTrace::Note(*mx, TransactionTrace::Milestone::parsed);
+
     /* RFC 2616 section 10.5.6 : handle unsupported HTTP major versions cleanly. */
     /* We currently only support 0.9, 1.0, 1.1 properly */
+    /* and HTTP/2 requests that Http2::Server converts for us */
     /* TODO: move HTTP-specific processing into servers/HttpServer and such */
     if ( (parser_->messageProtocol().major == 0 && parser_->messageProtocol().minor != 9) ||
-            (parser_->messageProtocol().major > 1) ) {
+            (parser_->messageProtocol().major > 1 && parser_->messageProtocol().major != transferProtocol.major) ) {
 
         debugs(33, 5, "Unsupported HTTP version discovered. :\n" << parser_->messageProtocol());
         // setReplyToError() requires log_uri
@@ -180,6 +189,7 @@ Http::One::Server::buildHttpRequest(Http::StreamPointer &context)
         }
         return false;
     }
+    mx->phases.stop(TransactionPhases::requestParse);
 
     // when absolute-URI is provided Host header should be ignored. However
     // some code still uses Host directly so normalize it using the previously
@@ -391,12 +401,16 @@ Http::One::Server::noteTakeServerConnectionControl(ServerConnectionContext serve
 ConnStateData *
 Http::NewServer(const MasterXaction::Pointer &xact)
 {
-    return new Http1::Server(xact, false);
+    if (xact->squidPort->http2)
+        return new Http2::Server(xact, false);
+    return new Http1::PlainServer(xact, false);
 }
 
 ConnStateData *
 Https::NewServer(const MasterXaction::Pointer &xact)
 {
-    return new Http1::Server(xact, true);
+    if (xact->squidPort->http2)
+        return new Http2::Server(xact, true);
+    return new Http1::PlainServer(xact, true);
 }
 
@@ -22,7 +22,7 @@ namespace One
 /// Manages a connection from an HTTP/1 or HTTP/0.9 client.
 class Server: public ConnStateData
 {
-    CBDATA_CHILD(Server);
+    CBDATA_INTERMEDIATE();
 
 public:
     Server(const MasterXaction::Pointer &xact, const bool beHttpsServer);
@@ -49,6 +49,8 @@ protected:
 
     void proceedAfterBodyContinuation(Http::StreamPointer context);
 
+    Http1::RequestParserPointer parser_;
+
 private:
     void processHttpRequest(Http::Stream *const context);
     void handleHttpRequestData();
@@ -61,13 +63,24 @@ private:
 
     void setReplyError(Http::StreamPointer &context, HttpRequest::Pointer &request, err_type requestError, Http::StatusCode errStatusCode, const char *requestErrorBytes);
 
-    Http1::RequestParserPointer parser_;
     HttpRequestMethod method_; ///< parsed HTTP method
 
     /// temporary hack to avoid creating a true HttpsServer class
     const bool isHttpsServer;
 };
 
+/// an Http1::Server on ports that do not accept HTTP/2 clients
+class PlainServer final: public Server
+{
+    CBDATA_CHILD(PlainServer);
+
+public:
+    PlainServer(const MasterXaction::Pointer &xact, const bool beHttpsServer):
+        AsyncJob("Http1::Server"),
+        Server(xact, beHttpsServer)
+    {}
+};
+
 } // namespace One
 } // namespace Http
 
@@ -0,0 +1,1154 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 33    Client-side Routines */
+
+#include "squid.h"
+#include "base/AsyncJobCalls.h"
+#include "base/CharacterSet.h"
+#include "client_side_request.h"
+#include "clientStream.h"
+#include "comm/Connection.h"
+#include "error/Detail.h"
+#include "http/one/RequestParser.h"
+#include "http/Stream.h"
+#include "HttpReply.h"
+#include "HttpRequest.h"
+#include "internal.h"
+#include "MemBuf.h"
+#include "parser/Tokenizer.h"
+#include "servers/Http2Server.h"
+#include "SquidConfig.h"
+#include "StatCounters.h"
+
+#include <algorithm>
+#include <vector>
+
+CBDATA_NAMESPACED_CLASS_INIT(Http2, Server);
+
+Http::Two::Server::Server(const MasterXaction::Pointer &xact, bool beHttpsServer):
+    AsyncJob("Http2::Server"),
+    Http1::Server(xact, beHttpsServer),
+    decoder_(DefaultHeaderTableSize, Config.maxRequestHeaderSize)
+{
+    clientResets_.configure(ClientResetsWindow);
+}
+
+Http::Stream *
+Http::Two::Server::parseOneRequest()
+{
+    if (mode_ == pmUndecided) {
+        const auto &preface = ClientPreface();
+        if (pipeline.nrequests) {
+            mode_ = pmHttp1;
+        } else if (inBuf.length() < preface.length() && preface.startsWith(inBuf)) {
+            debugs(33, 5, "need more bytes to detect the client protocol");
+            return nullptr;
+        } else {
+            mode_ = inBuf.startsWith(preface) ? pmHttp2 : pmHttp1;
+            if (mode_ == pmHttp2)
+                switchToHttp2();
+        }
+    }
+
+    if (mode_ == pmHttp1)
+        return Http1::Server::parseOneRequest();
+
+    return parseFrames();
+}
+
+/// consumes the client connection preface and sends our SETTINGS
+void
+Http::Two::Server::switchToHttp2()
+{
+    debugs(33, 3, "HTTP/2 client on " << clientConnection);
+    inBuf.consume(ClientPreface().length());
+    transferProtocol.major = 2;
+    transferProtocol.minor = 0;
+    preservingClientData_ = false;
+
+    SBuf settings;
+    PutUint16(settings, sMaxConcurrentStreams);
+    PutUint32(settings, MaxConcurrentStreams);
+    PutUint16(settings, sMaxHeaderListSize);
+    PutUint32(settings, Config.maxRequestHeaderSize);
+    PackFrame(outBuf_, ftSettings, 0, 0, settings);
+
+    resetReadTimeout(clientConnection->timeLeft(idleTimeout()));
+}
+
+/// processes complete frames in inBuf, stopping after the first frame that
+/// completes a request header block
+Http::Stream *
+Http::Two::Server::parseFrames()
+{
+    if (!partialFrame_.isEmpty()) {
+        partialFrame_.append(inBuf);
+        inBuf = partialFrame_;
+        partialFrame_.clear();
+    }
+
+    Http::Stream *context = nullptr;
+    while (!context && !goingAway_ && inBuf.length() >= FrameHeaderSize) {
+        const auto header = FrameHeader::Parse(inBuf.rawContent());
+        if (header.length > DefaultMaxFrameSize) {
+            connectionError(ecFrameSizeError, "frame exceeds SETTINGS_MAX_FRAME_SIZE");
+            break;
+        }
+        if (inBuf.length() < FrameHeaderSize + header.length)
+            break; // wait for the rest of the frame
+
+        const auto payload = inBuf.substr(FrameHeaderSize, header.length);
+        inBuf.consume(FrameHeaderSize + header.length);
+        context = processFrame(header, payload);
+    }
+
+    if (goingAway_) {
+        inBuf.clear();
+    } else if (!context) {
+        // keep inBuf empty so that ConnStateData does not wait for the
+        // rest of the "request" header
+        partialFrame_ = inBuf;
+        inBuf.clear();
+    }
+
+    writeSomeData();
+    return context;
+}
+
+Http::Stream *
+Http::Two::Server::processFrame(const FrameHeader &header, const SBuf &payload)
+{
+    debugs(33, 7, header);
+
+    if (!sawSettings_ && (header.type != ftSettings || header.hasFlag(ffAck))) {
+        connectionError(ecProtocolError, "connection preface lacks SETTINGS");
+        return nullptr;
+    }
+
+    if (headerBlockStream_ && header.type != ftContinuation) {
+        connectionError(ecProtocolError, "interrupted header block");
+        return nullptr;
+    }
+
+    switch (header.type) {
+    case ftData:
+        processData(header, payload);
+        return nullptr;
+
+    case ftHeaders:
+        return processHeaders(header, payload);
+
+    case ftContinuation:
+        return processContinuation(header, payload);
+
+    case ftSettings:
+        processSettings(header, payload);
+        return nullptr;
+
+    case ftPing:
+        if (header.streamId)
+            connectionError(ecProtocolError, "PING on a stream");
+        else if (header.length != 8)
+            connectionError(ecFrameSizeError, "bad PING size");
+        else if (!header.hasFlag(ffAck))
+            PackFrame(outBuf_, ftPing, ffAck, 0, payload);
+        return nullptr;
+
+    case ftWindowUpdate:
+        processWindowUpdate(header, payload);
+        return nullptr;
+
+    case ftRstStream:
+        processRstStream(header, payload);
+        return nullptr;
+
+    case ftGoAway:
+        if (header.streamId)
+            connectionError(ecProtocolError, "GOAWAY on a stream");
+        else if (header.length >= 8)
+            debugs(33, 3, "client is going away: " << ErrorCodeName(GetUint32(payload.rawContent() + 4)));
+        return nullptr;
+
+    case ftPushPromise:
+        connectionError(ecProtocolError, "PUSH_PROMISE from a client");
+        return nullptr;
+
+    case ftPriority:
+    default:
+        // we do not prioritize streams, and unknown frames must be ignored
+        return nullptr;
+    }
+}
+
+/// removes frame padding (if any) from the payload
+/// \returns false after a connection error
+bool
+Http::Two::Server::unpad(const FrameHeader &header, SBuf &payload)
+{
+    if (!header.hasFlag(ffPadded))
+        return true;
+
+    if (payload.isEmpty()) {
+        connectionError(ecFrameSizeError, "missing Pad Length");
+        return false;
+    }
+
+    const auto padLength = static_cast<uint8_t>(payload[0]);
+    if (padLength >= payload.length()) {
+        connectionError(ecProtocolError, "excessive padding");
+        return false;
+    }
+
+    payload = payload.substr(1, payload.length() - 1 - padLength);
+    return true;
+}
+
+void
+Http::Two::Server::processData(const FrameHeader &header, const SBuf &payload)
+{
+    if (!header.streamId) {
+        connectionError(ecProtocolError, "DATA on stream 0");
+        return;
+    }
+
+    SBuf data(payload);
+    if (!unpad(header, data))
+        return;
+
+    // we do not limit the connection window beyond what stream windows allow
+    if (header.length)
+        PackWindowUpdate(outBuf_, 0, header.length);
+
+    const auto streamId = header.streamId;
+    const auto it = streams_.find(streamId);
+    if (it == streams_.end()) {
+        if (streamId > lastStreamId_)
+            connectionError(ecProtocolError, "DATA on an idle stream");
+        else
+            debugs(33, 5, "ignoring DATA for closed stream " << streamId);
+        return;
+    }
+
+    auto &s = it->second;
+    if (s.remoteClosed) {
+        resetStream(streamId, ecStreamClosed);
+        return;
+    }
+
+    if (header.length > s.recvWindow) {
+        resetStream(streamId, ecFlowControlError);
+        return;
+    }
+    s.recvWindow -= header.length;
+
+    s.bodyReceived += data.length();
+    s.remoteClosed = header.hasFlag(ffEndStream);
+
+    if (s.contentLength >= 0 &&
+            (s.bodyReceived > static_cast<uint64_t>(s.contentLength) ||
+             (s.remoteClosed && s.bodyReceived != static_cast<uint64_t>(s.contentLength)))) {
+        debugs(33, 3, "request body size mismatch on stream " << streamId << ": " <<
+               s.bodyReceived << " != " << s.contentLength);
+        resetStream(streamId, ecProtocolError);
+        return;
+    }
+
+    if (Config.maxRequestBodySize && s.bodyReceived > static_cast<uint64_t>(Config.maxRequestBodySize)) {
+        debugs(33, 3, "request body too large on stream " << streamId);
+        resetStream(streamId, ecCancel);
+        return;
+    }
+
+    // padding and unwanted bytes never reach bodyBuf; credit them now
+    const auto creditNow = s.discardingBody ? header.length : header.length - data.length();
+    if (creditNow && !s.remoteClosed) {
+        PackWindowUpdate(outBuf_, streamId, creditNow);
+        s.recvWindow += creditNow;
+    }
+
+    if (!s.discardingBody)
+        s.bodyBuf.append(data);
+
+    feedBody(streamId);
+}
+
+Http::Stream *
+Http::Two::Server::processHeaders(const FrameHeader &header, const SBuf &payload)
+{
+    const auto streamId = header.streamId;
+    if (!streamId || !(streamId & 1)) {
+        connectionError(ecProtocolError, "HEADERS on a bad stream");
+        return nullptr;
+    }
+
+    SBuf block(payload);
+    if (!unpad(header, block))
+        return nullptr;
+
+    if (header.hasFlag(ffPriority)) {
+        if (block.length() < 5) {
+            connectionError(ecFrameSizeError, "truncated HEADERS priority");
+            return nullptr;
+        }
+        block.consume(5); // we do not prioritize streams
+    }
+
+    headerBlockOpensStream_ = streams_.find(streamId) == streams_.end() && streamId > lastStreamId_;
+    if (headerBlockOpensStream_)
+        lastStreamId_ = streamId;
+
+    headerBlock_ = block;
+    headerBlockStream_ = streamId;
+    headerBlockEndsStream_ = header.hasFlag(ffEndStream);
+
+    if (!header.hasFlag(ffEndHeaders))
+        return nullptr;
+
+    return processHeaderBlock();
+}
+
+Http::Stream *
+Http::Two::Server::processContinuation(const FrameHeader &header, const SBuf &payload)
+{
+    if (!headerBlockStream_ || header.streamId != headerBlockStream_) {
+        connectionError(ecProtocolError, "unexpected CONTINUATION");
+        return nullptr;
+    }
+
+    headerBlock_.append(payload);
+    if (headerBlock_.length() > Config.maxRequestHeaderSize) {
+        connectionError(ecEnhanceYourCalm, "header block exceeds request_header_max_size");
+        return nullptr;
+    }
+
+    if (!header.hasFlag(ffEndHeaders))
+        return nullptr;
+
+    return processHeaderBlock();
+}
+
+/// decodes a complete header block, starting a new stream if needed
+Http::Stream *
+Http::Two::Server::processHeaderBlock()
+{
+    const auto streamId = headerBlockStream_;
+    const auto endStream = headerBlockEndsStream_;
+    const SBuf block = headerBlock_;
+    headerBlock_.clear();
+    headerBlockStream_ = 0;
+
+    // always decode to keep the HPACK decoding context in sync
+    HeaderFields fields;
+    if (!decoder_.decode(block, fields)) {
+        connectionError(ecCompressionError, "cannot decode a header block");
+        return nullptr;
+    }
+
+    if (headerBlockOpensStream_)
+        return startStream(streamId, fields, endStream);
+
+    const auto it = streams_.find(streamId);
+    if (it == streams_.end()) {
+        if (wasReset(streamId)) {
+            debugs(33, 5, "ignoring HEADERS for reset stream " << streamId);
+            return nullptr;
+        }
+        // RFC 9113 Section 5.1: HEADERS after both sides sent END_STREAM
+        connectionError(ecStreamClosed, "HEADERS on a closed stream");
+        return nullptr;
+    }
+
+    // request trailers; we do not forward them
+    auto &s = it->second;
+    if (!endStream || s.remoteClosed) {
+        resetStream(streamId, s.remoteClosed ? ecStreamClosed : ecProtocolError);
+        return nullptr;
+    }
+
+    debugs(33, 5, "ignoring " << fields.size() << " trailer fields on stream " << streamId);
+    s.remoteClosed = true;
+    if (s.contentLength >= 0 && s.bodyReceived != static_cast<uint64_t>(s.contentLength)) {
+        resetStream(streamId, ecProtocolError);
+        return nullptr;
+    }
+    feedBody(streamId);
+    return nullptr;
+}
+
+/// converts the given request header fields into an HTTP/1.1-style request
+/// with an HTTP/2.0 request-line version
+/// \returns false for malformed requests
+bool
+Http::Two::Server::convertRequest(const HeaderFields &fields, const bool endStream, RequestConversion &result) const
+{
+    static const auto badPseudoChars = (CharacterSet::CTL + CharacterSet::SP).rename("h2-bad-pseudo-value");
+
+    SBuf method, scheme, authority, path, host, cookies;
+    SBuf headers;
+    bool sawRegular = false;
+
+    for (const auto &field: fields) {
+        const auto &name = field.name;
+        const auto &value = field.value;
+
+        if (!ValidFieldValue(value))
+            return false;
+
+        if (name.startsWith(SBuf(":"))) {
+            if (sawRegular)
+                return false; // pseudo-header after a regular field
+
+            SBuf *pseudo = nullptr;
+            if (name.cmp(":method") == 0)
+                pseudo = &method;
+            else if (name.cmp(":scheme") == 0)
+                pseudo = &scheme;
+            else if (name.cmp(":authority") == 0)
+                pseudo = &authority;
+            else if (name.cmp(":path") == 0)
+                pseudo = &path;
+            else
+                return false; // unknown or response pseudo-header
+
+            if (!pseudo->isEmpty() || value.isEmpty() || value.findFirstOf(badPseudoChars) != SBuf::npos)
+                return false;
+            *pseudo = value;
+            continue;
+        }
+
+        sawRegular = true;
+        if (!ValidFieldName(name))
+            return false;
+
+        // connection-specific fields are prohibited (RFC 9113 Section 8.2.2)
+        if (name.cmp("connection") == 0 || name.cmp("keep-alive") == 0 ||
+                name.cmp("proxy-connection") == 0 || name.cmp("transfer-encoding") == 0 ||
+                name.cmp("upgrade") == 0)
+            return false;
+
+        if (name.cmp("te") == 0) {
+            if (value.caseCmp("trailers") != 0)
+                return false;
+            continue; // we do not forward trailers
+        }
+
+        if (name.cmp("host") == 0) {
+            host = value;
+            continue;
+        }
+
+        if (name.cmp("cookie") == 0) {
+            if (!cookies.isEmpty())
+                cookies.append("; ");
+            cookies.append(value);
+            continue;
+        }
+
+        if (name.cmp("expect") == 0 && value.caseCmp("100-continue") == 0) {
+            result.expectsContinue = true;
+            continue;
+        }
+
+        if (name.cmp("content-length") == 0) {
+            Parser::Tokenizer tok(value);
+            int64_t length = 0;
+            if (!tok.int64(length, 10, false) || !tok.atEnd())
+                return false;
+            if (result.contentLength >= 0 && result.contentLength != length)
+                return false;
+            result.contentLength = length;
+        }
+
+        headers.append(name).append(": ").append(value).append("\r\n");
+    }
+
+    if (method.cmp("CONNECT") == 0) {
+        result.isConnect = true;
+        return true;
+    }
+
+    if (method.isEmpty() || scheme.isEmpty() || path.isEmpty())
+        return false;
+
+    if (endStream && result.contentLength > 0)
+        return false;
+
+    if (authority.isEmpty())
+        authority = host;
+
+    auto &request = result.request;
+    request.append(method).append(' ');
+    // forward proxies expect absolute-form targets
+    const auto absoluteForm = !port->flags.accelSurrogate && !transparent() &&
+                              !authority.isEmpty() && !internalCheck(path);
+    if (absoluteForm)
+        request.append(scheme).append("://").append(authority);
+    // the version becomes HttpRequest::http_ver before any callouts see it
+    request.append(path).append(" HTTP/2.0\r\n");
+
+    if (!authority.isEmpty())
+        request.append("Host: ").append(authority).append("\r\n");
+    request.append(headers);
+    if (!cookies.isEmpty())
+        request.append("Cookie: ").append(cookies).append("\r\n");
+    if (!endStream && result.contentLength < 0)
+        request.append("Transfer-Encoding: chunked\r\n"); // a body of unknown size
+    request.append("\r\n");
+    return true;
+}
+
+Http::Stream *
+Http::Two::Server::startStream(const uint32_t streamId, const HeaderFields &fields, const bool endStream)
+{
+    if (streams_.size() >= MaxConcurrentStreams) {
+        debugs(33, 3, "refusing stream " << streamId << " beyond " << MaxConcurrentStreams);
+        sendRstStream(streamId, ecRefusedStream);
+        return nullptr;
+    }
+
+    RequestConversion conversion;
+    if (!convertRequest(fields, endStream, conversion)) {
+        debugs(33, 3, "malformed request on stream " << streamId);
+        sendRstStream(streamId, ecProtocolError);
+        return nullptr;
+    }
+
+    if (conversion.isConnect) {
+        debugs(33, 3, "unsupported CONNECT on stream " << streamId);
+        sendStatusOnly(streamId, "501", true);
+        if (!endStream)
+            sendRstStream(streamId, ecNoError);
+        return nullptr;
+    }
+
+    auto &s = streams_[streamId];
+    s.sendWindow = peerInitialWindow_;
+    s.remoteClosed = endStream;
+    s.contentLength = conversion.contentLength;
+
+    if (conversion.expectsContinue && !endStream)
+        sendStatusOnly(streamId, "100", false);
+
+    parsingStream_ = streamId;
+    parser_ = new Http1::RequestParser(false);
+    Http::Stream *context = nullptr;
+    if (!parser_->parse(conversion.request) || parser_->needsMoreData()) {
+        const auto tooBig =
+            parser_->parseStatusCode == Http::scRequestHeaderFieldsTooLarge ||
+            parser_->parseStatusCode == Http::scUriTooLong;
+        context = abortRequestParsing(tooBig ? "error:request-too-large" : "error:invalid-request");
+    } else {
+        context = streamForParsedRequest(parser_);
+    }
+
+    s.context = context;
+    return context;
+}
+
+void
+Http::Two::Server::processParsedRequest(Http::StreamPointer &context)
+{
+    Http1::Server::processParsedRequest(context);
+
+    if (mode_ != pmHttp2)
+        return;
+
+    parsingStream_ = 0;
+
+    // other streams may use the connection while this one receives its body
+    context->mayUseConnection(false);
+}
+
+void
+Http::Two::Server::processSettings(const FrameHeader &header, const SBuf &payload)
+{
+    if (header.streamId) {
+        connectionError(ecProtocolError, "SETTINGS on a stream");
+        return;
+    }
+
+    if (header.hasFlag(ffAck)) {
+        if (header.length)
+            connectionError(ecFrameSizeError, "SETTINGS ACK with a payload");
+        return;
+    }
+
+    if (header.length % 6) {
+        connectionError(ecFrameSizeError, "bad SETTINGS size");
+        return;
+    }
+
+    for (SBuf::size_type pos = 0; pos < payload.length(); pos += 6) {
+        const auto setting = GetUint16(payload.rawContent() + pos);
+        const auto value = GetUint32(payload.rawContent() + pos + 2);
+        debugs(33, 5, "setting " << setting << '=' << value);
+        switch (setting) {
+        case sHeaderTableSize:
+            encoder_.setMaxTableSize(value);
+            break;
+
+        case sEnablePush:
+            if (value > 1) {
+                connectionError(ecProtocolError, "bad SETTINGS_ENABLE_PUSH");
+                return;
+            }
+            break;
+
+        case sInitialWindowSize: {
+            if (value > MaxWindowSize) {
+                connectionError(ecFlowControlError, "bad SETTINGS_INITIAL_WINDOW_SIZE");
+                return;
+            }
+            const auto delta = static_cast<int64_t>(value) - peerInitialWindow_;
+            for (auto &i: streams_) {
+                i.second.sendWindow += delta;
+                if (i.second.sendWindow > MaxWindowSize) {
+                    connectionError(ecFlowControlError, "stream window overflow");
+                    return;
+                }
+            }
+            peerInitialWindow_ = value;
+            break;
+        }
+
+        case sMaxFrameSize:
+            if (value < DefaultMaxFrameSize || value > MaxFrameSizeLimit) {
+                connectionError(ecProtocolError, "bad SETTINGS_MAX_FRAME_SIZE");
+                return;
+            }
+            peerMaxFrameSize_ = value;
+            break;
+
+        default:
+            break; // including SETTINGS_MAX_CONCURRENT_STREAMS since we do not push
+        }
+    }
+
+    sawSettings_ = true;
+    PackFrameHeader(outBuf_, ftSettings, ffAck, 0, 0);
+    frameResponseData(); // stream windows may have grown
+}
+
+void
+Http::Two::Server::processWindowUpdate(const FrameHeader &header, const SBuf &payload)
+{
+    if (header.length != 4) {
+        connectionError(ecFrameSizeError, "bad WINDOW_UPDATE size");
+        return;
+    }
+
+    const int64_t increment = GetUint32(payload.rawContent()) & 0x7fffffff;
+
+    if (!header.streamId) {
+        if (!increment) {
+            connectionError(ecProtocolError, "zero WINDOW_UPDATE");
+            return;
+        }
+        sendWindow_ += increment;
+        if (sendWindow_ > MaxWindowSize) {
+            connectionError(ecFlowControlError, "connection window overflow");
+            return;
+        }
+    } else {
+        const auto it = streams_.find(header.streamId);
+        if (it == streams_.end())
+            return; // a closed stream or a refused one
+
+        if (!increment) {
+            resetStream(header.streamId, ecProtocolError);
+            return;
+        }
+        it->second.sendWindow += increment;
+        if (it->second.sendWindow > MaxWindowSize) {
+            resetStream(header.streamId, ecFlowControlError);
+            return;
+        }
+    }
+
+    frameResponseData();
+}
+
+void
+Http::Two::Server::processRstStream(const FrameHeader &header, const SBuf &payload)
+{
+    if (!header.streamId || header.streamId > lastStreamId_) {
+        connectionError(ecProtocolError, "RST_STREAM on an idle stream");
+        return;
+    }
+
+    if (header.length != 4) {
+        connectionError(ecFrameSizeError, "bad RST_STREAM size");
+        return;
+    }
+
+    debugs(33, 3, "client reset stream " << header.streamId << ": " << ErrorCodeName(GetUint32(payload.rawContent())));
+    const auto wasActive = streams_.find(header.streamId) != streams_.end();
+    static const auto d = MakeNamedErrorDetail("HTTP2_RST_STREAM");
+    forgetStream(header.streamId, d);
+
+    // Opening and immediately canceling streams (a.k.a. "rapid reset") makes
+    // us start transactions that MaxConcurrentStreams does not limit.
+    if (wasActive && clientResets_.count(1) > ClientResetsLimit) {
+        debugs(33, 2, "client reset " << clientResets_.remembered() << " streams in " << ClientResetsWindow << " seconds");
+        connectionError(ecEnhanceYourCalm, "too many streams reset by the client");
+    }
+}
+
+void
+Http::Two::Server::sendStatusOnly(const uint32_t streamId, const char *status, const bool endStream)
+{
+    static const SBuf statusName(":status");
+    SBuf block;
+    encoder_.startBlock(block);
+    encoder_.encode(block, statusName, SBuf(status), HpackEncoder::idxIncremental);
+    PackHeaderBlock(outBuf_, streamId, block, endStream, peerMaxFrameSize_);
+}
+
+void
+Http::Two::Server::sendResponseHeaders(const uint32_t streamId, StreamState &s, HttpReply *rep)
+{
+    s.context->prepareReply(rep);
+
+    static const SBuf statusName(":status");
+    SBuf block;
+    encoder_.startBlock(block);
+    SBuf status;
+    status.appendf("%03d", rep->sline.status());
+    encoder_.encode(block, statusName, status, HpackEncoder::idxIncremental);
+
+    HttpHeaderPos pos = HttpHeaderInitPos;
+    while (const auto e = rep->header.getEntry(&pos)) {
+        switch (e->id) {
+        case Http::HdrType::CONNECTION:
+        case Http::HdrType::KEEP_ALIVE:
+        case Http::HdrType::PROXY_CONNECTION:
+        case Http::HdrType::TRANSFER_ENCODING:
+        case Http::HdrType::UPGRADE:
+            continue; // connection-specific fields are prohibited in HTTP/2
+        default:
+            break;
+        }
+        // Set-Cookie values are too diverse to benefit from indexing
+        const auto indexing = e->id == Http::HdrType::SET_COOKIE ?
+                              HpackEncoder::idxNone : HpackEncoder::idxIncremental;
+        encoder_.encode(block, ToLower(e->name), SBuf(e->value.rawBuf(), e->value.size()), indexing);
+    }
+
+    debugs(11, 2, "HTTP Client " << clientConnection << " stream " << streamId);
+    debugs(11, 2, "HTTP Client REPLY: " << rep->sline.status() << " in " << block.length() << " HPACK bytes");
+
+    const auto before = outBuf_.length();
+    PackHeaderBlock(outBuf_, streamId, block, false, peerMaxFrameSize_);
+    s.bytesQueued += outBuf_.length() - before;
+    s.headersSent = true;
+    s.context->http->out.headers_sz = block.length();
+}
+
+void
+Http::Two::Server::handleStreamReply(const Http::StreamPointer &context, clientStreamNode *node, HttpReply *rep, StoreIOBuffer receivedData)
+{
+    if (mode_ != pmHttp2) {
+        Http1::Server::handleStreamReply(context, node, rep, receivedData);
+        return;
+    }
+
+    const auto it = findStream(context);
+    if (it == streams_.end()) {
+        debugs(33, 3, "ignoring a reply for a forgotten stream");
+        return;
+    }
+
+    const auto streamId = it->first;
+    auto &s = it->second;
+    if (goingAway_)
+        return; // the connection is closing
+
+    if (!s.headersSent) {
+        if (!rep) {
+            resetStream(streamId, ecInternalError);
+            return;
+        }
+        sendResponseHeaders(streamId, s, rep);
+    }
+
+    if (receivedData.data && receivedData.length) {
+        MemBuf mb;
+        mb.init();
+        context->packBody(receivedData, mb);
+        s.pendingData.append(mb.content(), mb.contentSize());
+    }
+
+    s.replyPending = true;
+    frameResponseData();
+
+    if (!s.bytesQueued && !s.bytesWriting && s.pendingData.isEmpty())
+        scheduleStreamWritten(streamId); // nothing to write
+    else
+        writeSomeData();
+}
+
+/// frames buffered response bodies allowed by flow control windows
+void
+Http::Two::Server::frameResponseData()
+{
+    if (goingAway_)
+        return;
+
+    for (auto &i: streams_) {
+        const auto streamId = i.first;
+        auto &s = i.second;
+        while (!s.pendingData.isEmpty() && s.sendWindow > 0 && sendWindow_ > 0) {
+            const auto size = std::min<int64_t>({
+                static_cast<int64_t>(s.pendingData.length()),
+                s.sendWindow,
+                sendWindow_,
+                static_cast<int64_t>(peerMaxFrameSize_)
+            });
+            PackFrameHeader(outBuf_, ftData, 0, streamId, size);
+            outBuf_.append(s.pendingData.rawContent(), size);
+            s.pendingData.consume(size);
+            s.sendWindow -= size;
+            sendWindow_ -= size;
+            s.bytesQueued += FrameHeaderSize + size;
+        }
+    }
+}
+
+void
+Http::Two::Server::writeSomeData()
+{
+    if (mode_ != pmHttp2 || writing() || outBuf_.isEmpty() || !isOpen())
+        return;
+
+    for (auto &i: streams_) {
+        i.second.bytesWriting += i.second.bytesQueued;
+        i.second.bytesQueued = 0;
+    }
+
+    MemBuf mb;
+    mb.init(outBuf_.length(), outBuf_.length() + 1);
+    mb.append(outBuf_.rawContent(), outBuf_.length());
+    outBuf_.clear();
+    write(&mb);
+}
+
+void
+Http::Two::Server::afterClientWrite(const size_t size)
+{
+    if (mode_ != pmHttp2) {
+        Http1::Server::afterClientWrite(size);
+        return;
+    }
+
+    statCounter.client_http.kbytes_out += size;
+
+    if (goingAway_) {
+        if (outBuf_.isEmpty())
+            clientConnection->close();
+        return;
+    }
+
+    std::vector<uint32_t> written;
+    for (auto &i: streams_) {
+        auto &s = i.second;
+        s.bytesWritten += s.bytesWriting;
+        s.bytesWriting = 0;
+        if (s.replyPending && !s.bytesQueued && s.pendingData.isEmpty())
+            written.push_back(i.first);
+    }
+
+    for (const auto streamId: written)
+        noteStreamWritten(streamId);
+}
+
+/// asynchronously calls noteStreamWritten() to avoid reentering clientStream
+void
+Http::Two::Server::scheduleStreamWritten(const uint32_t streamId)
+{
+    typedef UnaryMemFunT<Http2::Server, uint32_t> Dialer;
+    AsyncCall::Pointer call = asyncCall(33, 5, "Http2::Server::noteStreamWritten",
+                                        Dialer(this, &Http2::Server::noteStreamWritten, streamId));
+    ScheduleCallHere(call);
+}
+
+/// tells the stream that its last reply piece has been written
+void
+Http::Two::Server::noteStreamWritten(const uint32_t streamId)
+{
+    auto it = streams_.find(streamId);
+    if (it == streams_.end() || !it->second.replyPending)
+        return;
+
+    auto &s = it->second;
+    s.replyPending = false;
+    const auto size = s.bytesWritten;
+    s.bytesWritten = 0;
+
+    const auto context = s.context; // writeComplete() may finish the stream
+    const auto http = context->http;
+    if (size && http->loggingTags().isTcpHit())
+        statCounter.client_http.hit_kbytes_out += size;
+
+    // HTTP/1 connection persistence does not apply to individual streams
+    if (http->request)
+        http->request->flags.proxyKeepalive = true;
+
+    const auto state = context->socketState();
+    if (state == STREAM_UNPLANNED_COMPLETE || state == STREAM_FAILED) {
+        debugs(33, 3, "stream " << streamId << " failed: " << state);
+        resetStream(streamId, ecInternalError);
+        return;
+    }
+
+    context->writeComplete(size);
+
+    it = streams_.find(streamId);
+    if (it != streams_.end() && !it->second.context->connRegistered())
+        closeStream(streamId);
+}
+
+/// ends a stream after its transaction is finished
+void
+Http::Two::Server::closeStream(const uint32_t streamId)
+{
+    const auto it = streams_.find(streamId);
+    if (it == streams_.end())
+        return;
+
+    PackFrameHeader(outBuf_, ftData, ffEndStream, streamId, 0);
+    if (!it->second.remoteClosed)
+        sendRstStream(streamId, ecNoError); // we do not need the rest of the request
+    forgetStream(streamId, nullptr);
+    writeSomeData();
+}
+
+void
+Http::Two::Server::resetStream(const uint32_t streamId, const ErrorCode error)
+{
+    debugs(33, 3, "resetting stream " << streamId << " with " << ErrorCodeName(error));
+    sendRstStream(streamId, error);
+    static const auto d = MakeNamedErrorDetail("HTTP2_STREAM_ERROR");
+    forgetStream(streamId, d);
+    writeSomeData();
+}
+
+/// sends RST_STREAM, remembering the stream to ignore its in-flight frames
+void
+Http::Two::Server::sendRstStream(const uint32_t streamId, const ErrorCode error)
+{
+    PackRstStream(outBuf_, streamId, error);
+    if (resetStreams_.size() >= MaxConcurrentStreams)
+        resetStreams_.pop_front();
+    resetStreams_.push_back(streamId);
+}
+
+/// whether we have recently sent RST_STREAM for the given stream
+bool
+Http::Two::Server::wasReset(const uint32_t streamId) const
+{
+    return std::find(resetStreams_.begin(), resetStreams_.end(), streamId) != resetStreams_.end();
+}
+
+/// removes the stream state, terminating the stream transaction (if any)
+void
+Http::Two::Server::forgetStream(const uint32_t streamId, const ErrorDetailPointer &detail)
+{
+    const auto it = streams_.find(streamId);
+    if (it == streams_.end())
+        return;
+
+    auto s = it->second;
+    streams_.erase(it);
+
+    if (s.bodyPipe)
+        stopProducingFor(s.bodyPipe, false);
+
+    if (s.context && s.context->connRegistered()) {
+        LogTagsErrors lte;
+        lte.aborted = true;
+        s.context->noteIoError(Error(ERR_CLIENT_GONE, detail), lte);
+        s.context->finished();
+    }
+
+    if (pipeline.empty() && isOpen())
+        resetReadTimeout(clientConnection->timeLeft(idleTimeout()));
+}
+
+/// moves buffered request body bytes into the stream body pipe
+void
+Http::Two::Server::feedBody(const uint32_t streamId)
+{
+    const auto it = streams_.find(streamId);
+    if (it == streams_.end())
+        return;
+
+    auto &s = it->second;
+    if (!s.bodyPipe)
+        return; // no body pipe yet or no longer
+
+    if (!s.bodyBuf.isEmpty()) {
+        if (const auto putSize = s.bodyPipe->putMoreData(s.bodyBuf)) {
+            s.bodyBuf.consume(putSize);
+            if (!s.remoteClosed) {
+                PackWindowUpdate(outBuf_, streamId, putSize);
+                s.recvWindow += putSize;
+            }
+        }
+    }
+
+    if (!s.bodyPipe->mayNeedMoreData()) {
+        // BodyPipe will clear us automagically when we produced everything
+        s.bodyPipe = nullptr;
+    } else if (s.remoteClosed && s.bodyBuf.isEmpty()) {
+        stopProducingFor(s.bodyPipe, true);
+    }
+
+    writeSomeData();
+}
+
+BodyPipe::Pointer
+Http::Two::Server::expectRequestBody(const int64_t size)
+{
+    if (mode_ != pmHttp2)
+        return Http1::Server::expectRequestBody(size);
+
+    const auto it = streams_.find(parsingStream_);
+    Must(it != streams_.end());
+    auto &s = it->second;
+    s.bodyPipe = new BodyPipe(this);
+    if (size >= 0)
+        s.bodyPipe->setBodySize(size);
+    return s.bodyPipe;
+}
+
+bool
+Http::Two::Server::handleRequestBodyData()
+{
+    if (mode_ != pmHttp2)
+        return Http1::Server::handleRequestBodyData();
+
+    feedBody(parsingStream_);
+    return true;
+}
+
+void
+Http::Two::Server::noteMoreBodySpaceAvailable(BodyPipe::Pointer pipe)
+{
+    if (mode_ != pmHttp2) {
+        Http1::Server::noteMoreBodySpaceAvailable(pipe);
+        return;
+    }
+
+    const auto it = findStream(pipe);
+    if (it != streams_.end())
+        feedBody(it->first);
+}
+
+void
+Http::Two::Server::noteBodyConsumerAborted(BodyPipe::Pointer pipe)
+{
+    if (mode_ != pmHttp2) {
+        Http1::Server::noteBodyConsumerAborted(pipe);
+        return;
+    }
+
+    const auto it = findStream(pipe);
+    if (it == streams_.end())
+        return;
+
+    const auto streamId = it->first;
+    auto &s = it->second;
+    stopProducingFor(s.bodyPipe, false);
+    s.discardingBody = true;
+    if (!s.bodyBuf.isEmpty() && !s.remoteClosed) {
+        PackWindowUpdate(outBuf_, streamId, s.bodyBuf.length());
+        s.recvWindow += s.bodyBuf.length();
+    }
+    s.bodyBuf.clear();
+    writeSomeData();
+}
+
+void
+Http::Two::Server::quitAfterError(HttpRequest *request)
+{
+    if (mode_ != pmHttp2) {
+        Http1::Server::quitAfterError(request);
+        return;
+    }
+
+    // an HTTP/2 stream error does not affect other streams
+    debugs(33, 4, "keeping " << clientConnection << " open after a stream error");
+}
+
+bool
+Http::Two::Server::writeControlMsgAndCall(HttpReply *rep, AsyncCall::Pointer &call)
+{
+    if (mode_ != pmHttp2)
+        return Http1::Server::writeControlMsgAndCall(rep, call);
+
+    // we do not know which stream the message belongs to
+    debugs(11, 2, "drop HTTP/2 1xx control message " << rep->sline.status());
+    return false;
+}
+
+int
+Http::Two::Server::pipelinePrefetchMax() const
+{
+    if (mode_ != pmHttp2)
+        return Http1::Server::pipelinePrefetchMax();
+
+    // startStream() refuses excessive streams; the pipeline never fills up
+    return MaxConcurrentStreams;
+}
+
+/// sends GOAWAY and closes the connection after writing it
+void
+Http::Two::Server::connectionError(const ErrorCode error, const char *reason)
+{
+    debugs(33, 2, "HTTP/2 connection error " << ErrorCodeName(error) << " on " << clientConnection << ": " << reason);
+    if (goingAway_)
+        return;
+
+    goingAway_ = true;
+    PackGoAway(outBuf_, lastStreamId_, error);
+    flags.readMore = false;
+    stopReading();
+    inBuf.clear();
+    partialFrame_.clear();
+    writeSomeData();
+}
+
+Http::Two::Server::Streams::iterator
+Http::Two::Server::findStream(const Http::StreamPointer &context)
+{
+    return std::find_if(streams_.begin(), streams_.end(), [&context](const Streams::value_type &i) {
+        return i.second.context == context;
+    });
+}
+
+Http::Two::Server::Streams::iterator
+Http::Two::Server::findStream(const BodyPipe::Pointer &pipe)
+{
+    return std::find_if(streams_.begin(), streams_.end(), [&pipe](const Streams::value_type &i) {
+        return i.second.bodyPipe == pipe;
+    });
+}
+
+void
+Http::Two::Server::swanSong()
+{
+    for (auto &i: streams_) {
+        if (i.second.bodyPipe)
+            stopProducingFor(i.second.bodyPipe, false);
+    }
+    streams_.clear();
+
+    Http1::Server::swanSong();
+}
+
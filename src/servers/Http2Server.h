@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_SERVERS_HTTP2SERVER_H
+#define SQUID_SRC_SERVERS_HTTP2SERVER_H
+
+#include "error/forward.h"
+#include "FadingCounter.h"
+#include "http/two/Frame.h"
+#include "http/two/Hpack.h"
+#include "servers/Http1Server.h"
+
+#include <deque>
+#include <map>
+
+namespace Http
+{
+namespace Two
+{
+
+/// Manages a connection from an HTTP/2 client on ports with the http2 option.
+///
+/// The connection starts as an HTTP/1 connection and switches to HTTP/2 when
+/// the client starts with the HTTP/2 connection preface (after negotiating
+/// HTTP/2 via TLS ALPN or with prior knowledge). Each HTTP/2 stream becomes
+/// an Http::Stream with the usual ClientHttpRequest and clientStream
+/// machinery; stream request headers are converted into an HTTP/1.1-style
+/// request (with an HTTP/2.0 version) for that machinery to parse.
+class Server: public Http1::Server
+{
+    CBDATA_CHILD(Server);
+
+public:
+    Server(const MasterXaction::Pointer &xact, const bool beHttpsServer);
+    ~Server() override {}
+
+    /// the maximum number of concurrent streams we allow the client to open
+    static const uint32_t MaxConcurrentStreams = 100;
+
+    /// the time span (in seconds) of ClientResetsLimit
+    static const time_t ClientResetsWindow = 10;
+
+    /// the maximum tolerated number of active streams reset by the client
+    /// during ClientResetsWindow
+    static const int ClientResetsLimit = 2*MaxConcurrentStreams;
+
+    /* ConnStateData API */
+    void handleStreamReply(const Http::StreamPointer &, clientStreamNode *, HttpReply *, StoreIOBuffer receivedData) override;
+    BodyPipe::Pointer expectRequestBody(int64_t size) override;
+    bool handleRequestBodyData() override;
+    void quitAfterError(HttpRequest *) override;
+
+    /* ::Server API */
+    void afterClientWrite(size_t) override;
+    void writeSomeData() override;
+
+protected:
+    /* ConnStateData API */
+    Http::Stream *parseOneRequest() override;
+    void processParsedRequest(Http::StreamPointer &context) override;
+    bool writeControlMsgAndCall(HttpReply *rep, AsyncCall::Pointer &call) override;
+    int pipelinePrefetchMax() const override;
+
+    /* BodyPipe API */
+    void noteMoreBodySpaceAvailable(BodyPipe::Pointer) override;
+    void noteBodyConsumerAborted(BodyPipe::Pointer) override;
+
+    /* AsyncJob API */
+    void swanSong() override;
+
+private:
+    /// HTTP/2 state of a client-initiated stream
+    class StreamState
+    {
+    public:
+        Http::StreamPointer context; ///< the transaction (once parsed)
+
+        BodyPipe::Pointer bodyPipe; ///< request body we are producing (if any)
+        SBuf bodyBuf; ///< received request body bytes not yet in bodyPipe
+        uint64_t bodyReceived = 0; ///< total request body bytes received
+        int64_t contentLength = -1; ///< request Content-Length value (or -1)
+        bool discardingBody = false; ///< nobody wants the remaining request body
+        bool remoteClosed = false; ///< the client sent END_STREAM
+
+        int64_t recvWindow = DefaultWindowSize; ///< stream flow control window for DATA we receive
+        int64_t sendWindow = DefaultWindowSize; ///< stream flow control window for DATA we send
+
+        bool headersSent = false; ///< whether response HEADERS were queued
+        bool replyPending = false; ///< clientStream waits for our writeComplete()
+        SBuf pendingData; ///< response body bytes blocked by flow control
+        size_t bytesQueued = 0; ///< stream bytes in outBuf_
+        size_t bytesWriting = 0; ///< stream bytes being written
+        size_t bytesWritten = 0; ///< stream bytes written since the last writeComplete()
+    };
+
+    typedef std::map<uint32_t, StreamState> Streams;
+
+    void switchToHttp2();
+    Http::Stream *parseFrames();
+    Http::Stream *processFrame(const FrameHeader &, const SBuf &payload);
+    Http::Stream *processHeaders(const FrameHeader &, const SBuf &payload);
+    Http::Stream *processContinuation(const FrameHeader &, const SBuf &payload);
+    Http::Stream *processHeaderBlock();
+    Http::Stream *startStream(uint32_t streamId, const HeaderFields &, bool endStream);
+    void processData(const FrameHeader &, const SBuf &payload);
+    void processSettings(const FrameHeader &, const SBuf &payload);
+    void processWindowUpdate(const FrameHeader &, const SBuf &payload);
+    void processRstStream(const FrameHeader &, const SBuf &payload);
+    bool unpad(const FrameHeader &, SBuf &payload);
+
+    /// the results of converting HTTP/2 request header fields
+    class RequestConversion
+    {
+    public:
+        SBuf request; ///< HTTP/1.1 request header
+        int64_t contentLength = -1; ///< Content-Length value (or -1)
+        bool expectsContinue = false; ///< had Expect: 100-continue
+        bool isConnect = false; ///< a CONNECT request
+    };
+    bool convertRequest(const HeaderFields &, bool endStream, RequestConversion &) const;
+    void sendStatusOnly(uint32_t streamId, const char *status, bool endStream);
+    void sendResponseHeaders(uint32_t streamId, StreamState &, HttpReply *);
+    void feedBody(uint32_t streamId);
+    void frameResponseData();
+    void scheduleStreamWritten(uint32_t streamId);
+    void noteStreamWritten(uint32_t streamId);
+    void closeStream(uint32_t streamId);
+    void resetStream(uint32_t streamId, ErrorCode);
+    void sendRstStream(uint32_t streamId, ErrorCode);
+    bool wasReset(uint32_t streamId) const;
+    void forgetStream(uint32_t streamId, const ErrorDetailPointer &);
+    void connectionError(ErrorCode, const char *reason);
+    Streams::iterator findStream(const Http::StreamPointer &);
+    Streams::iterator findStream(const BodyPipe::Pointer &);
+
+    /// the protocol spoken on this connection
+    typedef enum { pmUndecided, pmHttp1, pmHttp2 } ProtocolMode;
+    ProtocolMode mode_ = pmUndecided;
+
+    Streams streams_; ///< open (or half-closed) streams
+
+    /// recently reset streams; the client may still send frames for them
+    std::deque<uint32_t> resetStreams_;
+
+    /// recent RST_STREAM frames that canceled active streams
+    FadingCounter clientResets_;
+
+    HpackDecoder decoder_; ///< decodes request header blocks
+    HpackEncoder encoder_; ///< encodes response header blocks
+
+    SBuf partialFrame_; ///< an incomplete frame received from the client
+    SBuf outBuf_; ///< frames waiting to be written to the client
+
+    /// a partially received header block (i.e. not ending with END_HEADERS)
+    SBuf headerBlock_;
+    uint32_t headerBlockStream_ = 0; ///< the headerBlock_ stream (or zero)
+    bool headerBlockEndsStream_ = false; ///< whether headerBlock_ HEADERS had END_STREAM
+    bool headerBlockOpensStream_ = false; ///< whether headerBlock_ starts a new stream
+
+    uint32_t lastStreamId_ = 0; ///< the highest client-initiated stream ID seen
+    uint32_t parsingStream_ = 0; ///< the stream of the being-processed request
+
+    bool sawSettings_ = false; ///< the client has sent its SETTINGS
+    bool goingAway_ = false; ///< we sent GOAWAY and will close after writing it
+
+    int64_t sendWindow_ = DefaultWindowSize; ///< connection flow control window for DATA we send
+    int64_t peerInitialWindow_ = DefaultWindowSize; ///< client SETTINGS_INITIAL_WINDOW_SIZE
+    uint32_t peerMaxFrameSize_ = DefaultMaxFrameSize; ///< client SETTINGS_MAX_FRAME_SIZE
+};
+
+} // namespace Two
+} // namespace Http
+
+#endif /* SQUID_SRC_SERVERS_HTTP2SERVER_H */
+
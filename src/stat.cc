@@ -1217,6 +1217,8 @@ statCountersInitSpecial(StatCounters * C)
     C->client_http.nearMissSvcTime.logInit(300, 0.0, 3600000.0 * 3.0);
     C->client_http.nearHitSvcTime.logInit(300, 0.0, 3600000.0 * 3.0);
     C->client_http.hitSvcTime.logInit(300, 0.0, 3600000.0 * 3.0);
+    for (auto &hist: C->client_http.phaseTimes)
+        hist.logInit(300, 0.0, 3600000.0 * 3.0);
     /*
      * ICP svc_time hist is kept in micro-seconds; max of 1 minute.
      */
@@ -1336,6 +1338,11 @@ statCountersHistograms(StoreEntry * sentry)
     statCounter.client_http.nearHitSvcTime.dump(sentry, nullptr);
     storeAppendPrintf(sentry, "client_http.hitSvcTime histogram:\n");
     statCounter.client_http.hitSvcTime.dump(sentry, nullptr);
+    for (int i = 0; i < TransactionPhases::phaseCount; ++i) {
+        const auto phase = static_cast<TransactionPhases::Phase>(i);
+        storeAppendPrintf(sentry, "client_http.phaseTimes.%s histogram:\n", TransactionPhases::Name(phase));
+        statCounter.client_http.phaseTimes[phase].dump(sentry, nullptr);
+    }
     storeAppendPrintf(sentry, "icp.querySvcTime histogram:\n");
     statCounter.icp.querySvcTime.dump(sentry, nullptr);
     storeAppendPrintf(sentry, "icp.replySvcTime histogram:\n");
@@ -350,6 +350,7 @@ StoreEntry::StoreEntry() :
     ping_status(PING_NONE),
     store_status(STORE_PENDING),
     swap_status(SWAPOUT_NONE),
+    digestEpoch(0),
     lock_count(0),
     shareableWhenPrivate(false)
 {
@@ -433,6 +434,9 @@ void
 StoreEntry::hashDelete()
 {
     if (key) { // some test cases do not create keys and do not hashInsert()
+        // idle entries may leave the index while staying cached
+        if (store_digest && EBIT_TEST(flags, RELEASE_REQUEST))
+            storeDigestDel(this);
         hash_remove_link(store_table, this);
         storeKeyFree((const cache_key *)key);
         key = nullptr;
@@ -575,8 +579,15 @@ bool
 StoreEntry::setPublicKey(const KeyScope scope)
 {
     debugs(20, 3, *this);
-    if (key && !EBIT_TEST(flags, KEY_PRIVATE))
+    if (key && !EBIT_TEST(flags, KEY_PRIVATE)) {
+        // an entry made public before getting its response may need a new key
+        if (scope == ksDefault && !Store::Root().transientReaders(*this))
+            return clearPublicKeyScope();
+        // Remote collapsed readers cannot follow us to a new key, so we keep
+        // feeding them under the old one. Lookups of a variant stored under
+        // its base key are still checked by varyEvaluateMatch().
         return true; // already public
+    }
 
     assert(mem_obj);
 
@@ -593,7 +604,9 @@ StoreEntry::setPublicKey(const KeyScope scope)
     assert(!EBIT_TEST(flags, RELEASE_REQUEST));
 
     try {
-        EntryGuard newVaryMarker(adjustVary(), "setPublicKey+failure");
+        // Without a response, we cannot know its variance. The key keeps the
+        // request variance (if any) until clearPublicKeyScope() adjusts it.
+        EntryGuard newVaryMarker(hasParsedReplyHeader() ? adjustVary() : nullptr, "setPublicKey+failure");
         const cache_key *pubKey = calcPublicKey(scope);
         Store::Root().addWriting(this, pubKey);
         forcePublicKey(pubKey);
@@ -605,19 +618,35 @@ StoreEntry::setPublicKey(const KeyScope scope)
     return false;
 }
 
-void
+bool
 StoreEntry::clearPublicKeyScope()
 {
     if (!key || EBIT_TEST(flags, KEY_PRIVATE))
-        return; // probably the old public key was deleted or made private
-
-    // TODO: adjustVary() when collapsed revalidation supports that
+        return false; // probably the old public key was deleted or made private
 
-    const cache_key *newKey = calcPublicKey(ksDefault);
-    if (!storeKeyHashCmp(key, newKey))
-        return; // probably another collapsed revalidation beat us to this change
+    assert(mem_obj);
+    const auto &request = mem_obj->request;
+    const auto varianceChanged = request && request->vary_headers.cmp(mem_obj->vary_headers) != 0;
+    if (!varianceChanged && !storeKeyHashCmp(key, calcPublicKey(ksDefault)))
+        return true; // the key already matches the response
 
-    forcePublicKey(newKey);
+    try {
+        // Remote collapsed readers cannot follow us to the new key; they will
+        // notice that their entry has lost its writer. We leave the old key
+        // first so that adjustVary() does not mistake us for a Vary marker.
+        Store::Root().transientsDisconnect(*this);
+        hashDelete();
+        EntryGuard newVaryMarker(adjustVary(), "clearPublicKeyScope+failure");
+        const cache_key *newKey = calcPublicKey(ksDefault);
+        Store::Root().addWriting(this, newKey);
+        forcePublicKey(newKey);
+        newVaryMarker.unlockAndReset("clearPublicKeyScope+success");
+        return true;
+    } catch (const std::exception &ex) {
+        debugs(20, 2, "for " << *this << " failed: " << ex.what());
+    }
+    makePrivate(true); // a stale key without Transients is not usable
+    return false;
 }
 
 /// Unconditionally sets public key for this store entry.
@@ -787,8 +816,13 @@ StoreEntry::write (StoreIOBuffer writeBuffer)
     writeBuffer.offset += mem_obj->baseReply().hdr_sz;
 
     debugs(20, 5, "storeWrite: writing " << writeBuffer.length << " bytes for '" << getMD5Text() << "'");
-    storeGetMemSpace(writeBuffer.length);
-    mem_obj->write(writeBuffer);
+    {
+        // excludes store client notifications triggered by invokeHandlers()
+        const auto &request = mem_obj->request;
+        const TransactionPhases::Scope storing(request ? &request->masterXaction->phases : nullptr, TransactionPhases::storeWrite);
+        storeGetMemSpace(writeBuffer.length);
+        mem_obj->write(writeBuffer);
+    }
 
     if (EBIT_TEST(flags, ENTRY_FWD_HDR_WAIT) && !mem_obj->readAheadPolicyCanRead()) {
         debugs(20, 3, "allow Store clients to get entry content after buffering too much for " << *this);
@@ -0,0 +1,317 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/* DEBUG: section 20    Storage Manager */
+
+#include "squid.h"
+#include "base/Packable.h"
+#include "base/RunnersRegistry.h"
+#include "debug/Stream.h"
+#include "ipc/mem/FlexibleArray.h"
+#include "ipc/mem/Pointer.h"
+#include "ipc/mem/Segment.h"
+#include "md5.h"
+#include "mgr/Registration.h"
+#include "SquidConfig.h"
+#include "Store.h"
+#include "store/Admission.h"
+#include "store/Disk.h"
+#include "store_key_md5.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+namespace Store
+{
+
+/// A count-min sketch of recent cache lookups: Depth rows of width
+/// saturating counters each. Every row uses different key bits to pick
+/// its counter. Shared by all kids.
+class FrequencySketch
+{
+public:
+    /// the number of counter rows
+    static const int Depth = 4;
+
+    /// the largest counter value (TinyLFU uses 4-bit counters)
+    static const uint8_t MaxCount = 15;
+
+    explicit FrequencySketch(uint32_t aWidth);
+
+    size_t sharedMemorySize() const { return SharedMemorySize(width); }
+    static size_t SharedMemorySize(const uint32_t aWidth) { return sizeof(FrequencySketch) + size_t(Depth)*aWidth*sizeof(std::atomic<uint8_t>); }
+
+    /// counts one more lookup of the given key, aging counters as needed
+    void increment(const cache_key *);
+
+    /// the approximate number of recent lookups of the given key
+    uint8_t estimate(const cache_key *);
+
+    const uint32_t width; ///< the number of counters in a row; a power of two
+    const uint64_t sampleSize; ///< the number of increments between agings
+
+    std::atomic<uint64_t> additions; ///< increment() calls so far
+    std::atomic<uint64_t> agings; ///< age() calls so far
+
+    Ipc::Mem::FlexibleArray< std::atomic<uint8_t> > counters; ///< all rows
+
+private:
+    /// the given key counter in the given row
+    std::atomic<uint8_t> &counter(int row, const cache_key *);
+
+    /// halves all counters
+    void age();
+};
+
+} // namespace Store
+
+/// shared memory segment label
+static const char * const SketchLabel = "store_admission";
+
+/// the sketch segment opened by this kid (if any)
+static Ipc::Mem::Pointer<Store::FrequencySketch> TheSketch;
+
+/// all admission filters in this kid; for reporting
+static std::vector<const Store::Admission *> &
+Filters()
+{
+    static const auto filters = new std::vector<const Store::Admission *>();
+    return *filters;
+}
+
+/// lookup statistics of this kid
+static struct {
+    uint64_t lookups = 0; ///< NoteLookup() calls
+    uint64_t hits = 0; ///< NoteLookup() calls that found a cached entry
+} LookupStats;
+
+/* Store::FrequencySketch */
+
+Store::FrequencySketch::FrequencySketch(const uint32_t aWidth):
+    width(aWidth),
+    // TinyLFU ages counters after sampling ten lookups per cached entry
+    sampleSize(10*uint64_t(aWidth)),
+    additions(0),
+    agings(0),
+    counters(Depth*aWidth)
+{
+    for (int i = 0; i < Depth*int(width); ++i)
+        counters[i].store(0, std::memory_order_relaxed);
+}
+
+std::atomic<uint8_t> &
+Store::FrequencySketch::counter(const int row, const cache_key *key)
+{
+    // cache keys are MD5 digests, so their bits are already well mixed
+    static_assert(SQUID_MD5_DIGEST_LENGTH >= Depth*sizeof(uint32_t), "every sketch row uses different key bits");
+    uint32_t bits;
+    memcpy(&bits, key + row*sizeof(bits), sizeof(bits));
+    return counters[row*width + (bits & (width - 1))];
+}
+
+uint8_t
+Store::FrequencySketch::estimate(const cache_key *key)
+{
+    auto lowest = MaxCount;
+    for (int row = 0; row < Depth; ++row)
+        lowest = std::min(lowest, counter(row, key).load(std::memory_order_relaxed));
+    return lowest;
+}
+
+void
+Store::FrequencySketch::increment(const cache_key *key)
+{
+    // conservative update: only increment the counters that limit estimate()
+    const auto lowest = estimate(key);
+    if (lowest < MaxCount) {
+        for (int row = 0; row < Depth; ++row) {
+            auto expected = lowest;
+            (void)counter(row, key).compare_exchange_strong(expected, uint8_t(lowest + 1), std::memory_order_relaxed);
+        }
+    }
+
+    // the kid that completes a sample ages the counters for everybody
+    if ((additions.fetch_add(1, std::memory_order_relaxed) + 1) % sampleSize == 0)
+        age();
+}
+
+void
+Store::FrequencySketch::age()
+{
+    debugs(20, 3, "after " << additions.load() << " lookups");
+    for (int i = 0; i < Depth*int(width); ++i) {
+        auto &c = counters[i];
+        auto current = c.load(std::memory_order_relaxed);
+        while (current && !c.compare_exchange_weak(current, current/2, std::memory_order_relaxed)) {}
+    }
+    ++agings;
+}
+
+/* Store::Admission */
+
+Store::Admission::Admission(const char * const cacheName):
+    cacheName_(cacheName)
+{
+    Filters().push_back(this);
+}
+
+Store::Admission::~Admission()
+{
+    auto &filters = Filters();
+    filters.erase(std::remove(filters.begin(), filters.end(), this), filters.end());
+}
+
+void
+Store::Admission::NoteLookup(const cache_key * const key, const bool found)
+{
+    ++LookupStats.lookups;
+    if (found)
+        ++LookupStats.hits;
+
+    if (TheSketch)
+        TheSketch->increment(key);
+}
+
+bool
+Store::Admission::admit(const cache_key * const candidate, const cache_key * const victim)
+{
+    // without a sketch or a victim, there is nothing to weigh
+    if (!TheSketch || !victim || memcmp(candidate, victim, SQUID_MD5_DIGEST_LENGTH) == 0) {
+        ++admitted_;
+        return true;
+    }
+
+    const auto candidateCount = TheSketch->estimate(candidate);
+    const auto victimCount = TheSketch->estimate(victim);
+    debugs(20, 5, cacheName_ << ' ' << storeKeyText(candidate) << '=' << int(candidateCount) <<
+           " vs. victim " << storeKeyText(victim) << '=' << int(victimCount));
+
+    if (candidateCount > victimCount) {
+        ++admitted_;
+        return true;
+    }
+
+    ++rejected_;
+    return false;
+}
+
+void
+Store::Admission::packStatsInto(Packable * const p) const
+{
+    const auto decisions = admitted_ + rejected_;
+    p->appendf("\t" SQUIDSBUFPH ": admitted %" PRIu64 ", rejected %" PRIu64 " (%.1f%%)\n",
+               SQUIDSBUFPRINT(cacheName_), admitted_, rejected_,
+               decisions ? 100.0*rejected_/decisions : 0.0);
+}
+
+/// cache manager store_admission report
+static void
+AdmissionStats(StoreEntry * const sentry)
+{
+    sentry->appendf("Store admission (TinyLFU):\n");
+    if (TheSketch) {
+        sentry->appendf("\tsketch counters: %d x %" PRIu32 "\n", Store::FrequencySketch::Depth, TheSketch->width);
+        sentry->appendf("\tsketch additions: %" PRIu64 "\n", TheSketch->additions.load());
+        sentry->appendf("\tsketch agings: %" PRIu64 " (every %" PRIu64 " additions)\n",
+                        TheSketch->agings.load(), TheSketch->sampleSize);
+    } else {
+        sentry->appendf("\tsketch: disabled\n");
+    }
+
+    sentry->appendf("\tlookups: %" PRIu64 "\n", LookupStats.lookups);
+    sentry->appendf("\tlookup hits: %" PRIu64 " (%.1f%%)\n", LookupStats.hits,
+                    LookupStats.lookups ? 100.0*LookupStats.hits/LookupStats.lookups : 0.0);
+
+    for (const auto filter: Filters())
+        filter->packStatsInto(sentry);
+}
+
+/// whether any cache is configured to use an admission filter
+static bool
+AdmissionConfigured()
+{
+    if (Config.onoff.memory_cache_admission)
+        return true;
+
+    for (size_t i = 0; i < Config.cacheSwap.n_configured; ++i) {
+        if (INDEXSD(i)->flags.admission)
+            return true;
+    }
+
+    return false;
+}
+
+/// the number of counters in a sketch row, based on the number of entries
+/// that all caches may store
+static uint32_t
+SketchWidth()
+{
+    auto capacity = uint64_t(Config.memMaxSize);
+    for (size_t i = 0; i < Config.cacheSwap.n_configured; ++i)
+        capacity += INDEXSD(i)->maxSize();
+
+    const auto entries = capacity / std::max(Config.Store.avgObjectSize, int64_t(1));
+    const auto wanted = std::clamp(entries, uint64_t(1) << 10, uint64_t(1) << 22);
+
+    uint32_t width = 1;
+    while (width < wanted)
+        width <<= 1;
+    return width;
+}
+
+/// creates and opens the shared admission sketch
+class AdmissionRr: public Ipc::Mem::RegisteredRunner
+{
+public:
+    /* RegisteredRunner API */
+    void useConfig() override;
+    ~AdmissionRr() override;
+
+protected:
+    /* Ipc::Mem::RegisteredRunner API */
+    void create() override;
+    void open() override;
+
+private:
+    Ipc::Mem::Owner<Store::FrequencySketch> *owner = nullptr;
+};
+
+DefineRunnerRegistrator(AdmissionRr);
+
+void
+AdmissionRr::useConfig()
+{
+    Mgr::RegisterAction("store_admission", "Store Admission Statistics", AdmissionStats, 0, 1);
+
+    if (AdmissionConfigured() && Ipc::Mem::Segment::Enabled())
+        Ipc::Mem::RegisteredRunner::useConfig();
+}
+
+void
+AdmissionRr::create()
+{
+    const auto width = SketchWidth();
+    debugs(20, 3, "sketch width: " << width);
+    Must(!owner);
+    owner = shm_new(Store::FrequencySketch)(SketchLabel, width);
+}
+
+void
+AdmissionRr::open()
+{
+    Must(!TheSketch);
+    TheSketch = shm_old(Store::FrequencySketch)(SketchLabel);
+}
+
+AdmissionRr::~AdmissionRr()
+{
+    delete owner;
+}
+
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#ifndef SQUID_SRC_STORE_ADMISSION_H
+#define SQUID_SRC_STORE_ADMISSION_H
+
+#include "sbuf/SBuf.h"
+#include "store/forward.h"
+
+class Packable;
+
+namespace Store {
+
+/// TinyLFU admission filter of a single cache (cache_mem or a cache_dir).
+/// Refuses to cache a new entry unless that entry is estimated to be more
+/// popular than the cached entry that storing the new one would evict.
+/// Popularity estimates come from a count-min sketch of recent cache
+/// lookups. The sketch lives in shared memory: All kids and all caches
+/// contribute to and consult the same estimates. The sketch counters are
+/// periodically halved so that estimates reflect recent popularity.
+class Admission
+{
+public:
+    /// creates a filter for the named cache
+    explicit Admission(const char *cacheName);
+    ~Admission();
+
+    Admission(Admission &&) = delete; // no copying or moving of any kind
+
+    /// counts a cache lookup for the given entry key; found is true if
+    /// the lookup has found a cached entry
+    static void NoteLookup(const cache_key *, bool found);
+
+    /// whether the cache should store the candidate entry, given the key of
+    /// the cached entry that storing the candidate would evict (or nil)
+    bool admit(const cache_key *candidate, const cache_key *victim);
+
+    /// reports this filter statistics to the cache manager
+    void packStatsInto(Packable *) const;
+
+private:
+    const SBuf cacheName_; ///< cache_dir path or cache_mem; for reporting
+
+    uint64_t admitted_ = 0; ///< number of positive admit() decisions
+    uint64_t rejected_ = 0; ///< number of negative admit() decisions
+};
+
+} // namespace Store
+
+#endif /* SQUID_SRC_STORE_ADMISSION_H */
+
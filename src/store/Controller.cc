@@ -13,6 +13,7 @@
 #include "MemStore.h"
 #include "SquidConfig.h"
 #include "SquidMath.h"
+#include "store/Admission.h"
 #include "store/Controller.h"
 #include "store/Disks.h"
 #include "store/forward.h"
@@ -349,6 +350,7 @@ Store::Controller::find(const cache_key *key)
             checkFoundCandidate(*entry);
             entry->touch();
             referenceBusy(*entry);
+            Admission::NoteLookup(key, true);
             return entry;
         } catch (const std::exception &ex) {
             debugs(20, 2, "failed with " << *entry << ": " << ex.what());
@@ -356,6 +358,7 @@ Store::Controller::find(const cache_key *key)
             // fall through
         }
     }
+    Admission::NoteLookup(key, false);
     return nullptr;
 }
 
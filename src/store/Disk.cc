@@ -14,9 +14,11 @@
 #include "ConfigOption.h"
 #include "ConfigParser.h"
 #include "globals.h"
+#include "md5.h"
 #include "Parsing.h"
 #include "SquidConfig.h"
 #include "Store.h"
+#include "store/Admission.h"
 #include "store/Disk.h"
 #include "StoreFileSystem.h"
 #include "tools.h"
@@ -183,6 +185,27 @@ Store::Disk::canStore(const StoreEntry &e, int64_t diskSpaceNeeded, int &load) c
     return true; // kids may provide more tests and should report true load
 }
 
+bool
+Store::Disk::admits(const StoreEntry &e, const int64_t diskSpaceNeeded) const
+{
+    if (!admission_)
+        return true;
+
+    cache_key victimKey[SQUID_MD5_DIGEST_LENGTH];
+    const auto victim = peekVictim(e, diskSpaceNeeded, victimKey) ? victimKey : nullptr;
+    if (admission_->admit(reinterpret_cast<const cache_key *>(e.key), victim))
+        return true;
+
+    debugs(47, 5, "cache_dir[" << index << "] does not admit " << e);
+    return false;
+}
+
+bool
+Store::Disk::peekVictim(const StoreEntry &, int64_t, cache_key *) const
+{
+    return false;
+}
+
 /* Move to StoreEntry ? */
 bool
 Store::Disk::canLog(StoreEntry const &e)const
@@ -260,6 +283,7 @@ Store::Disk::getOptionTree() const
     ConfigOptionVector *result = new ConfigOptionVector;
     result->options.push_back(new ConfigOptionAdapter<Disk>(*const_cast<Disk*>(this), &Store::Disk::optionReadOnlyParse, &Store::Disk::optionReadOnlyDump));
     result->options.push_back(new ConfigOptionAdapter<Disk>(*const_cast<Disk*>(this), &Store::Disk::optionObjectSizeParse, &Store::Disk::optionObjectSizeDump));
+    result->options.push_back(new ConfigOptionAdapter<Disk>(*const_cast<Disk*>(this), &Store::Disk::optionAdmissionParse, &Store::Disk::optionAdmissionDump));
     return result;
 }
 
@@ -388,6 +412,49 @@ Store::Disk::optionObjectSizeDump(StoreEntry * e) const
         storeAppendPrintf(e, " max-size=%" PRId64, max_objsize);
 }
 
+bool
+Store::Disk::optionAdmissionParse(char const *option, const char *value, int isaReconfig)
+{
+    if (strcmp(option, "admission") != 0)
+        return false;
+
+    if (!value) {
+        self_destruct();
+        return false;
+    }
+
+    bool useAdmission = false;
+    if (strcmp(value, "tinylfu") == 0)
+        useAdmission = true;
+    else if (strcmp(value, "none") != 0) {
+        debugs(3, DBG_CRITICAL, "ERROR: Invalid cache_dir '" << path << "' admission policy '" << value << "': expected 'tinylfu' or 'none'.");
+        self_destruct();
+        return false;
+    }
+
+    // the shared admission sketch is only created at startup
+    if (isaReconfig && flags.admission != useAdmission) {
+        debugs(3, DBG_IMPORTANT, "WARNING: cache_dir '" << path << "' admission " <<
+               "cannot be changed dynamically, value left unchanged");
+        return true;
+    }
+
+    flags.admission = useAdmission;
+    if (flags.admission && !admission_)
+        admission_.reset(new Admission(path));
+    else if (!flags.admission)
+        admission_.reset();
+
+    return true;
+}
+
+void
+Store::Disk::optionAdmissionDump(StoreEntry * e) const
+{
+    if (flags.admission)
+        storeAppendPrintf(e, " admission=tinylfu");
+}
+
 // some SwapDirs may maintain their indexes and be able to lookup an entry key
 StoreEntry *
 Store::Disk::get(const cache_key *)
@@ -12,11 +12,15 @@
 #include "store/Controlled.h"
 #include "StoreIOState.h"
 
+#include <memory>
+
 class ConfigOption;
 class RemovalPolicy;
 
 namespace Store {
 
+class Admission;
+
 /// manages a single cache_dir
 class Disk: public Controlled
 {
@@ -84,6 +88,15 @@ protected:
     virtual ConfigOption *getOptionTree() const;
     virtual bool allowOptionReconfigure(const char *const) const { return true; }
 
+    /// whether the admission filter (if any) allows storing the entry;
+    /// the last canStore() check
+    bool admits(const StoreEntry &, int64_t diskSpaceNeeded) const;
+
+    /// Copies the key of the cached entry that storing the given entry
+    /// would evict (if we can tell) into victimKey.
+    /// \returns whether victimKey has been set
+    virtual bool peekVictim(const StoreEntry &, int64_t diskSpaceNeeded, cache_key *victimKey) const;
+
     int64_t sizeInBlocks(const int64_t size) const { return (size + fs.blksize - 1) / fs.blksize; }
 
 private:
@@ -91,8 +104,13 @@ private:
     void optionReadOnlyDump(StoreEntry * e) const;
     bool optionObjectSizeParse(char const *option, const char *value, int reconfiguring);
     void optionObjectSizeDump(StoreEntry * e) const;
+    bool optionAdmissionParse(char const *option, const char *value, int reconfiguring);
+    void optionAdmissionDump(StoreEntry * e) const;
     char const *theType;
 
+    /// cache_dir admission filter; set if flags.admission
+    std::unique_ptr<Admission> admission_;
+
 protected:
     uint64_t max_size;        ///< maximum allocatable size of the storage area
     int64_t min_objsize;      ///< minimum size of any object stored here (-1 for no limit)
@@ -107,9 +125,10 @@ public:
     int scanned;
 
     struct Flags {
-        Flags() : selected(false), read_only(false) {}
+        Flags() : selected(false), read_only(false), admission(false) {}
         bool selected;
         bool read_only;
+        bool admission; ///< whether to use TinyLFU admission filter
     } flags;
 
     virtual void dump(StoreEntry &)const;   /* Dump fs config snippet */
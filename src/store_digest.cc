@@ -35,6 +35,7 @@
 #include "util.h"
 
 #include <cmath>
+#include <vector>
 
 /*
  * local types
@@ -47,6 +48,10 @@ public:
     int rebuild_lock = 0;                 ///< bucket number
     StoreEntry * rewrite_lock = nullptr;  ///< points to store entry with the digest
     StoreEntry * publicEntry = nullptr;  ///< points to the previous store entry with the digest
+    StoreEntry * publicDeltaEntry = nullptr; ///< points to the store entry with the latest digest delta
+    /// a copy of the digest mask being (or last) written to Store
+    std::vector<char> publishedMask;
+    int generation = 0; ///< the generation of publishedMask (or zero)
     StoreSearchPointer theSearch;
     int rewrite_offset = 0;
     int rebuild_count = 0;
@@ -68,6 +73,11 @@ public:
 static StoreDigestState sd_state;
 static StoreDigestStats sd_stats;
 
+/// The current local digest epoch. Every digest clear or resize starts a new
+/// epoch, invalidating StoreEntry::digestEpoch marks of earlier additions.
+/// Never zero after storeDigestInit().
+static uint16_t sd_epoch = 0;
+
 /* local prototypes */
 static void storeDigestRebuildStart(void *datanotused);
 static void storeDigestRebuildResume(void);
@@ -77,8 +87,11 @@ static void storeDigestRewriteStart(void *);
 static void storeDigestRewriteResume(void);
 static void storeDigestRewriteFinish(StoreEntry * e);
 static EVH storeDigestSwapOutStep;
+static void storeDigestFillCBlock(StoreDigestCBlock &);
 static void storeDigestCBlockSwapOut(StoreEntry * e);
-static void storeDigestAdd(const StoreEntry *);
+static void storeDigestRewriteDelta(const std::vector<char> &previousMask, int previousGeneration);
+static void storeDigestAddEntry(StoreEntry *);
+static void storeDigestStartEpoch();
 
 /// calculates digest capacity
 static uint64_t
@@ -136,11 +149,15 @@ storeDigestInit(void)
 
     const uint64_t cap = storeDigestCalcCap();
     store_digest = new CacheDigest(cap, Config.digest.bits_per_entry);
+    if (Config.onoff.digest_online_updates)
+        store_digest->enableRemovals();
     debugs(71, DBG_IMPORTANT, "Local cache digest enabled; rebuild/rewrite every " <<
            (int) Config.digest.rebuild_period << "/" <<
-           (int) Config.digest.rewrite_period << " sec");
+           (int) Config.digest.rewrite_period << " sec" <<
+           (store_digest->removable() ? "; online updates enabled" : ""));
 
     sd_state = StoreDigestState();
+    storeDigestStartEpoch();
 #else
     store_digest = nullptr;
     debugs(71, 3, "Local cache digest is 'off'");
@@ -161,28 +178,48 @@ storeDigestNoteStoreReady(void)
 #endif
 }
 
-//TODO: this seems to be dead code. Is it needed?
 void
-storeDigestDel(const StoreEntry * entry)
+storeDigestAdd(StoreEntry * entry)
 {
 #if USE_CACHE_DIGESTS
 
-    if (!Config.onoff.digest_generation) {
+    if (!Config.onoff.digest_generation || !store_digest || !store_digest->removable()) {
         return;
     }
 
-    assert(entry && store_digest);
+    storeDigestAddEntry(entry);
+#else
+    (void)entry;
+#endif //USE_CACHE_DIGESTS
+}
+
+void
+storeDigestDel(StoreEntry * entry)
+{
+#if USE_CACHE_DIGESTS
+
+    if (!Config.onoff.digest_generation || !store_digest || !store_digest->removable()) {
+        return;
+    }
+
+    assert(entry);
     debugs(71, 6, "storeDigestDel: checking entry, key: " << entry->getMD5Text());
 
-    if (!EBIT_TEST(entry->flags, KEY_PRIVATE)) {
-        if (!store_digest->contains(static_cast<const cache_key *>(entry->key))) {
-            ++sd_stats.del_lost_count;
-            debugs(71, 6, "storeDigestDel: lost entry, key: " << entry->getMD5Text() << " url: " << entry->url()  );
-        } else {
-            ++sd_stats.del_count;
-            store_digest->remove(static_cast<const cache_key *>(entry->key));
-            debugs(71, 6, "storeDigestDel: deled entry, key: " << entry->getMD5Text());
-        }
+    // only remove what we have added to the current digest, or we would
+    // decrement counters of other entries
+    if (entry->digestEpoch != sd_epoch) {
+        debugs(71, 6, "storeDigestDel: not counted, key: " << entry->getMD5Text());
+        return;
+    }
+    entry->digestEpoch = 0;
+
+    if (!store_digest->contains(static_cast<const cache_key *>(entry->key))) {
+        ++sd_stats.del_lost_count;
+        debugs(71, 6, "storeDigestDel: lost entry, key: " << entry->getMD5Text() << " url: " << entry->url()  );
+    } else {
+        ++sd_stats.del_count;
+        store_digest->remove(static_cast<const cache_key *>(entry->key));
+        debugs(71, 6, "storeDigestDel: deled entry, key: " << entry->getMD5Text());
     }
 #else
     (void)entry;
@@ -209,6 +246,9 @@ storeDigestReport(StoreEntry * e)
         storeAppendPrintf(e, "\t collisions: on add: %.2f %% on rej: %.2f %%\n",
                           xpercent(sd_stats.add_coll_count, sd_stats.add_count),
                           xpercent(sd_stats.rej_coll_count, sd_stats.rej_count));
+        storeAppendPrintf(e, "\t published generation: %d delta: %s\n",
+                          sd_state.generation,
+                          sd_state.publicDeltaEntry ? "yes" : "no");
     } else {
         storeAppendPrintf(e, "store digest: disabled.\n");
     }
@@ -283,10 +323,16 @@ storeDigestAddable(const StoreEntry * e)
 }
 
 static void
-storeDigestAdd(const StoreEntry * entry)
+storeDigestAddEntry(StoreEntry * entry)
 {
     assert(entry && store_digest);
 
+    // both a swapout and a rebuild step may add the same entry
+    if (entry->digestEpoch == sd_epoch) {
+        debugs(71, 6, "storeDigestAdd: already added, key: " << entry->getMD5Text());
+        return;
+    }
+
     if (storeDigestAddable(entry)) {
         ++sd_stats.add_count;
 
@@ -294,9 +340,12 @@ storeDigestAdd(const StoreEntry * entry)
             ++sd_stats.add_coll_count;
 
         store_digest->add(static_cast<const cache_key *>(entry->key));
+        entry->digestEpoch = sd_epoch;
 
         debugs(71, 6, "storeDigestAdd: added entry, key: " << entry->getMD5Text());
     } else {
+        entry->digestEpoch = 0; // may be a stale mark from an old epoch
+
         ++sd_stats.rej_count;
 
         if (store_digest->contains(static_cast<const cache_key *>(entry->key)))
@@ -304,6 +353,15 @@ storeDigestAdd(const StoreEntry * entry)
     }
 }
 
+/// invalidates all StoreEntry::digestEpoch marks after emptying the digest
+static void
+storeDigestStartEpoch()
+{
+    if (++sd_epoch == 0) // zero marks entries that are not in the digest
+        ++sd_epoch;
+    debugs(71, 3, "epoch: " << sd_epoch);
+}
+
 /* rebuilds digest from scratch */
 static void
 storeDigestRebuildStart(void *)
@@ -363,6 +421,7 @@ storeDigestRebuildResume(void)
 
     if (!storeDigestResize())
         store_digest->clear();     /* not clean()! */
+    storeDigestStartEpoch();
 
     sd_stats = StoreDigestStats();
 
@@ -397,7 +456,7 @@ storeDigestRebuildStep(void *)
     debugs(71, 3, "storeDigestRebuildStep: buckets: " << store_hash_buckets << " entries to check: " << count);
 
     while (count-- && !sd_state.theSearch->isDone() && sd_state.theSearch->next())
-        storeDigestAdd(sd_state.theSearch->currentItem());
+        storeDigestAddEntry(sd_state.theSearch->currentItem());
 
     /* are we done ? */
     if (sd_state.theSearch->isDone())
@@ -461,10 +520,19 @@ storeDigestRewriteResume(void)
     }
     assert(e->locked());
     sd_state.publicEntry = e;
+
+    /* take a snapshot: online updates may change the digest while we write */
+    auto previousMask = std::move(sd_state.publishedMask);
+    const auto previousGeneration = sd_state.generation;
+    sd_state.publishedMask.assign(store_digest->mask, store_digest->mask + store_digest->mask_size);
+    // start with the current time to avoid reusing generations after restarts
+    sd_state.generation = previousGeneration ? previousGeneration + 1 : static_cast<int>(squid_curtime);
+    storeDigestRewriteDelta(previousMask, previousGeneration);
+
     /* fake reply */
     HttpReply *rep = new HttpReply;
     rep->setHeaders(Http::scOkay, "Cache Digest OK",
-                    "application/cache-digest", (store_digest->mask_size + sizeof(sd_state.cblock)),
+                    "application/cache-digest", (sd_state.publishedMask.size() + sizeof(sd_state.cblock)),
                     squid_curtime, (squid_curtime + Config.digest.rewrite_period) );
     debugs(71, 3, "storeDigestRewrite: entry expires on " << rep->expires <<
            " (" << std::showpos << (int) (rep->expires - squid_curtime) << ")");
@@ -506,38 +574,120 @@ storeDigestSwapOutStep(void *data)
     assert(e);
     /* _add_ check that nothing bad happened while we were waiting @?@ @?@ */
 
-    if (static_cast<uint32_t>(sd_state.rewrite_offset + chunk_size) > store_digest->mask_size)
-        chunk_size = store_digest->mask_size - sd_state.rewrite_offset;
+    const auto &mask = sd_state.publishedMask;
+    if (static_cast<size_t>(sd_state.rewrite_offset + chunk_size) > mask.size())
+        chunk_size = mask.size() - sd_state.rewrite_offset;
 
-    e->append(store_digest->mask + sd_state.rewrite_offset, chunk_size);
+    e->append(mask.data() + sd_state.rewrite_offset, chunk_size);
 
-    debugs(71, 3, "storeDigestSwapOutStep: size: " << store_digest->mask_size <<
+    debugs(71, 3, "storeDigestSwapOutStep: size: " << mask.size() <<
            " offset: " << sd_state.rewrite_offset << " chunk: " <<
            chunk_size << " bytes");
 
     sd_state.rewrite_offset += chunk_size;
 
     /* are we done ? */
-    if (static_cast<uint32_t>(sd_state.rewrite_offset) >= store_digest->mask_size)
+    if (static_cast<size_t>(sd_state.rewrite_offset) >= mask.size())
         storeDigestRewriteFinish(e);
     else
         eventAdd("storeDigestSwapOutStep", storeDigestSwapOutStep, data, 0.0, 1, false);
 }
 
+/// fills the given control block with the published digest parameters
+static void
+storeDigestFillCBlock(StoreDigestCBlock &cblock)
+{
+    memset(&cblock, 0, sizeof(cblock));
+    cblock.ver.current = htons(CacheDigestVer.current);
+    cblock.ver.required = htons(CacheDigestVer.required);
+    cblock.capacity = htonl(store_digest->capacity);
+    cblock.count = htonl(store_digest->count);
+    cblock.del_count = htonl(store_digest->del_count);
+    cblock.mask_size = htonl(sd_state.publishedMask.size());
+    cblock.bits_per_entry = Config.digest.bits_per_entry;
+    cblock.hash_func_count = (unsigned char) CacheDigestHashFuncCount;
+    cblock.generation = htonl(sd_state.generation);
+}
+
 static void
 storeDigestCBlockSwapOut(StoreEntry * e)
 {
-    memset(&sd_state.cblock, 0, sizeof(sd_state.cblock));
-    sd_state.cblock.ver.current = htons(CacheDigestVer.current);
-    sd_state.cblock.ver.required = htons(CacheDigestVer.required);
-    sd_state.cblock.capacity = htonl(store_digest->capacity);
-    sd_state.cblock.count = htonl(store_digest->count);
-    sd_state.cblock.del_count = htonl(store_digest->del_count);
-    sd_state.cblock.mask_size = htonl(store_digest->mask_size);
-    sd_state.cblock.bits_per_entry = Config.digest.bits_per_entry;
-    sd_state.cblock.hash_func_count = (unsigned char) CacheDigestHashFuncCount;
+    storeDigestFillCBlock(sd_state.cblock);
     e->append((char *) &sd_state.cblock, sizeof(sd_state.cblock));
 }
 
+/// Publishes positions of mask bits that differ between the given previously
+/// published digest and the digest being published now. Peers that have the
+/// previous generation apply these changes instead of fetching the whole
+/// digest. Releases any stale delta.
+static void
+storeDigestRewriteDelta(const std::vector<char> &previousMask, const int previousGeneration)
+{
+    if (const auto oldEntry = sd_state.publicDeltaEntry) {
+        oldEntry->release(true);
+        sd_state.publicDeltaEntry = nullptr;
+        oldEntry->unlock("storeDigestRewriteDelta");
+    }
+
+    const auto &mask = sd_state.publishedMask;
+    if (!previousGeneration || previousMask.size() != mask.size()) {
+        debugs(71, 3, "no delta: mask changed from " << previousMask.size() << " to " << mask.size() << " bytes");
+        return;
+    }
+
+    std::vector<uint32_t> toggled;
+    for (size_t i = 0; i < mask.size(); ++i) {
+        if (const auto changes = static_cast<unsigned char>(previousMask[i] ^ mask[i])) {
+            for (uint32_t bit = 0; bit < 8; ++bit) {
+                if (changes & (1 << bit))
+                    toggled.push_back(htonl(i * 8 + bit));
+            }
+        }
+    }
+
+    // a delta larger than the digest itself is pointless
+    const auto deltaBytes = toggled.size() * sizeof(uint32_t);
+    if (deltaBytes >= mask.size()) {
+        debugs(71, 3, "no delta: " << toggled.size() << " changed bits in a " << mask.size() << "-byte mask");
+        return;
+    }
+
+    const char *url = internalLocalUri("/squid-internal-periodic/", SBuf(StoreDigestDeltaFileName));
+    const auto mx = MasterXaction::MakePortless<XactionInitiator::initCacheDigest>();
+    auto req = HttpRequest::FromUrlXXX(url, mx);
+
+    RequestFlags flags;
+    flags.cachable.support(); // prevent RELEASE_REQUEST in storeCreateEntry()
+
+    StoreEntry *e = storeCreateEntry(url, url, flags, Http::METHOD_GET);
+    assert(e);
+    e->mem_obj->request = req;
+    EBIT_SET(e->flags, ENTRY_SPECIAL);
+    e->setPublicKey();
+    sd_state.publicDeltaEntry = e;
+
+    StoreDigestCBlock cblock;
+    storeDigestFillCBlock(cblock);
+    cblock.delta_base = htonl(previousGeneration);
+    cblock.delta_size = htonl(toggled.size());
+
+    HttpReply *rep = new HttpReply;
+    rep->setHeaders(Http::scOkay, "Cache Digest Delta OK",
+                    StoreDigestMimeStr, (deltaBytes + sizeof(cblock)),
+                    squid_curtime, (squid_curtime + Config.digest.rewrite_period) );
+    e->buffer();
+    e->replaceHttpReply(rep);
+    e->append(reinterpret_cast<const char *>(&cblock), sizeof(cblock));
+    if (deltaBytes)
+        e->append(reinterpret_cast<const char *>(toggled.data()), deltaBytes);
+    e->flush();
+    e->complete();
+    e->timestampsSet();
+    e->mem_obj->unlinkRequest();
+
+    debugs(71, 2, "generation " << sd_state.generation << " delta: " << toggled.size() <<
+           " changed bits (" << deltaBytes << " vs. " << mask.size() << " bytes)");
+}
+
 #endif /* USE_CACHE_DIGESTS */
 
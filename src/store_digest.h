@@ -15,7 +15,12 @@ class StoreEntry;
 
 void storeDigestInit(void);
 void storeDigestNoteStoreReady(void);
-void storeDigestDel(const StoreEntry * entry);
+
+/// reflects a newly cached entry in the local digest (digest_online_updates)
+void storeDigestAdd(StoreEntry * entry);
+
+/// reflects an uncached entry in the local digest (digest_online_updates)
+void storeDigestDel(StoreEntry * entry);
 void storeDigestReport(StoreEntry *);
 
 #endif /* SQUID_SRC_STORE_DIGEST_H */
@@ -13,6 +13,7 @@
 #include "cbdata.h"
 #include "CollapsedForwarding.h"
 #include "globals.h"
+#include "HttpRequest.h"
 #include "Store.h"
 #include "StoreClient.h"
 // TODO: Abstract the use of this more
@@ -22,6 +23,7 @@
 #include "StatCounters.h"
 #include "store/Disk.h"
 #include "store/Disks.h"
+#include "store_digest.h"
 #include "store_log.h"
 #include "swap_log_op.h"
 
@@ -155,6 +157,9 @@ StoreEntry::swapOut()
     if (!mem_obj)
         return;
 
+    const auto &request = mem_obj->request;
+    const TransactionPhases::Scope storing(request ? &request->masterXaction->phases : nullptr, TransactionPhases::storeWrite);
+
     // this flag may change so we must check even if we are swappingOut
     if (EBIT_TEST(flags, ENTRY_ABORTED)) {
         assert(EBIT_TEST(flags, RELEASE_REQUEST));
@@ -313,6 +318,8 @@ storeSwapOutFileClosed(void *data, int errflag, StoreIOState::Pointer self)
         if (e->checkCachable()) {
             storeLog(STORE_LOG_SWAPOUT, e);
             storeDirSwapLog(e, SWAP_LOG_ADD);
+            if (store_digest)
+                storeDigestAdd(e);
         }
 
         ++statCounter.swap.outs;
@@ -0,0 +1,321 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+/*
+ * A replay benchmark for StoreMap eviction policies. It feeds a request
+ * trace to a model of a StoreMap-based cache: Entries live at their key
+ * hash positions (colliding entries overwrite each other, as in StoreMap),
+ * entries of several sizes share a limited number of slots, and the policy
+ * frees entries when the slots run out, like StoreMap::purgeOne() does.
+ *
+ * Without arguments, the benchmark replays built-in synthetic traces.
+ * Otherwise, it replays the given trace file, using the given number of
+ * slots (4096 by default). Each line of that file is a request key (e.g.,
+ * a URL from access.log). The program is not a part of "make check";
+ * build it with "make tests/replayStoreMapEviction".
+ */
+
+#include "squid.h"
+#include "ipc/StoreMapEviction.h"
+#include "md5.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// a request trace: a sequence of object IDs
+typedef std::vector<uint64_t> Trace;
+
+/// a deterministic 64-bit mixer (SplitMix64 finalizer)
+static uint64_t
+Mix(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/// a deterministic pseudo-random number generator for trace synthesis
+class TraceRandom
+{
+public:
+    explicit TraceRandom(const uint64_t seed): state(seed) {}
+
+    /// a number in the [0, 1) range
+    double next() { state = Mix(state); return (state >> 11) * (1.0 / 9007199254740992.0); }
+
+private:
+    uint64_t state;
+};
+
+/// the StoreMap-like cache model replaying a trace
+class CacheModel
+{
+public:
+    CacheModel(int capacity, Ipc::EvictionPolicy);
+
+    /// simulates a single request for the given object
+    /// \returns whether it was a hit
+    bool request(uint64_t objectId);
+
+    /// replays the entire trace, skipping statistics for the first warmup requests
+    /// \returns the hit ratio of the remaining requests
+    double replay(const Trace &, size_t warmup);
+
+private:
+    /// a cached entry at a hash position
+    class Entry
+    {
+    public:
+        cache_key key[SQUID_MD5_DIGEST_LENGTH] = {}; ///< all zeros if empty
+        int slots = 0; ///< the number of slots the entry occupies (or zero)
+    };
+
+    static void MakeKey(uint64_t objectId, cache_key *key);
+    static int SlotsFor(uint64_t objectId);
+
+    bool evict(sfileno, uint32_t tag);
+    bool evictOne();
+    void free(Entry &);
+
+    const int capacity; ///< entry positions and slots
+    const Ipc::EvictionPolicy policy;
+    std::vector<Entry> entries;
+    int slotsUsed = 0;
+    uint64_t hashVictim = 0; ///< the next hashOrder eviction candidate
+
+    std::unique_ptr<char[]> raw; ///< eviction memory (normally shared)
+    Ipc::StoreMapEviction *eviction = nullptr; ///< nil for hashOrder
+};
+
+CacheModel::CacheModel(const int aCapacity, const Ipc::EvictionPolicy aPolicy):
+    capacity(aCapacity),
+    policy(aPolicy),
+    entries(aCapacity)
+{
+    if (policy != Ipc::EvictionPolicy::hashOrder) {
+        raw.reset(new char[Ipc::StoreMapEviction::SharedMemorySize(capacity)]);
+        eviction = new (raw.get()) Ipc::StoreMapEviction(capacity, policy);
+    }
+}
+
+void
+CacheModel::MakeKey(const uint64_t objectId, cache_key * const key)
+{
+    const uint64_t parts[2] = { Mix(objectId), Mix(objectId ^ 0x5bd1e995ULL) };
+    memcpy(key, parts, sizeof(parts));
+}
+
+/// objects occupy one to seven slots, four on average
+int
+CacheModel::SlotsFor(const uint64_t objectId)
+{
+    return 1 + Mix(objectId * 31 + 7) % 7;
+}
+
+void
+CacheModel::free(Entry &entry)
+{
+    slotsUsed -= entry.slots;
+    entry = Entry();
+}
+
+/// mimics StoreMap::purgeAt()
+bool
+CacheModel::evict(const sfileno fileno, const uint32_t tag)
+{
+    auto &entry = entries[fileno];
+    if (!entry.slots)
+        return false;
+    if (tag && Ipc::StoreMapEviction::Tag(entry.key) != tag)
+        return false;
+    free(entry);
+    return true;
+}
+
+/// mimics StoreMap::purgeOne()
+bool
+CacheModel::evictOne()
+{
+    if (eviction) {
+        const auto evictor = [this](const sfileno fileno, const uint32_t tag) {
+            return evict(fileno, tag);
+        };
+        return eviction->evictOne(evictor, std::min(10000, capacity));
+    }
+
+    for (int tries = 0; tries < capacity; ++tries) {
+        // positions are key hashes, so this order ignores entry popularity
+        const auto fileno = static_cast<sfileno>(hashVictim++ % capacity);
+        if (evict(fileno, 0))
+            return true;
+    }
+    return false;
+}
+
+bool
+CacheModel::request(const uint64_t objectId)
+{
+    cache_key key[SQUID_MD5_DIGEST_LENGTH];
+    MakeKey(objectId, key);
+    const auto fileno = static_cast<sfileno>(Mix(objectId ^ 0x2545f491ULL) % capacity);
+    auto &entry = entries[fileno];
+
+    if (entry.slots && memcmp(entry.key, key, sizeof(key)) == 0) {
+        if (eviction)
+            eviction->noteAccess(fileno);
+        return true;
+    }
+
+    // a miss: store the object, overwriting any hash collision victim
+    if (entry.slots)
+        free(entry);
+
+    const auto slots = SlotsFor(objectId);
+    while (slotsUsed + slots > capacity) {
+        if (!evictOne())
+            return false; // cannot make room
+    }
+
+    memcpy(entry.key, key, sizeof(key));
+    entry.slots = slots;
+    slotsUsed += slots;
+    if (eviction)
+        eviction->noteInsertion(fileno, key);
+    return false;
+}
+
+double
+CacheModel::replay(const Trace &trace, const size_t warmup)
+{
+    size_t hits = 0;
+    size_t counted = 0;
+    for (size_t i = 0; i < trace.size(); ++i) {
+        const auto hit = request(trace[i]);
+        if (i >= warmup) {
+            ++counted;
+            hits += hit ? 1 : 0;
+        }
+    }
+    return counted ? static_cast<double>(hits) / counted : 0;
+}
+
+/// Zipf-distributed requests for the given number of objects
+static Trace
+ZipfTrace(const size_t objects, const double alpha, const size_t requests, const uint64_t seed)
+{
+    std::vector<double> cdf(objects);
+    double sum = 0;
+    for (size_t i = 0; i < objects; ++i) {
+        sum += 1.0 / pow(static_cast<double>(i + 1), alpha);
+        cdf[i] = sum;
+    }
+
+    TraceRandom random(seed);
+    Trace trace;
+    trace.reserve(requests);
+    for (size_t i = 0; i < requests; ++i) {
+        const auto target = random.next() * sum;
+        const auto pos = std::lower_bound(cdf.begin(), cdf.end(), target) - cdf.begin();
+        trace.push_back(static_cast<uint64_t>(pos));
+    }
+    return trace;
+}
+
+/// interleaves the given trace with scans of never repeated objects
+static Trace
+AddScans(const Trace &base, const size_t period, const size_t scanLength)
+{
+    Trace trace;
+    uint64_t nextUnique = uint64_t(1) << 40; // far from base trace object IDs
+    for (size_t i = 0; i < base.size(); ++i) {
+        trace.push_back(base[i]);
+        if ((i + 1) % period == 0) {
+            for (size_t j = 0; j < scanLength; ++j)
+                trace.push_back(nextUnique++);
+        }
+    }
+    return trace;
+}
+
+/// replays the trace with every policy, reporting hit ratios
+static void
+ReplayAll(const char * const description, const Trace &trace, const int capacity)
+{
+    static const Ipc::EvictionPolicy Policies[] = {
+        Ipc::EvictionPolicy::hashOrder,
+        Ipc::EvictionPolicy::clock,
+        Ipc::EvictionPolicy::s3fifo
+    };
+
+    std::cout << description << " (" << trace.size() << " requests, " << capacity << " slots):";
+    for (const auto policy: Policies) {
+        CacheModel cache(capacity, policy);
+        const auto ratio = cache.replay(trace, trace.size()/10);
+        std::cout << ' ' << Ipc::EvictionPolicyName(policy) << '=' << std::fixed << std::setprecision(2) << 100*ratio << '%';
+    }
+    std::cout << std::endl;
+}
+
+/// loads a trace file with one request key per line
+static bool
+LoadTrace(const char * const fileName, Trace &trace)
+{
+    std::ifstream in(fileName);
+    if (!in.good())
+        return false;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        // FNV-1a; the cache model scrambles these IDs further
+        uint64_t id = 0xcbf29ce484222325ULL;
+        for (const auto c: line)
+            id = (id ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+        trace.push_back(id);
+    }
+    return true;
+}
+
+int
+main(int argc, char *argv[])
+{
+    if (argc > 3) {
+        std::cerr << "usage: " << argv[0] << " [trace-file [slots]]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (argc == 1) {
+        ReplayAll("Zipf(0.9)", ZipfTrace(20000, 0.9, 400000, 1), 4096);
+        ReplayAll("Zipf(0.9) with scans", AddScans(ZipfTrace(20000, 0.9, 400000, 2), 5000, 5000), 4096);
+        return EXIT_SUCCESS;
+    }
+
+    const auto capacity = argc > 2 ? atoi(argv[2]) : 4096;
+    if (capacity <= 0) {
+        std::cerr << argv[0] << ": bad slot count: " << argv[2] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    Trace trace;
+    if (!LoadTrace(argv[1], trace)) {
+        std::cerr << argv[0] << ": cannot read " << argv[1] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    ReplayAll(argv[1], trace, capacity);
+    return EXIT_SUCCESS;
+}
+
@@ -0,0 +1,15 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+
+#define STUB_API "BackgroundRefresh.cc"
+#include "tests/STUB.h"
+
+#include "BackgroundRefresh.h"
+void BackgroundRefresh::Start(const StoreEntry &, const HttpRequest &) STUB
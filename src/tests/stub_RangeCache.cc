@@ -0,0 +1,21 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+
+#define STUB_API "RangeCache.cc"
+#include "tests/STUB.h"
+
+#include "RangeCache.h"
+RangeCache &RangeCache::Instance() STUB_RETREF(RangeCache)
+void RangeCache::configure(uint64_t) STUB
+bool RangeCache::mayRemember(const HttpRequest &, const HttpReply &) const STUB_RETVAL(false)
+void RangeCache::remember(HttpRequest &, const HttpReply &, const SBuf &) STUB
+std::optional<RangeCache::Hit> RangeCache::find(HttpRequest &) STUB_RETVAL(std::nullopt)
+uint64_t RangeCache::maxBodySize() const STUB_RETVAL(0)
+void RangeCache::packStatsInto(Packable *) const STUB
@@ -0,0 +1,20 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "ConfigParser.h"
+
+#define STUB_API "VaryNormalizer.cc"
+#include "tests/STUB.h"
+
+#include "VaryNormalizer.h"
+VaryNormalizer::~VaryNormalizer() STUB
+void VaryNormalizer::configure(ConfigParser &) STUB
+void VaryNormalizer::dump(StoreEntry *, const char *) const STUB
+void VaryNormalizer::normalize(const SBuf &, HttpRequest &, SBuf &) const STUB
+void VaryNormalizer::normalizeForwarded(HttpRequest &, HttpHeader &) const STUB
@@ -18,8 +18,8 @@ Mgr::Action::Pointer CacheManager::createNamedAction(char const*) STUB_RETVAL(nu
 void CacheManager::start(const Comm::ConnectionPointer &, HttpRequest *, StoreEntry *, const AccessLogEntryPointer &) STUB
 static CacheManager* instance = nullptr;
 CacheManager* CacheManager::GetInstance() STUB_RETVAL(instance)
-void Mgr::RegisterAction(char const *, char const *, OBJH *, Protected, Atomic, Format) {}
-void Mgr::RegisterAction(char const *, char const *, ClassActionCreationHandler *, Protected, Atomic, Format) {}
+void Mgr::RegisterAction(char const *, char const *, OBJH *, Protected, Atomic, Format, Scope) {}
+void Mgr::RegisterAction(char const *, char const *, ClassActionCreationHandler *, Protected, Atomic, Format, Scope) {}
 
 Mgr::Action::Pointer CacheManager::createRequestedAction(const Mgr::ActionParams &) STUB_RETVAL(nullptr)
 void CacheManager::PutCommonResponseHeaders(HttpReply &, const char *) STUB
@@ -13,6 +13,17 @@
 #define STUB_API "http/libhttp.la"
 #include "tests/STUB.h"
 
+#include "http/Compressor.h"
+namespace Http
+{
+bool Compressor::Supported(Coding) STUB_RETVAL(false)
+const char *Compressor::Name(Coding) STUB_RETVAL(nullptr)
+Compressor::Coding Compressor::Negotiate(const SBuf &, int, int) STUB_RETVAL(Coding::identity)
+bool Compressor::AddETagCoding(SBuf &, Coding) STUB_RETVAL(false)
+bool Compressor::RemoveETagCoding(SBuf &, const SBuf &) STUB_RETVAL(false)
+std::unique_ptr<Compressor> Compressor::Make(Coding, int) STUB_RETVAL(nullptr)
+}
+
 #include "http/ContentLengthInterpreter.h"
 namespace Http
 {
@@ -114,6 +125,8 @@ void Stream::sendStartOfMessage(HttpReply *, StoreIOBuffer) STUB
 void Stream::sendBody(StoreIOBuffer) STUB
 void Stream::noteSentBodyBytes(size_t) STUB
 void Stream::buildRangeHeader(HttpReply *) STUB
+void Stream::prepareReply(HttpReply *) STUB
+void Stream::packBody(const StoreIOBuffer &, MemBuf &) STUB
 clientStreamNode *Stream::getTail() const STUB_RETVAL(nullptr)
 clientStreamNode *Stream::getClientReplyContext() const STUB_RETVAL(nullptr)
 ConnStateData *Stream::getConn() const STUB_RETVAL(nullptr)
@@ -182,8 +182,8 @@ void Mgr::QueryParams::Parse(Parser::Tokenizer &, QueryParams &) STUB
 Mgr::QueryParam::Pointer Mgr::QueryParams::CreateParam(QueryParam::Type) STUB_RETVAL(Mgr::QueryParam::Pointer(nullptr))
 
 #include "mgr/Registration.h"
-//void Mgr::RegisterAction(char const *, char const *, OBJH *, Protected, Atomic, Format);
-//void Mgr::RegisterAction(char const *, char const *, ClassActionCreationHandler *, Protected, Atomic, Format);
+//void Mgr::RegisterAction(char const *, char const *, OBJH *, Protected, Atomic, Format, Scope);
+//void Mgr::RegisterAction(char const *, char const *, ClassActionCreationHandler *, Protected, Atomic, Format, Scope);
 
 #include "mgr/Request.h"
 //Mgr::Request::Request(int, unsigned int, int, const Mgr::ActionParams &) STUB
@@ -48,6 +48,9 @@ bool Security::HandshakeParser::parseHello(const SBuf &) STUB_RETVAL(false)
 #include "security/Io.h"
 Security::IoResult Security::Accept(Comm::Connection &) STUB_RETVAL(IoResult(IoResult::ioError))
 Security::IoResult Security::Connect(Comm::Connection &) STUB_RETVAL(IoResult(IoResult::ioError))
+#if USE_OPENSSL
+Security::IoResult Security::WriteEarlyData(Comm::Connection &, const SBuf &) STUB_RETVAL(IoResult(IoResult::ioError))
+#endif
 void Security::IoResult::printGist(std::ostream &) const STUB
 void Security::IoResult::printWithExtras(std::ostream &) const STUB
 void Security::ForgetErrors() STUB
@@ -162,3 +165,15 @@ Security::SessionPointer NewSessionObject(const Security::ContextPointer &) STUB
 #endif
 } // namespace Security
 
+#include "security/SessionResumption.h"
+namespace Security {
+void HandshakeCounters::noteSession(const SessionPointer &) STUB
+void HandshakeCounters::noteEarlyData(bool) STUB
+void HandshakeCounters::dump(std::ostream &, const char *) const STUB
+void ResumeOriginSession(const SBuf &, const SessionPointer &) STUB
+void RememberOriginSession(const SBuf &, const SessionPointer &) STUB
+void SetOriginSessionCallbacks(ContextPointer &) STUB
+size_t EarlyDataLimit(const SessionPointer &) STUB_RETVAL(0)
+HandshakeCounters &OriginHandshakes() STUB_RETREF(HandshakeCounters)
+} // namespace Security
+
@@ -11,6 +11,16 @@
 #define STUB_API "store/libstore.la"
 #include "tests/STUB.h"
 
+#include "store/Admission.h"
+namespace Store
+{
+Admission::Admission(const char *) {STUB}
+Admission::~Admission() {STUB_NOP}
+void Admission::NoteLookup(const cache_key *, bool) STUB
+bool Admission::admit(const cache_key *, const cache_key *) STUB_RETVAL(true)
+void Admission::packStatsInto(Packable *) const STUB
+}
+
 #include "store/Controller.h"
 namespace Store
 {
@@ -79,6 +89,8 @@ void Disk::maintain() STUB
 int64_t Disk::minObjectSize() const STUB_RETVAL(0)
 void Disk::maxObjectSize(int64_t) STUB
 bool Disk::objectSizeIsAcceptable(int64_t) const STUB_RETVAL(false)
+bool Disk::admits(const StoreEntry &, int64_t) const STUB_RETVAL(true)
+bool Disk::peekVictim(const StoreEntry &, int64_t, cache_key *) const STUB_RETVAL(false)
 void Disk::parseOptions(int) STUB
 void Disk::dumpOptions(StoreEntry *) const STUB
 ConfigOption *Disk::getOptionTree() const STUB_RETVAL(nullptr)
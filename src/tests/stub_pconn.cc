@@ -28,6 +28,7 @@ void PconnPool::moduleInit() STUB
 void PconnPool::push(const Comm::ConnectionPointer &, const char *) STUB
 Comm::ConnectionPointer PconnPool::pop(const Comm::ConnectionPointer &, const char *, bool) STUB_RETVAL(Comm::ConnectionPointer())
 void PconnPool::count(int) STUB
+int PconnPool::count(const Comm::ConnectionPointer &, const char *) const STUB_RETVAL(0)
 void PconnPool::noteUses(int) STUB
 void PconnPool::dump(std::ostream&) const STUB
 void PconnPool::unlinkList(IdleConnList *) STUB
@@ -22,6 +22,8 @@ void StoreEntry::invokeHandlers() STUB_NOP
 void storeLog(int, const StoreEntry *) STUB_NOP
 void storeLogOpen(void) STUB
 void storeDigestInit(void) STUB
+void storeDigestAdd(StoreEntry *) STUB
+void storeDigestDel(StoreEntry *) STUB
 void storeRebuildStart(void) STUB
 void storeReplSetup(void) STUB
 void store_client::noteSwapInDone(bool) STUB
@@ -15,6 +15,7 @@
 class StoreEntry;
 void storeDigestInit(void) STUB
 void storeDigestNoteStoreReady(void) STUB
-void storeDigestDel(const StoreEntry *) STUB
+void storeDigestAdd(StoreEntry *) STUB
+void storeDigestDel(StoreEntry *) STUB
 void storeDigestReport(StoreEntry *) STUB
 
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+
+#if USE_DELAY_POOLS
+#include "compat/cppunit.h"
+#include "DelayBucket.h"
+#include "DelaySpec.h"
+#include "SquidConfig.h"
+#include "time/gadgets.h"
+#include "unitTestMain.h"
+
+#include <limits>
+
+class TestDelayBucket : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestDelayBucket);
+    CPPUNIT_TEST(testRefill);
+    CPPUNIT_TEST(testLongIdleRefill);
+    CPPUNIT_TEST(testUnlimited);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() override;
+
+protected:
+    void testRefill();
+    void testLongIdleRefill();
+    void testUnlimited();
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(TestDelayBucket);
+
+/// a restore/max delay pool parameter
+static DelaySpec
+Rate(const int restore, const int64_t max)
+{
+    DelaySpec rate;
+    rate.restore_bps = restore;
+    rate.max_bytes = max;
+    return rate;
+}
+
+void
+TestDelayBucket::setUp()
+{
+    squid_curtime = 1000000;
+    Config.Delay.initial = 0;
+}
+
+void
+TestDelayBucket::testRefill()
+{
+    const auto rate = Rate(100, 1000);
+    DelayBucket bucket;
+    bucket.init(rate);
+    CPPUNIT_ASSERT_EQUAL(0, bucket.level());
+
+    // no refill within the same second
+    bucket.refill(rate);
+    CPPUNIT_ASSERT_EQUAL(0, bucket.level());
+
+    squid_curtime += 3;
+    bucket.refill(rate);
+    CPPUNIT_ASSERT_EQUAL(300, bucket.level());
+
+    // consumed bytes may overdraw the bucket
+    bucket.bytesIn(500);
+    CPPUNIT_ASSERT_EQUAL(-200, bucket.level());
+    squid_curtime += 1;
+    bucket.refill(rate);
+    CPPUNIT_ASSERT_EQUAL(-100, bucket.level());
+
+    // refills stop at the maximum
+    squid_curtime += 60;
+    bucket.refill(rate);
+    CPPUNIT_ASSERT_EQUAL(1000, bucket.level());
+}
+
+void
+TestDelayBucket::testLongIdleRefill()
+{
+    // a 10 MB/s pool idle for five minutes restores 3*10^9 bytes
+    const auto rate = Rate(10000000, 20000000);
+    DelayBucket bucket;
+    bucket.init(rate);
+    bucket.bytesIn(5000);
+
+    squid_curtime += 300;
+    bucket.refill(rate);
+    CPPUNIT_ASSERT_EQUAL(20000000, bucket.level());
+
+    // a bucket idle for a year with a maximum beyond int
+    const auto hugeRate = Rate(std::numeric_limits<int>::max(), std::numeric_limits<int64_t>::max());
+    DelayBucket hugeBucket;
+    hugeBucket.init(hugeRate);
+    squid_curtime += 365*24*3600;
+    hugeBucket.refill(hugeRate);
+    CPPUNIT_ASSERT_EQUAL(std::numeric_limits<int>::max(), hugeBucket.level());
+}
+
+void
+TestDelayBucket::testUnlimited()
+{
+    const auto rate = Rate(-1, -1);
+    DelayBucket bucket;
+    bucket.init(rate);
+    bucket.bytesIn(10);
+    squid_curtime += 10;
+    bucket.refill(rate);
+    CPPUNIT_ASSERT_EQUAL(-10, bucket.level());
+}
+
+#endif /* USE_DELAY_POOLS */
+
+int
+main(int argc, char *argv[])
+{
+    return TestProgram().run(argc, argv);
+}
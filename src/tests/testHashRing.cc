@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "base/HashRing.h"
+#include "compat/cppunit.h"
+#include "unitTestMain.h"
+
+#include <string>
+#include <vector>
+
+class TestHashRing : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestHashRing);
+    CPPUNIT_TEST(testEmpty);
+    CPPUNIT_TEST(testStableHash);
+    CPPUNIT_TEST(testDistribution);
+    CPPUNIT_TEST(testWeightedDistribution);
+    CPPUNIT_TEST(testRemappingAfterFailure);
+    CPPUNIT_TEST(testBoundedLoads);
+    CPPUNIT_TEST(testOverloadedFallback);
+    CPPUNIT_TEST(testReset);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testEmpty();
+    void testStableHash();
+    void testDistribution();
+    void testWeightedDistribution();
+    void testRemappingAfterFailure();
+    void testBoundedLoads();
+    void testOverloadedFallback();
+    void testReset();
+
+    /// a ring with the given number of equally weighted members
+    static void fillRing(HashRing &, size_t members);
+
+    /// the hash of a generated key with the given number
+    static HashRing::Point KeyHash(size_t n);
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(TestHashRing);
+
+/// a HashRing::select() loadOf that ignores loads
+static uint64_t
+NoLoad(HashRing::Member)
+{
+    return 0;
+}
+
+/// a HashRing::select() usable that accepts all members
+static bool
+AllUsable(HashRing::Member)
+{
+    return true;
+}
+
+/// balance factor that effectively disables load bounding
+static const double Unbounded = 1e9;
+
+void
+TestHashRing::fillRing(HashRing &ring, const size_t members)
+{
+    for (size_t i = 0; i < members; ++i) {
+        const auto name = "peer" + std::to_string(i) + ".example.com";
+        ring.add(name.data(), name.size(), 1);
+    }
+    ring.seal();
+}
+
+HashRing::Point
+TestHashRing::KeyHash(const size_t n)
+{
+    const auto key = "http://example.com/object/" + std::to_string(n);
+    return HashRing::Hash(key.data(), key.size());
+}
+
+void
+TestHashRing::testEmpty()
+{
+    HashRing ring;
+    CPPUNIT_ASSERT(ring.empty());
+    CPPUNIT_ASSERT(!ring.select(KeyHash(0), Unbounded, 0, NoLoad, AllUsable));
+
+    fillRing(ring, 4);
+    CPPUNIT_ASSERT_EQUAL(size_t(4), ring.members());
+    const auto noneUsable = [](HashRing::Member) { return false; };
+    CPPUNIT_ASSERT(!ring.select(KeyHash(0), Unbounded, 0, NoLoad, noneUsable));
+
+    ring.clear();
+    CPPUNIT_ASSERT(ring.empty());
+    CPPUNIT_ASSERT(!ring.select(KeyHash(0), Unbounded, 0, NoLoad, AllUsable));
+}
+
+void
+TestHashRing::testStableHash()
+{
+    // peers in different Squid instances must agree on key placement
+    CPPUNIT_ASSERT_EQUAL(HashRing::Hash("key", 3), HashRing::Hash("key", 3));
+    CPPUNIT_ASSERT(HashRing::Hash("key1", 4) != HashRing::Hash("key2", 4));
+
+    HashRing a, b;
+    fillRing(a, 16);
+    fillRing(b, 16);
+    for (size_t k = 0; k < 1000; ++k)
+        CPPUNIT_ASSERT(a.select(KeyHash(k), Unbounded, 0, NoLoad, AllUsable) == b.select(KeyHash(k), Unbounded, 0, NoLoad, AllUsable));
+}
+
+void
+TestHashRing::testDistribution()
+{
+    const size_t members = 64;
+    const size_t keysPerMember = 1000;
+    HashRing ring;
+    fillRing(ring, members);
+
+    std::vector<size_t> counts(members, 0);
+    for (size_t k = 0; k < members * keysPerMember; ++k) {
+        const auto member = ring.select(KeyHash(k), Unbounded, 0, NoLoad, AllUsable);
+        CPPUNIT_ASSERT(member);
+        ++counts.at(*member);
+    }
+
+    for (const auto count: counts) {
+        CPPUNIT_ASSERT(count > keysPerMember / 2);
+        CPPUNIT_ASSERT(count < keysPerMember * 3 / 2);
+    }
+}
+
+void
+TestHashRing::testWeightedDistribution()
+{
+    HashRing ring;
+    ring.add("light", 5, 1);
+    ring.add("heavy", 5, 3);
+    ring.seal();
+
+    std::vector<size_t> counts(2, 0);
+    const size_t keys = 40000;
+    for (size_t k = 0; k < keys; ++k)
+        ++counts.at(*ring.select(KeyHash(k), Unbounded, 0, NoLoad, AllUsable));
+
+    // the heavy member should get about 75% of keys
+    CPPUNIT_ASSERT(counts[1] > keys * 65 / 100);
+    CPPUNIT_ASSERT(counts[1] < keys * 85 / 100);
+}
+
+void
+TestHashRing::testRemappingAfterFailure()
+{
+    const size_t members = 16;
+    const size_t keys = 10000;
+    HashRing ring;
+    fillRing(ring, members);
+
+    std::vector<HashRing::Member> before;
+    for (size_t k = 0; k < keys; ++k)
+        before.push_back(*ring.select(KeyHash(k), Unbounded, 0, NoLoad, AllUsable));
+
+    const HashRing::Member failed = 7;
+    const auto survivors = [failed](const HashRing::Member m) { return m != failed; };
+    std::vector<size_t> inherited(members, 0);
+    size_t moved = 0;
+    for (size_t k = 0; k < keys; ++k) {
+        const auto after = *ring.select(KeyHash(k), Unbounded, 0, NoLoad, survivors);
+        CPPUNIT_ASSERT(after != failed);
+        if (before[k] == failed) {
+            ++moved;
+            ++inherited.at(after);
+        } else {
+            // keys of healthy members stay put
+            CPPUNIT_ASSERT_EQUAL(before[k], after);
+        }
+    }
+    CPPUNIT_ASSERT(moved > 0);
+
+    // keys of the failed member are spread among several survivors
+    size_t heirs = 0;
+    for (const auto count: inherited)
+        heirs += count ? 1 : 0;
+    CPPUNIT_ASSERT(heirs > members / 2);
+
+    // the recovered member gets its keys back
+    for (size_t k = 0; k < keys; ++k)
+        CPPUNIT_ASSERT_EQUAL(before[k], *ring.select(KeyHash(k), Unbounded, 0, NoLoad, AllUsable));
+}
+
+void
+TestHashRing::testBoundedLoads()
+{
+    const size_t members = 8;
+    const auto balance = 1.25;
+    HashRing ring;
+    fillRing(ring, members);
+
+    // a single hot key must not overload its home member
+    std::vector<uint64_t> loads(members, 0);
+    const auto loadOf = [&loads](const HashRing::Member m) { return loads.at(m); };
+    uint64_t totalLoad = 0;
+    const auto home = *ring.select(KeyHash(0), balance, totalLoad, NoLoad, AllUsable);
+    for (size_t i = 0; i < 100; ++i) {
+        const auto member = *ring.select(KeyHash(0), balance, totalLoad, loadOf, AllUsable);
+        ++loads.at(member);
+        ++totalLoad;
+        for (HashRing::Member m = 0; m < members; ++m)
+            CPPUNIT_ASSERT(loads[m] <= ring.capacity(m, balance, totalLoad - 1));
+    }
+    CPPUNIT_ASSERT(loads[home] < totalLoad);
+    CPPUNIT_ASSERT(loads[home] >= totalLoad / members);
+}
+
+void
+TestHashRing::testOverloadedFallback()
+{
+    HashRing ring;
+    fillRing(ring, 4);
+
+    // all members are overloaded, but the request still has to go somewhere
+    const auto heavyLoad = [](HashRing::Member) { return uint64_t(1000); };
+    const auto member = ring.select(KeyHash(0), 1.25, 10, heavyLoad, AllUsable);
+    CPPUNIT_ASSERT(member);
+    CPPUNIT_ASSERT_EQUAL(*ring.select(KeyHash(0), Unbounded, 0, NoLoad, AllUsable), *member);
+}
+
+void
+TestHashRing::testReset()
+{
+    HashRing ring;
+    fillRing(ring, 4);
+    const auto none = [](HashRing::Member) { return false; };
+    CPPUNIT_ASSERT(!ring.select(KeyHash(0), Unbounded, 0, NoLoad, none));
+
+    // a grown ring visits its new members
+    ring.clear();
+    fillRing(ring, 32);
+    const auto lastOnly = [](const HashRing::Member m) { return m == 31; };
+    for (size_t k = 0; k < 100; ++k)
+        CPPUNIT_ASSERT_EQUAL(HashRing::Member(31), *ring.select(KeyHash(k), Unbounded, 0, NoLoad, lastOnly));
+
+    // a shrunk ring does not visit its former members
+    ring.clear();
+    fillRing(ring, 2);
+    for (size_t k = 0; k < 100; ++k)
+        CPPUNIT_ASSERT(*ring.select(KeyHash(k), Unbounded, 0, NoLoad, AllUsable) < 2);
+}
+
+int
+main(int argc, char *argv[])
+{
+    return TestProgram().run(argc, argv);
+}
+
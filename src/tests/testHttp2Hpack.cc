@@ -0,0 +1,283 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "compat/cppunit.h"
+#include "http/two/Hpack.h"
+#include "unitTestMain.h"
+
+#include <cctype>
+#include <string>
+
+using namespace Http::Two;
+
+class TestHttp2Hpack : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestHttp2Hpack);
+    CPPUNIT_TEST(testDecodeRequests);
+    CPPUNIT_TEST(testDecodeHuffmanRequests);
+    CPPUNIT_TEST(testDecodeHuffmanResponses);
+    CPPUNIT_TEST(testEncodeRequests);
+    CPPUNIT_TEST(testHuffmanRoundTrip);
+    CPPUNIT_TEST(testTableSizeUpdates);
+    CPPUNIT_TEST(testMalformedBlocks);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testDecodeRequests();
+    void testDecodeHuffmanRequests();
+    void testDecodeHuffmanResponses();
+    void testEncodeRequests();
+    void testHuffmanRoundTrip();
+    void testTableSizeUpdates();
+    void testMalformedBlocks();
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(TestHttp2Hpack);
+
+/// converts hex digits (ignoring any other characters) into raw bytes
+static SBuf
+Raw(const char *hex)
+{
+    std::string digits;
+    for (auto p = hex; *p; ++p) {
+        if (isxdigit(*p))
+            digits += *p;
+    }
+    SBuf raw;
+    for (size_t i = 0; i + 1 < digits.size(); i += 2)
+        raw.append(static_cast<char>(std::stoi(digits.substr(i, 2), nullptr, 16)));
+    return raw;
+}
+
+/// checks that the decoded header list matches name/value pairs
+static void
+CheckFields(const HeaderFields &fields, const std::initializer_list<std::pair<const char *, const char *>> &expected)
+{
+    CPPUNIT_ASSERT_EQUAL(expected.size(), fields.size());
+    auto field = fields.begin();
+    for (const auto &pair: expected) {
+        CPPUNIT_ASSERT_EQUAL(SBuf(pair.first), field->name);
+        CPPUNIT_ASSERT_EQUAL(SBuf(pair.second), field->value);
+        ++field;
+    }
+}
+
+/// decodes a header block that must be valid
+static HeaderFields
+Decode(HpackDecoder &decoder, const char *hex)
+{
+    HeaderFields fields;
+    CPPUNIT_ASSERT(decoder.decode(Raw(hex), fields));
+    return fields;
+}
+
+/// RFC 7541 Appendix C.3
+void
+TestHttp2Hpack::testDecodeRequests()
+{
+    HpackDecoder decoder(4096, 65536);
+
+    CheckFields(Decode(decoder, "8286 8441 0f77 7777 2e65 7861 6d70 6c65 2e63 6f6d"), {
+        {":method", "GET"},
+        {":scheme", "http"},
+        {":path", "/"},
+        {":authority", "www.example.com"}
+    });
+
+    CheckFields(Decode(decoder, "8286 84be 5808 6e6f 2d63 6163 6865"), {
+        {":method", "GET"},
+        {":scheme", "http"},
+        {":path", "/"},
+        {":authority", "www.example.com"},
+        {"cache-control", "no-cache"}
+    });
+
+    CheckFields(Decode(decoder, "8287 85bf 400a 6375 7374 6f6d 2d6b 6579 0c63 7573 746f 6d2d 7661 6c75 65"), {
+        {":method", "GET"},
+        {":scheme", "https"},
+        {":path", "/index.html"},
+        {":authority", "www.example.com"},
+        {"custom-key", "custom-value"}
+    });
+}
+
+/// RFC 7541 Appendix C.4
+void
+TestHttp2Hpack::testDecodeHuffmanRequests()
+{
+    HpackDecoder decoder(4096, 65536);
+
+    CheckFields(Decode(decoder, "8286 8441 8cf1 e3c2 e5f2 3a6b a0ab 90f4 ff"), {
+        {":method", "GET"},
+        {":scheme", "http"},
+        {":path", "/"},
+        {":authority", "www.example.com"}
+    });
+
+    CheckFields(Decode(decoder, "8286 84be 5886 a8eb 1064 9cbf"), {
+        {":method", "GET"},
+        {":scheme", "http"},
+        {":path", "/"},
+        {":authority", "www.example.com"},
+        {"cache-control", "no-cache"}
+    });
+
+    CheckFields(Decode(decoder, "8287 85bf 4088 25a8 49e9 5ba9 7d7f 8925 a849 e95b b8e8 b4bf"), {
+        {":method", "GET"},
+        {":scheme", "https"},
+        {":path", "/index.html"},
+        {":authority", "www.example.com"},
+        {"custom-key", "custom-value"}
+    });
+}
+
+/// RFC 7541 Appendix C.6, including dynamic table evictions
+void
+TestHttp2Hpack::testDecodeHuffmanResponses()
+{
+    HpackDecoder decoder(256, 65536);
+
+    CheckFields(Decode(decoder, "4882 6402 5885 aec3 771a 4b61 96d0 7abe 9410 54d4 44a8 2005 9504 0b81 66e0 82a6 2d1b ff6e 919d 29ad 1718 63c7 8f0b 97c8 e9ae 82ae 43d3"), {
+        {":status", "302"},
+        {"cache-control", "private"},
+        {"date", "Mon, 21 Oct 2013 20:13:21 GMT"},
+        {"location", "https://www.example.com"}
+    });
+
+    CheckFields(Decode(decoder, "4883 640e ffc1 c0bf"), {
+        {":status", "307"},
+        {"cache-control", "private"},
+        {"date", "Mon, 21 Oct 2013 20:13:21 GMT"},
+        {"location", "https://www.example.com"}
+    });
+
+    CheckFields(Decode(decoder, "88c1 6196 d07a be94 1054 d444 a820 0595 040b 8166 e084 a62d 1bff c05a 839b d9ab 77ad 94e7 821d d7f2 e6c7 b335 dfdf cd5b 3960 d5af 2708 7f36 72c1 ab27 0fb5 291f 9587 3160 65c0 03ed 4ee5 b106 3d50 07"), {
+        {":status", "200"},
+        {"cache-control", "private"},
+        {"date", "Mon, 21 Oct 2013 20:13:22 GMT"},
+        {"location", "https://www.example.com"},
+        {"content-encoding", "gzip"},
+        {"set-cookie", "foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; version=1"}
+    });
+}
+
+/// the encoder reproduces RFC 7541 Appendix C.4 blocks
+void
+TestHttp2Hpack::testEncodeRequests()
+{
+    HpackEncoder encoder;
+    const SBuf method(":method");
+    const SBuf scheme(":scheme");
+    const SBuf path(":path");
+    const SBuf authority(":authority");
+
+    SBuf first;
+    encoder.startBlock(first);
+    encoder.encode(first, method, SBuf("GET"), HpackEncoder::idxIncremental);
+    encoder.encode(first, scheme, SBuf("http"), HpackEncoder::idxIncremental);
+    encoder.encode(first, path, SBuf("/"), HpackEncoder::idxIncremental);
+    encoder.encode(first, authority, SBuf("www.example.com"), HpackEncoder::idxIncremental);
+    CPPUNIT_ASSERT_EQUAL(Raw("8286 8441 8cf1 e3c2 e5f2 3a6b a0ab 90f4 ff"), first);
+
+    SBuf second;
+    encoder.startBlock(second);
+    encoder.encode(second, method, SBuf("GET"), HpackEncoder::idxIncremental);
+    encoder.encode(second, scheme, SBuf("http"), HpackEncoder::idxIncremental);
+    encoder.encode(second, path, SBuf("/"), HpackEncoder::idxIncremental);
+    encoder.encode(second, authority, SBuf("www.example.com"), HpackEncoder::idxIncremental);
+    encoder.encode(second, SBuf("cache-control"), SBuf("no-cache"), HpackEncoder::idxIncremental);
+    CPPUNIT_ASSERT_EQUAL(Raw("8286 84be 5886 a8eb 1064 9cbf"), second);
+
+    // what we encode, we can decode
+    HpackDecoder decoder(4096, 65536);
+    Decode(decoder, "8286 8441 8cf1 e3c2 e5f2 3a6b a0ab 90f4 ff");
+    HeaderFields fields;
+    CPPUNIT_ASSERT(decoder.decode(second, fields));
+    CPPUNIT_ASSERT_EQUAL(size_t(5), fields.size());
+}
+
+void
+TestHttp2Hpack::testHuffmanRoundTrip()
+{
+    SBuf all;
+    for (int i = 0; i < 256; ++i)
+        all.append(static_cast<char>(i));
+
+    SBuf encoded;
+    HuffmanEncode(all, encoded);
+    CPPUNIT_ASSERT_EQUAL(HuffmanEncodedSize(all), size_t(encoded.length()));
+
+    SBuf decoded;
+    CPPUNIT_ASSERT(HuffmanDecode(encoded.rawContent(), encoded.length(), decoded));
+    CPPUNIT_ASSERT_EQUAL(all, decoded);
+}
+
+void
+TestHttp2Hpack::testTableSizeUpdates()
+{
+    // a size update (to 4096) at the start of a block is accepted
+    HpackDecoder decoder(4096, 65536);
+    CheckFields(Decode(decoder, "3fe1 1f82"), {
+        {":method", "GET"}
+    });
+
+    // a size update after a field representation is not
+    HeaderFields fields;
+    CPPUNIT_ASSERT(!decoder.decode(Raw("8220"), fields));
+
+    // the encoder signals the smallest and the final size
+    HpackEncoder encoder;
+    encoder.setMaxTableSize(100);
+    encoder.setMaxTableSize(2000);
+    SBuf block;
+    encoder.startBlock(block);
+    CPPUNIT_ASSERT_EQUAL(Raw("3f45 3fb1 0f"), block);
+}
+
+void
+TestHttp2Hpack::testMalformedBlocks()
+{
+    // EOS-like padding longer than 7 bits
+    SBuf decoded;
+    const auto badPadding = Raw("ff ff ff ff");
+    CPPUNIT_ASSERT(!HuffmanDecode(badPadding.rawContent(), badPadding.length(), decoded));
+
+    // an index beyond both tables
+    {
+        HpackDecoder decoder(4096, 65536);
+        HeaderFields fields;
+        CPPUNIT_ASSERT(!decoder.decode(Raw("be"), fields));
+    }
+
+    // a truncated literal
+    {
+        HpackDecoder decoder(4096, 65536);
+        HeaderFields fields;
+        CPPUNIT_ASSERT(!decoder.decode(Raw("400a 6375"), fields));
+    }
+
+    // a size update exceeding our SETTINGS_HEADER_TABLE_SIZE
+    {
+        HpackDecoder decoder(256, 65536);
+        HeaderFields fields;
+        CPPUNIT_ASSERT(!decoder.decode(Raw("3fe1 1f82"), fields));
+    }
+
+    // a header list exceeding the configured limit
+    {
+        HpackDecoder decoder(4096, 40);
+        HeaderFields fields;
+        CPPUNIT_ASSERT(!decoder.decode(Raw("8286 8441 0f77 7777 2e65 7861 6d70 6c65 2e63 6f6d"), fields));
+    }
+}
+
+int
+main(int argc, char *argv[])
+{
+    return TestProgram().run(argc, argv);
+}
@@ -0,0 +1,635 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "base/AsyncCallQueue.h"
+#include "clients/Http2Session.h"
+#include "comm.h"
+#include "comm/Connection.h"
+#include "comm/Read.h"
+#include "comm/Write.h"
+#include "CommCalls.h"
+#include "compat/cppunit.h"
+#include "fde.h"
+#include "FwdState.h"
+#include "HttpHeader.h"
+#include "HttpRequest.h"
+#include "MasterXaction.h"
+#include "mem/forward.h"
+#include "SquidConfig.h"
+#include "unitTestMain.h"
+
+#include <string>
+#include <vector>
+
+using namespace Http::Two;
+
+/*
+ * A fake Comm layer connecting the tested Session to the test acting as an
+ * HTTP/2 server: Session writes are collected in Wire::fromSquid, and Session
+ * reads get the frames the test puts into Wire::toSquid.
+ */
+
+namespace Wire
+{
+static SBuf fromSquid; ///< bytes written by the Session
+static SBuf toSquid; ///< bytes waiting to be read by the Session
+static AsyncCall::Pointer reader; ///< the pending Comm::Read() callback
+static bool closed = false; ///< whether the Session has closed the connection
+}
+
+void
+Comm::Read(const Comm::ConnectionPointer &, AsyncCall::Pointer &callback)
+{
+    CPPUNIT_ASSERT(!Wire::reader);
+    Wire::reader = callback;
+}
+
+Comm::Flag
+Comm::ReadNow(CommIoCbParams &params, SBuf &buf)
+{
+    if (Wire::toSquid.isEmpty()) {
+        params.flag = Comm::INPROGRESS;
+        return params.flag;
+    }
+    buf.append(Wire::toSquid);
+    params.size = Wire::toSquid.length();
+    Wire::toSquid.clear();
+    params.flag = Comm::OK;
+    return params.flag;
+}
+
+void
+Comm::ReadCancel(int, AsyncCall::Pointer &callback)
+{
+    if (Wire::reader == callback)
+        Wire::reader = nullptr;
+}
+
+void
+Comm::Write(const Comm::ConnectionPointer &conn, const char *buf, int size, AsyncCall::Pointer &callback, FREE *)
+{
+    Wire::fromSquid.append(buf, size);
+    auto &params = GetCommParams<CommIoCbParams>(callback);
+    params.conn = conn;
+    params.flag = Comm::OK;
+    params.size = size;
+    ScheduleCallHere(callback);
+}
+
+void
+_comm_close(int, char const *, int)
+{
+    Wire::closed = true;
+}
+
+void comm_add_close_handler(int, AsyncCall::Pointer &) {}
+void comm_remove_close_handler(int, AsyncCall::Pointer &) {}
+void commSetConnTimeout(const Comm::ConnectionPointer &, time_t, AsyncCall::Pointer &) {}
+void commUnsetConnTimeout(const Comm::ConnectionPointer &) {}
+
+// used by Session::noteClosure(), which the fake _comm_close() never calls
+PconnPool *fwdPconnPool = nullptr;
+
+/// a received frame
+class Frame
+{
+public:
+    FrameHeader header;
+    SBuf payload;
+};
+
+/// a stream writer callback that remembers the outcome
+static std::vector<Comm::Flag> WriteOutcomes;
+
+static void
+NoteWritten(const Comm::ConnectionPointer &, char *, size_t, Comm::Flag flag, int, void *)
+{
+    WriteOutcomes.push_back(flag);
+}
+
+/// the number of stream reader callbacks
+static int ReadNotifications = 0;
+
+static void
+NoteReadable(const Comm::ConnectionPointer &, char *, size_t, Comm::Flag, int, void *)
+{
+    ++ReadNotifications;
+}
+
+class TestHttp2Session : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestHttp2Session);
+    CPPUNIT_TEST(testPreface);
+    CPPUNIT_TEST(testMultiplexing);
+    CPPUNIT_TEST(testConcurrencyLimit);
+    CPPUNIT_TEST(testSendWindows);
+    CPPUNIT_TEST(testInitialWindowChange);
+    CPPUNIT_TEST(testReceiveWindow);
+    CPPUNIT_TEST(testGoAway);
+    CPPUNIT_TEST(testSessionEnd);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() override;
+    void tearDown() override;
+
+protected:
+    void testPreface();
+    void testMultiplexing();
+    void testConcurrencyLimit();
+    void testSendWindows();
+    void testInitialWindowChange();
+    void testReceiveWindow();
+    void testGoAway();
+    void testSessionEnd();
+
+private:
+    void startSession(const SBuf &serverSettings);
+    void serverSends(const SBuf &frames);
+    std::vector<Frame> framesFromSquid();
+    uint32_t openStream(bool endStream);
+    void writeBody(uint32_t streamId, const char *body, bool endStream);
+    SBuf readStream(uint32_t streamId, Comm::Flag &flag);
+
+    Comm::ConnectionPointer conn;
+    Session *session = nullptr;
+    HttpRequest *request = nullptr;
+    HttpHeader *header = nullptr;
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(TestHttp2Session);
+
+/// a SETTINGS frame with the given id/value pairs
+static SBuf
+Settings(const std::initializer_list<std::pair<SettingId, uint32_t>> &settings)
+{
+    SBuf payload;
+    for (const auto &setting: settings) {
+        PutUint16(payload, setting.first);
+        PutUint32(payload, setting.second);
+    }
+    SBuf frame;
+    PackFrame(frame, ftSettings, 0, 0, payload);
+    return frame;
+}
+
+/// a response HEADERS frame with the given status
+static SBuf
+ResponseHeaders(HpackEncoder &encoder, const uint32_t streamId, const char *status, const bool endStream)
+{
+    SBuf block;
+    encoder.startBlock(block);
+    encoder.encode(block, SBuf(":status"), SBuf(status), HpackEncoder::idxNone);
+    SBuf frame;
+    PackFrame(frame, ftHeaders, ffEndHeaders | (endStream ? ffEndStream : 0), streamId, block);
+    return frame;
+}
+
+/// a DATA frame with the given payload
+static SBuf
+Data(const uint32_t streamId, const char *payload, const bool endStream)
+{
+    SBuf frame;
+    PackFrame(frame, ftData, endStream ? ffEndStream : 0, streamId, SBuf(payload));
+    return frame;
+}
+
+/// a WINDOW_UPDATE frame
+static SBuf
+WindowUpdate(const uint32_t streamId, const uint32_t increment)
+{
+    SBuf frame;
+    PackWindowUpdate(frame, streamId, increment);
+    return frame;
+}
+
+/// fires all scheduled async calls, including the calls they schedule
+static void
+FireCalls()
+{
+    while (AsyncCallQueue::Instance().fire()) {}
+}
+
+/// the total DATA payload size for the given stream
+static size_t
+DataBytes(const std::vector<Frame> &frames, const uint32_t streamId)
+{
+    size_t bytes = 0;
+    for (const auto &frame: frames) {
+        if (frame.header.type == ftData && frame.header.streamId == streamId)
+            bytes += frame.header.length;
+    }
+    return bytes;
+}
+
+/// the first frame of the given type (if any)
+static const Frame *
+FindFrame(const std::vector<Frame> &frames, const uint8_t type, const uint32_t streamId)
+{
+    for (const auto &frame: frames) {
+        if (frame.header.type == type && frame.header.streamId == streamId)
+            return &frame;
+    }
+    return nullptr;
+}
+
+void
+TestHttp2Session::setUp()
+{
+    Wire::fromSquid.clear();
+    Wire::toSquid.clear();
+    Wire::reader = nullptr;
+    Wire::closed = false;
+    WriteOutcomes.clear();
+    ReadNotifications = 0;
+
+    if (!fd_table) {
+        Squid_MaxFD = 16;
+        fd_table = new fde[Squid_MaxFD];
+    }
+
+    conn = new Comm::Connection;
+    conn->fd = 5;
+
+    const auto mx = MasterXaction::MakePortless<XactionInitiator::initHtcp>();
+    request = new HttpRequest(Http::METHOD_POST, AnyP::PROTO_HTTP, "http", "/upload", mx);
+    header = new HttpHeader(hoRequest);
+    header->putStr(Http::HdrType::HOST, "example.com");
+}
+
+void
+TestHttp2Session::tearDown()
+{
+    // the job is stuck without Comm closure notifications; abandon it
+    session = nullptr;
+    delete header;
+    delete request;
+    conn->fd = -1; // do not close
+    conn = nullptr;
+}
+
+/// starts a Session and completes the connection preface exchange
+void
+TestHttp2Session::startSession(const SBuf &serverSettings)
+{
+    session = new Session(conn);
+    AsyncJob::Start(session);
+    FireCalls();
+    CPPUNIT_ASSERT(Wire::fromSquid.startsWith(ClientPreface()));
+    Wire::fromSquid.consume(ClientPreface().length());
+    serverSends(serverSettings);
+}
+
+/// delivers the given frames to the Session
+void
+TestHttp2Session::serverSends(const SBuf &frames)
+{
+    Wire::toSquid.append(frames);
+    CPPUNIT_ASSERT(Wire::reader);
+    AsyncCall::Pointer call = Wire::reader;
+    Wire::reader = nullptr;
+    auto &params = GetCommParams<CommIoCbParams>(call);
+    params.conn = conn;
+    params.flag = Comm::OK;
+    ScheduleCallHere(call);
+    FireCalls();
+}
+
+/// parses and forgets the frames written by the Session so far
+std::vector<Frame>
+TestHttp2Session::framesFromSquid()
+{
+    std::vector<Frame> frames;
+    auto &wire = Wire::fromSquid;
+    while (wire.length() >= FrameHeaderSize) {
+        Frame frame;
+        frame.header = FrameHeader::Parse(wire.rawContent());
+        CPPUNIT_ASSERT(wire.length() >= FrameHeaderSize + frame.header.length);
+        frame.payload = wire.substr(FrameHeaderSize, frame.header.length);
+        wire.consume(FrameHeaderSize + frame.header.length);
+        frames.push_back(frame);
+    }
+    CPPUNIT_ASSERT(wire.isEmpty());
+    return frames;
+}
+
+/// starts a request stream
+uint32_t
+TestHttp2Session::openStream(const bool endStream)
+{
+    const auto streamId = session->addStream();
+    CPPUNIT_ASSERT(streamId);
+    AsyncCall::Pointer writer = commCbCall(5, 5, "NoteWritten", CommIoCbPtrFun(&NoteWritten, nullptr));
+    session->sendHeaders(streamId, *request, *header, endStream, writer);
+    FireCalls();
+    return streamId;
+}
+
+/// sends request body bytes on the given stream
+void
+TestHttp2Session::writeBody(const uint32_t streamId, const char *body, const bool endStream)
+{
+    AsyncCall::Pointer writer = commCbCall(5, 5, "NoteWritten", CommIoCbPtrFun(&NoteWritten, nullptr));
+    session->write(streamId, body, strlen(body), endStream, writer);
+    FireCalls();
+}
+
+/// reads all available response bytes from the given stream
+SBuf
+TestHttp2Session::readStream(const uint32_t streamId, Comm::Flag &flag)
+{
+    SBuf buf;
+    CommIoCbParams params(nullptr);
+    params.size = 0; // no limit
+    flag = session->readNow(streamId, params, buf);
+    FireCalls(); // flushes WINDOW_UPDATE frames (if any)
+    return buf;
+}
+
+void
+TestHttp2Session::testPreface()
+{
+    startSession(Settings({}));
+
+    const auto frames = framesFromSquid();
+    // our SETTINGS, connection WINDOW_UPDATE, and SETTINGS ACK
+    CPPUNIT_ASSERT_EQUAL(size_t(3), frames.size());
+    CPPUNIT_ASSERT_EQUAL(uint8_t(ftSettings), frames[0].header.type);
+    CPPUNIT_ASSERT(!frames[0].header.hasFlag(ffAck));
+    CPPUNIT_ASSERT_EQUAL(uint8_t(ftWindowUpdate), frames[1].header.type);
+    CPPUNIT_ASSERT_EQUAL(uint8_t(ftSettings), frames[2].header.type);
+    CPPUNIT_ASSERT(frames[2].header.hasFlag(ffAck));
+}
+
+void
+TestHttp2Session::testMultiplexing()
+{
+    startSession(Settings({}));
+    (void)framesFromSquid();
+
+    const auto first = openStream(true);
+    const auto second = openStream(true);
+    CPPUNIT_ASSERT_EQUAL(uint32_t(1), first);
+    CPPUNIT_ASSERT_EQUAL(uint32_t(3), second);
+
+    const auto frames = framesFromSquid();
+    CPPUNIT_ASSERT_EQUAL(size_t(2), frames.size());
+    CPPUNIT_ASSERT_EQUAL(uint8_t(ftHeaders), frames[0].header.type);
+    CPPUNIT_ASSERT_EQUAL(first, frames[0].header.streamId);
+    CPPUNIT_ASSERT(frames[0].header.hasFlag(ffEndStream));
+    CPPUNIT_ASSERT_EQUAL(uint8_t(ftHeaders), frames[1].header.type);
+    CPPUNIT_ASSERT_EQUAL(second, frames[1].header.streamId);
+    CPPUNIT_ASSERT_EQUAL(size_t(2), WriteOutcomes.size());
+
+    // interleaved responses reach their own streams
+    HpackEncoder encoder;
+    SBuf response;
+    response.append(ResponseHeaders(encoder, second, "404", false));
+    response.append(ResponseHeaders(encoder, first, "200", false));
+    response.append(Data(second, "missing", true));
+    response.append(Data(first, "found", true));
+    serverSends(response);
+
+    Comm::Flag flag;
+    const auto firstResponse = readStream(first, flag);
+    CPPUNIT_ASSERT_EQUAL(Comm::OK, flag);
+    CPPUNIT_ASSERT(firstResponse.startsWith(SBuf("HTTP/1.1 200 ")));
+    CPPUNIT_ASSERT(firstResponse.substr(firstResponse.length() - 9) == SBuf("\r\n\r\nfound"));
+
+    const auto secondResponse = readStream(second, flag);
+    CPPUNIT_ASSERT(secondResponse.startsWith(SBuf("HTTP/1.1 404 ")));
+    CPPUNIT_ASSERT(secondResponse.substr(secondResponse.length() - 11) == SBuf("\r\n\r\nmissing"));
+
+    (void)readStream(first, flag);
+    CPPUNIT_ASSERT_EQUAL(Comm::ENDFILE, flag);
+
+    session->closeStream(first);
+    session->closeStream(second);
+    FireCalls();
+    CPPUNIT_ASSERT(framesFromSquid().empty()); // no RST_STREAM for complete streams
+}
+
+void
+TestHttp2Session::testConcurrencyLimit()
+{
+    startSession(Settings({{sMaxConcurrentStreams, 1}}));
+    (void)framesFromSquid();
+
+    const auto first = openStream(true);
+    const auto second = openStream(true);
+
+    // the second stream waits for the first one to end
+    auto frames = framesFromSquid();
+    CPPUNIT_ASSERT_EQUAL(size_t(1), frames.size());
+    CPPUNIT_ASSERT_EQUAL(first, frames[0].header.streamId);
+    CPPUNIT_ASSERT_EQUAL(size_t(1), WriteOutcomes.size());
+
+    HpackEncoder encoder;
+    serverSends(ResponseHeaders(encoder, first, "204", true));
+    session->closeStream(first);
+    FireCalls();
+
+    frames = framesFromSquid();
+    CPPUNIT_ASSERT_EQUAL(size_t(1), frames.size());
+    CPPUNIT_ASSERT_EQUAL(uint8_t(ftHeaders), frames[0].header.type);
+    CPPUNIT_ASSERT_EQUAL(second, frames[0].header.streamId);
+    CPPUNIT_ASSERT_EQUAL(size_t(2), WriteOutcomes.size());
+}
+
+void
+TestHttp2Session::testSendWindows()
+{
+    startSession(Settings({{sInitialWindowSize, 10}}));
+    (void)framesFromSquid();
+
+    const auto streamId = openStream(false);
+    (void)framesFromSquid();
+    WriteOutcomes.clear();
+
+    // the stream window limits DATA frames
+    writeBody(streamId, "0123456789abcdefghijklmno", true);
+    auto frames = framesFromSquid();
+    CPPUNIT_ASSERT_EQUAL(size_t(10), DataBytes(frames, streamId));
+    CPPUNIT_ASSERT(WriteOutcomes.empty()); // the writer waits for all bytes
+
+    // a stream WINDOW_UPDATE releases that many bytes
+    serverSends(WindowUpdate(streamId, 5));
+    frames = framesFromSquid();
+    CPPUNIT_ASSERT_EQUAL(size_t(5), DataBytes(frames, streamId));
+    CPPUNIT_ASSERT(!FindFrame(frames, ftData, streamId)->header.hasFlag(ffEndStream));
+
+    serverSends(WindowUpdate(streamId, 100));
+    frames = framesFromSquid();
+    CPPUNIT_ASSERT_EQUAL(size_t(10), DataBytes(frames, streamId));
+    CPPUNIT_ASSERT(FindFrame(frames, ftData, streamId)->header.hasFlag(ffEndStream));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), WriteOutcomes.size());
+    CPPUNIT_ASSERT_EQUAL(Comm::OK, WriteOutcomes[0]);
+}
+
+void
+TestHttp2Session::testInitialWindowChange()
+{
+    startSession(Settings({{sInitialWindowSize, 4}}));
+    (void)framesFromSquid();
+
+    const auto streamId = openStream(false);
+    (void)framesFromSquid();
+
+    writeBody(streamId, "0123456789", false);
+    CPPUNIT_ASSERT_EQUAL(size_t(4), DataBytes(framesFromSquid(), streamId));
+
+    // a larger SETTINGS_INITIAL_WINDOW_SIZE grows the open stream window
+    serverSends(Settings({{sInitialWindowSize, 7}}));
+    auto frames = framesFromSquid();
+    CPPUNIT_ASSERT_EQUAL(size_t(3), DataBytes(frames, streamId));
+    CPPUNIT_ASSERT(FindFrame(frames, ftSettings, 0)->header.hasFlag(ffAck));
+
+    // a smaller one may make it negative (RFC 9113 Section 6.9.2)
+    serverSends(Settings({{sInitialWindowSize, 2}}));
+    (void)framesFromSquid();
+    serverSends(WindowUpdate(streamId, 5));
+    CPPUNIT_ASSERT_EQUAL(size_t(0), DataBytes(framesFromSquid(), streamId));
+    serverSends(WindowUpdate(streamId, 2));
+    CPPUNIT_ASSERT_EQUAL(size_t(2), DataBytes(framesFromSquid(), streamId));
+}
+
+void
+TestHttp2Session::testReceiveWindow()
+{
+    startSession(Settings({}));
+    (void)framesFromSquid();
+
+    const auto streamId = openStream(true);
+    (void)framesFromSquid();
+
+    HpackEncoder encoder;
+    serverSends(ResponseHeaders(encoder, streamId, "200", false));
+
+    // fill our 256 KB stream window without reading
+    const SBuf chunk(std::string(DefaultMaxFrameSize, 'x'));
+    SBuf frames;
+    for (int i = 0; i < 16; ++i)
+        PackFrame(frames, ftData, 0, streamId, chunk);
+    serverSends(frames);
+    CPPUNIT_ASSERT(framesFromSquid().empty());
+
+    // reading credits the stream window with a WINDOW_UPDATE
+    Comm::Flag flag;
+    (void)readStream(streamId, flag);
+    CPPUNIT_ASSERT_EQUAL(Comm::OK, flag);
+    auto sent = framesFromSquid();
+    const auto update = FindFrame(sent, ftWindowUpdate, streamId);
+    CPPUNIT_ASSERT(update);
+    CPPUNIT_ASSERT_EQUAL(uint32_t(16*DefaultMaxFrameSize), GetUint32(update->payload.rawContent()));
+
+    // exceeding the credited window is a stream error
+    frames.clear();
+    for (int i = 0; i < 17; ++i)
+        PackFrame(frames, ftData, 0, streamId, chunk);
+    serverSends(frames);
+    sent = framesFromSquid();
+    const auto reset = FindFrame(sent, ftRstStream, streamId);
+    CPPUNIT_ASSERT(reset);
+    CPPUNIT_ASSERT_EQUAL(uint32_t(ecFlowControlError), GetUint32(reset->payload.rawContent()));
+    CPPUNIT_ASSERT(!FindFrame(sent, ftGoAway, 0));
+
+    (void)readStream(streamId, flag);
+    CPPUNIT_ASSERT_EQUAL(Comm::COMM_ERROR, flag);
+}
+
+void
+TestHttp2Session::testGoAway()
+{
+    startSession(Settings({}));
+    (void)framesFromSquid();
+
+    const auto first = openStream(true);
+    const auto second = openStream(true);
+    (void)framesFromSquid();
+
+    // the server will only process the first stream
+    SBuf payload;
+    PutUint32(payload, first);
+    PutUint32(payload, ecNoError);
+    SBuf goAway;
+    PackFrame(goAway, ftGoAway, 0, 0, payload);
+    serverSends(goAway);
+
+    Comm::Flag flag;
+    (void)readStream(second, flag);
+    CPPUNIT_ASSERT_EQUAL(Comm::COMM_ERROR, flag);
+    CPPUNIT_ASSERT(!session->addStream());
+
+    // the first stream completes normally
+    HpackEncoder encoder;
+    serverSends(ResponseHeaders(encoder, first, "200", false));
+    serverSends(Data(first, "done", true));
+    const auto response = readStream(first, flag);
+    CPPUNIT_ASSERT_EQUAL(Comm::OK, flag);
+    CPPUNIT_ASSERT(response.startsWith(SBuf("HTTP/1.1 200 ")));
+    CPPUNIT_ASSERT(!Wire::closed);
+
+    // the connection closes after its last stream
+    session->closeStream(second);
+    CPPUNIT_ASSERT(!Wire::closed);
+    session->closeStream(first);
+    FireCalls();
+    CPPUNIT_ASSERT(Wire::closed);
+    CPPUNIT_ASSERT(framesFromSquid().empty()); // no RST_STREAM for refused or complete streams
+}
+
+void
+TestHttp2Session::testSessionEnd()
+{
+    startSession(Settings({{sInitialWindowSize, 0}}));
+    (void)framesFromSquid();
+
+    // a stream with a flow-controlled writer and a waiting reader
+    const auto streamId = openStream(false);
+    WriteOutcomes.clear();
+    writeBody(streamId, "blocked", true);
+    AsyncCall::Pointer reader = commCbCall(5, 5, "NoteReadable", CommIoCbPtrFun(&NoteReadable, nullptr));
+    session->read(streamId, reader);
+    FireCalls();
+    CPPUNIT_ASSERT(WriteOutcomes.empty());
+    CPPUNIT_ASSERT_EQUAL(0, ReadNotifications);
+
+    // a connection error ends the session
+    serverSends(Data(0, "x", false));
+    CPPUNIT_ASSERT(Wire::closed);
+    session = nullptr; // gone
+
+    // the stream transactions learn about the connection closure
+    CPPUNIT_ASSERT_EQUAL(size_t(1), WriteOutcomes.size());
+    CPPUNIT_ASSERT_EQUAL(Comm::ERR_CLOSING, WriteOutcomes[0]);
+    CPPUNIT_ASSERT_EQUAL(1, ReadNotifications);
+}
+
+/// customizes our test setup
+class MyTestProgram: public TestProgram
+{
+public:
+    /* TestProgram API */
+    void startup() override;
+};
+
+void
+MyTestProgram::startup()
+{
+    Mem::Init();
+    AnyP::UriScheme::Init();
+    httpHeaderInitModule();
+    Config.maxReplyHeaderSize = 64*1024;
+}
+
+int
+main(int argc, char *argv[])
+{
+    return MyTestProgram().run(argc, argv);
+}
+
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "compat/cppunit.h"
+#include "http/Compressor.h"
+#include "unitTestMain.h"
+
+#if HAVE_LIBZLIB && HAVE_ZLIB_H
+#include <zlib.h>
+#endif
+
+using Coding = Http::Compressor::Coding;
+
+class TestHttpCompressor : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestHttpCompressor);
+    CPPUNIT_TEST(testNegotiate);
+    CPPUNIT_TEST(testGzipRoundTrip);
+    CPPUNIT_TEST(testBrotli);
+    CPPUNIT_TEST(testETagCoding);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testNegotiate();
+    void testGzipRoundTrip();
+    void testBrotli();
+    void testETagCoding();
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(TestHttpCompressor);
+
+/// Negotiate() with both codings enabled
+static Coding
+Negotiate(const char *acceptEncoding)
+{
+    return Http::Compressor::Negotiate(SBuf(acceptEncoding), 6, 5);
+}
+
+/// a compressible body with some variety
+static SBuf
+SampleBody()
+{
+    SBuf body;
+    for (int i = 0; i < 2000; ++i)
+        body.appendf("line %d of a sample response body\n", i % 37);
+    return body;
+}
+
+/// compresses the body in small pieces
+static SBuf
+Compress(Coding coding, const SBuf &body)
+{
+    const auto compressor = Http::Compressor::Make(coding, 6);
+    SBuf out;
+    const SBuf::size_type step = 1000;
+    for (SBuf::size_type offset = 0; offset < body.length(); offset += step) {
+        const auto piece = body.substr(offset, step);
+        compressor->compress(piece.rawContent(), piece.length(), out);
+    }
+    compressor->finish(out);
+    CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(body.length()), compressor->bytesIn());
+    CPPUNIT_ASSERT_EQUAL(static_cast<uint64_t>(out.length()), compressor->bytesOut());
+    return out;
+}
+
+void
+TestHttpCompressor::testNegotiate()
+{
+    const auto best = Http::Compressor::Supported(Coding::br) ? Coding::br :
+                      Http::Compressor::Supported(Coding::gzip) ? Coding::gzip : Coding::identity;
+    const auto gzip = Http::Compressor::Supported(Coding::gzip) ? Coding::gzip : Coding::identity;
+
+    CPPUNIT_ASSERT(Negotiate("") == Coding::identity);
+    CPPUNIT_ASSERT(Negotiate("identity") == Coding::identity);
+    CPPUNIT_ASSERT(Negotiate("deflate, compress") == Coding::identity);
+    CPPUNIT_ASSERT(Negotiate("gzip") == gzip);
+    CPPUNIT_ASSERT(Negotiate("GZIP") == gzip);
+    CPPUNIT_ASSERT(Negotiate("x-gzip") == gzip);
+    CPPUNIT_ASSERT(Negotiate("gzip, deflate, br") == best);
+    CPPUNIT_ASSERT(Negotiate("*") == best);
+
+    // qvalues
+    CPPUNIT_ASSERT(Negotiate("gzip;q=0") == Coding::identity);
+    CPPUNIT_ASSERT(Negotiate("gzip ; q=0.000") == Coding::identity);
+    CPPUNIT_ASSERT(Negotiate("br;q=0, gzip") == gzip);
+    CPPUNIT_ASSERT(Negotiate("br;q=0.5, gzip;q=0.8") == gzip);
+    CPPUNIT_ASSERT(Negotiate("br;q=0.9, gzip;q=0.8") == best);
+    CPPUNIT_ASSERT(Negotiate("*;q=0, gzip") == gzip);
+    CPPUNIT_ASSERT(Negotiate("br;Q=1.0;foo=bar, *;q=0.1") == best);
+    CPPUNIT_ASSERT(Negotiate("gzip;q=2") == Coding::identity);
+    CPPUNIT_ASSERT(Negotiate("gzip;q=x") == Coding::identity);
+
+    // malformed members do not hide the others
+    CPPUNIT_ASSERT(Negotiate(",, @@, gzip") == gzip);
+
+    // disabled codings
+    CPPUNIT_ASSERT(Http::Compressor::Negotiate(SBuf("br, gzip"), 6, 0) == gzip);
+    CPPUNIT_ASSERT(Http::Compressor::Negotiate(SBuf("br, gzip"), 0, 0) == Coding::identity);
+}
+
+void
+TestHttpCompressor::testGzipRoundTrip()
+{
+#if HAVE_LIBZLIB && HAVE_ZLIB_H
+    const auto body = SampleBody();
+    const auto compressed = Compress(Coding::gzip, body);
+    CPPUNIT_ASSERT(compressed.length() < body.length() / 10);
+
+    // gzip magic
+    CPPUNIT_ASSERT_EQUAL('\x1f', compressed[0]);
+    CPPUNIT_ASSERT_EQUAL('\x8b', compressed[1]);
+
+    z_stream stream = {};
+    CPPUNIT_ASSERT_EQUAL(Z_OK, inflateInit2(&stream, MAX_WBITS + 16));
+    std::vector<char> inflated(body.length() + 1);
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(compressed.rawContent()));
+    stream.avail_in = compressed.length();
+    stream.next_out = reinterpret_cast<Bytef *>(inflated.data());
+    stream.avail_out = inflated.size();
+    CPPUNIT_ASSERT_EQUAL(Z_STREAM_END, inflate(&stream, Z_FINISH));
+    CPPUNIT_ASSERT_EQUAL(0u, stream.avail_in);
+    CPPUNIT_ASSERT_EQUAL(static_cast<uLong>(body.length()), stream.total_out);
+    (void)inflateEnd(&stream);
+    CPPUNIT_ASSERT_EQUAL(body, SBuf(inflated.data(), body.length()));
+
+    // an empty body still gets the gzip header and trailer
+    CPPUNIT_ASSERT(!Compress(Coding::gzip, SBuf()).isEmpty());
+#endif
+}
+
+void
+TestHttpCompressor::testBrotli()
+{
+    if (!Http::Compressor::Supported(Coding::br))
+        return;
+
+    const auto body = SampleBody();
+    const auto compressed = Compress(Coding::br, body);
+    CPPUNIT_ASSERT(!compressed.isEmpty());
+    CPPUNIT_ASSERT(compressed.length() < body.length() / 10);
+}
+
+void
+TestHttpCompressor::testETagCoding()
+{
+    SBuf etag("\"v1\"");
+    CPPUNIT_ASSERT(Http::Compressor::AddETagCoding(etag, Coding::gzip));
+    CPPUNIT_ASSERT_EQUAL(SBuf("\"v1-gzip\""), etag);
+    CPPUNIT_ASSERT(Http::Compressor::RemoveETagCoding(etag, SBuf("gzip")));
+    CPPUNIT_ASSERT_EQUAL(SBuf("\"v1\""), etag);
+
+    etag = SBuf("W/\"v2\"");
+    CPPUNIT_ASSERT(Http::Compressor::AddETagCoding(etag, Coding::br));
+    CPPUNIT_ASSERT_EQUAL(SBuf("W/\"v2-br\""), etag);
+    CPPUNIT_ASSERT(Http::Compressor::RemoveETagCoding(etag, SBuf("BR")));
+    CPPUNIT_ASSERT_EQUAL(SBuf("W/\"v2\""), etag);
+
+    // an empty opaque tag
+    etag = SBuf("\"\"");
+    CPPUNIT_ASSERT(Http::Compressor::AddETagCoding(etag, Coding::gzip));
+    CPPUNIT_ASSERT_EQUAL(SBuf("\"-gzip\""), etag);
+    CPPUNIT_ASSERT(Http::Compressor::RemoveETagCoding(etag, SBuf("gzip")));
+    CPPUNIT_ASSERT_EQUAL(SBuf("\"\""), etag);
+
+    // malformed tags are left alone
+    for (const auto bad: {"", "v1", "\"", "W/", "W/v1", "\"v1"}) {
+        etag = SBuf(bad);
+        CPPUNIT_ASSERT(!Http::Compressor::AddETagCoding(etag, Coding::gzip));
+        CPPUNIT_ASSERT_EQUAL(SBuf(bad), etag);
+    }
+
+    // suffixes that do not match the response coding are kept
+    etag = SBuf("\"v1-gzip\"");
+    CPPUNIT_ASSERT(!Http::Compressor::RemoveETagCoding(etag, SBuf("br")));
+    CPPUNIT_ASSERT(!Http::Compressor::RemoveETagCoding(etag, SBuf()));
+    CPPUNIT_ASSERT(!Http::Compressor::RemoveETagCoding(etag, SBuf("gzip, br")));
+    CPPUNIT_ASSERT_EQUAL(SBuf("\"v1-gzip\""), etag);
+    etag = SBuf("\"v1\"");
+    CPPUNIT_ASSERT(!Http::Compressor::RemoveETagCoding(etag, SBuf("gzip")));
+    CPPUNIT_ASSERT_EQUAL(SBuf("\"v1\""), etag);
+}
+
+int
+main(int argc, char *argv[])
+{
+    return TestProgram().run(argc, argv);
+}
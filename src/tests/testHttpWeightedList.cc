@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "compat/cppunit.h"
+#include "http/WeightedList.h"
+#include "unitTestMain.h"
+
+class TestHttpWeightedList : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestHttpWeightedList);
+    CPPUNIT_TEST(testParseWeightedList);
+    CPPUNIT_TEST(testCanonicalTokens);
+    CPPUNIT_TEST(testCanonicalTokensOnly);
+    CPPUNIT_TEST(testLookupLanguage);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testParseWeightedList();
+    void testCanonicalTokens();
+    void testCanonicalTokensOnly();
+    void testLookupLanguage();
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(TestHttpWeightedList);
+
+/// CanonicalTokens() result for the given field value
+static SBuf
+Canonical(const char *value, const SBufList &only = SBufList())
+{
+    return Http::CanonicalTokens(SBuf(value), only);
+}
+
+/// LookupLanguage() result for the given field value
+static SBuf
+Lookup(const char *value, const char *defaultLanguage = "en")
+{
+    static const SBufList languages = { SBuf("en"), SBuf("de"), SBuf("fr-ca") };
+    return Http::LookupLanguage(SBuf(value), languages, SBuf(defaultLanguage));
+}
+
+void
+TestHttpWeightedList::testParseWeightedList()
+{
+    auto items = Http::ParseWeightedList(SBuf("en-US, de;q=0.5 , *;q=0.001,fr;level=1;q=0"));
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(4), items.size());
+    CPPUNIT_ASSERT_EQUAL(SBuf("en-US"), items[0].value);
+    CPPUNIT_ASSERT_EQUAL(1000, items[0].quality);
+    CPPUNIT_ASSERT_EQUAL(SBuf("de"), items[1].value);
+    CPPUNIT_ASSERT_EQUAL(500, items[1].quality);
+    CPPUNIT_ASSERT_EQUAL(SBuf("*"), items[2].value);
+    CPPUNIT_ASSERT_EQUAL(1, items[2].quality);
+    CPPUNIT_ASSERT_EQUAL(SBuf("fr"), items[3].value);
+    CPPUNIT_ASSERT_EQUAL(0, items[3].quality);
+
+    CPPUNIT_ASSERT(Http::ParseWeightedList(SBuf()).empty());
+    CPPUNIT_ASSERT(Http::ParseWeightedList(SBuf(" ,, ")).empty());
+
+    items = Http::ParseWeightedList(SBuf("@bad, br;q=1.000"));
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), items.size());
+    CPPUNIT_ASSERT_EQUAL(SBuf("br"), items[0].value);
+    CPPUNIT_ASSERT_EQUAL(1000, items[0].quality);
+
+    // malformed and out-of-range qvalues are "not acceptable"
+    items = Http::ParseWeightedList(SBuf("a;q=2, b;q=x, c;q=0.9999"));
+    CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), items.size());
+    CPPUNIT_ASSERT_EQUAL(0, items[0].quality);
+    CPPUNIT_ASSERT_EQUAL(0, items[1].quality);
+    CPPUNIT_ASSERT_EQUAL(999, items[2].quality);
+}
+
+void
+TestHttpWeightedList::testCanonicalTokens()
+{
+    CPPUNIT_ASSERT_EQUAL(SBuf(), Canonical(""));
+
+    // sorting, case, and weights of acceptable members do not matter
+    CPPUNIT_ASSERT_EQUAL(SBuf("br,deflate,gzip"), Canonical("gzip, deflate, br"));
+    CPPUNIT_ASSERT_EQUAL(SBuf("br,deflate,gzip"), Canonical("BR;q=0.1,Deflate , gzip;q=1"));
+
+    // duplicates
+    CPPUNIT_ASSERT_EQUAL(SBuf("br,gzip"), Canonical("gzip, br, GZIP, gzip;q=0.5"));
+
+    // members with zero weights are dropped without a wildcard
+    CPPUNIT_ASSERT_EQUAL(SBuf("gzip"), Canonical("gzip, br;q=0"));
+    CPPUNIT_ASSERT_EQUAL(SBuf(), Canonical("identity;q=0"));
+
+    // an acceptable member wins over its rejected duplicate
+    CPPUNIT_ASSERT_EQUAL(SBuf("gzip"), Canonical("gzip;q=0, gzip"));
+
+    // a rejected wildcard accepts nothing
+    CPPUNIT_ASSERT_EQUAL(SBuf("gzip"), Canonical("*;q=0, gzip"));
+    CPPUNIT_ASSERT_EQUAL(SBuf(), Canonical("*;q=0"));
+
+    // an acceptable wildcard keeps the rejected members
+    CPPUNIT_ASSERT_EQUAL(SBuf("*,identity;q=0"), Canonical("*, identity;q=0"));
+    CPPUNIT_ASSERT_EQUAL(SBuf("*,gzip,br;q=0"), Canonical("br;q=0, gzip, *;q=0.5"));
+    CPPUNIT_ASSERT_EQUAL(SBuf("*,gzip"), Canonical("*, gzip;q=0, gzip"));
+}
+
+void
+TestHttpWeightedList::testCanonicalTokensOnly()
+{
+    const SBufList only = { SBuf("gzip"), SBuf("br") };
+
+    CPPUNIT_ASSERT_EQUAL(SBuf("br,gzip"), Canonical("deflate, gzip;q=0.5, br, compress", only));
+    CPPUNIT_ASSERT_EQUAL(SBuf("gzip"), Canonical("GZIP, x-gzip", only));
+    CPPUNIT_ASSERT_EQUAL(SBuf(), Canonical("deflate, compress", only));
+
+    // wildcards are kept, but only configured members may be rejected
+    CPPUNIT_ASSERT_EQUAL(SBuf("*"), Canonical("*, deflate;q=0", only));
+    CPPUNIT_ASSERT_EQUAL(SBuf("*,br;q=0"), Canonical("*, br;q=0, deflate;q=0", only));
+    CPPUNIT_ASSERT_EQUAL(SBuf("gzip"), Canonical("*;q=0, gzip", only));
+}
+
+void
+TestHttpWeightedList::testLookupLanguage()
+{
+    // exact matches
+    CPPUNIT_ASSERT_EQUAL(SBuf("de"), Lookup("de"));
+    CPPUNIT_ASSERT_EQUAL(SBuf("fr-ca"), Lookup("FR-CA"));
+
+    // RFC 4647 Lookup truncates ranges, not supported tags
+    CPPUNIT_ASSERT_EQUAL(SBuf("de"), Lookup("de-AT"));
+    CPPUNIT_ASSERT_EQUAL(SBuf("de"), Lookup("de-Latn-AT-x-private"));
+    CPPUNIT_ASSERT_EQUAL(SBuf("fr-ca"), Lookup("fr-CA-x-quebec"));
+    CPPUNIT_ASSERT_EQUAL(SBuf("en"), Lookup("fr"));
+
+    // ranges are tried in qvalue order, keeping list order on ties
+    CPPUNIT_ASSERT_EQUAL(SBuf("de"), Lookup("es, de;q=0.5, en;q=0.4"));
+    CPPUNIT_ASSERT_EQUAL(SBuf("fr-ca"), Lookup("de;q=0.5, fr-ca;q=0.9"));
+    CPPUNIT_ASSERT_EQUAL(SBuf("de"), Lookup("de, fr-ca"));
+    CPPUNIT_ASSERT_EQUAL(SBuf("fr-ca"), Lookup("de;q=0, fr-ca;q=0.1"));
+
+    // unacceptable and unsupported languages fall back to the default
+    CPPUNIT_ASSERT_EQUAL(SBuf("en"), Lookup("de;q=0"));
+    CPPUNIT_ASSERT_EQUAL(SBuf("en"), Lookup("es, it"));
+    CPPUNIT_ASSERT_EQUAL(SBuf("en"), Lookup(""));
+    CPPUNIT_ASSERT_EQUAL(SBuf("de"), Lookup("es", "de"));
+    CPPUNIT_ASSERT_EQUAL(SBuf(), Lookup("es", ""));
+
+    // a wildcard selects the default (or the first supported) language
+    CPPUNIT_ASSERT_EQUAL(SBuf("en"), Lookup("es, *;q=0.5"));
+    CPPUNIT_ASSERT_EQUAL(SBuf("de"), Lookup("*", "de"));
+    CPPUNIT_ASSERT_EQUAL(SBuf("en"), Lookup("*", ""));
+    CPPUNIT_ASSERT_EQUAL(SBuf("de"), Lookup("*;q=0.5, de"));
+}
+
+int
+main(int argc, char *argv[])
+{
+    return TestProgram().run(argc, argv);
+}
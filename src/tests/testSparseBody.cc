@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "compat/cppunit.h"
+#include "SparseBody.h"
+#include "unitTestMain.h"
+
+class TestSparseBody : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestSparseBody);
+    CPPUNIT_TEST(testDisjoint);
+    CPPUNIT_TEST(testTouching);
+    CPPUNIT_TEST(testOverlapping);
+    CPPUNIT_TEST(testBridging);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testDisjoint();
+    void testTouching();
+    void testOverlapping();
+    void testBridging();
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(TestSparseBody);
+
+/// asserts that the given body range is stored and has the expected bytes
+static void
+AssertStored(const SparseBody &body, const int64_t offset, const char *expected)
+{
+    const SBuf bytes(expected);
+    const auto stored = body.get(offset, bytes.length());
+    CPPUNIT_ASSERT(stored);
+    CPPUNIT_ASSERT_EQUAL(bytes, *stored);
+}
+
+void
+TestSparseBody::testDisjoint()
+{
+    SparseBody body;
+    CPPUNIT_ASSERT(!body.get(0, 1));
+    CPPUNIT_ASSERT_EQUAL(uint64_t(0), body.bytes());
+
+    body.add(10, SBuf("abcd"));
+    body.add(20, SBuf("wxyz"));
+    CPPUNIT_ASSERT_EQUAL(size_t(2), body.pieces());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(8), body.bytes());
+
+    AssertStored(body, 10, "abcd");
+    AssertStored(body, 11, "bc");
+    AssertStored(body, 13, "d");
+    AssertStored(body, 20, "wxyz");
+
+    // holes
+    CPPUNIT_ASSERT(!body.get(0, 1));
+    CPPUNIT_ASSERT(!body.get(9, 2));
+    CPPUNIT_ASSERT(!body.get(12, 3));
+    CPPUNIT_ASSERT(!body.get(14, 1));
+    CPPUNIT_ASSERT(!body.get(10, 11));
+    CPPUNIT_ASSERT(!body.get(23, 2));
+}
+
+void
+TestSparseBody::testTouching()
+{
+    SparseBody body;
+
+    // after an existing piece
+    body.add(0, SBuf("abc"));
+    body.add(3, SBuf("def"));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), body.pieces());
+    AssertStored(body, 0, "abcdef");
+
+    // before an existing piece
+    body.add(10, SBuf("klm"));
+    body.add(8, SBuf("ij"));
+    CPPUNIT_ASSERT_EQUAL(size_t(2), body.pieces());
+    AssertStored(body, 8, "ijklm");
+
+    // between two existing pieces
+    body.add(6, SBuf("gh"));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), body.pieces());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(13), body.bytes());
+    AssertStored(body, 0, "abcdefghijklm");
+}
+
+void
+TestSparseBody::testOverlapping()
+{
+    SparseBody body;
+    body.add(10, SBuf("abcdef"));
+
+    // the tail of the new piece overlaps the stored one
+    body.add(7, SBuf("xyzAB"));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), body.pieces());
+    AssertStored(body, 7, "xyzABcdef");
+
+    // the head of the new piece overlaps the stored one
+    body.add(14, SBuf("EFGH"));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), body.pieces());
+    AssertStored(body, 7, "xyzABcdEFGH");
+
+    // the new piece is inside the stored one
+    body.add(9, SBuf("Z"));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), body.pieces());
+    AssertStored(body, 7, "xyZABcdEFGH");
+
+    // the new piece starts where the stored one starts
+    body.add(7, SBuf("12"));
+    AssertStored(body, 7, "12ZABcdEFGH");
+
+    // the new piece covers the stored one
+    body.add(5, SBuf("0123456789ABCDE"));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), body.pieces());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(15), body.bytes());
+    AssertStored(body, 5, "0123456789ABCDE");
+}
+
+void
+TestSparseBody::testBridging()
+{
+    SparseBody body;
+    body.add(0, SBuf("aa"));
+    body.add(4, SBuf("bb"));
+    body.add(8, SBuf("cc"));
+    body.add(12, SBuf("dd"));
+    CPPUNIT_ASSERT_EQUAL(size_t(4), body.pieces());
+
+    // overlaps the first piece, covers two, and touches the last one
+    body.add(1, SBuf("XXXXXXXXXXX"));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), body.pieces());
+    CPPUNIT_ASSERT_EQUAL(uint64_t(14), body.bytes());
+    AssertStored(body, 0, "aXXXXXXXXXXXdd");
+}
+
+int
+main(int argc, char *argv[])
+{
+    return TestProgram().run(argc, argv);
+}
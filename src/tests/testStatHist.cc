@@ -11,6 +11,8 @@
 #include "StatHist.h"
 #include "unitTestMain.h"
 
+#include <cmath>
+
 class TestStatHist : public CPPUNIT_NS::TestFixture
 {
     CPPUNIT_TEST_SUITE(TestStatHist);
@@ -18,6 +20,7 @@ class TestStatHist : public CPPUNIT_NS::TestFixture
     CPPUNIT_TEST(testStatHistBaseAssignment);
     CPPUNIT_TEST(testStatHistLog);
     CPPUNIT_TEST(testStatHistSum);
+    CPPUNIT_TEST(testStatHistBinBounds);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -26,6 +29,7 @@ protected:
     void testStatHistBaseAssignment();
     void testStatHistLog();
     void testStatHistSum();
+    void testStatHistBinBounds();
 };
 CPPUNIT_TEST_SUITE_REGISTRATION( TestStatHist );
 
@@ -120,6 +124,29 @@ TestStatHist::testStatHistSum()
 
 }
 
+void
+TestStatHist::testStatHistBinBounds()
+{
+    InspectingStatHist test;
+    test.logInit(300, 0.0, 3600000.0 * 3.0);
+    CPPUNIT_ASSERT_EQUAL(300u, test.capacity());
+
+    // bounds grow and every counted value lands in the bin it is bound by
+    for (unsigned int bin = 0; bin + 1 < test.capacity(); ++bin) {
+        const auto bound = test.binUpperBound(bin);
+        CPPUNIT_ASSERT(bound < test.binUpperBound(bin + 1));
+        InspectingStatHist counted;
+        counted.logInit(300, 0.0, 3600000.0 * 3.0);
+        counted.count(bound * 0.999);
+        CPPUNIT_ASSERT_EQUAL(StatHist::bins_type(1), counted.binCount(bin));
+    }
+    CPPUNIT_ASSERT(std::isinf(test.binUpperBound(test.capacity() - 1)));
+
+    test.count(1.0);
+    test.count(1e9);
+    CPPUNIT_ASSERT_EQUAL(StatHist::bins_type(1), test.binCount(test.capacity() - 1));
+}
+
 int
 main(int argc, char *argv[])
 {
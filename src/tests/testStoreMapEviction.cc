@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "compat/cppunit.h"
+#include "ipc/StoreMapEviction.h"
+#include "md5.h"
+#include "unitTestMain.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+class TestStoreMapEviction : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestStoreMapEviction);
+    CPPUNIT_TEST(testPolicyNames);
+    CPPUNIT_TEST(testEvictsOnlyValidEntries);
+    CPPUNIT_TEST(testScanResistance);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testPolicyNames();
+    void testEvictsOnlyValidEntries();
+    void testScanResistance();
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(TestStoreMapEviction);
+
+void
+TestStoreMapEviction::testPolicyNames()
+{
+    Ipc::EvictionPolicy policy = Ipc::EvictionPolicy::hashOrder;
+    CPPUNIT_ASSERT(Ipc::ParseEvictionPolicy("s3fifo", policy));
+    CPPUNIT_ASSERT(policy == Ipc::EvictionPolicy::s3fifo);
+    CPPUNIT_ASSERT(Ipc::ParseEvictionPolicy("clock", policy));
+    CPPUNIT_ASSERT(policy == Ipc::EvictionPolicy::clock);
+    CPPUNIT_ASSERT(Ipc::ParseEvictionPolicy("hash", policy));
+    CPPUNIT_ASSERT(policy == Ipc::EvictionPolicy::hashOrder);
+    CPPUNIT_ASSERT(!Ipc::ParseEvictionPolicy("lru", policy));
+    CPPUNIT_ASSERT(policy == Ipc::EvictionPolicy::hashOrder);
+
+    CPPUNIT_ASSERT_EQUAL(std::string("s3fifo"), std::string(Ipc::EvictionPolicyName(Ipc::EvictionPolicy::s3fifo)));
+}
+
+void
+TestStoreMapEviction::testEvictsOnlyValidEntries()
+{
+    const int capacity = 10; // the small queue target size is 1
+    std::unique_ptr<char[]> raw(new char[Ipc::StoreMapEviction::SharedMemorySize(capacity)]);
+    auto &eviction = *new (raw.get()) Ipc::StoreMapEviction(capacity, Ipc::EvictionPolicy::s3fifo);
+
+    cache_key key[SQUID_MD5_DIGEST_LENGTH];
+    memset(key, 0, sizeof(key));
+    key[8] = 1;
+    const auto tag = Ipc::StoreMapEviction::Tag(key);
+    CPPUNIT_ASSERT(tag != 0);
+    eviction.noteInsertion(5, key);
+
+    cache_key otherKey[SQUID_MD5_DIGEST_LENGTH];
+    memset(otherKey, 0, sizeof(otherKey));
+    otherKey[8] = 2;
+    eviction.noteInsertion(6, otherKey);
+
+    // the oldest unused probationary entry is the next victim
+    CPPUNIT_ASSERT_EQUAL(sfileno(5), eviction.nextVictim());
+    sfileno victim = -1;
+    uint32_t victimTag = 0;
+    CPPUNIT_ASSERT(eviction.evictOne([&](const sfileno fileno, const uint32_t t) {
+        victim = fileno;
+        victimTag = t;
+        return true;
+    }, capacity));
+    CPPUNIT_ASSERT_EQUAL(sfileno(5), victim);
+    CPPUNIT_ASSERT_EQUAL(tag, victimTag);
+
+    // a recently evicted key skips the small queue
+    eviction.noteInsertion(7, key);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), eviction.ghostHits.load());
+    CPPUNIT_ASSERT(!eviction.items[7].probationary.load());
+
+    // busy entries are not evicted
+    CPPUNIT_ASSERT(!eviction.evictOne([](sfileno, uint32_t) { return false; }, capacity));
+
+    // read entries get a second chance
+    eviction.noteAccess(7);
+    victim = -1;
+    CPPUNIT_ASSERT(eviction.evictOne([&](const sfileno fileno, uint32_t) {
+        if (fileno != 7)
+            return false; // empty position
+        victim = fileno;
+        return true;
+    }, 2*capacity + 1));
+    CPPUNIT_ASSERT_EQUAL(sfileno(7), victim);
+    CPPUNIT_ASSERT(eviction.secondChances.load() > 0);
+}
+
+void
+TestStoreMapEviction::testScanResistance()
+{
+    const int capacity = 40; // the small queue target size is 4
+    std::unique_ptr<char[]> raw(new char[Ipc::StoreMapEviction::SharedMemorySize(capacity)]);
+    auto &eviction = *new (raw.get()) Ipc::StoreMapEviction(capacity, Ipc::EvictionPolicy::s3fifo);
+
+    std::vector<bool> used(capacity, false);
+    cache_key key[SQUID_MD5_DIGEST_LENGTH];
+    memset(key, 0, sizeof(key));
+
+    // a popular entry followed by a scan of entries that are never read
+    for (int i = 0; i <= 5; ++i) {
+        key[8] = i + 1;
+        eviction.noteInsertion(i, key);
+        used[i] = true;
+        if (i == 0)
+            eviction.noteAccess(i);
+    }
+
+    // the scan entries are evicted first; the popular one is promoted
+    for (int i = 1; i <= 5; ++i) {
+        sfileno victim = -1;
+        CPPUNIT_ASSERT(eviction.evictOne([&](const sfileno fileno, uint32_t) {
+            if (!used[fileno])
+                return false;
+            used[fileno] = false;
+            victim = fileno;
+            return true;
+        }, capacity));
+        CPPUNIT_ASSERT_EQUAL(sfileno(i), victim);
+    }
+    CPPUNIT_ASSERT(used[0]);
+    CPPUNIT_ASSERT_EQUAL(uint64_t(1), eviction.promotions.load());
+    CPPUNIT_ASSERT(!eviction.items[0].probationary.load());
+}
+
+int
+main(int argc, char *argv[])
+{
+    return TestProgram().run(argc, argv);
+}
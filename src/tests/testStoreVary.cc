@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "compat/cppunit.h"
+#include "globals.h"
+#include "HttpHeader.h"
+#include "HttpReply.h"
+#include "HttpRequest.h"
+#include "MasterXaction.h"
+#include "MemObject.h"
+#include "RemovalPolicy.h"
+#include "SquidConfig.h"
+#include "Store.h"
+#include "store_key_md5.h"
+#include "unitTestMain.h"
+
+/*
+ * test (re)keying of public entries with Vary-controlled responses
+ */
+
+class TestStoreVary : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestStoreVary);
+    CPPUNIT_TEST(testRekeyVariant);
+    CPPUNIT_TEST(testKeepInvariant);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testRekeyVariant();
+    void testKeepInvariant();
+};
+CPPUNIT_TEST_SUITE_REGISTRATION(TestStoreVary);
+
+/// the request variance that httpMakeVaryMark() computes for our Vary header
+static const SBuf VaryMark("accept-language=\"en\"");
+
+/// creates a GET request for the given URL
+static HttpRequestPointer
+makeRequest(const char *url)
+{
+    const HttpRequestPointer request(HttpRequest::FromUrlXXX(url, MasterXaction::MakePortless<XactionInitiator::initHtcp>()));
+    CPPUNIT_ASSERT(request);
+    request->flags.cachable.support();
+    return request;
+}
+
+/// creates a public entry for the given request, as collapsed forwarding
+/// does before the response is known
+static StoreEntry *
+makePublicEntry(const HttpRequestPointer &request)
+{
+    auto url = request->storeId();
+    const auto e = storeCreatePureEntry(url.c_str(), url.c_str(), request->method);
+    e->lock("TestStoreVary");
+    e->mem_obj->request = request;
+    CPPUNIT_ASSERT(e->setPublicKey());
+    CPPUNIT_ASSERT_EQUAL(e, storeGetPublicByRequest(request.getRaw()));
+    return e;
+}
+
+/// gives the entry parsed response headers with the given Vary value (if any)
+static void
+setReply(StoreEntry *e, const char *vary)
+{
+    const HttpReplyPointer reply(new HttpReply);
+    reply->setHeaders(Http::scOkay, "OK", "text/plain", 10, -1, squid_curtime + 100);
+    if (vary) {
+        reply->header.putStr(Http::HdrType::VARY, vary);
+        // as if HttpStateData has computed the response variance
+        e->mem_obj->vary_headers = VaryMark;
+        e->mem_obj->request->vary_headers = VaryMark;
+    }
+    reply->pstate = Http::Message::psParsed;
+    e->replaceHttpReply(reply, false);
+}
+
+void
+TestStoreVary::testRekeyVariant()
+{
+    const auto request = makeRequest("http://example.com/variant");
+    const auto e = makePublicEntry(request);
+    const auto baseKey = storeKeyDup(e->publicKey());
+
+    setReply(e, "Accept-Language");
+
+    // without remote collapsed readers, the first response moves the entry
+    // from the base key to the variant key and leaves a Vary marker behind
+    CPPUNIT_ASSERT(e->setPublicKey());
+    CPPUNIT_ASSERT(storeKeyHashCmp(baseKey, e->publicKey()));
+    CPPUNIT_ASSERT_EQUAL(e, storeGetPublicByRequest(request.getRaw()));
+
+    const auto marker = Store::Root().peek(baseKey);
+    CPPUNIT_ASSERT(marker);
+    CPPUNIT_ASSERT(marker != e);
+    CPPUNIT_ASSERT(marker->mem().freshestReply().header.has(Http::HdrType::VARY));
+
+    storeKeyFree(baseKey);
+    e->unlock("TestStoreVary");
+}
+
+void
+TestStoreVary::testKeepInvariant()
+{
+    const auto request = makeRequest("http://example.com/invariant");
+    const auto e = makePublicEntry(request);
+    const auto baseKey = storeKeyDup(e->publicKey());
+
+    setReply(e, nullptr);
+
+    // a response without Vary keeps the key and needs no Vary marker
+    CPPUNIT_ASSERT(e->setPublicKey());
+    CPPUNIT_ASSERT(!storeKeyHashCmp(baseKey, e->publicKey()));
+    CPPUNIT_ASSERT_EQUAL(e, Store::Root().peek(baseKey));
+
+    storeKeyFree(baseKey);
+    e->unlock("TestStoreVary");
+}
+
+/// customizes our test setup
+class MyTestProgram: public TestProgram
+{
+public:
+    /* TestProgram API */
+    void startup() override;
+};
+
+void
+MyTestProgram::startup()
+{
+    Config.memShared.defaultTo(false);
+    // keep idle Vary markers in the local memory cache
+    Config.memMaxSize = 1024*1024;
+    Config.Store.maxInMemObjSize = 2048;
+    Config.Store.avgObjectSize = 1024;
+    Config.Store.objectsPerBucket = 20;
+    Config.Store.maxObjectSize = 2048;
+    Config.store_dir_select_algorithm = xstrdup("round-robin");
+
+    Config.replPolicy = new RemovalPolicySettings;
+    Config.replPolicy->type = xstrdup("lru");
+    Config.replPolicy->args = nullptr;
+
+    /* garh garh */
+    extern REMOVALPOLICYCREATE createRemovalPolicy_lru;
+    storeReplAdd("lru", createRemovalPolicy_lru);
+
+    visible_appname_string = xstrdup(APP_FULLNAME);
+
+    Mem::Init();
+    httpHeaderInitModule();
+    mem_policy = createRemovalPolicy(Config.replPolicy);
+
+    Store::Root().configure();
+    Store::Root().init();
+}
+
+int
+main(int argc, char *argv[])
+{
+    return MyTestProgram().run(argc, argv);
+}
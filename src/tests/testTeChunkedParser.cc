@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 1996-2026 The Squid Software Foundation and contributors
+ *
+ * Squid software is distributed under GPLv2+ license and includes
+ * contributions from numerous individuals and organizations.
+ * Please see the COPYING and CONTRIBUTORS files for details.
+ */
+
+#include "squid.h"
+#include "base/TextException.h"
+#include "compat/cppunit.h"
+#include "http/one/TeChunkedParser.h"
+#include "sbuf/SBuf.h"
+#include "unitTestMain.h"
+
+class TestTeChunkedParser : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestTeChunkedParser);
+    CPPUNIT_TEST(testDecode);
+    CPPUNIT_TEST(testSharedOutput);
+    CPPUNIT_TEST(testOutputLimit);
+    CPPUNIT_TEST(testDripFeed);
+    CPPUNIT_TEST(testInvalid);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    void testDecode();
+    void testSharedOutput();
+    void testOutputLimit();
+    void testDripFeed();
+    void testInvalid();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TestTeChunkedParser );
+
+/// a chunked message body with two chunks and a trailer
+static const SBuf Encoded("5\r\nhello\r\n6;ext=1\r\n world\r\n0\r\nX-Trailer: yes\r\n\r\n");
+
+/// the decoded Encoded content
+static const SBuf Decoded("hello world");
+
+void
+TestTeChunkedParser::testDecode()
+{
+    Http1::TeChunkedParser parser;
+    SBuf out;
+    parser.setPayloadBuffer(&out, Decoded.length());
+
+    CPPUNIT_ASSERT(parser.parse(Encoded));
+    CPPUNIT_ASSERT_EQUAL(Decoded, out);
+    CPPUNIT_ASSERT(parser.remaining().isEmpty());
+    CPPUNIT_ASSERT(!parser.needsMoreSpace());
+}
+
+void
+TestTeChunkedParser::testSharedOutput()
+{
+    const SBuf input("5\r\nhello\r\n");
+    Http1::TeChunkedParser parser;
+    SBuf out;
+    parser.setPayloadBuffer(&out, 1024);
+
+    // decoded content of a single chunk is not copied from the input
+    CPPUNIT_ASSERT(!parser.parse(input));
+    CPPUNIT_ASSERT_EQUAL(SBuf("hello"), out);
+    CPPUNIT_ASSERT(out.rawContent() == input.rawContent() + 3);
+
+    // the caller may keep the decoded content after the parser is gone
+    const SBuf kept = out;
+    parser.clear();
+    CPPUNIT_ASSERT_EQUAL(SBuf("hello"), kept);
+}
+
+void
+TestTeChunkedParser::testOutputLimit()
+{
+    const SBuf::size_type limit = 4;
+    Http1::TeChunkedParser parser;
+    SBuf out;
+    parser.setPayloadBuffer(&out, limit);
+
+    SBuf decoded;
+    auto done = parser.parse(Encoded);
+    while (!done) {
+        // the parser stops when the output buffer reaches its limit
+        CPPUNIT_ASSERT(parser.needsMoreSpace());
+        CPPUNIT_ASSERT(out.length() <= limit);
+        CPPUNIT_ASSERT(!out.isEmpty());
+        decoded.append(out);
+        out.clear(); // as if the consumer took everything
+        done = parser.parse(parser.remaining());
+    }
+    decoded.append(out);
+
+    CPPUNIT_ASSERT_EQUAL(Decoded, decoded);
+    CPPUNIT_ASSERT(parser.remaining().isEmpty());
+}
+
+void
+TestTeChunkedParser::testDripFeed()
+{
+    Http1::TeChunkedParser parser;
+    SBuf out;
+    parser.setPayloadBuffer(&out, 1024);
+
+    SBuf ioBuf;
+    auto done = false;
+    for (SBuf::size_type pos = 0; pos < Encoded.length(); ++pos) {
+        CPPUNIT_ASSERT(!done);
+        ioBuf.append(Encoded[pos]);
+        done = parser.parse(ioBuf);
+        ioBuf = parser.remaining();
+    }
+
+    CPPUNIT_ASSERT(done);
+    CPPUNIT_ASSERT_EQUAL(Decoded, out);
+}
+
+void
+TestTeChunkedParser::testInvalid()
+{
+    Http1::TeChunkedParser parser;
+    SBuf out;
+    parser.setPayloadBuffer(&out, 1024);
+
+    CPPUNIT_ASSERT_THROW(parser.parse(SBuf("0x5\r\nhello\r\n")), TextException);
+}
+
+int
+main(int argc, char *argv[])
+{
+    return TestProgram().run(argc, argv);
+}
+
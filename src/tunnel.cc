@@ -1188,6 +1188,7 @@ void
 TunnelStateData::noteConnection(HappyConnOpener::Answer &answer)
 {
     transportWait.finish();
+    request->masterXaction->phases.stop(TransactionPhases::tcpConnect);
 
     updateAttempts(answer.n_tries);
 
@@ -1321,6 +1322,7 @@ TunnelStateData::secureConnectionToPeer(const Comm::ConnectionPointer &conn)
 {
     const auto callback = asyncCallback(5, 4, TunnelStateData::noteSecurityPeerConnectorAnswer, this);
     const auto connector = new Security::BlindPeerConnector(request, conn, callback, al);
+    request->masterXaction->phases.start(TransactionPhases::tlsHandshake);
     encryptionWait.start(connector, callback);
 }
 
@@ -1349,6 +1351,7 @@ void
 TunnelStateData::noteSecurityPeerConnectorAnswer(Security::EncryptorAnswer &answer)
 {
     encryptionWait.finish();
+    request->masterXaction->phases.stop(TransactionPhases::tlsHandshake);
 
     ErrorState *error = nullptr;
     assert(!answer.tunneled);
@@ -1538,6 +1541,7 @@ TunnelStateData::startConnecting()
     cs->setRetriable(false);
     cs->allowPersistent(false);
     destinations->notificationPending = true; // start() is async
+    request->masterXaction->phases.start(TransactionPhases::tcpConnect);
     transportWait.start(cs, callback);
 }
 